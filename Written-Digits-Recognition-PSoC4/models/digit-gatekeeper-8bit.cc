@@ -0,0 +1,193 @@
+#include "digit-gatekeeper-8bit.h"
+
+alignas(16) const unsigned char digit_gatekeeper_8bit_tflite[] = {
+  0x18, 0x00, 0x00, 0x00, 0x54, 0x46, 0x4c, 0x33, 0x00, 0x00, 0x0e, 0x00,
+  0x18, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x14, 0x00,
+  0x0e, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x70, 0x00, 0x00, 0x00, 0x34, 0x06, 0x00, 0x00, 0x60, 0x06, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00,
+  0x48, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x72, 0x00, 0x00, 0x00, 0x72, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x10, 0x00,
+  0x0c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x0c, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00,
+  0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00,
+  0x10, 0x00, 0x14, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x4c, 0x04, 0x00, 0x00, 0x50, 0x04, 0x00, 0x00, 0x54, 0x04, 0x00, 0x00,
+  0x90, 0x05, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00,
+  0xa4, 0x00, 0x00, 0x00, 0x18, 0x01, 0x00, 0x00, 0x8c, 0x01, 0x00, 0x00,
+  0x00, 0x02, 0x00, 0x00, 0x6c, 0x02, 0x00, 0x00, 0xd8, 0x02, 0x00, 0x00,
+  0x4c, 0x03, 0x00, 0x00, 0xb8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00,
+  0x18, 0x00, 0x04, 0x00, 0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00,
+  0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x20, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
+  0x1c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+  0x69, 0x6e, 0x70, 0x75, 0x74, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x81, 0x80, 0x80, 0x3b, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+  0x38, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x71, 0x75, 0x61, 0x6e,
+  0x74, 0x69, 0x7a, 0x65, 0x64, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x81, 0x80, 0x80, 0x3b, 0x01, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+  0x34, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x70, 0x6f, 0x6f, 0x6c,
+  0x65, 0x64, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x81, 0x80, 0x80, 0x3b,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+  0x34, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+  0x64, 0x65, 0x6e, 0x73, 0x65, 0x2f, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74,
+  0x73, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x45, 0x12, 0xcf, 0x3c,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x14, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x2c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x64, 0x65, 0x6e, 0x73,
+  0x65, 0x2f, 0x62, 0x69, 0x61, 0x73, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x28, 0xe2, 0xcf, 0x38, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00,
+  0x18, 0x00, 0x04, 0x00, 0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00,
+  0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x18, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,
+  0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x05, 0x00, 0x00, 0x00, 0x64, 0x65, 0x6e, 0x73, 0x65, 0x00, 0x00, 0x00,
+  0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00,
+  0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0xea, 0x7b, 0x15, 0x3d, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00, 0x14, 0x00, 0x08, 0x00,
+  0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00,
+  0x09, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x6c, 0x6f, 0x67, 0x69,
+  0x74, 0x2f, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74, 0x73, 0x00, 0x00, 0x00,
+  0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00,
+  0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x3c, 0x06, 0x1b, 0x3d, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00, 0x14, 0x00, 0x08, 0x00,
+  0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00,
+  0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x0a, 0x00, 0x00, 0x00, 0x6c, 0x6f, 0x67, 0x69, 0x74, 0x2f, 0x62, 0x69,
+  0x61, 0x73, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x56, 0x0b, 0xb5, 0x3a,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x14, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+  0x2c, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+  0x6c, 0x6f, 0x67, 0x69, 0x74, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x33, 0x07, 0x93, 0x3e, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00,
+  0xa4, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00,
+  0x10, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x0a, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x08, 0x00, 0x0c, 0x00, 0x14, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,
+  0x28, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x18, 0x00, 0x14, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00,
+  0x10, 0x00, 0x15, 0x00, 0x10, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00,
+  0x08, 0x00, 0x0c, 0x00, 0x14, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00,
+  0x02, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
+  0x28, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+  0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00,
+  0x08, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x0e, 0x00, 0x18, 0x00, 0x04, 0x00, 0x08, 0x00, 0x0c, 0x00,
+  0x14, 0x00, 0x10, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x08, 0x00, 0x04, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+  0x6d, 0x61, 0x69, 0x6e, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x00,
+  0x44, 0x69, 0x67, 0x69, 0x74, 0x20, 0x67, 0x61, 0x74, 0x65, 0x6b, 0x65,
+  0x65, 0x70, 0x65, 0x72, 0x2c, 0x20, 0x74, 0x6f, 0x6f, 0x6c, 0x73, 0x2f,
+  0x74, 0x72, 0x61, 0x69, 0x6e, 0x5f, 0x67, 0x61, 0x74, 0x65, 0x6b, 0x65,
+  0x65, 0x70, 0x65, 0x72, 0x2e, 0x70, 0x79, 0x00, 0x05, 0x00, 0x00, 0x00,
+  0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0xb8, 0x01, 0x00, 0x00,
+  0xec, 0x01, 0x00, 0x00, 0x10, 0x02, 0x00, 0x00, 0x04, 0x00, 0x04, 0x00,
+  0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x08, 0x00, 0x04, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x88, 0x01, 0x00, 0x00,
+  0xec, 0xec, 0xf6, 0xd7, 0xed, 0x01, 0xf8, 0xfa, 0xe1, 0xe6, 0x1d, 0x15,
+  0x0f, 0xe6, 0xe4, 0xdb, 0xb3, 0xbc, 0xde, 0xd4, 0xd5, 0xe1, 0xf3, 0x0b,
+  0xc2, 0xef, 0x33, 0x20, 0xc6, 0x00, 0xa6, 0xdb, 0x13, 0xe7, 0xd9, 0xe8,
+  0x3f, 0x68, 0x4e, 0xfa, 0xf9, 0xe1, 0x0f, 0x33, 0x3e, 0x27, 0xf5, 0xf5,
+  0x00, 0x09, 0x07, 0xf7, 0xfa, 0x08, 0x13, 0x10, 0x09, 0xff, 0x09, 0x13,
+  0x06, 0xfd, 0xf2, 0xe9, 0xe5, 0x1f, 0xe3, 0xe3, 0x0c, 0xfd, 0xe3, 0x16,
+  0x03, 0xec, 0x10, 0x1a, 0x10, 0xf9, 0xfc, 0xd7, 0x08, 0xd6, 0xfe, 0xfa,
+  0x04, 0xe6, 0x14, 0x0e, 0x13, 0x00, 0xf8, 0x0c, 0x07, 0x04, 0xf7, 0xf7,
+  0x02, 0x08, 0x09, 0x08, 0xfd, 0xda, 0xd9, 0x15, 0xf3, 0x18, 0x16, 0xc9,
+  0xca, 0xe7, 0x04, 0xf0, 0x27, 0x1f, 0x20, 0xc1, 0xae, 0xc0, 0x02, 0x1e,
+  0x21, 0x12, 0xa1, 0xd0, 0xe7, 0x09, 0x3d, 0x44, 0x28, 0xd0, 0xf2, 0xde,
+  0xf9, 0x25, 0x14, 0x1b, 0xfc, 0xe2, 0xc4, 0x02, 0xfb, 0xd4, 0x19, 0x47,
+  0x17, 0xf2, 0xf7, 0xf4, 0xfc, 0x17, 0xea, 0x08, 0xf3, 0x02, 0xf6, 0x19,
+  0x2b, 0xd5, 0x17, 0x14, 0xed, 0x01, 0xf6, 0x0a, 0xbf, 0x15, 0xf6, 0x03,
+  0xf0, 0xf4, 0xd8, 0xe1, 0x1f, 0xdd, 0xf2, 0xe5, 0x1f, 0x49, 0x81, 0x31,
+  0x1c, 0xf6, 0xf8, 0x02, 0x29, 0xd3, 0x20, 0xf7, 0xed, 0x0a, 0x13, 0xf5,
+  0x0b, 0xf3, 0xfb, 0xf2, 0xeb, 0xf1, 0xf2, 0x08, 0x08, 0xf9, 0xf8, 0xfa,
+  0xe5, 0xce, 0x0f, 0x03, 0xe0, 0xfd, 0xe1, 0xfc, 0x2a, 0x02, 0x23, 0x1c,
+  0xf4, 0x1d, 0xfc, 0xc9, 0xaa, 0xd1, 0xc6, 0xe2, 0xe9, 0x07, 0x6e, 0x36,
+  0x14, 0x28, 0xf4, 0xfd, 0xdf, 0xb4, 0xbe, 0x19, 0x11, 0x03, 0x14, 0xf4,
+  0x14, 0x21, 0x0f, 0x05, 0xff, 0x01, 0x04, 0xf1, 0x38, 0x08, 0xf2, 0xf3,
+  0x07, 0xef, 0xef, 0x2a, 0x16, 0x1c, 0x08, 0x03, 0xc7, 0xd5, 0xda, 0xeb,
+  0x0b, 0x0b, 0x07, 0xea, 0xb8, 0xd6, 0xfd, 0xf3, 0x1b, 0xf9, 0x02, 0xcd,
+  0xa9, 0xfb, 0x0a, 0x09, 0xfc, 0xf1, 0xd2, 0xc5, 0xc8, 0x02, 0x01, 0x15,
+  0xfa, 0xdb, 0xd4, 0xf4, 0x1c, 0xf9, 0xfb, 0xef, 0xda, 0x19, 0x02, 0x08,
+  0xf3, 0xf6, 0xdb, 0xcd, 0x3a, 0xfa, 0x12, 0x07, 0xf1, 0x2e, 0x01, 0x24,
+  0xe9, 0x0c, 0x0a, 0x03, 0xe5, 0xd2, 0xee, 0xb3, 0xf1, 0xfa, 0xf3, 0xec,
+  0x0f, 0x21, 0xe5, 0xf5, 0x03, 0x02, 0x12, 0x42, 0x37, 0xbf, 0x1b, 0x0c,
+  0xfd, 0xec, 0xd3, 0x01, 0xe4, 0x04, 0x00, 0x02, 0x07, 0xfa, 0x01, 0xf7,
+  0x01, 0xfb, 0x0b, 0xe5, 0xb3, 0xb3, 0xea, 0xff, 0xf4, 0xf0, 0xef, 0xef,
+  0xa3, 0xd9, 0xe2, 0x1e, 0x13, 0x08, 0xd6, 0xe8, 0xf1, 0x5c, 0x20, 0x1d,
+  0xdd, 0x1e, 0x4d, 0x3d, 0x24, 0x21, 0x0e, 0xfc, 0x48, 0x3d, 0x39, 0x22,
+  0xfa, 0xec, 0xd7, 0x1a, 0xf9, 0x08, 0x26, 0xf8, 0x00, 0x00, 0x06, 0x00,
+  0x08, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x19, 0xa4, 0x00, 0x00,
+  0x8e, 0x0d, 0x00, 0x00, 0x54, 0x53, 0x00, 0x00, 0x1b, 0x11, 0x00, 0x00,
+  0x60, 0x03, 0x00, 0x00, 0xb2, 0x61, 0x00, 0x00, 0x28, 0x1b, 0x00, 0x00,
+  0x72, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x08, 0x00, 0x04, 0x00,
+  0x06, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x53, 0x2f, 0x97, 0x62, 0x70, 0x81, 0x40, 0xae, 0x00, 0x00, 0x06, 0x00,
+  0x08, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x34, 0xf3, 0xff, 0xff,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+const unsigned int digit_gatekeeper_8bit_tflite_len = 2256;
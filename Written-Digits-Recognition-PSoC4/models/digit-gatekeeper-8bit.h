@@ -0,0 +1,14 @@
+/*
+ * digit-gatekeeper-8bit.h
+ *
+ *  Generated by tools/train_gatekeeper.py
+ */
+
+#ifndef MODELS_DIGIT_GATEKEEPER_8BIT_H_
+#define MODELS_DIGIT_GATEKEEPER_8BIT_H_
+
+extern const unsigned char digit_gatekeeper_8bit_tflite[];
+extern const unsigned int digit_gatekeeper_8bit_tflite_len;
+
+
+#endif /* MODELS_DIGIT_GATEKEEPER_8BIT_H_ */
@@ -17,7 +17,8 @@
 #include "cycfg_capsense.h"
 #include "raw_data_size.h"
 #include "bitmatrix_data.h"
-#include "intensity_LUT.h"
+#include "image_rescale.h"
+#include "trace.h"
 
 void input_preprocessing(BitMatrix112x112* raw_data, uint8_t input_data[28][28]);
 void fillInputMatrix(BitMatrix112x112* raw_data);
@@ -76,7 +77,13 @@ void acquire_data(BitMatrix112x112* raw_data, uint8_t input_data[28][28], bool*
     if(MSC_CAPSENSE_WIDGET_INACTIVE != Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD0_WDGT_ID, &cy_capsense_context))
     {
 
+    	/*A new digit, or a further stroke of the same one*/
+    	if(!acquired_data || !timer_stopped){
+    		TRACE_BEGIN("STROKE");
+    	}
+
     	if(!timer_stopped){
+    		TRACE_END("PEN_UP_TIMER");
     		cyhal_timer_stop(timer_obj); // Stops timer if running
     		timer_stopped = true;
     	}
@@ -96,6 +103,12 @@ void acquire_data(BitMatrix112x112* raw_data, uint8_t input_data[28][28], bool*
 
         if(acquired_data){
 
+            /*First scan without the touch: the stroke is over and the pen up timer starts*/
+            if(timer_stopped){
+                TRACE_END("STROKE");
+                TRACE_BEGIN("PEN_UP_TIMER");
+            }
+
             // Start the timer with the configured settings
             cyhal_timer_start(timer_obj);
             timer_stopped = false;
@@ -103,8 +116,12 @@ void acquire_data(BitMatrix112x112* raw_data, uint8_t input_data[28][28], bool*
             // When timer is done...
             if(*timer_done){
 
+				TRACE_END("PEN_UP_TIMER");
+
 				/*Start input data preprocessing...*/
+				TRACE_BEGIN("PREPROCESSING");
 				input_preprocessing(raw_data, input_data);
+				TRACE_END("PREPROCESSING");
 
 				*data_ready = true;
 
@@ -236,41 +253,6 @@ void fillInputMatrix(BitMatrix112x112* raw_data){
 *
 *******************************************************************************/
 
-/*Internal rescaling function declaration:*/
-// Function to rescale the 112x112 image to a 28x28 image
-void rescale_image(BitMatrix112x112 *raw_data, uint8_t input_data[28][28]) {
-
-    // Calculate the scaling factor
-    const int scaling_factor = 4;
-
-    // Loop over the target 28x28 matrix
-    for (int row = 0; row < 28; row++) {
-        for (int col = 0; col < 28; col++) {
-            int sum = 0;
-
-            // Find the corresponding region in the source 128x128 matrix
-            for (int i = 0; i < scaling_factor; i++) {
-                for (int j = 0; j < scaling_factor; j++) {
-                    int source_row = row * scaling_factor + i;
-                    int source_col = col * scaling_factor + j;
-
-                    // Check if the bit in the source matrix is set (white pixel)
-                    if (READ_BIT(raw_data, source_row, source_col) == 1) {
-                        sum++;
-                    }
-                }
-            }
-
-            // Determine the intensity value
-            uint8_t intensity = intensity_table[sum];
-
-            // Set the intensity value in the target 28x28 matrix
-            input_data[row][col] = intensity;
-        }
-    }
-}
-
-
 void input_preprocessing(BitMatrix112x112* raw_data, uint8_t input_data[28][28]){
 
 	/*Image preprocessing steps: rescaling, mirroring and rotating.*/
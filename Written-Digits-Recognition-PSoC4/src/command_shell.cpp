@@ -0,0 +1,253 @@
+/*
+ * command_shell.cpp
+ *
+ *  Command handler of the benchmark and settings shell, see command_shell.h.
+ */
+
+#include "command_shell.h"
+
+#include <string.h>
+
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+#define COMMAND_SHELL_SETTINGS_SIZE     (4u)
+#define COMMAND_SHELL_BENCHMARK_SIZE    (23u)
+#define COMMAND_SHELL_MEMORY_SIZE       (24u)
+
+/*Prediction reported for an output below the confidence threshold*/
+#define COMMAND_SHELL_NO_PREDICTION     (11u)
+
+/*Largest reply, STATS*/
+#define COMMAND_SHELL_MAX_PAYLOAD       (1u + COMMAND_SHELL_MEMORY_SIZE + COMMAND_SHELL_BENCHMARK_SIZE)
+
+
+static uint8_t* put_u16(uint8_t* out, uint16_t value)
+{
+    *out++ = (uint8_t)value;
+    *out++ = (uint8_t)(value >> 8);
+    return out;
+}
+
+
+static uint8_t* put_u32(uint8_t* out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
+
+
+static uint8_t* put_settings(uint8_t* out, const command_shell_settings_t* settings)
+{
+    *out++ = settings->confidence_threshold;
+    out = put_u16(out, settings->pen_up_timeout_ms);
+    *out++ = settings->verbosity;
+    return out;
+}
+
+
+static uint8_t* put_benchmark(uint8_t* out, const command_shell_benchmark_t* benchmark)
+{
+    out = put_u16(out, benchmark->runs);
+    out = put_u32(out, benchmark->ticks_per_second);
+    out = put_u32(out, benchmark->min_ticks);
+    out = put_u32(out, benchmark->max_ticks);
+    out = put_u32(out, (uint32_t)benchmark->total_ticks);
+    out = put_u32(out, (uint32_t)(benchmark->total_ticks >> 32));
+    *out++ = benchmark->prediction;
+    return out;
+}
+
+
+static uint8_t* put_memory(uint8_t* out, const command_shell_t* shell)
+{
+    stack_usage_t stack = {0, 0, 0};
+
+    if (shell->read_stack != NULL) {
+        shell->read_stack(&stack);
+    }
+    out = put_u32(out, stack.used);
+    out = put_u32(out, stack.headroom);
+    out = put_u32(out, stack.reserved);
+    out = put_u32(out, shell->arena_size);
+    out = put_u32(out, (uint32_t)shell->model->arena_used_bytes());
+    out = put_u32(out, (uint32_t)shell->model->arena_head_high_water_bytes());
+    return out;
+}
+
+
+static void reply(command_shell_t* shell, uint8_t command, uint8_t* payload, uint16_t length)
+{
+    /*Static, to keep the frame off the small stack*/
+    static uint8_t frame[COMMAND_SHELL_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+
+    shell->send(frame, uart_frame_encode(command | UART_FRAME_REPLY, payload, length, frame));
+}
+
+
+/* Index of the largest output, or COMMAND_SHELL_NO_PREDICTION if it is below the threshold. */
+static uint8_t prediction(const command_shell_t* shell)
+{
+    const TfLiteTensor* output = shell->model->output(0);
+    uint8_t max_output = 0;
+    uint8_t index = COMMAND_SHELL_NO_PREDICTION;
+
+    for (size_t i = 0; i < output->bytes; i++) {
+        if (output->data.uint8[i] > max_output) {
+            max_output = output->data.uint8[i];
+            index = (uint8_t)i;
+        }
+    }
+    return max_output < shell->settings.confidence_threshold ? COMMAND_SHELL_NO_PREDICTION : index;
+}
+
+
+/*******************************************************************************
+* Function Name: run_benchmark
+********************************************************************************
+* Summary:
+*  Invokes the model runs times on the test input and keeps the fastest,
+*  slowest and total time in shell->benchmark. The time is read once per run,
+*  which is often enough for the SysTick of the Cortex-M0+ as long as a run
+*  takes less than its period. Returns false if an invoke fails.
+*
+*******************************************************************************/
+static bool run_benchmark(command_shell_t* shell, uint16_t runs)
+{
+    command_shell_benchmark_t* benchmark = &shell->benchmark;
+    TfLiteTensor* input = shell->model->input(0);
+
+    memset(benchmark, 0, sizeof(*benchmark));
+    if (input->bytes != shell->test_input_size) {
+        return false;
+    }
+    benchmark->ticks_per_second = tflite::ticks_per_second();
+    benchmark->min_ticks = UINT32_MAX;
+
+    for (uint16_t i = 0; i < runs; i++) {
+        /*The gatekeeper shares the arena, so the input is copied for every run*/
+        memcpy(input->data.uint8, shell->test_input, shell->test_input_size);
+
+        TfLiteStatus status;
+        const uint32_t start = tflite::GetCurrentTimeTicks();
+        if (shell->profiler != NULL) {
+            tflite::ScopedMicroProfiler scoped_profiler("CNN", shell->profiler);
+            status = shell->model->Invoke();
+        } else {
+            status = shell->model->InvokeLean();
+        }
+        const uint32_t ticks = tflite::GetCurrentTimeTicks() - start;
+
+        if (status != kTfLiteOk) {
+            memset(benchmark, 0, sizeof(*benchmark));
+            return false;
+        }
+        benchmark->runs++;
+        benchmark->total_ticks += ticks;
+        if (ticks < benchmark->min_ticks) {
+            benchmark->min_ticks = ticks;
+        }
+        if (ticks > benchmark->max_ticks) {
+            benchmark->max_ticks = ticks;
+        }
+    }
+    benchmark->prediction = prediction(shell);
+    return true;
+}
+
+
+/* Applies the settings of a SETTINGS_SET request, or returns false and keeps the current ones. */
+static bool set_settings(command_shell_t* shell, const uint8_t* payload)
+{
+    command_shell_settings_t settings;
+
+    settings.confidence_threshold = payload[0];
+    settings.pen_up_timeout_ms = (uint16_t)(payload[1] | (payload[2] << 8));
+    settings.verbosity = payload[3];
+
+    if (settings.pen_up_timeout_ms < COMMAND_SHELL_MIN_PEN_UP_MS ||
+        settings.pen_up_timeout_ms > COMMAND_SHELL_MAX_PEN_UP_MS ||
+        settings.verbosity > COMMAND_SHELL_VERBOSITY_FULL) {
+        return false;
+    }
+    if (shell->apply != NULL && !shell->apply(shell->model, &settings)) {
+        return false;
+    }
+    shell->settings = settings;
+    return true;
+}
+
+
+void command_shell_init(command_shell_t* shell, tflite::MicroInterpreter* model,
+                        tflite::MicroProfilerInterface* profiler, const uint8_t* test_input,
+                        size_t test_input_size, uint32_t arena_size,
+                        const command_shell_settings_t* settings, command_shell_read_stack_t read_stack,
+                        command_shell_apply_t apply, command_shell_send_t send)
+{
+    shell->model = model;
+    shell->profiler = profiler;
+    shell->test_input = test_input;
+    shell->test_input_size = test_input_size;
+    shell->arena_size = arena_size;
+    shell->settings = *settings;
+    memset(&shell->benchmark, 0, sizeof(shell->benchmark));
+    shell->read_stack = read_stack;
+    shell->apply = apply;
+    shell->send = send;
+}
+
+
+/*******************************************************************************
+* Function Name: command_shell_handle
+********************************************************************************
+* Summary:
+*  Answers a request. A benchmark runs before its reply is sent.
+*
+*******************************************************************************/
+void command_shell_handle(command_shell_t* shell, uint8_t command, const uint8_t* request, uint16_t length,
+                          bool busy)
+{
+    static uint8_t payload[COMMAND_SHELL_MAX_PAYLOAD];
+    uint8_t* end = payload + 1;
+    uint16_t runs;
+
+    switch (command) {
+    case COMMAND_SHELL_BENCH:
+        payload[0] = COMMAND_SHELL_ERROR;
+        if (length == 2) {
+            runs = (uint16_t)(request[0] | (request[1] << 8));
+            if (busy) {
+                payload[0] = COMMAND_SHELL_BUSY;
+            } else if (runs > 0 && runs <= COMMAND_SHELL_MAX_RUNS && run_benchmark(shell, runs)) {
+                payload[0] = COMMAND_SHELL_OK;
+            }
+        }
+        if (payload[0] == COMMAND_SHELL_OK) {
+            end = put_benchmark(end, &shell->benchmark);
+        }
+        reply(shell, command, payload, (uint16_t)(end - payload));
+        break;
+    case COMMAND_SHELL_STATS:
+        payload[0] = length == 0 ? COMMAND_SHELL_OK : COMMAND_SHELL_ERROR;
+        if (payload[0] == COMMAND_SHELL_OK) {
+            end = put_memory(end, shell);
+            end = put_benchmark(end, &shell->benchmark);
+        }
+        reply(shell, command, payload, (uint16_t)(end - payload));
+        break;
+    case COMMAND_SHELL_SETTINGS_GET:
+    case COMMAND_SHELL_SETTINGS_SET:
+        payload[0] = COMMAND_SHELL_OK;
+        if (command == COMMAND_SHELL_SETTINGS_GET ? length != 0 :
+            length != COMMAND_SHELL_SETTINGS_SIZE || !set_settings(shell, request)) {
+            payload[0] = COMMAND_SHELL_ERROR;
+        }
+        end = put_settings(end, &shell->settings);
+        reply(shell, command, payload, (uint16_t)(end - payload));
+        break;
+    default:
+        break;
+    }
+}
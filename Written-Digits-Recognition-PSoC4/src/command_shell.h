@@ -0,0 +1,118 @@
+/*
+ * command_shell.h
+ *
+ *  Benchmark and run time settings of the application over the UART, with the
+ *  binary frames of uart_frame.h. Requests and the payload of their replies:
+ *
+ *    BENCH         runs (2)       -> status (1), benchmark
+ *    STATS                        -> status (1), memory, benchmark
+ *    SETTINGS_GET                 -> status (1), settings
+ *    SETTINGS_SET  settings       -> status (1), settings
+ *
+ *  All integers are little endian:
+ *
+ *    benchmark: runs (2) | ticks per second (4) | fastest run (4) |
+ *               slowest run (4) | all runs (8) | prediction (1)
+ *    memory:    stack used (4) | stack headroom (4) | stack reserved (4) |
+ *               arena size (4) | arena used (4) | arena head high-water of
+ *               the last inference (4)
+ *    settings:  confidence threshold (1) | pen up timeout in ms (2) |
+ *               verbosity (1)
+ *
+ *  BENCH copies test_input_qnt (test_data/test_sample.h) into the model and
+ *  invokes it the given number of times, timing each run with
+ *  tflite::GetCurrentTimeTicks(). The prediction is that of the last run, 11
+ *  below the confidence threshold, as in the main loop. STATS returns the last
+ *  benchmark again, next to the stack and arena usage; the stack needs
+ *  MEMORY_WATERMARKS and the high-water mark the arena watermarks, both are 0
+ *  otherwise. With a profiler the runs are also recorded under a CNN event,
+ *  so tools/profile_report.py reads their per-operator statistics.
+ *
+ *  The status is COMMAND_SHELL_OK, COMMAND_SHELL_BUSY for a BENCH while an
+ *  inference of the main loop is in progress, or COMMAND_SHELL_ERROR for a
+ *  request of the wrong size, a run count out of range, settings out of range
+ *  or settings the application could not apply; settings that are not applied
+ *  are left as they were. The host side is tools/board_shell.py.
+ *
+ *  The shell only depends on the interpreter and on callbacks, so that a host
+ *  build can drive it with requests.
+ */
+
+#ifndef SRC_COMMAND_SHELL_H_
+#define SRC_COMMAND_SHELL_H_
+
+#include "stack_watermark.h"
+#include "uart_frame.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+#define COMMAND_SHELL_BENCH             (0x16u)
+#define COMMAND_SHELL_STATS             (0x17u)
+#define COMMAND_SHELL_SETTINGS_GET      (0x18u)
+#define COMMAND_SHELL_SETTINGS_SET      (0x19u)
+
+#define COMMAND_SHELL_OK                (0u)
+#define COMMAND_SHELL_ERROR             (1u)
+#define COMMAND_SHELL_BUSY              (2u)
+
+/*A benchmark blocks the main loop, and CAPSENSE, until it is over*/
+#define COMMAND_SHELL_MAX_RUNS          (100u)
+
+/*The pen up timer counts at 10 kHz with a 16 bit period*/
+#define COMMAND_SHELL_MIN_PEN_UP_MS     (50u)
+#define COMMAND_SHELL_MAX_PEN_UP_MS     (6500u)
+
+/*Verbosity of the text output of each digit*/
+#define COMMAND_SHELL_VERBOSITY_QUIET   (0u)    /*nothing*/
+#define COMMAND_SHELL_VERBOSITY_RESULT  (1u)    /*scores and prediction*/
+#define COMMAND_SHELL_VERBOSITY_FULL    (2u)    /*the input image too, for the GUI*/
+
+typedef struct {
+    uint8_t confidence_threshold;
+    uint16_t pen_up_timeout_ms;
+    uint8_t verbosity;
+} command_shell_settings_t;
+
+typedef struct {
+    uint16_t runs;
+    uint32_t ticks_per_second;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint64_t total_ticks;
+    uint8_t prediction;
+} command_shell_benchmark_t;
+
+typedef void (*command_shell_send_t)(const uint8_t* data, size_t size);
+typedef void (*command_shell_read_stack_t)(stack_usage_t* usage);
+/* Applies new settings to the application and to the model; returns false to reject them. */
+typedef bool (*command_shell_apply_t)(tflite::MicroInterpreter* model, const command_shell_settings_t* settings);
+
+typedef struct {
+    tflite::MicroInterpreter* model;
+    tflite::MicroProfilerInterface* profiler;
+    const uint8_t* test_input;
+    size_t test_input_size;
+    uint32_t arena_size;
+    command_shell_settings_t settings;
+    command_shell_benchmark_t benchmark;
+    command_shell_read_stack_t read_stack;
+    command_shell_apply_t apply;
+    command_shell_send_t send;
+} command_shell_t;
+
+/* The model has to be allocated, with PrepareLeanInvoke() when there is no
+ * profiler, and its output has to be uint8. read_stack, apply and profiler may
+ * be NULL; the settings are taken as they are, without calling apply. */
+void command_shell_init(command_shell_t* shell, tflite::MicroInterpreter* model,
+                        tflite::MicroProfilerInterface* profiler, const uint8_t* test_input,
+                        size_t test_input_size, uint32_t arena_size,
+                        const command_shell_settings_t* settings, command_shell_read_stack_t read_stack,
+                        command_shell_apply_t apply, command_shell_send_t send);
+
+/* Answers a request decoded from the UART, BENCH to SETTINGS_SET; other
+ * commands are ignored. busy tells that the main loop is in the middle of an
+ * inference of the model, which a benchmark would overwrite. */
+void command_shell_handle(command_shell_t* shell, uint8_t command, const uint8_t* request, uint16_t length,
+                          bool busy);
+
+#endif /* SRC_COMMAND_SHELL_H_ */
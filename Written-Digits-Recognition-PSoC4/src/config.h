@@ -11,5 +11,45 @@
 
 #define CONFIDENCE_THRESHOLD 128
 
+/*Time without a touch after which the strokes drawn so far are taken as a digit*/
+#define PEN_UP_TIMEOUT_MS 700
+
+/*Text output of each digit: 0 nothing, 1 the scores and the prediction, 2 the input image too, as
+ * the GUI expects. The threshold, the timeout and the verbosity can be changed at run time over the
+ * UART with tools/board_shell.py*/
+#define OUTPUT_VERBOSITY 2
+
+/*Opt-in. 1: the CNN stops at the logits and reports a one-hot argmax, or all zeros below
+ * CONFIDENCE_THRESHOLD, with the same decisions as the softmax but no scores for the GUI.
+ * 0: the GUI gets the softmax scores*/
+#define ARGMAX_OUTPUT 0
+
+/*Opt-in. 1: every stroke first goes through the "is this a digit?" gatekeeper model and the CNN
+ * only runs on the strokes it accepts. It also rejects some real digits, see the README.
+ * 0: the gatekeeper model is compiled out and every stroke goes through the CNN*/
+#define GATEKEEPER 0
+
+/*Strokes with a gatekeeper logit up to this value are not digits and skip the CNN*/
+#define GATEKEEPER_THRESHOLD 0
+
+/*1: both models run with a tflite::MicroAggregateProfiler, whose per operator statistics are read
+ * out over the UART by tools/profile_report.py. The inferences then run at once instead of one
+ * step per loop iteration*/
+#define PROFILE_OUTPUT 0
+
+/*1: the free RAM below the stack is painted at start up and both models record how far into the
+ * arena each node reaches. tools/memory_report.py reads the stack and arena high-water marks over
+ * the UART*/
+#define MEMORY_WATERMARKS 0
+
+/*1: the stages of each digit, from the end of the stroke to the UART output, and the operators of
+ * both models are traced with begin and end timestamps into a buffer of 128 events, which
+ * tools/trace_to_chrome.py reads over the UART and converts into a Chrome trace. As with
+ * PROFILE_OUTPUT, the inferences run at once. Not together with PROFILE_OUTPUT*/
+#define TRACE_OUTPUT 0
+
+/*Flash reserved for a model uploaded over the UART (tools/upload_model.py), header row included*/
+#define MODEL_SLOT_SIZE (16u * 1024u)
+
 
 #endif /* SRC_CONFIG_H_ */
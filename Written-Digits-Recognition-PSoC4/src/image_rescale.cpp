@@ -0,0 +1,47 @@
+/*
+ * image_rescale.cpp
+ *
+ *  Downscale of the stroke matrix, see image_rescale.h.
+ */
+
+#include "image_rescale.h"
+
+#include "intensity_LUT.h"
+
+// Returns the number of set bits in each nibble of a row word: four 4-bit counts
+static inline uint32_t nibble_counts(uint32_t word) {
+    word = word - ((word >> 1) & 0x5555);
+    return (word & 0x3333) + ((word >> 2) & 0x3333);
+}
+
+// Function to rescale the 112x112 image to a 28x28 image.
+// Every 16-bit word of a row holds the bits of 4 adjacent 4x4 blocks, so the
+// blocks are counted 4 at a time with AND masks and a SWAR popcount instead
+// of reading the 16 bits of each block one by one.
+void rescale_image(BitMatrix112x112 *raw_data, uint8_t input_data[28][28]) {
+
+    // Loop over the target 28x28 matrix, one block row and one word at a time
+    for (int row = 0; row < 28; row++) {
+        const int source_row = row * 4;
+
+        for (int word = 0; word < 7; word++) {
+            // Nibble counts of two rows add up to at most 8, which still fits
+            uint32_t top = nibble_counts(raw_data->data[source_row][word]) +
+                           nibble_counts(raw_data->data[source_row + 1][word]);
+            uint32_t bottom = nibble_counts(raw_data->data[source_row + 2][word]) +
+                              nibble_counts(raw_data->data[source_row + 3][word]);
+
+            // Spread the nibbles to bytes (blocks 0, 2, 1, 3) so that the 4 rows add up to 16
+            top = (top & 0x0f0f) | ((top & 0xf0f0) << 12);
+            bottom = (bottom & 0x0f0f) | ((bottom & 0xf0f0) << 12);
+            const uint32_t sums = top + bottom;
+
+            // Determine the intensity values in the target 28x28 matrix
+            uint8_t* target = &input_data[row][word * 4];
+            target[0] = intensity_table[sums & 0xff];
+            target[1] = intensity_table[(sums >> 16) & 0xff];
+            target[2] = intensity_table[(sums >> 8) & 0xff];
+            target[3] = intensity_table[sums >> 24];
+        }
+    }
+}
@@ -0,0 +1,17 @@
+/*
+ * image_rescale.h
+ *
+ *  Downscale of the 112x112 stroke matrix to the 28x28 image the models take.
+ *  It does not touch the PSoC 4, so that it also runs on a host.
+ */
+
+#ifndef SRC_IMAGE_RESCALE_H_
+#define SRC_IMAGE_RESCALE_H_
+
+#include <stdint.h>
+
+#include "bitmatrix_data.h"
+
+void rescale_image(BitMatrix112x112 *raw_data, uint8_t input_data[28][28]);
+
+#endif /* SRC_IMAGE_RESCALE_H_ */
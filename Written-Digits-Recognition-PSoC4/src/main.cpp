@@ -42,6 +42,8 @@
 /*******************************************************************************
  * Include header files
  ******************************************************************************/
+#include <cstring>
+
 #include "cybsp.h"
 #include "cy_pdl.h"
 #include "cyhal.h"
@@ -52,15 +54,31 @@
 
 #include "raw_data_size.h"
 #include "written-digit-recognition-cnn-8bit.h"
+#include "digit-gatekeeper-8bit.h"
 #include "capsense_input_preprocessing.h"
 #include "bitmatrix_data.h"
 #include "config.h"
+#include "patch_config.h"
+#include "packed_weights.h"
+#include "model_slot.h"
+#include "model_slot_psoc4.h"
+#include "model_upload.h"
+#include "profile_dump.h"
+#include "memory_dump.h"
+#include "stack_watermark_psoc4.h"
+#include "trace.h"
+#include "trace_dump.h"
+#include "command_shell.h"
+#include "test_sample.h"
 
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/micro/micro_aggregate_profiler.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_trace_profiler.h"
 #include "tensorflow/lite/micro/recording_micro_interpreter.h"
 #include "tensorflow/lite/micro/system_setup.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -78,14 +96,30 @@
 #define CY_ASSERT_FAILED                 (0u)
 
 
-/*Number of different operations used by your model. This includes both layer operations (i.e. Conv2D, Dense...),
- * activation operations (i.e. SOFTMAX) and quantization operations (i.e. QUANTIZE).*/
-#define OPNUM 7
+/*Number of different operations used by your models. This includes both layer operations (i.e. Conv2D, Dense...),
+ * activation operations (i.e. SOFTMAX) and quantization operations (i.e. QUANTIZE).
+ * Fused kernels (i.e. Conv2D+MaxPool2D) count as one more operation each.*/
+#define OPNUM 12
 
 
 /*Name of your model as defined in the .h file*/
 #define MODEL_NAME written_digit_recognition_cnn_8bit_tflite
 
+/*Name of the "is this a digit?" gatekeeper model, see tools/train_gatekeeper.py*/
+#define GATEKEEPER_MODEL_NAME digit_gatekeeper_8bit_tflite
+
+/*Profiler given to the interpreters, whose operators then add their events to it*/
+#if PROFILE_OUTPUT && TRACE_OUTPUT
+#error "PROFILE_OUTPUT and TRACE_OUTPUT need a profiler each, set only one of them"
+#elif PROFILE_OUTPUT
+#define INFERENCE_PROFILER (&profiler)
+#elif TRACE_OUTPUT
+#define INFERENCE_PROFILER (&trace_profiler)
+#endif
+
+/*The pen up timer counts at 10 kHz*/
+#define PEN_UP_TIMER_HZ 10000
+
 
 /*******************************************************************************
 * Global Definitions
@@ -99,6 +133,37 @@ bool timer_done = false;
 // Timer object used
 cyhal_timer_t timer_obj;
 
+/*Decoder of the binary frames of all the UART protocols below, which are told apart by their
+ * command byte*/
+static uart_frame_decoder_t uart_decoder;
+
+/*Flash slot for models uploaded over the UART. An uploaded model replaces the CNN, so it has to
+ * take the pixels of input_data and give the 10 uint8 scores*/
+static model_slot_t model_slot;
+static model_upload_t model_upload;
+static const model_slot_tensors_t model_tensors = {kTfLiteUInt8, sizeof(input_data), kTfLiteUInt8, 10};
+
+/*Benchmark and run time settings, sent by tools/board_shell.py*/
+static command_shell_t command_shell;
+
+#if PROFILE_OUTPUT
+/*Per operator timing statistics of both models, read out by tools/profile_report.py*/
+static tflite::MicroAggregateProfiler profiler;
+static profile_dump_t profile_dump;
+#endif
+
+#if MEMORY_WATERMARKS
+/*Stack and arena high-water marks, read out by tools/memory_report.py*/
+static memory_dump_t memory_dump;
+#endif
+
+#if TRACE_OUTPUT
+/*Timeline of the stages of each digit and of the operators, read out by tools/trace_to_chrome.py.
+ * Also used by the hooks of trace.h in the other files*/
+tflite::MicroTraceProfiler trace_profiler;
+static trace_dump_t trace_dump;
+#endif
+
 
 /*******************************************************************************
 * Function Prototypes
@@ -107,6 +172,10 @@ static void initialize_capsense(void);
 static void capsense_msc0_isr(void);
 static void capsense_msc1_isr(void);
 static void printSerialData(uint8_t* output, uint8_t prediction);
+static void uart_send(const uint8_t* data, size_t size);
+static bool handle_frame(const uart_frame_decoder_t* frame, bool inference_running);
+static bool apply_settings(tflite::MicroInterpreter* model, const command_shell_settings_t* settings);
+static cy_rslt_t configure_pen_up_timer(uint16_t timeout_ms);
 //static void acquireDataset(uint8_t* output);
 cy_rslt_t timer_initialization(void);
 
@@ -127,6 +196,13 @@ TfLiteStatus RegisterOps(ModelOpResolver& op_resolver) {
   TF_LITE_ENSURE_STATUS(op_resolver.AddSoftmax());
   TF_LITE_ENSURE_STATUS(op_resolver.AddReshape());
   TF_LITE_ENSURE_STATUS(op_resolver.AddMean());
+  TF_LITE_ENSURE_STATUS(op_resolver.AddAveragePool2D());
+  TF_LITE_ENSURE_STATUS(op_resolver.AddConv2DMaxPool2D());
+  TF_LITE_ENSURE_STATUS(op_resolver.AddMeanFullyConnectedSoftmax());
+#if ARGMAX_OUTPUT
+  TF_LITE_ENSURE_STATUS(op_resolver.AddMeanFullyConnectedArgMax());
+#endif
+  TF_LITE_ENSURE_STATUS(op_resolver.AddPatchConvStack());
   return kTfLiteOk;
 }
 }  // namespace
@@ -172,6 +248,11 @@ int main(void)
 {
     cy_rslt_t result;
 
+#if MEMORY_WATERMARKS
+    /*Before anything else runs on the stack below main()*/
+    stack_watermark_psoc4_init();
+#endif
+
     /* Initialize the device and board peripherals */
     result = cybsp_init();
 
@@ -194,27 +275,164 @@ int main(void)
     /*TFLite registration of DebugLog*/
     RegisterDebugLogCallback(debug_log_printf);
 
-    /*Define and load model in memory: */
-    const tflite::Model* model =::tflite::GetModel(MODEL_NAME);
-    TFLITE_CHECK_EQ(model->version(), TFLITE_SCHEMA_VERSION);
-
     /*Resolution of model operations*/
     ModelOpResolver op_resolver;
     TF_LITE_ENSURE_STATUS(RegisterOps(op_resolver));
 
+    /*A model uploaded over the UART into the flash slot replaces the built-in one*/
+    model_slot_flash_t model_slot_flash;
+    model_slot_psoc4_flash_init(&model_slot_flash);
+    model_slot_init(&model_slot, &model_slot_flash);
+    uart_frame_decoder_init(&uart_decoder);
+    model_upload_init(&model_upload, &model_slot, &op_resolver, &model_tensors, uart_send);
+#if PROFILE_OUTPUT
+    profile_dump_init(&profile_dump, &profiler, uart_send);
+#endif
+#if TRACE_OUTPUT
+    trace_dump_init(&trace_dump, &trace_profiler, uart_send);
+#endif
+
+    const unsigned char* model_data = model_slot_active_model(&model_slot, NULL);
+    if(model_data == NULL){
+    	model_data = MODEL_NAME;
+    }
+
+    /*Define and load model in memory: */
+    const tflite::Model* model =::tflite::GetModel(model_data);
+    TFLITE_CHECK_EQ(model->version(), TFLITE_SCHEMA_VERSION);
+#if GATEKEEPER
+    const tflite::Model* gatekeeper_model =::tflite::GetModel(GATEKEEPER_MODEL_NAME);
+    TFLITE_CHECK_EQ(gatekeeper_model->version(), TFLITE_SCHEMA_VERSION);
+#endif
+
     // Manual setting of TFArena. The exact arena usage can be determined
     // using the RecordingMicroInterpreter.
     //constexpr int kTensorArenaSize = 4000;
     constexpr int kTensorArenaSize = 10000;
     uint8_t tensor_arena[kTensorArenaSize];
 
-    /*Interpreter allocation:*/
-    tflite::MicroInterpreter interpreter(model, op_resolver, tensor_arena, kTensorArenaSize);
-    TF_LITE_ENSURE_STATUS(interpreter.AllocateTensors());
+    /*Interpreters allocation: the gatekeeper and the CNN never run at the same time, so they share
+     * the arena. Running one of them invalidates the input and output tensors of the other.*/
+    tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(tensor_arena, kTensorArenaSize);
+#if defined(INFERENCE_PROFILER)
+#if GATEKEEPER
+    tflite::MicroInterpreter gatekeeper(gatekeeper_model, op_resolver, allocator, nullptr, INFERENCE_PROFILER);
+#endif
+    tflite::MicroInterpreter interpreter(model, op_resolver, allocator, nullptr, INFERENCE_PROFILER);
+#else
+#if GATEKEEPER
+    tflite::MicroInterpreter gatekeeper(gatekeeper_model, op_resolver, allocator);
+#endif
+    tflite::MicroInterpreter interpreter(model, op_resolver, allocator);
+#endif
+
+    /*Weights packed in flash for the Cortex-M0+ kernels by tools/pack_weights.py*/
+#if GATEKEEPER
+    TF_LITE_ENSURE_STATUS(gatekeeper.SetPackedWeights(&packed_weights));
+#endif
+    TF_LITE_ENSURE_STATUS(interpreter.SetPackedWeights(&packed_weights));
+#if ARGMAX_OUTPUT
+    /*The softmax is skipped: the threshold on its uint8 output, which is the int8 output of the
+     * classifier head shifted by 128, is checked on the logits instead*/
+    TF_LITE_ENSURE_STATUS(interpreter.SetArgMaxConfidenceThreshold(CONFIDENCE_THRESHOLD - 128));
+#endif
+#if GATEKEEPER
+    TF_LITE_ENSURE_STATUS(gatekeeper.AllocateTensors());
+    /*input_data is copied into its input as into the one of the CNN*/
+    if(gatekeeper.input(0)->type != model_tensors.input_type || gatekeeper.input(0)->bytes != model_tensors.input_bytes){
+    	return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(gatekeeper.PrepareLeanInvoke());
+#if MEMORY_WATERMARKS
+    TF_LITE_ENSURE_STATUS(gatekeeper.EnableArenaWatermarks());
+#endif
+#endif
+
+    /*Patch based execution of the first layers, tile size chosen by tools/patch_tile_planner.py*/
+    tflite::PatchExecutionConfig patch_config;
+    patch_config.num_layers = PATCH_NUM_LAYERS;
+    patch_config.tile_height = PATCH_TILE_HEIGHT;
+    patch_config.tile_width = PATCH_TILE_WIDTH;
+    TfLiteStatus model_status = interpreter.SetPatchExecutionConfig(patch_config);
+    if(model_status == kTfLiteOk){
+    	model_status = interpreter.AllocateTensors();
+    }
+
+    /*Precomputed dispatch table for a low overhead Invoke*/
+    if(model_status == kTfLiteOk){
+    	model_status = interpreter.PrepareLeanInvoke();
+    }
+#if MEMORY_WATERMARKS
+    if(model_status == kTfLiteOk){
+    	model_status = interpreter.EnableArenaWatermarks();
+    }
+#endif
+
+    /*An uploaded model has to fit in the arena, take input_data and produce the 10 uint8 scores,
+     * otherwise it is dropped and the board restarts with the built-in model. The tensors are
+     * checked at the upload, and again here for a slot written by an older firmware*/
+    if(model_status == kTfLiteOk &&
+       (interpreter.input(0)->type != model_tensors.input_type || interpreter.input(0)->bytes != model_tensors.input_bytes ||
+        interpreter.output(0)->type != model_tensors.output_type || interpreter.output(0)->bytes != model_tensors.output_bytes)){
+    	model_status = kTfLiteError;
+    }
+    if(model_status != kTfLiteOk){
+    	if(model_data != MODEL_NAME){
+    		model_slot_invalidate(&model_slot);
+    		NVIC_SystemReset();
+    	}
+    	return model_status;
+    }
 
+#if MEMORY_WATERMARKS
+    memory_dump_init(&memory_dump, kTensorArenaSize, stack_watermark_psoc4_read, uart_send);
+#if GATEKEEPER
+    memory_dump_add_model(&memory_dump, &gatekeeper);
+#endif
+    memory_dump_add_model(&memory_dump, &interpreter);
+#endif
+
+    /*The settings start from config.h; the benchmark runs the CNN on the test digit*/
+    const command_shell_settings_t settings = {CONFIDENCE_THRESHOLD, PEN_UP_TIMEOUT_MS, OUTPUT_VERBOSITY};
+#if defined(INFERENCE_PROFILER)
+    tflite::MicroProfilerInterface* shell_profiler = INFERENCE_PROFILER;
+#else
+    tflite::MicroProfilerInterface* shell_profiler = NULL;
+#endif
+#if MEMORY_WATERMARKS
+    command_shell_read_stack_t shell_read_stack = stack_watermark_psoc4_read;
+#else
+    command_shell_read_stack_t shell_read_stack = NULL;
+#endif
+    command_shell_init(&command_shell, &interpreter, shell_profiler, test_input_qnt, sizeof(test_input_qnt),
+                       kTensorArenaSize, &settings, shell_read_stack, apply_settings, uart_send);
+
+
+    /*Progress of the running inference, which is run one step per loop
+     * iteration so that CAPSENSE keeps being serviced in between*/
+    tflite::InvokeResumeToken inference;
+    bool inference_running = false;
 
     for(;;)
     {
+        TRACE_KEEP_TIME();
+
+        /*Model upload, read out and shell requests, sent by the scripts in tools/*/
+        while(cyhal_uart_readable(&cy_retarget_io_uart_obj) > 0)
+        {
+            uint8_t byte;
+
+            if(cyhal_uart_getc(&cy_retarget_io_uart_obj, &byte, 1) != CY_RSLT_SUCCESS){
+                continue;
+            }
+            if(uart_frame_decode(&uart_decoder, byte) && handle_frame(&uart_decoder, inference_running))
+            {
+                /*Restart with the uploaded model once the reply has been sent*/
+                while(cyhal_uart_is_tx_active(&cy_retarget_io_uart_obj)){}
+                NVIC_SystemReset();
+            }
+        }
+
         if(CY_CAPSENSE_NOT_BUSY == Cy_CapSense_IsBusy(&cy_capsense_context))
         {
             /* Process all widgets */
@@ -223,28 +441,86 @@ int main(void)
             /* Acquire input data  */
             acquire_data(&raw_data, input_data, &data_ready, &timer_obj, &timer_done);
 
-            if(data_ready){
+            /*The input tensors can only be written once the previous inference is over*/
+            if(data_ready && !inference_running){
+
+            	/*Reset the inference flag*/
+            	data_ready = false;
+
+            	bool is_digit = true;
+
+#if GATEKEEPER
+            	/*The gatekeeper rejects palm touches, taps and scribbles before the CNN runs*/
+            	TRACE_BEGIN("INPUT_COPY");
+            	memcpy(gatekeeper.input(0)->data.uint8, input_data, sizeof(input_data));
+            	TRACE_END("INPUT_COPY");
+#if defined(INFERENCE_PROFILER)
+            	{
+            		/*The lean invoke has no profiler events*/
+            		tflite::ScopedMicroProfiler scoped_profiler("GATEKEEPER", INFERENCE_PROFILER);
+            		TF_LITE_ENSURE_STATUS(gatekeeper.Invoke());
+            	}
+#else
+            	TF_LITE_ENSURE_STATUS(gatekeeper.InvokeLean());
+#endif
+            	is_digit = gatekeeper.output(0)->data.int8[0] > GATEKEEPER_THRESHOLD;
+#endif
 
-            	uint16_t input_index = 0;
+            	if(is_digit){
+
+            		TRACE_BEGIN("INPUT_COPY");
+            		memcpy(interpreter.input(0)->data.uint8, input_data, sizeof(input_data));
+            		TRACE_END("INPUT_COPY");
+
+            		if(command_shell.settings.verbosity != COMMAND_SHELL_VERBOSITY_QUIET){
+            			printf("***");
+            		}
 
-            	for(int x = 0; x < 28; x++){
-            		for(int y = 0; y < 28; y++){
+            		/*Start a new inference*/
+            		inference = tflite::InvokeResumeToken();
+            		inference_running = true;
+            	}else{
 
-            			interpreter.input(0)->data.uint8[input_index] = input_data[x][y];
-            			input_index++;
+            		static uint8_t rejected_output[10] = {0};
 
-            			}
+            		if(command_shell.settings.verbosity != COMMAND_SHELL_VERBOSITY_QUIET){
+            			printf("***");
             		}
+            		TRACE_BEGIN("PRINT");
+            		printSerialData(rejected_output, 11);
+            		TRACE_END("PRINT");
+            	}
+            }
+
+            /* Start the next scan */
+            Cy_CapSense_ScanAllSlots(&cy_capsense_context);
+
+        }
 
-            	printf("***");
+        if(inference_running)
+        {
+#if defined(INFERENCE_PROFILER)
+            /*Calling inference engine: the whole inference at once, since the time sliced invoke
+             * has no profiler events*/
+            {
+            	tflite::ScopedMicroProfiler scoped_profiler("CNN", INFERENCE_PROFILER);
+            	TF_LITE_ENSURE_STATUS(interpreter.Invoke());
+            }
+            inference.finished = true;
+#else
+            /*Calling inference engine: runs a single node or a single block of rows of a layer*/
+            TF_LITE_ENSURE_STATUS(interpreter.InvokeStep(&inference));
+#endif
 
-                /*Calling inference engine*/
-                TF_LITE_ENSURE_STATUS(interpreter.Invoke());
+            if(inference.finished)
+            {
+                inference_running = false;
 
                 uint8_t max_output = 0;
                 uint8_t prediction_index = 11;
 
             	/*Checking max output*/
+            	TRACE_BEGIN("ARGMAX");
             	for(int k = 0; k<10; k++){
 
             		uint8_t prediction = interpreter.output(0)->data.uint8[k];
@@ -255,22 +531,17 @@ int main(void)
             		}
             	}
 
-            	if(max_output < CONFIDENCE_THRESHOLD){
+            	if(max_output < command_shell.settings.confidence_threshold){
             		prediction_index = 11;
             	}
-
-            	/*Reset the inference flag*/
-            	data_ready = false;
+            	TRACE_END("ARGMAX");
 
             	//printf("\n\r");
+            	TRACE_BEGIN("PRINT");
             	printSerialData(interpreter.output(0)->data.uint8, prediction_index);
+            	TRACE_END("PRINT");
             	//acquireDataset(interpreter.output(0)->data.uint8);
-
             }
-
-            /* Start the next scan */
-            Cy_CapSense_ScanAllSlots(&cy_capsense_context);
-
         }
     }
 }
@@ -280,13 +551,19 @@ int main(void)
 ********************************************************************************
 * Summary:
 *  Function that prints data to operate the external GUI listening to the UART.
+*  Below COMMAND_SHELL_VERBOSITY_FULL the input image is left out, which saves
+*  most of the 3 kB of each line; the GUI then cannot parse it.
 *
 *******************************************************************************/
 static void printSerialData(uint8_t* output, uint8_t prediction)
 {
+    const uint8_t verbosity = command_shell.settings.verbosity;
 
+    if(verbosity == COMMAND_SHELL_VERBOSITY_QUIET){
+    	return;
+    }
 
-    for(int x = 0; x < 28; x++){
+    for(int x = 0; x < 28 && verbosity == COMMAND_SHELL_VERBOSITY_FULL; x++){
     	for(int y = 0; y < 28; y++){
     		if(y == 27 && x == 27){
     			printf("%d", input_data[x][y]);
@@ -460,15 +737,6 @@ static void isr_timer(void* callback_arg, cyhal_timer_event_t event)
 cy_rslt_t timer_initialization()
 {
     cy_rslt_t rslt;
-    const cyhal_timer_cfg_t timer_cfg =
-    {
-    	.is_continuous = true,               // Run the timer indefinitely
-        .direction     = CYHAL_TIMER_DIR_UP, // Timer counts up
-        .is_compare    = false,              // Don't use compare mode
-        .period        = 6999,               // Defines the timer period
-        .compare_value = 0,                  // Timer compare value, not used
-        .value         = 0                   // Initial value of counter
-    };
 
     // Initialize the timer object. Does not use pin output ('pin' is NC) and does not use a
     // pre-configured clock source ('clk' is NULL).
@@ -476,12 +744,12 @@ cy_rslt_t timer_initialization()
     // Apply timer configuration such as period, count direction, run mode, etc.
     if (CY_RSLT_SUCCESS == rslt)
     {
-        rslt = cyhal_timer_configure(&timer_obj, &timer_cfg);
+        rslt = configure_pen_up_timer(PEN_UP_TIMEOUT_MS);
     }
     // Set the frequency of timer to 10000 Hz
     if (CY_RSLT_SUCCESS == rslt)
     {
-        rslt = cyhal_timer_set_frequency(&timer_obj, 10000);
+        rslt = cyhal_timer_set_frequency(&timer_obj, PEN_UP_TIMER_HZ);
     }
     if (CY_RSLT_SUCCESS == rslt)
     {
@@ -492,3 +760,112 @@ cy_rslt_t timer_initialization()
     }
     return rslt;
 }
+
+/*******************************************************************************
+* Function Name: configure_pen_up_timer
+********************************************************************************
+* Summary:
+*  Sets the period of the pen up timer, which also restarts its count.
+*
+*******************************************************************************/
+static cy_rslt_t configure_pen_up_timer(uint16_t timeout_ms)
+{
+    const cyhal_timer_cfg_t timer_cfg =
+    {
+    	.is_continuous = true,               // Run the timer indefinitely
+        .direction     = CYHAL_TIMER_DIR_UP, // Timer counts up
+        .is_compare    = false,              // Don't use compare mode
+        .period        = (uint32_t)timeout_ms * (PEN_UP_TIMER_HZ / 1000) - 1, // Defines the timer period
+        .compare_value = 0,                  // Timer compare value, not used
+        .value         = 0                   // Initial value of counter
+    };
+
+    return cyhal_timer_configure(&timer_obj, &timer_cfg);
+}
+
+/*******************************************************************************
+* Function Name: apply_settings
+********************************************************************************
+* Summary:
+*  Applies the settings changed over the UART: the pen up timeout to the timer
+*  and, with ARGMAX_OUTPUT, the confidence threshold to the classifier head,
+*  whose uint8 output is its int8 one shifted by 128. The verbosity is read by
+*  printSerialData.
+*
+*******************************************************************************/
+static bool apply_settings(tflite::MicroInterpreter* model, const command_shell_settings_t* settings)
+{
+#if ARGMAX_OUTPUT
+    if(model->SetArgMaxConfidenceThreshold((int8_t)(settings->confidence_threshold - 128)) != kTfLiteOk){
+    	return false;
+    }
+#else
+    (void)model;
+#endif
+    return configure_pen_up_timer(settings->pen_up_timeout_ms) == CY_RSLT_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: handle_frame
+********************************************************************************
+* Summary:
+*  Passes a frame decoded from the UART to the protocol its command belongs
+*  to. Commands of protocols left out of the build, and unknown ones, are
+*  ignored. Returns true when an uploaded model has been activated and the
+*  board has to restart.
+*
+*******************************************************************************/
+static bool handle_frame(const uart_frame_decoder_t* frame, bool inference_running)
+{
+    switch(frame->command){
+    case MODEL_UPLOAD_BEGIN:
+    case MODEL_UPLOAD_DATA:
+    case MODEL_UPLOAD_COMMIT:
+    case MODEL_UPLOAD_ACTIVATE:
+    case MODEL_UPLOAD_INFO:
+    	return model_upload_handle(&model_upload, frame->command, frame->payload, frame->length);
+#if PROFILE_OUTPUT
+    case PROFILE_DUMP_READ:
+    case PROFILE_DUMP_CLEAR:
+    	profile_dump_handle(&profile_dump, frame->command, frame->payload, frame->length);
+    	break;
+#endif
+#if MEMORY_WATERMARKS
+    case MEMORY_DUMP_READ:
+    case MEMORY_DUMP_RESET:
+    	memory_dump_handle(&memory_dump, frame->command, frame->payload, frame->length);
+    	break;
+#endif
+#if TRACE_OUTPUT
+    case TRACE_DUMP_READ:
+    case TRACE_DUMP_CLEAR:
+    	trace_dump_handle(&trace_dump, frame->command, frame->payload, frame->length);
+    	break;
+#endif
+    case COMMAND_SHELL_BENCH:
+    case COMMAND_SHELL_STATS:
+    case COMMAND_SHELL_SETTINGS_GET:
+    case COMMAND_SHELL_SETTINGS_SET:
+    	command_shell_handle(&command_shell, frame->command, frame->payload, frame->length,
+    	                     inference_running);
+    	break;
+    default:
+    	break;
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: uart_send
+********************************************************************************
+* Summary:
+*  Sends the replies of the model upload, profile, memory and trace read out
+*  protocols and of the command shell on the UART.
+*
+*******************************************************************************/
+static void uart_send(const uint8_t* data, size_t size)
+{
+    for(size_t i = 0; i < size; i++){
+    	cyhal_uart_putc(&cy_retarget_io_uart_obj, data[i]);
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * memory_dump.cpp
+ *
+ *  Command handler of the memory read out, see memory_dump.h.
+ */
+
+#include "memory_dump.h"
+
+#define MEMORY_DUMP_SUMMARY_RECORD  (0u)
+#define MEMORY_DUMP_MODEL_RECORD    (1u)
+#define MEMORY_DUMP_VERSION         (1u)
+
+/*Nodes that fit in a model record after the status byte*/
+#define MEMORY_DUMP_MAX_NODES       ((UART_FRAME_MAX_PAYLOAD - 1u - 7u) / 4u)
+
+
+static uint8_t* put_u32(uint8_t* out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        *out++ = (uint8_t)(value >> (8 * i));
+    }
+    return out;
+}
+
+
+static void reply(memory_dump_t* dump, uint8_t command, uint8_t* payload, uint16_t length)
+{
+    /*Static, to keep the frame off the small stack*/
+    static uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+
+    dump->send(frame, uart_frame_encode(command | UART_FRAME_REPLY, payload, length, frame));
+}
+
+
+/* Writes record |index| to |out| and returns its end, or NULL if there is no such record. */
+static uint8_t* write_record(const memory_dump_t* dump, uint8_t index, uint8_t* out)
+{
+    if (index == 0) {
+        stack_usage_t stack = {0, 0, 0};
+
+        if (dump->read_stack != NULL) {
+            dump->read_stack(&stack);
+        }
+        *out++ = MEMORY_DUMP_SUMMARY_RECORD;
+        *out++ = MEMORY_DUMP_VERSION;
+        out = put_u32(out, stack.used);
+        out = put_u32(out, stack.headroom);
+        out = put_u32(out, stack.reserved);
+        out = put_u32(out, dump->arena_size);
+        out = put_u32(out, dump->num_models > 0 ? dump->models[0]->arena_tail_used_bytes() : 0);
+        *out++ = dump->num_models;
+        return out;
+    }
+    if (index > dump->num_models) {
+        return NULL;
+    }
+
+    const tflite::MicroInterpreter* model = dump->models[index - 1];
+    int nodes = model->arena_watermark_nodes();
+
+    if (nodes > (int)MEMORY_DUMP_MAX_NODES) {
+        nodes = MEMORY_DUMP_MAX_NODES;
+    }
+    *out++ = MEMORY_DUMP_MODEL_RECORD;
+    *out++ = (uint8_t)(index - 1);
+    out = put_u32(out, model->arena_head_high_water_bytes());
+    *out++ = (uint8_t)nodes;
+    for (int i = 0; i < nodes; i++) {
+        out = put_u32(out, model->node_arena_head_high_water_bytes(i));
+    }
+    return out;
+}
+
+
+void memory_dump_init(memory_dump_t* dump, uint32_t arena_size, memory_dump_read_stack_t read_stack,
+                      memory_dump_send_t send)
+{
+    dump->num_models = 0;
+    dump->arena_size = arena_size;
+    dump->read_stack = read_stack;
+    dump->send = send;
+}
+
+
+bool memory_dump_add_model(memory_dump_t* dump, tflite::MicroInterpreter* interpreter)
+{
+    if (dump->num_models == MEMORY_DUMP_MAX_MODELS) {
+        return false;
+    }
+    dump->models[dump->num_models++] = interpreter;
+    return true;
+}
+
+
+/*******************************************************************************
+* Function Name: memory_dump_handle
+********************************************************************************
+* Summary:
+*  Answers a request from the interpreters and the stack scan. Other commands
+*  are ignored.
+*
+*******************************************************************************/
+void memory_dump_handle(memory_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length)
+{
+    static uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+    uint8_t* end;
+
+    switch (command) {
+    case MEMORY_DUMP_READ:
+        end = NULL;
+        if (length == 1) {
+            end = write_record(dump, request[0], payload + 1);
+        }
+        payload[0] = end != NULL ? MEMORY_DUMP_OK : MEMORY_DUMP_ERROR;
+        reply(dump, command, payload, (uint16_t)(end != NULL ? end - payload : 1));
+        break;
+    case MEMORY_DUMP_RESET:
+        for (uint8_t i = 0; i < dump->num_models; i++) {
+            dump->models[i]->ResetArenaWatermarks();
+        }
+        payload[0] = MEMORY_DUMP_OK;
+        reply(dump, command, payload, 1);
+        break;
+    default:
+        break;
+    }
+}
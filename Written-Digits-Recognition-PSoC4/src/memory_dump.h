@@ -0,0 +1,65 @@
+/*
+ * memory_dump.h
+ *
+ *  Read out of the stack high-water mark and of the arena watermarks of the
+ *  interpreters (tflite::MicroInterpreter::EnableArenaWatermarks) over the
+ *  UART, with the binary frames of uart_frame.h. Requests and the payload of
+ *  their replies:
+ *
+ *    READ     record index (1)  -> status (1), record
+ *    RESET                      -> status (1)
+ *
+ *  RESET clears the arena watermarks of the nodes; the stack is only painted
+ *  once, at start up. Record 0 is the summary, records 1 to the number of
+ *  models those of the interpreters. All integers are little endian:
+ *
+ *    summary: 0 (1) | version 1 (1) | stack used (4) | stack headroom (4) |
+ *             stack reserved (4) | arena size (4) | arena tail used (4) |
+ *             models (1)
+ *    model:   1 (1) | model index (1) | head high-water of the last
+ *             inference (4) | nodes n (1) | head high-water of nodes 0 to
+ *             n - 1 (4 each)
+ *
+ *  The head high-water marks are offsets from the start of the arena, see
+ *  stack_watermark.h for the stack. The status is MEMORY_DUMP_OK, or
+ *  MEMORY_DUMP_ERROR for a missing record or a request of the wrong size. The
+ *  host side is tools/memory_report.py.
+ */
+
+#ifndef SRC_MEMORY_DUMP_H_
+#define SRC_MEMORY_DUMP_H_
+
+#include "stack_watermark.h"
+#include "uart_frame.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+#define MEMORY_DUMP_READ            (0x12u)
+#define MEMORY_DUMP_RESET           (0x13u)
+
+#define MEMORY_DUMP_OK              (0u)
+#define MEMORY_DUMP_ERROR           (1u)
+
+#define MEMORY_DUMP_MAX_MODELS      (2u)
+
+typedef void (*memory_dump_send_t)(const uint8_t* data, size_t size);
+typedef void (*memory_dump_read_stack_t)(stack_usage_t* usage);
+
+typedef struct {
+    tflite::MicroInterpreter* models[MEMORY_DUMP_MAX_MODELS];
+    uint8_t num_models;
+    uint32_t arena_size;
+    memory_dump_read_stack_t read_stack;
+    memory_dump_send_t send;
+} memory_dump_t;
+
+void memory_dump_init(memory_dump_t* dump, uint32_t arena_size, memory_dump_read_stack_t read_stack,
+                      memory_dump_send_t send);
+
+/* Adds an interpreter, which has to have its arena watermarks enabled. Returns false when
+ * MEMORY_DUMP_MAX_MODELS are already there. */
+bool memory_dump_add_model(memory_dump_t* dump, tflite::MicroInterpreter* interpreter);
+
+/* Answers a request decoded from the UART, READ or RESET; other commands are ignored. */
+void memory_dump_handle(memory_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length);
+
+#endif /* SRC_MEMORY_DUMP_H_ */
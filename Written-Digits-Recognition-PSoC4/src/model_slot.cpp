@@ -0,0 +1,310 @@
+/*
+ * model_slot.cpp
+ *
+ *  Slot manager for models uploaded over the UART, see model_slot.h.
+ */
+
+#include "model_slot.h"
+
+#include <string.h>
+
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/tflite_bridge/flatbuffer_conversions_bridge.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+/*******************************************************************************
+* Function Name: model_slot_crc32
+********************************************************************************
+* Summary:
+*  Reflected CRC-32 with a 16 entry table, a trade-off between the flash
+*  footprint and the time spent checking the slot at boot.
+*
+*******************************************************************************/
+uint32_t model_slot_crc32(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const uint32_t table[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+        0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu,
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ data[i]) & 0x0Fu];
+        crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 4)) & 0x0Fu];
+    }
+    return ~crc;
+}
+
+static const model_slot_header_t* header(const model_slot_t* slot)
+{
+    return reinterpret_cast<const model_slot_header_t*>(slot->flash.base);
+}
+
+static const uint8_t* model_data(const model_slot_t* slot)
+{
+    return slot->flash.base + slot->flash.row_size;
+}
+
+void model_slot_init(model_slot_t* slot, const model_slot_flash_t* flash)
+{
+    slot->flash = *flash;
+    slot->uploading = false;
+    slot->expected_size = 0;
+}
+
+uint32_t model_slot_capacity(const model_slot_t* slot)
+{
+    return slot->flash.size - slot->flash.row_size;
+}
+
+const uint8_t* model_slot_active_model(const model_slot_t* slot, uint32_t* size)
+{
+    const model_slot_header_t* slot_header = header(slot);
+
+    if (slot->uploading || slot_header->magic != MODEL_SLOT_MAGIC ||
+        slot_header->size == 0 || slot_header->size > model_slot_capacity(slot)) {
+        return NULL;
+    }
+    if (model_slot_crc32(0, model_data(slot), slot_header->size) != slot_header->crc) {
+        return NULL;
+    }
+    if (size != NULL) {
+        *size = slot_header->size;
+    }
+    return model_data(slot);
+}
+
+/*******************************************************************************
+* Function Name: write_header
+********************************************************************************
+* Summary:
+*  Programs the header row. An empty header (all 0xFF, as erased flash) marks
+*  the slot as empty.
+*
+*******************************************************************************/
+static bool write_header(model_slot_t* slot, const model_slot_header_t* slot_header)
+{
+    memset(slot->row, 0xFF, slot->flash.row_size);
+    if (slot_header != NULL) {
+        memcpy(slot->row, slot_header, sizeof(*slot_header));
+    }
+    return slot->flash.write_row(&slot->flash, 0, reinterpret_cast<uint8_t*>(slot->row));
+}
+
+static bool flush_row(model_slot_t* slot)
+{
+    uint32_t offset = slot->flash.row_size + slot->written - slot->row_fill;
+
+    memset(reinterpret_cast<uint8_t*>(slot->row) + slot->row_fill, 0xFF,
+           slot->flash.row_size - slot->row_fill);
+    slot->row_fill = 0;
+    return slot->flash.write_row(&slot->flash, offset, reinterpret_cast<uint8_t*>(slot->row));
+}
+
+model_slot_status_t model_slot_begin(model_slot_t* slot, uint32_t size, uint32_t crc)
+{
+    slot->uploading = false;
+    if (size == 0 || size > model_slot_capacity(slot)) {
+        return MODEL_SLOT_ERROR_SIZE;
+    }
+    if (!write_header(slot, NULL)) {
+        return MODEL_SLOT_ERROR_FLASH;
+    }
+    slot->uploading = true;
+    slot->expected_size = size;
+    slot->expected_crc = crc;
+    slot->written = 0;
+    slot->row_fill = 0;
+    return MODEL_SLOT_OK;
+}
+
+model_slot_status_t model_slot_write(model_slot_t* slot, uint32_t offset, const uint8_t* data, uint32_t length)
+{
+    if (!slot->uploading) {
+        return MODEL_SLOT_ERROR_STATE;
+    }
+    /* A repeated chunk (its acknowledge got lost) has already been written. */
+    if (length > 0 && offset + length == slot->written) {
+        return MODEL_SLOT_OK;
+    }
+    if (offset != slot->written) {
+        return MODEL_SLOT_ERROR_OFFSET;
+    }
+    if (offset + length > slot->expected_size) {
+        return MODEL_SLOT_ERROR_SIZE;
+    }
+
+    uint8_t* row = reinterpret_cast<uint8_t*>(slot->row);
+    while (length > 0) {
+        uint32_t count = slot->flash.row_size - slot->row_fill;
+        if (count > length) {
+            count = length;
+        }
+        memcpy(row + slot->row_fill, data, count);
+        slot->row_fill += count;
+        slot->written += count;
+        data += count;
+        length -= count;
+        if (slot->row_fill == slot->flash.row_size && !flush_row(slot)) {
+            slot->uploading = false;
+            return MODEL_SLOT_ERROR_FLASH;
+        }
+    }
+    return MODEL_SLOT_OK;
+}
+
+model_slot_status_t model_slot_commit(model_slot_t* slot, const tflite::MicroOpResolver& op_resolver,
+                                      const model_slot_tensors_t* tensors)
+{
+    if (!slot->uploading) {
+        /* A repeated commit (its acknowledge got lost) has already succeeded. */
+        const model_slot_header_t* slot_header = header(slot);
+        if (slot->expected_size != 0 && slot_header->magic == MODEL_SLOT_MAGIC &&
+            slot_header->size == slot->expected_size && slot_header->crc == slot->expected_crc) {
+            return MODEL_SLOT_OK;
+        }
+        return MODEL_SLOT_ERROR_STATE;
+    }
+    slot->uploading = false;
+    if (slot->written != slot->expected_size) {
+        return MODEL_SLOT_ERROR_SIZE;
+    }
+    if (slot->row_fill > 0 && !flush_row(slot)) {
+        return MODEL_SLOT_ERROR_FLASH;
+    }
+    /* Everything is checked on the flash content, not on the received data. */
+    if (model_slot_crc32(0, model_data(slot), slot->expected_size) != slot->expected_crc) {
+        return MODEL_SLOT_ERROR_CRC;
+    }
+    model_slot_status_t status = model_slot_validate(model_data(slot), slot->expected_size, op_resolver, tensors);
+    if (status != MODEL_SLOT_OK) {
+        return status;
+    }
+
+    model_slot_header_t slot_header;
+    slot_header.magic = MODEL_SLOT_MAGIC;
+    slot_header.size = slot->expected_size;
+    slot_header.crc = slot->expected_crc;
+    return write_header(slot, &slot_header) ? MODEL_SLOT_OK : MODEL_SLOT_ERROR_FLASH;
+}
+
+model_slot_status_t model_slot_invalidate(model_slot_t* slot)
+{
+    slot->uploading = false;
+    return write_header(slot, NULL) ? MODEL_SLOT_OK : MODEL_SLOT_ERROR_FLASH;
+}
+
+/*******************************************************************************
+* Function Name: tensor_matches
+********************************************************************************
+* Summary:
+*  Checks that the first tensor of indices has the given type and the given
+*  size, as the allocator will compute it from its shape. The application
+*  copies that many bytes in or out, so a smaller tensor would let it write
+*  past the tensor into the arena.
+*
+*******************************************************************************/
+static bool tensor_matches(const tflite::SubGraph* subgraph, const flatbuffers::Vector<int32_t>* indices,
+                           TfLiteType type, uint32_t bytes)
+{
+    if (indices == nullptr || indices->size() == 0 || subgraph->tensors() == nullptr) {
+        return false;
+    }
+    const int32_t index = indices->Get(0);
+    if (index < 0 || (uint32_t)index >= subgraph->tensors()->size()) {
+        return false;
+    }
+
+    const tflite::Tensor* tensor = subgraph->tensors()->Get(index);
+    TfLiteType tensor_type;
+    size_t type_size;
+    if (tflite::ConvertTensorType(tensor->type(), &tensor_type) != kTfLiteOk || tensor_type != type ||
+        tflite::TfLiteTypeSizeOf(type, &type_size) != kTfLiteOk) {
+        return false;
+    }
+    /* A scalar has no shape. The size is bounded by bytes at every step, so it cannot overflow. */
+    uint32_t size = (uint32_t)type_size;
+    if (tensor->shape() != nullptr) {
+        for (const int32_t dimension : *tensor->shape()) {
+            if (dimension <= 0 || (uint32_t)dimension > bytes / size) {
+                return false;
+            }
+            size *= (uint32_t)dimension;
+        }
+    }
+    return size == bytes;
+}
+
+/*******************************************************************************
+* Function Name: model_slot_validate
+********************************************************************************
+* Summary:
+*  Runs the flatbuffers Verifier on the model, so that the interpreter never
+*  follows an offset outside of it, checks that every operator it uses is
+*  registered in the op resolver, and that its input and output are the
+*  tensors the application copies its data into and its scores out of.
+*
+*******************************************************************************/
+model_slot_status_t model_slot_validate(const uint8_t* data, uint32_t size, const tflite::MicroOpResolver& op_resolver,
+                                        const model_slot_tensors_t* tensors)
+{
+    flatbuffers::Verifier verifier(data, size);
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        return MODEL_SLOT_ERROR_VERIFY;
+    }
+
+    const tflite::Model* model = tflite::GetModel(data);
+    if (model->version() != TFLITE_SCHEMA_VERSION || model->subgraphs() == nullptr ||
+        model->subgraphs()->size() == 0 || model->operator_codes() == nullptr) {
+        return MODEL_SLOT_ERROR_VERIFY;
+    }
+
+    for (const tflite::OperatorCode* opcode : *model->operator_codes()) {
+        const tflite::BuiltinOperator builtin = tflite::GetBuiltinCode(opcode);
+        const TFLMRegistration* registration;
+        if (builtin == tflite::BuiltinOperator_CUSTOM) {
+            if (opcode->custom_code() == nullptr) {
+                return MODEL_SLOT_ERROR_OPS;
+            }
+            registration = op_resolver.FindOp(opcode->custom_code()->c_str());
+        } else {
+            registration = op_resolver.FindOp(builtin);
+        }
+        if (registration == nullptr) {
+            return MODEL_SLOT_ERROR_OPS;
+        }
+    }
+
+    const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+    if (!tensor_matches(subgraph, subgraph->inputs(), tensors->input_type, tensors->input_bytes) ||
+        !tensor_matches(subgraph, subgraph->outputs(), tensors->output_type, tensors->output_bytes)) {
+        return MODEL_SLOT_ERROR_TENSORS;
+    }
+    return MODEL_SLOT_OK;
+}
+
+/*******************************************************************************
+* RAM flash stand-in
+*******************************************************************************/
+static bool ram_flash_write_row(const model_slot_flash_t* flash, uint32_t offset, const uint8_t* data)
+{
+    if (offset % flash->row_size != 0 || offset + flash->row_size > flash->size) {
+        return false;
+    }
+    memcpy(const_cast<uint8_t*>(flash->base) + offset, data, flash->row_size);
+    return true;
+}
+
+void model_slot_ram_flash_init(model_slot_flash_t* flash, uint8_t* memory, uint32_t size, uint32_t row_size)
+{
+    memset(memory, 0xFF, size);
+    flash->base = memory;
+    flash->size = size;
+    flash->row_size = row_size;
+    flash->write_row = ram_flash_write_row;
+}
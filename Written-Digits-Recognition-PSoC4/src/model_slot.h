@@ -0,0 +1,116 @@
+/*
+ * model_slot.h
+ *
+ *  Reserved flash region holding a model uploaded over the UART, which
+ *  replaces the model built into the application at the next boot.
+ *
+ *  The first flash row of the slot holds the header, the model starts at the
+ *  second row. An upload erases the header first, writes the model row by
+ *  row, checks it in flash and writes the header last, so a slot interrupted
+ *  at any point is never taken for a valid one.
+ *
+ *  The flash is accessed through model_slot_flash_t: the PSoC 4 flash in the
+ *  application (model_slot_psoc4.h) or a RAM buffer standing in for it, so the
+ *  slot manager also runs on a host.
+ */
+
+#ifndef SRC_MODEL_SLOT_H_
+#define SRC_MODEL_SLOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+
+#define MODEL_SLOT_MAGIC            (0x4C534D54u)   /* "TMSL" */
+#define MODEL_SLOT_MAX_ROW_SIZE     (256u)
+
+typedef enum {
+    MODEL_SLOT_OK = 0,
+    MODEL_SLOT_ERROR_STATE,         /* No upload in progress */
+    MODEL_SLOT_ERROR_SIZE,          /* Model larger than the slot, or incomplete */
+    MODEL_SLOT_ERROR_OFFSET,        /* Data not contiguous with the previous chunk */
+    MODEL_SLOT_ERROR_FLASH,         /* Flash write failed */
+    MODEL_SLOT_ERROR_CRC,           /* Model in flash does not match the CRC of the upload */
+    MODEL_SLOT_ERROR_VERIFY,        /* Not a valid TFLite flatbuffer */
+    MODEL_SLOT_ERROR_OPS,           /* Uses an operator missing from the op resolver */
+    MODEL_SLOT_ERROR_TENSORS,       /* Input or output tensor not the one the application uses */
+} model_slot_status_t;
+
+/* Tensors through which the application runs a model: the type and size of
+ * the first input and of the first output of its first subgraph. */
+typedef struct {
+    TfLiteType input_type;
+    uint32_t input_bytes;
+    TfLiteType output_type;
+    uint32_t output_bytes;
+} model_slot_tensors_t;
+
+/* Flash backing a slot. base is the memory mapped start of the region, size
+ * its size and row_size the flash row size (at most MODEL_SLOT_MAX_ROW_SIZE).
+ * write_row erases and programs the row at the given offset. */
+typedef struct model_slot_flash model_slot_flash_t;
+struct model_slot_flash {
+    const uint8_t* base;
+    uint32_t size;
+    uint32_t row_size;
+    bool (*write_row)(const model_slot_flash_t* flash, uint32_t offset, const uint8_t* data);
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t crc;
+} model_slot_header_t;
+
+typedef struct {
+    model_slot_flash_t flash;
+    bool uploading;
+    uint32_t expected_size;
+    uint32_t expected_crc;
+    uint32_t written;
+    uint32_t row_fill;
+    uint32_t row[MODEL_SLOT_MAX_ROW_SIZE / 4];
+} model_slot_t;
+
+void model_slot_init(model_slot_t* slot, const model_slot_flash_t* flash);
+
+/* Returns the model stored in the slot, or NULL if the slot holds no valid
+ * model. The CRC of the model is checked on every call. */
+const uint8_t* model_slot_active_model(const model_slot_t* slot, uint32_t* size);
+
+/* Largest model the slot can hold. */
+uint32_t model_slot_capacity(const model_slot_t* slot);
+
+/* Starts an upload of size bytes with the given CRC-32, invalidating the
+ * model currently in the slot. */
+model_slot_status_t model_slot_begin(model_slot_t* slot, uint32_t size, uint32_t crc);
+
+/* Writes the next chunk of the upload. Chunks have to be sent in order; the
+ * last chunk sent can be sent again, e.g. after a lost acknowledge. */
+model_slot_status_t model_slot_write(model_slot_t* slot, uint32_t offset, const uint8_t* data, uint32_t length);
+
+/* Finishes the upload: the model is checked in flash against the CRC, with
+ * the flatbuffers Verifier, against the operators of op_resolver and against
+ * the tensors the application uses, and the slot is marked valid if all
+ * checks pass. */
+model_slot_status_t model_slot_commit(model_slot_t* slot, const tflite::MicroOpResolver& op_resolver,
+                                      const model_slot_tensors_t* tensors);
+
+/* Marks the slot as empty, e.g. when its model cannot be allocated. */
+model_slot_status_t model_slot_invalidate(model_slot_t* slot);
+
+/* Checks that data holds a TFLite model that can be run with op_resolver,
+ * through tensors of the given type and size. */
+model_slot_status_t model_slot_validate(const uint8_t* data, uint32_t size, const tflite::MicroOpResolver& op_resolver,
+                                        const model_slot_tensors_t* tensors);
+
+/* CRC-32 (IEEE 802.3, as zlib.crc32), continued from crc. */
+uint32_t model_slot_crc32(uint32_t crc, const uint8_t* data, size_t size);
+
+/* Flash stand-in backed by memory, for running the slot manager on a host.
+ * memory has to be aligned to 16 bytes. */
+void model_slot_ram_flash_init(model_slot_flash_t* flash, uint8_t* memory, uint32_t size, uint32_t row_size);
+
+#endif /* SRC_MODEL_SLOT_H_ */
@@ -0,0 +1,51 @@
+/*
+ * model_slot_psoc4.cpp
+ *
+ *  PSoC 4 flash backing the model slot, see model_slot_psoc4.h.
+ */
+
+/*******************************************************************************
+ * Include header files
+ ******************************************************************************/
+#include "cy_pdl.h"
+
+#include "config.h"
+#include "model_slot_psoc4.h"
+
+
+/*******************************************************************************
+* Global variables
+*******************************************************************************/
+
+/* The slot is a row aligned constant array, so that it is placed in flash
+ * without changes to the linker script. It is only accessed through its
+ * address from the other translation units, so the compiler cannot assume
+ * it still holds its initial value. Erased (0xFF) rows are written by the
+ * first upload; until then the header does not match MODEL_SLOT_MAGIC. */
+CY_ALIGN(CY_FLASH_SIZEOF_ROW) static const uint8_t model_slot_storage[MODEL_SLOT_SIZE] = {0};
+
+
+/*******************************************************************************
+* Function Name: flash_write_row
+********************************************************************************
+* Summary:
+*  Erases and programs one flash row of the slot. The CPU is stalled while the
+*  row is programmed.
+*
+*******************************************************************************/
+static bool flash_write_row(const model_slot_flash_t* flash, uint32_t offset, const uint8_t* data)
+{
+    if (offset % CY_FLASH_SIZEOF_ROW != 0 || offset + CY_FLASH_SIZEOF_ROW > flash->size) {
+        return false;
+    }
+    uint32_t row_address = (uint32_t)(flash->base + offset);
+    return Cy_Flash_WriteRow(row_address, (const uint32_t*)data) == CY_FLASH_DRV_SUCCESS;
+}
+
+void model_slot_psoc4_flash_init(model_slot_flash_t* flash)
+{
+    flash->base = model_slot_storage;
+    flash->size = MODEL_SLOT_SIZE;
+    flash->row_size = CY_FLASH_SIZEOF_ROW;
+    flash->write_row = flash_write_row;
+}
@@ -0,0 +1,15 @@
+/*
+ * model_slot_psoc4.h
+ *
+ *  PSoC 4 flash backing the model slot: MODEL_SLOT_SIZE bytes reserved in the
+ *  application flash, programmed one row at a time.
+ */
+
+#ifndef SRC_MODEL_SLOT_PSOC4_H_
+#define SRC_MODEL_SLOT_PSOC4_H_
+
+#include "model_slot.h"
+
+void model_slot_psoc4_flash_init(model_slot_flash_t* flash);
+
+#endif /* SRC_MODEL_SLOT_PSOC4_H_ */
@@ -0,0 +1,86 @@
+/*
+ * model_upload.cpp
+ *
+ *  Command handler of the model upload protocol, see model_upload.h.
+ */
+
+#include "model_upload.h"
+
+static uint32_t read_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void reply(model_upload_t* upload, uint8_t command, model_slot_status_t status, uint32_t value)
+{
+    uint8_t payload[5];
+    uint8_t frame[sizeof(payload) + UART_FRAME_OVERHEAD];
+
+    payload[0] = (uint8_t)status;
+    for (int i = 0; i < 4; i++) {
+        payload[1 + i] = (uint8_t)(value >> (8 * i));
+    }
+    upload->send(frame, uart_frame_encode(command | UART_FRAME_REPLY, payload, sizeof(payload), frame));
+}
+
+void model_upload_init(model_upload_t* upload, model_slot_t* slot, const tflite::MicroOpResolver* op_resolver,
+                       const model_slot_tensors_t* tensors, model_upload_send_t send)
+{
+    upload->slot = slot;
+    upload->op_resolver = op_resolver;
+    upload->tensors = tensors;
+    upload->send = send;
+}
+
+/*******************************************************************************
+* Function Name: model_upload_handle
+********************************************************************************
+* Summary:
+*  Runs a request on the slot. Requests with a payload of the wrong size are
+*  answered with MODEL_SLOT_ERROR_SIZE, unknown commands are ignored.
+*
+*******************************************************************************/
+bool model_upload_handle(model_upload_t* upload, uint8_t command, const uint8_t* payload, uint16_t length)
+{
+    model_slot_t* slot = upload->slot;
+    model_slot_status_t status;
+    uint32_t size = 0;
+
+    switch (command) {
+    case MODEL_UPLOAD_BEGIN:
+        if (length != 8) {
+            reply(upload, command, MODEL_SLOT_ERROR_SIZE, 0);
+            break;
+        }
+        status = model_slot_begin(slot, read_u32(payload), read_u32(payload + 4));
+        reply(upload, command, status, model_slot_capacity(slot));
+        break;
+    case MODEL_UPLOAD_DATA:
+        if (length < 4) {
+            reply(upload, command, MODEL_SLOT_ERROR_SIZE, 0);
+            break;
+        }
+        status = model_slot_write(slot, read_u32(payload), payload + 4, length - 4u);
+        reply(upload, command, status, slot->written);
+        break;
+    case MODEL_UPLOAD_COMMIT:
+        status = model_slot_commit(slot, *upload->op_resolver, upload->tensors);
+        reply(upload, command, status, slot->expected_size);
+        break;
+    case MODEL_UPLOAD_ACTIVATE:
+        if (model_slot_active_model(slot, NULL) == NULL) {
+            reply(upload, command, MODEL_SLOT_ERROR_STATE, 0);
+            break;
+        }
+        reply(upload, command, MODEL_SLOT_OK, 0);
+        return true;
+    case MODEL_UPLOAD_INFO:
+        model_slot_active_model(slot, &size);
+        reply(upload, command, MODEL_SLOT_OK, size);
+        break;
+    default:
+        break;
+    }
+    return false;
+}
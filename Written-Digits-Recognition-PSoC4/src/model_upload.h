@@ -0,0 +1,52 @@
+/*
+ * model_upload.h
+ *
+ *  Upload of a model into the model slot over the UART, with the binary
+ *  frames of uart_frame.h. Requests and the payload of their replies (all
+ *  integers little endian):
+ *
+ *    BEGIN    size (4), CRC-32 (4)  -> status (1), slot capacity (4)
+ *    DATA     offset (4), data      -> status (1), bytes written (4)
+ *    COMMIT                         -> status (1), model size (4)
+ *    ACTIVATE                       -> status (1), 0 (4)
+ *    INFO                           -> status (1), size of the model in the slot (4)
+ *
+ *  The status is a model_slot_status_t. The host side is
+ *  tools/upload_model.py.
+ */
+
+#ifndef SRC_MODEL_UPLOAD_H_
+#define SRC_MODEL_UPLOAD_H_
+
+#include "model_slot.h"
+#include "uart_frame.h"
+
+#define MODEL_UPLOAD_BEGIN          (0x01u)
+#define MODEL_UPLOAD_DATA           (0x02u)
+#define MODEL_UPLOAD_COMMIT         (0x03u)
+#define MODEL_UPLOAD_ACTIVATE       (0x04u)
+#define MODEL_UPLOAD_INFO           (0x05u)
+
+/* Largest data chunk of a DATA request. */
+#define MODEL_UPLOAD_MAX_CHUNK      (UART_FRAME_MAX_PAYLOAD - 4u)
+
+typedef void (*model_upload_send_t)(const uint8_t* data, size_t size);
+
+typedef struct {
+    model_slot_t* slot;
+    const tflite::MicroOpResolver* op_resolver;
+    const model_slot_tensors_t* tensors;
+    model_upload_send_t send;
+} model_upload_t;
+
+/* A model is committed only if op_resolver has all its operators and its
+ * input and output match tensors. */
+void model_upload_init(model_upload_t* upload, model_slot_t* slot, const tflite::MicroOpResolver* op_resolver,
+                       const model_slot_tensors_t* tensors, model_upload_send_t send);
+
+/* Answers a request decoded from the UART, BEGIN to INFO; other commands are
+ * ignored. Returns true once an ACTIVATE request has been accepted, which needs a
+ * valid model in the slot: the application then restarts, to boot with it. */
+bool model_upload_handle(model_upload_t* upload, uint8_t command, const uint8_t* payload, uint16_t length);
+
+#endif /* SRC_MODEL_UPLOAD_H_ */
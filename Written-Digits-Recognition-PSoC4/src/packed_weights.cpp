@@ -0,0 +1,373 @@
+/*
+ * packed_weights.cpp
+ *
+ *  Generated by tools/pack_weights.py, do not edit, from:
+ *  written-digit-recognition-cnn-v3.0-8bit.cc
+ *  digit-gatekeeper-8bit.cc
+ */
+
+#include "packed_weights.h"
+
+/* written-digit-recognition-cnn-v3.0-8bit.cc, operator 1 (CONV_2D), 16x9 */
+static const int32_t packed_weights_0[] = {
+  -5177442, 5767226, -8192127, 589951, -3473446, -655307, 5177303, 458866,
+  1048628, -8322993, -8322983, -589885, 5701649, -5111886, 2293852, 130962,
+  -7077851, 5308289, -1769599, 3211224, -7274571, 2818079, -8257612, -6815688,
+  4653059, 8388561, 7208960, 5963757, 7208931, 1638374, 393208, 6160257,
+  -655360, 2555831, -917504, 5373861, -393233, 786374, 655367, 4915163,
+  4194306, 5111863, -5898238, -3211350, -8257644, 2031595, -5177452, 6226047,
+  6815752, -8257611, 1835083, -6029309, -1769345, -1114040, 3801051, 5635969,
+  -2424719, -786406, -8257608, -5504985, 5570494, 6225945, 1310847, -655234,
+  -3211329, -4980711, 2162669, 131097, 1441914, -6815787, 851883, -8257572,
+  -2567, -30398, 13295, -83, -26551, -2031, -27857, 34386,
+  -2050, -12831, -3628, -262, -6188, 1273, -4354, -23628
+};
+
+/* written-digit-recognition-cnn-v3.0-8bit.cc, operator 2 (CONV_2D), 16x144 */
+static const int32_t packed_weights_1[] = {
+  1507326, -5046262, -3080156, 3670016, -262204, -3080234, 327668, -917530,
+  -2228172, -393217, 2031587, 458791, -786449, -196607, 589795, -2490409,
+  2293756, -3342328, 65503, 2031626, -2424779, 2555863, 851949, 3145729,
+  262179, 1376227, 262166, 4587479, -655383, -2752585, -131010, -3997712,
+  720894, -3735539, -3735613, 1441781, -393239, -1769528, 1900528, -2490332,
+  851913, -1376254, -1441776, -458771, 196608, -7, -1769481, 1376243,
+  3866655, -1245183, -1441800, 655364, -851954, 262166, -3473405, 2686938,
+  -589800, 1638410, -589818, 3932126, 1572865, 1114137, 1441787, -327639,
+  -7602168, -720868, -8257610, 3735440, 3735546, -2162651, 589807, 196589,
+  -2293887, -786444, -6356969, -720905, -655387, -1572899, -720907, -4784104,
+  -3407850, 2031620, -2097213, 458711, 1441808, -2228203, -1245173, -2752541,
+  2686981, 2555898, -1310748, 589812, -655351, -8323034, 3407884, 3211267,
+  -327701, -5308427, 655359, 4718579, 1179590, -1245192, -3342340, -2424874,
+  -1441777, -262124, 2293726, -1245178, 3211314, 2883600, 458716, 196579,
+  -983045, 1179645, 3080153, 2752526, -2883548, 917495, 3080187, 5832714,
+  -5177326, 2883522, 65519, 2621407, 851975, -5767177, -3538880, -589875,
+  -2424838, -851993, 1179663, 1310716, -524307, 786440, -3473418, -1179648,
+  524286, 3866635, 1245189, 1638391, -1572883, 196624, 0, -589819,
+  -1179650, -786453, 393224, 1835023, -6291453, 786435, -589833, 393231,
+  -4456457, 2293762, -917533, -131091, -1572835, -196587, -3014662, 2424837,
+  -589842, -9, 4063234, 2293751, 524296, -3342318, -393203, 3801084,
+  262122, 2686976, 589831, -2228213, -1966088, 983042, -4980738, -2359270,
+  2031578, -1507414, 1376267, -4063296, 917513, 1114120, -2293761, -6946812,
+  -3014659, -2555909, -458759, 786437, 720906, 4194341, 1048570, 3407874,
+  -4456469, -6291456, 1900560, -4128738, 196597, -2883587, 2031600, -2621455,
+  2621434, 655340, 982993, 1572872, 1769440, 6094850, -851991, -721004,
+  -1507342, -1638372, 1245135, 3735596, 131102, -3538970, 2621369, 1179677,
+  3342348, -4063264, -3342389, -1310828, -1441773, -7798796, -4128817, -6029439,
+  -6553633, -3604485, 5111827, 1507329, -2883592, 196616, -589820, -1703925,
+  458696, 589835, 720884, 1572850, 3014570, 4849681, 131070, -983068,
+  -5046310, 3670046, 1966043, -1900514, 720923, -4587537, 3801074, 983047,
+  2949137, -5111828, 1900576, -2424869, -5963777, 327679, 262161, -131056,
+  -2555936, -2162719, 4390928, -852010, -4456466, -262102, -2949145, -917504,
+  2359219, 2228211, 393195, -2687032, -917581, 851958, -1507357, -720922,
+  983030, 655378, 2752494, -3997710, -786417, -786434, -3932159, -2883598,
+  1638425, -2097150, 786440, -786456, -5963795, -2424812, 1114126, -262112,
+  -131054, 6684705, -1376303, -6488056, 1245106, 4390888, 786426, 5570491,
+  -1900546, -327616, 65497, -131051, -327705, -8323027, 65483, -1638424,
+  -851967, 2621459, -458785, -3276812, -393207, -2162730, 458731, -4063243,
+  1048559, -1376300, 1507265, -5701671, 524266, 1638405, 786501, 2359169,
+  262165, 2293781, 983044, 65560, 1703914, 4390920, -1441869, 3538958,
+  1966061, 458771, 917507, 2424857, -1441828, -1572856, 720914, -2424850,
+  720920, 1310733, 786437, 851993, -1638414, -5308434, -589848, 1572885,
+  -327669, -7995400, 524250, -2949116, -1048567, -1114128, -458745, -6750231,
+  -458806, -3211253, 589891, 3014679, -14, -5636128, -1835044, -5570569,
+  786437, -983020, 3276768, 3145717, 1703910, -5636113, -3, -1441808,
+  1703875, -2293756, 2818039, 5046283, -4849690, -7077893, 3276704, 2424815,
+  -2162666, -1310735, 3538986, 3801073, -3276830, -6357014, -3211281, -7929863,
+  -720890, 65560, -720904, -1114115, 1310654, 4128763, 655364, 4063228,
+  -2162642, -65518, 327682, 2490376, -458693, -3473409, -327672, 1638375,
+  -4390910, 2883586, -1900536, 1048590, -1179643, -393207, 327665, -327702,
+  786437, -2031616, 1114033, 2031598, 262137, 655391, -851990, -1376233,
+  -196608, 1179672, -917496, 1638404, 1572885, -1703940, 3145710, 2097147,
+  -917480, 3211281, -65522, 4587537, -2752512, -917508, 196628, -1114114,
+  -3407865, 2359312, -65587, -983027, 1769472, 1310706, -2621474, -65529,
+  1114106, 1900537, -786457, 458750, -1834993, -65549, 3342322, -2883602,
+  -1114148, -4718572, 786446, 4259850, -1114112, -2293763, -589792, -2621453,
+  -983005, 3211281, 655350, -2752502, -131080, 2424831, -1114111, -1900531,
+  327670, -327644, -720897, -1507339, 2883520, -1245183, 262017, 1310706,
+  -327690, 3014654, 1376270, 2097148, -262153, 196612, -786436, 983029,
+  -3080186, 1310725, -2883556, 2424842, 65548, -196611, 655398, -524294,
+  458808, -2424829, -8257597, 2621451, 786418, -1441819, -2162662, 524278,
+  -7077922, 786437, -1245206, -458762, 3211291, 2293760, 589785, 983026,
+  524323, 3670017, -2752552, 327690, -2818026, -2097152, 2228230, 983039,
+  -3276797, 393210, -2686988, 393238, 262148, 720889, 2228219, 3407885,
+  -393213, -2949098, -2818057, 1310742, 2555851, -2752509, -655326, -917508,
+  -1835046, 2555931, -2818059, -2490359, 2162734, 2097146, -196652, -2031585,
+  2228241, 1441790, -1376231, 1310712, 2883595, 786441, 3670037, 2031590,
+  -2228208, 2097165, 1441795, -589826, -786408, 786435, 2293779, 524291,
+  -1441779, -3211259, -1769458, -982990, 2752479, -3473427, -524266, -1441786,
+  -1507323, 1245221, 65564, -3801074, 1572885, 3473405, -1507430, -1703930,
+  524304, 2555878, 327682, -2293763, 3145685, -327675, 2424856, 1769394,
+  2162690, -851968, -458745, 1507310, 3342379, 2359238, 1638409, 3801047,
+  -3276927, -4259858, 1179695, 983035, -2162712, 1507304, -1441803, 524295,
+  1179681, -655345, 1703976, -589898, -1441829, 589872, 2162721, 1245136,
+  458755, 196618, 852004, 393265, 1900528, -983037, 1114101, -65504,
+  655360, -1048561, 1441764, 1572776, 1441805, 327646, -589811, 65556,
+  1900509, -1441854, 327687, -524310, 1900546, 458745, -1179640, -196645,
+  720913, -1245184, 1966079, 1376150, -131076, 2031671, 720879, 851953,
+  327672, 1179667, 1376254, 196601, 1966088, 1048562, 65552, 983080,
+  196609, 1179674, 524274, -2949182, 23, 1638402, -720907, 7,
+  1441754, -983167, -2162686, 1834997, -655339, 1245102, -1179630, -1048645,
+  -2228243, 1769494, -1048586, 2424772, 2097179, -851959, -2293744, 2490346,
+  1376250, -1179620, 1703915, -2424876, 196626, 2621470, 1703959, -393175,
+  1507372, -3145749, 393210, -393203, 2097181, -1179673, -786407, -851970,
+  -1703969, -1048588, 2752532, 786433, 65511, 524244, 327655, -131046,
+  2162703, -720904, 3080171, 1179629, -2228247, -655339, 3211265, 1179631,
+  -327691, 262137, -65559, 1179676, 1245217, -2097140, -1245193, -393198,
+  1834997, -1310738, 458762, 2228232, 3145727, 524280, -917495, -589814,
+  851937, -2490378, 1114104, 1048579, 1441785, 655343, -786445, -1572864,
+  -196648, -2490353, 1572864, 131080, 458744, 1507346, 1245168, 1048585,
+  655351, -65543, -327693, -1114117, 2031632, 1179672, 327646, -786436,
+  -2883641, 1310721, 2555919, -131111, 851966, 1834975, -786450, 2293722,
+  655358, -1704000, -1441802, -786378, -655348, 3669948, -2162675, -1835026,
+  -5832720, 1048600, -1703921, 458737, -2031600, -5832689, -1900548, 524294,
+  1507365, -655350, -851968, -1769471, 982977, 15, 1376247, 655354,
+  131081, 1048571, -39, -7012289, 655349, -196602, -196571, -720927,
+  -1310758, 2162720, 3014633, 1048582, -524310, 8388585, -3473427, -1245155,
+  -262132, 327690, 2228143, -4390855, -7602153, -2228213, 5046251, -720874,
+  -3211231, -6160369, -786475, -4456402, -4456433, -720870, -4521944, -1835052,
+  -655356, -1835006, -2883586, -5308401, -851978, 2424816, -1048563, 1310718,
+  131045, 196626, 1507312, -1900539, 4456414, 4653035, -4325405, -1048570,
+  4194313, 3080208, 2359238, 65542, -3538883, -1114126, 2228207, -393200,
+  -5111780, -3932157, -1572877, -2162680, -655366, -1638369, 131098, -12,
+  -2752515, 1900562, -2293728, -1966096, 655344, 196585, -2031632, 2752484,
+  -2097214, 655315, -4980764, 2097187, -196634, 3276797, -6750238, -720913,
+  -7798812, 720914, 1441779, 851984, -8323016, -524313, -3932177, -4718566,
+  -5570549, -1966084, -3735540, -2228190, -4718583, 1179627, 3276836, 3211218,
+  1835053, -3866685, 131098, 1048697, 2883457, 393222, 1900562, 2818044,
+  2687028, -2031619, 1376251, 1245175, 393204, 2686926, -7405645, 1114140,
+  655367, -3801133, -262119, -3080203, -851981, 1835040, -3145783, 1048581,
+  -4325414, 851978, -6946880, 1048612, -33, -1507335, -4522035, -196644,
+  1310719, -393297, 262156, -2293687, 1310652, 2424744, 5963806, 4456397,
+  196631, -3932150, 4390956, -1703954, 1703928, 1441759, -7077937, 1376273,
+  589800, -852056, 1114088, -851922, -3997710, 2424914, -131094, -327699,
+  -5832707, 720964, -4128770, 589874, -5046385, 3932089, -4325408, -1703924,
+  1179646, -1966090, 655376, -1507329, -3670039, 4194210, 196628, 3014640,
+  1441829, -5636025, 2162712, 4325344, 1376289, 5701599, -4784188, -851990,
+  1769511, 6225958, -917463, 2359271, -589861, 131109, -1638344, 3866497,
+  -3080182, 2031675, -3997687, 327694, -3211349, -1572915, -2818044, -3604407,
+  -720874, -3670013, 3342345, 65515, -2031609, -1114097, 2293772, 1048562,
+  1114136, -4915225, -2752534, -2490393, -2424817, 851994, -3014656, -327643,
+  -6160382, -4587551, -4653083, -3014692, 6553598, 393209, -2687006, 458738,
+  1310705, -4063211, 458752, 262119, -1310723, -1966032, 1179644, -1834997,
+  -524276, -5898305, 1769477, 1507323, -3145754, -1966067, 851930, -3145761,
+  -1703929, -7274539, -2031607, -2949146, -1376246, 2097159, -2818045, -589800,
+  -1966083, -1704022, -524286, 1376229, 3342348, 393234, 12, 1310727,
+  3866628, -196607, -983020, 1441823, 1376254, -1114137, 458732, 65561,
+  2818067, 4456429, -2097172, 2228220, 983028, -4063251, -5701703, 786489,
+  -1703918, -3604479, 1441816, 8323112, -917478, 4259860, 458758, -2228235,
+  3735573, 3997697, 3604491, 3670100, 131044, -6160484, 2555922, 5636063,
+  2424819, -2949186, 1966085, 1769502, 3276821, -524413, 3211268, -5570551,
+  -4980759, -2686875, -2621481, 589715, -3538952, -4325300, 196611, -5046200,
+  589807, -7274451, -8126463, 262195, 983072, -6553542, -458734, -1507388,
+  -5832710, 1441845, -2359279, 196619, 3932180, -327722, -196600, 1572827,
+  1179678, 6291367, 2162696, 1441703, -2883599, -1966071, 2293778, 4980700,
+  -8257551, -7012276, 1376218, 3473331, -3997709, -5898223, -3473473, -2490337,
+  -131113, -5439438, -65520, -1638455, 5177365, 65551, 1966094, 2424823,
+  -4784131, -1376249, 1114090, -1835103, 262108, 2097189, 3145717, 4128693,
+  1441766, 5439487, 327704, 4980691, 589825, -3145721, 655357, 983086,
+  -327687, -1376309, 2293701, 3932110, 30, -2818042, -3538966, 262153,
+  327646, -3473344, 4325391, 4194180, 2031611, -589756, 1245192, 1048563,
+  2621423, 3342221, 5308421, 589744, -2490391, -393170, 1966100, 1703902,
+  -1507356, -1900507, -131065, 2424801, 1048580, -3276844, -1507328, -3276789,
+  -132998, -130601, -130007, -114324, -113539, -55281, -2181, -46938,
+  -52700, -88890, -69956, -40559, -87236, -117679, -122528, -49487
+};
+
+/* written-digit-recognition-cnn-v3.0-8bit.cc, operator 3 (CONV_2D), 16x144 */
+static const int32_t packed_weights_2[] = {
+  -3538929, 4063163, -1114115, 8191939, 2490356, -393187, -393210, -851970,
+  -196620, -3932135, -1114123, -2228204, -196567, 1638500, 655329, 1376242,
+  2162746, -65480, 1507294, -1703914, 1376245, 5701659, -1835071, -2883563,
+  2555912, 131076, -458762, 524261, 1703937, 3014601, -720817, -2162710,
+  -1769422, -2686998, -1966044, 2162649, 4128784, -1966072, 1900509, -851961,
+  -4849636, -4194270, -589820, -458735, -2621409, 2752525, -4259869, 6684675,
+  2228213, -983049, -3538946, 393175, -1572859, 4718595, 4325355, -524246,
+  -2555904, -3211272, 393203, -1245188, -786429, 5767108, 1245309, 2752519,
+  917502, 1966072, -3407821, 2424798, 852020, -327698, 1114052, -4128745,
+  -4784135, -3014597, 4980746, -2424845, -1835003, 327629, -1310732, 5439405,
+  3276817, -3801068, -2555934, -2424879, 917482, 3538941, -3276864, -1441747,
+  3014696, -1638482, 8323072, -1441767, 2555983, 3932167, 458818, 5242886,
+  -1114155, -655350, -2687020, 5701614, 2031675, 131091, 327636, -3473352,
+  -2686986, -851980, 2949106, -131038, 2359275, -4063169, 1114064, 3145671,
+  -2097112, -3866539, -2293798, -4915231, -196634, 2424794, 2162711, -1048566,
+  1769461, -4063187, 4390937, -1900561, 65550, 2162696, -1769451, 6160374,
+  786417, -524271, -1310729, 1507326, -393172, -3014639, 1834898, -6750238,
+  -1179675, -917492, 3866585, -5963730, 2359256, -2424783, 1114059, 4390885,
+  -982991, -3997633, 458762, -4653077, -2228246, 851933, 4194316, 3538939,
+  131115, -2621466, -2162656, 1048548, 2293823, 3997674, -458775, 1703955,
+  1376290, -393212, -2162679, 720896, -1245214, -3538974, 2555889, -6488016,
+  -852093, 1245197, 2621392, -196624, -327736, -393203, -2621420, -2097196,
+  1310794, 1245157, 2097143, -2490395, -5046330, 3473423, -3407876, 1376266,
+  -1310711, 3014595, -1114062, -196589, 3473442, 3538945, 131004, -1835082,
+  2228289, 2555915, -589767, 2162713, -65521, -6422529, 4194285, -4718565,
+  -5046325, -3276807, -1769487, -8257560, -1310658, -4259872, 3276830, -2752533,
+  -3801030, 1048637, 1572882, 1114117, -65635, 327691, -2555971, 3735544,
+  -983078, -4653069, 6225954, -2424846, 1245205, 2883534, 4521988, -917505,
+  458809, 1310718, 327669, 4521934, -917590, -1310730, 3473372, -5111754,
+  65525, -2818037, -65574, -131047, 1703996, 196600, -589783, -1114113,
+  -3473369, 1507380, 4325422, -3801106, -3670107, 655379, -3866751, 1638409,
+  -1048617, 3080189, 3670092, -2621461, 2162734, 1638396, 1834936, -6619161,
+  -196526, -1245133, -5963785, 2097224, 655317, -1703934, -393268, -1900493,
+  -1114114, -3407889, -5242963, -5373975, -1834946, 3407874, 1048587, -5242862,
+  655382, 3014654, 5111893, 4784001, 458673, 1245154, -4456530, 1507359,
+  1114108, 5373912, 6357050, -3211291, 131078, 1769428, 655391, -327680,
+  -6029331, 851958, 65527, 1376278, 3670021, -2162683, -2228172, 3145705,
+  1834995, -2228180, 1376291, -262123, 2686992, -1376205, 4718520, 2686957,
+  2621510, -7209016, -2293802, 1703951, 2490351, 2621415, 2228125, 1114129,
+  655385, -3276776, 6684724, -196568, 851940, -2752523, -4128835, -2293794,
+  -3211255, 524226, 917510, 131092, 2883588, -5898300, -2883535, 3407890,
+  -2490335, -1114046, -1900515, 44, -393188, -262136, 983006, -655329,
+  -393178, -5767206, -5636072, 4128797, 3407905, 3735582, 4653047, 2097189,
+  196600, -983002, 3604447, -983016, 2228195, -1572885, -1114147, -2424838,
+  -2293781, 3080065, 2490369, 786471, 786457, -3080169, 1179678, -3735585,
+  1048605, 2883675, 1769515, 2228238, -1048536, 983016, -2555892, 1638395,
+  -3080204, -3801162, -6029189, 4194359, 3211290, 655396, 5308364, -2162638,
+  -2949147, -2031676, 2752468, -720902, 393175, -4456496, -1048541, 2883587,
+  -4587553, -4063192, 3211216, -786431, 5046282, -720892, -2490285, 458739,
+  2031617, 2752582, 393275, 3014683, 4521951, -2818047, -3538936, -983051,
+  1507357, -3604520, -1441842, -655330, -2228270, -1835067, 4259715, 4390837,
+  983007, 4390920, 4784154, -4653097, -1638459, -786432, 65530, -1966098,
+  -4456517, 3407918, -1114153, -1507342, -65464, -3014651, 327686, -2555884,
+  -1769458, 3866629, 3080225, 458738, 1834996, -393193, -2424810, -2097143,
+  2949105, -2424838, -2949132, -1900480, -3211257, -458772, 983031, -851975,
+  -1638420, -1048595, 2228162, -2949112, -3866659, 786382, 1245229, 196599,
+  327681, 917437, -2031624, 196580, -3276813, -2621404, -2883547, -3932165,
+  5504995, 2162733, 3670040, 720901, -2097146, -3735604, -4587522, -196623,
+  -4259876, -4259882, -3014575, 3604477, -1900528, 720931, -2162627, -6750193,
+  -5177337, -1703932, 8388598, -1900577, -3080260, -589854, -65526, 1900557,
+  -4128745, 2555937, -852074, 3473370, 2162727, -7667725, -327612, -2228212,
+  -1835035, -524198, -1114097, 1703948, -1114129, 1376260, 1179699, -1507335,
+  1769400, 2228193, -2490336, -458717, 5439518, 4063249, 3342238, 917483,
+  -2621448, 1638379, -327740, -4653047, -4849664, -2162685, 393261, 65523,
+  -2228168, 3014663, 1572784, 2293730, -3932157, -4653021, -1769480, 46,
+  -589769, 2687004, 3670038, 786396, 1048568, 786452, 1245243, -4653077,
+  2686918, 1376221, -3080129, 1638449, 720898, 4390983, -5373939, 2686987,
+  196607, -131041, 3342316, -4587579, -5177298, -196620, 262166, -524309,
+  -1965973, 1179649, -458788, 3473409, 262017, -4849629, 393263, 1245216,
+  2555916, -589797, -131084, 3276800, -2359310, -327722, -131060, 851950,
+  -1310791, -26, -4849613, 5898279, -720886, 8323172, 1048596, -1114081,
+  -4128766, 2097167, 3276819, -3866656, -3014689, -524297, -2687047, -655360,
+  3407883, 1834985, 5242937, -917459, 5177284, -3276739, 65597, -2031627,
+  -1900500, -131183, 327633, -1966184, 983014, -2555960, 131123, -2162638,
+  -32, 262132, -2752632, 720894, -1703883, 1572914, 4718667, -3211304,
+  3276801, -2228142, -2752594, -5963708, -1376271, 1572894, -2490411, -1441819,
+  -458702, 6291439, 4587562, 6684652, -1507273, -1834950, -3997666, -3997695,
+  -5177318, -1507404, -196572, 327691, -1114115, -917510, -1114067, -2818008,
+  -262180, 1310734, -1638405, -720959, -851954, 2359276, 1179758, -327683,
+  3866690, -327624, 1966001, -2162689, 1114063, 1900568, -3276853, 1507335,
+  -1048531, 3276781, -1310597, 7929798, -655338, 2490431, -1572830, -4259816,
+  -5308494, -2031611, -917465, 1310763, -1048516, 4915232, -720852, 393268,
+  -1179639, -2883578, 1638384, 4128759, -917510, 1966060, 720958, -2621452,
+  2228331, -2097127, 196654, -1310705, 2097059, 4980695, -1310817, 2883530,
+  3014677, 4522026, -1441721, 5505057, -3669998, -3276784, 524313, -3932184,
+  524303, -2031656, 1966048, -4718648, -5832674, 720890, 3604459, 2097198,
+  2097124, 720880, -917476, 262111, 2293723, -3473417, 66, 1900567,
+  -3145691, 3866646, -2555956, 2097156, 2621422, 2818146, 24, -655365,
+  2359360, 2687020, 458809, 5636041, -1114086, 458708, -3735556, -4128813,
+  262117, -1179644, 851998, -786420, -2883640, -917528, 1638408, -1638313,
+  -1507329, -1966030, -1441780, 3014663, 1966041, -983028, -917467, 1114117,
+  1900550, -1441782, -2621399, 3276812, 851906, 5308410, 851962, 655350,
+  524297, 3276825, 4325405, 7077872, -851959, -917517, 1835065, -5701590,
+  786334, 655392, 589866, 786386, -327636, 3211205, 1703978, -2949041,
+  -3145708, -1441786, 2424765, 1441821, 655341, -2949048, -1441860, -1507357,
+  5505062, -524256, 1310714, -1048501, 1441714, 262207, 983060, -786427,
+  -655303, 4194265, 3407981, 5701655, 5505075, -4063198, -2621368, -1441766,
+  786430, -1572836, -589827, -3407940, 1769528, 131123, 1441787, -720925,
+  -131114, 196579, -1638273, -2686942, -524309, 65476, -1048607, -196568,
+  1572858, 5963784, -262138, 18, 1376256, 393343, -3145726, 1769510,
+  2097207, 2883547, 4980801, 1179590, 6881282, 3538940, -1507308, -1703981,
+  -3473471, 3145766, 2818047, -1441833, 1638403, -1114088, 2949130, 1376281,
+  -917511, -655367, -1441680, -1572850, -2097150, 1966037, 3473356, 1310726,
+  2752520, 3211275, -3604422, -1769417, 851941, 786449, -2097120, -2293797,
+  3014648, 786434, 8388561, -3801074, 917482, 4390955, 1114168, -8323012,
+  -2752506, 2555871, 2817993, -2621491, 3604533, -1179656, 4521967, -1507319,
+  983045, 983016, -2883527, 1900525, -1835046, -2359352, 3407843, -2228189,
+  3801131, 2883590, 3145677, 458850, -655360, 1376286, -2555848, -3407922,
+  -3211294, -3014599, 2687034, -4784181, 262189, 589819, -7405576, -5636087,
+  6160397, 2949215, 917403, 1835059, -7274583, 5177368, 4653107, 458769,
+  -5898248, 2162729, -655314, 5570586, -851903, -4784133, -524317, 1769497,
+  4652977, 4128757, 7667707, 3211219, -4128744, -2752584, -393173, 524285,
+  -655389, -786434, 3014647, 917507, -1441771, 1310692, 262133, -131056,
+  393190, 1376305, 1769385, 1900516, -7274468, -3276804, 5046335, -2555903,
+  458749, -3670031, 786439, -262098, -2097124, 1114134, 4587468, 2031614,
+  786336, 2752486, 2818014, -917494, -6160310, 1048523, -7208872, 1834991,
+  524341, -327654, -1900550, -1245159, -4784115, 2818050, 3276782, -2228272,
+  1703904, 3538944, 2490354, -1441796, -2097098, -8323054, 6946802, -7208980,
+  -3145794, 3604448, -851932, -4325373, -3538937, 65501, -3670053, 589847,
+  -2359250, -982982, 1703906, 917427, -3669988, -327744, 851993, 1834991,
+  -1048611, -2162679, 262137, -4653094, 4587508, 3145714, -7209010, 1114169,
+  2228225, 2293833, 2621379, 3604503, -8192100, 2097168, 5308430, -2359272,
+  -720961, -262184, -393203, 196613, -2949089, -786502, 2162716, 3276793,
+  3932080, 2818035, -1572866, -1572932, -4128736, -2752493, 458783, 4718622,
+  786467, -1703919, -1703894, -655334, 2490359, 4194384, -1900598, -65553,
+  -131047, 1638376, 2031586, 3276708, -2162676, -2293795, 393200, -4194308,
+  -4259820, -851973, 851945, -1048531, -2686955, -4194322, 2883622, -1245197,
+  -524304, 2818095, 3932190, -1835102, -1703911, -3801048, -1048608, 131062,
+  2031645, -2490381, -131015, -2097187, 2817994, 3801205, 1310658, 1441888,
+  196610, 2359345, 4194341, -720873, 1769557, -1900535, -917516, -4063214,
+  -1572821, 786505, -1572912, 262037, -7012302, -3276801, -917492, -3604570,
+  983035, 851963, 2752482, -1048615, 852032, 589834, 1966035, -983041,
+  -393329, 2555930, -1900535, 1900594, 5701637, 5111811, -4915257, -786428,
+  65511, 5111752, 3080154, 2228220, -262177, -917544, 2424822, -851963,
+  2228268, -3932161, 1376278, 1114154, 4587493, 786397, -4587515, -2949109,
+  2621434, 852047, 7667707, -327807, 4194295, -2555931, 1441796, 4849732,
+  3538883, 1179697, -131042, 1900483, 4653044, 5963818, 4718534, -2817993,
+  -2818036, 720898, -1769475, 1572867, 3538927, -196607, 589836, -327673,
+  -2555861, -1835027, 458703, 4063181, 5767196, -6094857, 2424829, -5636079,
+  196627, 720919, -983066, 5963753, 3932182, -65507, -8257590, 2949130,
+  4390836, -3669994, 5636116, 786394, 2490359, 6029312, 4390836, -2555807,
+  -1966105, 3997661, 6160378, -1507293, 2359290, 1245137, -2031592, -3342338,
+  -5570540, -720930, -196735, 2883518, 47, -4784065, 5505019, 458767,
+  -524284, 1703990, -3670088, 5177321, -1507288, -2424869, -6356922, -1834981,
+  -16629, 24058, -26309, -68913, -8089, -53896, 33790, -63339,
+  145572, 81890, 81983, 30226, -71292, 41196, 13824, 2376
+};
+
+/* digit-gatekeeper-8bit.cc, operator 2 (FULLY_CONNECTED), 8x49 */
+static const int32_t packed_weights_3[] = {
+  655340, -786423, 524268, -262136, -524298, 1572861, -327721, -1376294,
+  589805, 589785, 1245185, -851947, 1114104, 196595, 655354, -655336,
+  -31, 1638422, 655334, 2883529, 1245213, -2752566, 393237, 1572839,
+  -196593, 1310724, -851994, -1179664, -1441820, 65575, -1703973, -655329,
+  2097075, 655392, -1835076, -4194367, -1835042, 1441710, 851924, -589888,
+  -131115, 196610, -1835039, -1048546, 1507315, -786399, 196619, -2621422,
+  -1245246, -1966175, 1114095, 2097104, 1703987, -2228249, 1048608, -917495,
+  -393274, -1769411, -262144, 2031684, -2621530, 4784168, 589787, -8257584,
+  -2752493, 3276786, -65561, 1900510, -327719, -589831, 327656, -524251,
+  -1703873, 131092, 1310824, 2687003, 917582, -2883588, 1310714, 2162658,
+  65529, -524348, -458783, -1245182, 786447, 720891, 458803, 1310676,
+  262206, -720871, -589785, 720967, -524299, -851945, 196597, -262158,
+  524288, -851977, 131051, 196603, 327665, 524271, -917518, -327718,
+  3670024, 65561, 524296, -589822, -851975, 65544, -786440, -262157,
+  524282, 786422, -1048603, -1703973, -1048626, -4980787, 2752527, -5046214,
+  1441795, -1376262, 1900512, -65518, 589821, -786425, 262113, -983055,
+  -3670020, -1114066, -2818006, -1114111, -2490366, -6094812, -1376221, -2490391,
+  720924, -1966068, 786420, 1966090, 458781, 1245187, -1376260, 589797,
+  -4653111, -2687022, -2687062, -1507346, -131119, -917581, -786490, 6094833,
+  1834978, 2162682, -393239, 1966067, 131079, -2228244, -3342226, 1966095,
+  -5701578, 5046305, -327660, 4063205, 655400, 2424821, 655348, 2162691,
+  -196611, 917506, -917537, -262126, -2949196, 4718658, -3801154, 3997751,
+  -3669991, 3801023, 131089, 2228251, 65539, -393204, 1376276, -1245187,
+  -327692, -2621460, -2424812, 1769427, -2883551, -458751, -786417, 589796,
+  1835013, 2490372, -393217, -524288, -10343, 782, -8492, -13285,
+  -24352, -40910, -15320, 19186
+};
+
+/* digit-gatekeeper-8bit.cc, operator 3 (FULLY_CONNECTED), 1x8 */
+static const int32_t packed_weights_4[] = {
+  83, 0, 47, 0, 65431, 0, 98, 0,
+  112, 0, 65409, 0, 64, 0, 65454, 0,
+  8244, 0, 0, 0
+};
+
+static const tflite::PackedWeightsEntry packed_weights_entries[] = {
+  {0x290e9db3u, 16, 9, packed_weights_0, nullptr, 0},
+  {0xed13026cu, 16, 144, packed_weights_1, nullptr, 0},
+  {0xb8d9bd95u, 16, 144, packed_weights_2, nullptr, 0},
+  {0xf2cca534u, 8, 49, packed_weights_3, nullptr, 0},
+  {0x5a1097cfu, 1, 8, packed_weights_4, nullptr, 0},
+};
+
+const tflite::PackedWeightsTable packed_weights = {
+  packed_weights_entries, 5
+};
@@ -0,0 +1,18 @@
+/*
+ * packed_weights.h
+ *
+ *  Generated by tools/pack_weights.py, do not edit, from:
+ *  written-digit-recognition-cnn-v3.0-8bit.cc
+ *  digit-gatekeeper-8bit.cc
+ *  Weights packed for the Cortex-M0+ kernels, see
+ *  MicroInterpreter::SetPackedWeights.
+ */
+
+#ifndef SRC_PACKED_WEIGHTS_H_
+#define SRC_PACKED_WEIGHTS_H_
+
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+
+extern const tflite::PackedWeightsTable packed_weights;
+
+#endif /* SRC_PACKED_WEIGHTS_H_ */
@@ -0,0 +1,17 @@
+/*
+ * patch_config.h
+ *
+ *  Generated by tools/patch_tile_planner.py from
+ *  written-digit-recognition-cnn-v3.0-8bit.cc, do not edit.
+ *  Estimated activation peak: 4704 bytes, MAC overhead: 34.8%.
+ *  Set PATCH_NUM_LAYERS to 0 to disable patch based execution.
+ */
+
+#ifndef SRC_PATCH_CONFIG_H_
+#define SRC_PATCH_CONFIG_H_
+
+#define PATCH_NUM_LAYERS 4
+#define PATCH_TILE_HEIGHT 2
+#define PATCH_TILE_WIDTH 4
+
+#endif /* SRC_PATCH_CONFIG_H_ */
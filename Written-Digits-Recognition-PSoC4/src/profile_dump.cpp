@@ -0,0 +1,60 @@
+/*
+ * profile_dump.cpp
+ *
+ *  Command handler of the profile read out, see profile_dump.h.
+ */
+
+#include "profile_dump.h"
+
+static_assert(1u + tflite::MicroAggregateProfiler::kMaxRecordSize <= UART_FRAME_MAX_PAYLOAD,
+              "a profile record has to fit in a frame");
+
+
+static void reply(profile_dump_t* dump, uint8_t command, uint8_t* payload, uint16_t length)
+{
+    /*Static, to keep the frame off the small stack*/
+    static uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+
+    dump->send(frame, uart_frame_encode(command | UART_FRAME_REPLY, payload, length, frame));
+}
+
+
+void profile_dump_init(profile_dump_t* dump, tflite::MicroAggregateProfiler* profiler,
+                       profile_dump_send_t send)
+{
+    dump->profiler = profiler;
+    dump->send = send;
+}
+
+
+/*******************************************************************************
+* Function Name: profile_dump_handle
+********************************************************************************
+* Summary:
+*  Answers a request from the profiler. Other commands are ignored.
+*
+*******************************************************************************/
+void profile_dump_handle(profile_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length)
+{
+    static uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+    size_t size;
+
+    switch (command) {
+    case PROFILE_DUMP_READ:
+        size = 0;
+        if (length == 1) {
+            size = dump->profiler->SerializeRecord(request[0], payload + 1,
+                                                   sizeof(payload) - 1);
+        }
+        payload[0] = size != 0 ? PROFILE_DUMP_OK : PROFILE_DUMP_ERROR;
+        reply(dump, command, payload, (uint16_t)(1 + size));
+        break;
+    case PROFILE_DUMP_CLEAR:
+        dump->profiler->ClearEvents();
+        payload[0] = PROFILE_DUMP_OK;
+        reply(dump, command, payload, 1);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * profile_dump.h
+ *
+ *  Read out of the statistics of a tflite::MicroAggregateProfiler over the
+ *  UART, with the binary frames of uart_frame.h. Requests and the payload of
+ *  their replies:
+ *
+ *    READ     record index (1)  -> status (1), record
+ *    CLEAR                      -> status (1)
+ *
+ *  The records are those of MicroAggregateProfiler::SerializeRecord: index 0
+ *  is the summary, which gives the number of tag records that follow. The
+ *  status is PROFILE_DUMP_OK, or PROFILE_DUMP_ERROR for a missing record or
+ *  a request of the wrong size. The host side is tools/profile_report.py.
+ */
+
+#ifndef SRC_PROFILE_DUMP_H_
+#define SRC_PROFILE_DUMP_H_
+
+#include "uart_frame.h"
+#include "tensorflow/lite/micro/micro_aggregate_profiler.h"
+
+#define PROFILE_DUMP_READ           (0x10u)
+#define PROFILE_DUMP_CLEAR          (0x11u)
+
+#define PROFILE_DUMP_OK             (0u)
+#define PROFILE_DUMP_ERROR          (1u)
+
+typedef void (*profile_dump_send_t)(const uint8_t* data, size_t size);
+
+typedef struct {
+    tflite::MicroAggregateProfiler* profiler;
+    profile_dump_send_t send;
+} profile_dump_t;
+
+void profile_dump_init(profile_dump_t* dump, tflite::MicroAggregateProfiler* profiler,
+                       profile_dump_send_t send);
+
+/* Answers a request decoded from the UART, READ or CLEAR; other commands are ignored. */
+void profile_dump_handle(profile_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length);
+
+#endif /* SRC_PROFILE_DUMP_H_ */
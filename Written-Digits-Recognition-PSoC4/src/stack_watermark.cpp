@@ -0,0 +1,28 @@
+/*
+ * stack_watermark.cpp
+ *
+ *  Stack painting and high-water scan, see stack_watermark.h.
+ */
+
+#include "stack_watermark.h"
+
+
+void stack_watermark_paint(uint32_t* low, uint32_t* high)
+{
+    /*Volatile, so that the stores are not turned into a memset call that would run on the
+     * memory being painted*/
+    for (volatile uint32_t* word = low; word < high; word++) {
+        *word = STACK_WATERMARK_PAINT;
+    }
+}
+
+
+const uint32_t* stack_watermark_deepest(const uint32_t* low, const uint32_t* high)
+{
+    const uint32_t* word = low;
+
+    while (word < high && *word == STACK_WATERMARK_PAINT) {
+        word++;
+    }
+    return word;
+}
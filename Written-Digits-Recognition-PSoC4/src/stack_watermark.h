@@ -0,0 +1,35 @@
+/*
+ * stack_watermark.h
+ *
+ *  Stack painting: the free memory below the stack is filled with
+ *  STACK_WATERMARK_PAINT, and the deepest point the stack has reached since is
+ *  found as the lowest word that no longer holds it. The scan starts from the
+ *  far end of the painted region, so it is not fooled by a deeper stack frame
+ *  that left some of its words untouched.
+ *
+ *  Only the region bounds are target specific, see stack_watermark_psoc4.h.
+ *  The host build runs the same scan on a stack it allocates itself.
+ */
+
+#ifndef SRC_STACK_WATERMARK_H_
+#define SRC_STACK_WATERMARK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STACK_WATERMARK_PAINT       (0x5A7AC4E5u)
+
+typedef struct {
+    uint32_t used;      /*Bytes below the top of the stack at its deepest point*/
+    uint32_t headroom;  /*Bytes still painted below that point*/
+    uint32_t reserved;  /*Bytes reserved for the stack by the linker script*/
+} stack_usage_t;
+
+/* Fills [low, high) with STACK_WATERMARK_PAINT. */
+void stack_watermark_paint(uint32_t* low, uint32_t* high);
+
+/* Returns the lowest word of [low, high) that no longer holds the paint, or
+ * high if all of them do, scanning upwards from low. */
+const uint32_t* stack_watermark_deepest(const uint32_t* low, const uint32_t* high);
+
+#endif /* SRC_STACK_WATERMARK_H_ */
@@ -0,0 +1,58 @@
+/*
+ * stack_watermark_psoc4.cpp
+ *
+ *  Stack painting bounds of the PSoC 4 application, see
+ *  stack_watermark_psoc4.h.
+ */
+
+/*******************************************************************************
+ * Include header files
+ ******************************************************************************/
+#include <unistd.h>
+
+#include "cy_pdl.h"
+
+#include "stack_watermark_psoc4.h"
+
+
+/*Words left unpainted below the stack pointer, for the frames of the painting itself*/
+#define STACK_WATERMARK_MARGIN      (16u)
+
+/*Linker script symbols*/
+extern "C" uint32_t __StackLimit[];
+extern "C" uint32_t __StackTop[];
+
+
+/* Current end of the heap, word aligned. */
+static uint32_t* heap_end(void)
+{
+    const uintptr_t end = (uintptr_t)sbrk(0);
+
+    return (uint32_t*)((end + 3u) & ~(uintptr_t)3u);
+}
+
+
+void stack_watermark_psoc4_init(void)
+{
+    stack_watermark_paint(heap_end(), (uint32_t*)(uintptr_t)__get_MSP() - STACK_WATERMARK_MARGIN);
+}
+
+
+/*******************************************************************************
+* Function Name: stack_watermark_psoc4_read
+********************************************************************************
+* Summary:
+*  Scans the painted RAM from the end of the heap upwards. The stack has
+*  reached the first word that lost the paint; a used size above the reserved
+*  one means that the stack overran its section into the heap RAM.
+*
+*******************************************************************************/
+void stack_watermark_psoc4_read(stack_usage_t* usage)
+{
+    const uint32_t* low = heap_end();
+    const uint32_t* deepest = stack_watermark_deepest(low, __StackTop);
+
+    usage->used = (uint32_t)((uintptr_t)__StackTop - (uintptr_t)deepest);
+    usage->headroom = (uint32_t)((uintptr_t)deepest - (uintptr_t)low);
+    usage->reserved = (uint32_t)((uintptr_t)__StackTop - (uintptr_t)__StackLimit);
+}
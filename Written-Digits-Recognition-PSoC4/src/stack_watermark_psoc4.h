@@ -0,0 +1,25 @@
+/*
+ * stack_watermark_psoc4.h
+ *
+ *  Stack high-water mark of the PSoC 4 application. The linker script
+ *  reserves __STACK_SIZE (1 KB) at the end of RAM for the stack, but main()
+ *  keeps the tensor arena and the interpreters on it, so the stack runs down
+ *  into the RAM the linker leaves to the heap. The whole free RAM between
+ *  the end of the heap and the stack is painted, and the headroom is what is
+ *  left of it between the heap and the deepest point of the stack.
+ */
+
+#ifndef SRC_STACK_WATERMARK_PSOC4_H_
+#define SRC_STACK_WATERMARK_PSOC4_H_
+
+#include "stack_watermark.h"
+
+/* Paints the free RAM up to just below the frame of the caller. To be called
+ * first thing in main(), before the interrupts are enabled. */
+void stack_watermark_psoc4_init(void);
+
+/* Measures the stack usage so far. The heap may have grown into the painted
+ * RAM since it was painted, so the scan starts at its current end. */
+void stack_watermark_psoc4_read(stack_usage_t* usage);
+
+#endif /* SRC_STACK_WATERMARK_PSOC4_H_ */
@@ -0,0 +1,46 @@
+/*
+ * trace.h
+ *
+ *  Latency trace hooks of the application stages. With TRACE_OUTPUT set in
+ *  config.h they add begin, end and instant events to trace_profiler, a
+ *  tflite::MicroTraceProfiler that the interpreters also get for their
+ *  operators; otherwise they compile to nothing, arguments included. The
+ *  tags are string literals:
+ *
+ *    TRACE_BEGIN("STAGE");  ...  TRACE_END("STAGE");
+ *
+ *  The begin and the end may be in different functions. The trace is read
+ *  out by trace_dump.h.
+ */
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#include "config.h"
+
+#if TRACE_OUTPUT
+
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/micro/micro_trace_profiler.h"
+
+/*Defined in main.cpp*/
+extern tflite::MicroTraceProfiler trace_profiler;
+
+#define TRACE_BEGIN(tag)    ((void)trace_profiler.BeginEvent(tag))
+#define TRACE_END(tag)      (trace_profiler.EndEventOf(tag))
+#define TRACE_INSTANT(tag)  (trace_profiler.InstantEvent(tag))
+
+/*The SysTick ticks of the Cortex-M0+ only count the periods they are read in, see
+ * cortex_m_generic/micro_time.cc, so the main loop reads them while nothing is traced*/
+#define TRACE_KEEP_TIME()   ((void)tflite::GetCurrentTimeTicks())
+
+#else
+
+#define TRACE_BEGIN(tag)    ((void)0)
+#define TRACE_END(tag)      ((void)0)
+#define TRACE_INSTANT(tag)  ((void)0)
+#define TRACE_KEEP_TIME()   ((void)0)
+
+#endif
+
+#endif /* SRC_TRACE_H_ */
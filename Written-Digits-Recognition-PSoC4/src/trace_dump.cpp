@@ -0,0 +1,62 @@
+/*
+ * trace_dump.cpp
+ *
+ *  Command handler of the trace read out, see trace_dump.h.
+ */
+
+#include "trace_dump.h"
+
+static_assert(1u + tflite::MicroTraceProfiler::kMaxRecordSize <= UART_FRAME_MAX_PAYLOAD,
+              "a trace record has to fit in a frame");
+static_assert(tflite::MicroTraceProfiler::kMaxTags +
+                  tflite::MicroTraceProfiler::kMaxEvents / tflite::MicroTraceProfiler::kRecordEvents + 2 <= 256,
+              "the record index of a request has 8 bits");
+
+
+static void reply(trace_dump_t* dump, uint8_t command, uint8_t* payload, uint16_t length)
+{
+    /*Static, to keep the frame off the small stack*/
+    static uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+
+    dump->send(frame, uart_frame_encode(command | UART_FRAME_REPLY, payload, length, frame));
+}
+
+
+void trace_dump_init(trace_dump_t* dump, tflite::MicroTraceProfiler* profiler, trace_dump_send_t send)
+{
+    dump->profiler = profiler;
+    dump->send = send;
+}
+
+
+/*******************************************************************************
+* Function Name: trace_dump_handle
+********************************************************************************
+* Summary:
+*  Answers a request from the trace profiler. Other commands are ignored.
+*
+*******************************************************************************/
+void trace_dump_handle(trace_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length)
+{
+    static uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+    size_t size;
+
+    switch (command) {
+    case TRACE_DUMP_READ:
+        size = 0;
+        if (length == 1) {
+            size = dump->profiler->SerializeRecord(request[0], payload + 1,
+                                                   sizeof(payload) - 1);
+        }
+        payload[0] = size != 0 ? TRACE_DUMP_OK : TRACE_DUMP_ERROR;
+        reply(dump, command, payload, (uint16_t)(1 + size));
+        break;
+    case TRACE_DUMP_CLEAR:
+        dump->profiler->ClearEvents();
+        payload[0] = TRACE_DUMP_OK;
+        reply(dump, command, payload, 1);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * trace_dump.h
+ *
+ *  Read out of the events of a tflite::MicroTraceProfiler over the UART, with
+ *  the binary frames of uart_frame.h. Requests and the payload of their
+ *  replies:
+ *
+ *    READ     record index (1)  -> status (1), record
+ *    CLEAR                      -> status (1)
+ *
+ *  The records are those of MicroTraceProfiler::SerializeRecord: index 0 is
+ *  the summary, which gives the number of tags and of events, and so of the
+ *  records that follow. The status is TRACE_DUMP_OK, or TRACE_DUMP_ERROR for
+ *  a missing record or a request of the wrong size. The host side is
+ *  tools/trace_to_chrome.py.
+ */
+
+#ifndef SRC_TRACE_DUMP_H_
+#define SRC_TRACE_DUMP_H_
+
+#include "uart_frame.h"
+#include "tensorflow/lite/micro/micro_trace_profiler.h"
+
+#define TRACE_DUMP_READ             (0x14u)
+#define TRACE_DUMP_CLEAR            (0x15u)
+
+#define TRACE_DUMP_OK               (0u)
+#define TRACE_DUMP_ERROR            (1u)
+
+typedef void (*trace_dump_send_t)(const uint8_t* data, size_t size);
+
+typedef struct {
+    tflite::MicroTraceProfiler* profiler;
+    trace_dump_send_t send;
+} trace_dump_t;
+
+void trace_dump_init(trace_dump_t* dump, tflite::MicroTraceProfiler* profiler, trace_dump_send_t send);
+
+/* Answers a request decoded from the UART, READ or CLEAR; other commands are ignored. */
+void trace_dump_handle(trace_dump_t* dump, uint8_t command, const uint8_t* request, uint16_t length);
+
+#endif /* SRC_TRACE_DUMP_H_ */
@@ -0,0 +1,120 @@
+/*
+ * uart_frame.cpp
+ *
+ *  Encoder and decoder of the binary UART frames, see uart_frame.h.
+ */
+
+#include "uart_frame.h"
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+enum {
+    STATE_SYNC0,
+    STATE_SYNC1,
+    STATE_COMMAND,
+    STATE_LENGTH0,
+    STATE_LENGTH1,
+    STATE_PAYLOAD,
+    STATE_CRC0,
+    STATE_CRC1,
+};
+
+
+/*******************************************************************************
+* Function Name: uart_frame_crc16
+********************************************************************************
+* Summary:
+*  CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), bitwise to
+*  keep the flash footprint small.
+*
+*******************************************************************************/
+uint16_t uart_frame_crc16(uint16_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void uart_frame_decoder_init(uart_frame_decoder_t* decoder)
+{
+    decoder->state = STATE_SYNC0;
+}
+
+/*******************************************************************************
+* Function Name: uart_frame_decode
+********************************************************************************
+* Summary:
+*  Byte by byte frame decoder. A frame with a bad CRC or a too long payload is
+*  dropped and the decoder looks for the next sync pattern.
+*
+*******************************************************************************/
+bool uart_frame_decode(uart_frame_decoder_t* decoder, uint8_t byte)
+{
+    switch (decoder->state) {
+    case STATE_SYNC0:
+        if (byte == UART_FRAME_SYNC0) {
+            decoder->state = STATE_SYNC1;
+        }
+        return false;
+    case STATE_SYNC1:
+        decoder->state = (byte == UART_FRAME_SYNC1) ? STATE_COMMAND :
+                         (byte == UART_FRAME_SYNC0) ? STATE_SYNC1 : STATE_SYNC0;
+        return false;
+    case STATE_COMMAND:
+        decoder->command = byte;
+        decoder->crc = uart_frame_crc16(0xFFFFu, &byte, 1);
+        decoder->state = STATE_LENGTH0;
+        return false;
+    case STATE_LENGTH0:
+        decoder->length = byte;
+        decoder->crc = uart_frame_crc16(decoder->crc, &byte, 1);
+        decoder->state = STATE_LENGTH1;
+        return false;
+    case STATE_LENGTH1:
+        decoder->length |= (uint16_t)(byte << 8);
+        decoder->crc = uart_frame_crc16(decoder->crc, &byte, 1);
+        decoder->received = 0;
+        if (decoder->length > UART_FRAME_MAX_PAYLOAD) {
+            decoder->state = STATE_SYNC0;
+        } else {
+            decoder->state = (decoder->length == 0) ? STATE_CRC0 : STATE_PAYLOAD;
+        }
+        return false;
+    case STATE_PAYLOAD:
+        decoder->payload[decoder->received++] = byte;
+        decoder->crc = uart_frame_crc16(decoder->crc, &byte, 1);
+        if (decoder->received == decoder->length) {
+            decoder->state = STATE_CRC0;
+        }
+        return false;
+    case STATE_CRC0:
+        decoder->crc ^= byte;
+        decoder->state = STATE_CRC1;
+        return false;
+    default:
+        decoder->crc ^= (uint16_t)(byte << 8);
+        decoder->state = STATE_SYNC0;
+        return decoder->crc == 0;
+    }
+}
+
+size_t uart_frame_encode(uint8_t command, const uint8_t* payload, uint16_t length, uint8_t* out)
+{
+    out[0] = UART_FRAME_SYNC0;
+    out[1] = UART_FRAME_SYNC1;
+    out[2] = command;
+    out[3] = (uint8_t)(length & 0xFFu);
+    out[4] = (uint8_t)(length >> 8);
+    for (uint16_t i = 0; i < length; i++) {
+        out[5 + i] = payload[i];
+    }
+    uint16_t crc = uart_frame_crc16(0xFFFFu, &out[2], length + 3u);
+    out[5 + length] = (uint8_t)(crc & 0xFFu);
+    out[6 + length] = (uint8_t)(crc >> 8);
+    return length + UART_FRAME_OVERHEAD;
+}
@@ -0,0 +1,48 @@
+/*
+ * uart_frame.h
+ *
+ *  Binary frames exchanged over the UART, next to the text output of the
+ *  application:
+ *
+ *    0xA5 0x5A | command (1) | length (2, LE) | payload (length) | CRC (2, LE)
+ *
+ *  The CRC is the CRC-16/CCITT-FALSE of the command, length and payload bytes.
+ *  Replies use the command of the request with UART_FRAME_REPLY set.
+ */
+
+#ifndef SRC_UART_FRAME_H_
+#define SRC_UART_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UART_FRAME_SYNC0            (0xA5u)
+#define UART_FRAME_SYNC1            (0x5Au)
+#define UART_FRAME_REPLY            (0x80u)
+#define UART_FRAME_MAX_PAYLOAD      (136u)
+#define UART_FRAME_OVERHEAD         (7u)
+
+typedef struct {
+    uint8_t state;
+    uint8_t command;
+    uint16_t length;
+    uint16_t received;
+    uint16_t crc;
+    uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+} uart_frame_decoder_t;
+
+uint16_t uart_frame_crc16(uint16_t crc, const uint8_t* data, size_t size);
+
+void uart_frame_decoder_init(uart_frame_decoder_t* decoder);
+
+/* Feeds one received byte to the decoder. Returns true when it completes a
+ * frame with a valid CRC, whose command and payload are then held by the
+ * decoder until the next call. Anything that is not a valid frame (e.g. text
+ * output) is skipped. */
+bool uart_frame_decode(uart_frame_decoder_t* decoder, uint8_t byte);
+
+/* Writes a frame to out, which must hold length + UART_FRAME_OVERHEAD bytes,
+ * and returns its size. */
+size_t uart_frame_encode(uint8_t command, const uint8_t* payload, uint16_t length, uint8_t* out);
+
+#endif /* SRC_UART_FRAME_H_ */
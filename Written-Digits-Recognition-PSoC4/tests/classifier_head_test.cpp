@@ -0,0 +1,424 @@
+/*
+ * classifier_head_test.cpp
+ *
+ *  Fused classifier heads of kernels/cmsis_nn/classifier_head.cc against the
+ *  MEAN, FULLY_CONNECTED and SOFTMAX they replace, on heads built for the
+ *  test with random weights, several numbers of classes and logit scales.
+ *  The softmax head has to give the output of the three operators byte for
+ *  byte. The argmax head has to report the lowest index of the largest
+ *  logit, and only where the softmax output there, as arm_softmax_s8
+ *  computes it, reaches the confidence threshold.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "host_test.h"
+#include "model_builder.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define ARENA_SIZE                  (16 * 1024)
+#define RANDOM_INPUTS               (300)
+#define INPUT_SIZE                  (3)
+#define INPUT_DEPTH                 (8)
+#define INPUT_SCALE                 (0.1f)
+#define MEAN_SCALE                  (0.05f)
+#define WEIGHTS_SCALE               (0.01f)
+/*Step of the threshold sweep, which also takes both ends of the int8 range*/
+#define THRESHOLD_STEP              (7)
+
+typedef struct {
+    const char* name;
+    int classes;
+    /*Scale of the logits, the input of the softmax*/
+    float logit_scale;
+    /*Copy of the weights and bias of class duplicate_of into class duplicate, -1 for none*/
+    int duplicate;
+    int duplicate_of;
+    /*Logits chosen through a 1x1 input and identity weights, rather than random*/
+    bool direct_logits;
+} head_case_t;
+
+typedef struct {
+    /*Height and width, depth and quantization of the input*/
+    int size;
+    int depth;
+    float input_scale;
+    float mean_scale;
+    float weights_scale;
+    std::vector<int8_t> weights;
+    std::vector<int32_t> bias;
+    std::vector<std::vector<int8_t>> inputs;
+} head_data_t;
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+
+
+/*******************************************************************************
+* Function Name: direct_head
+********************************************************************************
+* Summary:
+*  Head whose logits are its 1x1 input: the weights are the identity and
+*  every scale is the logit scale. The inputs give the largest logit every
+*  margin over the second one, from a tie to the whole int8 range, with the
+*  other logits at the lowest value, at the second one or in between.
+*
+*******************************************************************************/
+static head_data_t direct_head(const head_case_t* head_case)
+{
+    head_data_t data;
+
+    data.size = 1;
+    data.depth = head_case->classes;
+    data.input_scale = head_case->logit_scale;
+    data.mean_scale = head_case->logit_scale;
+    data.weights_scale = 1.0f / 127.0f;
+    data.weights.assign(head_case->classes * head_case->classes, 0);
+    for (int i = 0; i < head_case->classes; i++) {
+        data.weights[i * head_case->classes + i] = 127;
+    }
+    data.bias.assign(head_case->classes, 0);
+
+    for (int margin = 0; margin < 256; margin++) {
+        for (int others = 0; others < 3; others++) {
+            const int largest = host_test_random(margin - 128, 127);
+            const int second = largest - margin;
+            const int arg_max = host_test_random(0, head_case->classes - 1);
+            const int arg_second = (arg_max + host_test_random(1, head_case->classes - 1)) % head_case->classes;
+            std::vector<int8_t> input(head_case->classes);
+            for (int i = 0; i < head_case->classes; i++) {
+                input[i] = (int8_t)(others == 0 ? -128 : others == 1 ? second : host_test_random(-128, second));
+            }
+            input[arg_second] = (int8_t)second;
+            input[arg_max] = (int8_t)largest;
+            data.inputs.push_back(input);
+        }
+    }
+    return data;
+}
+
+
+/*******************************************************************************
+* Function Name: random_head
+********************************************************************************
+* Summary:
+*  Random weights, biases and inputs of a head. A duplicated class gets the
+*  weights of another one and a larger bias than the others, so that the two
+*  tie for the largest logit on most inputs.
+*
+*******************************************************************************/
+static head_data_t random_head(const head_case_t* head_case)
+{
+    head_data_t data;
+
+    if (head_case->direct_logits) {
+        return direct_head(head_case);
+    }
+    data.size = INPUT_SIZE;
+    data.depth = INPUT_DEPTH;
+    data.input_scale = INPUT_SCALE;
+    data.mean_scale = MEAN_SCALE;
+    data.weights_scale = WEIGHTS_SCALE;
+    for (int i = 0; i < head_case->classes * INPUT_DEPTH; i++) {
+        data.weights.push_back((int8_t)host_test_random(-127, 127));
+    }
+    for (int i = 0; i < head_case->classes; i++) {
+        data.bias.push_back(host_test_random(-2000, 2000));
+    }
+    if (head_case->duplicate >= 0) {
+        memcpy(&data.weights[head_case->duplicate * INPUT_DEPTH], &data.weights[head_case->duplicate_of * INPUT_DEPTH],
+               INPUT_DEPTH);
+        data.bias[head_case->duplicate_of] = 20000;
+        data.bias[head_case->duplicate] = 20000;
+    }
+    for (int i = 0; i < RANDOM_INPUTS; i++) {
+        std::vector<int8_t> input;
+        for (int j = 0; j < INPUT_SIZE * INPUT_SIZE * INPUT_DEPTH; j++) {
+            input.push_back((int8_t)host_test_random(-128, 127));
+        }
+        data.inputs.push_back(input);
+    }
+    return data;
+}
+
+
+/*******************************************************************************
+* Function Name: build_head
+********************************************************************************
+* Summary:
+*  MEAN over the height and width, FULLY_CONNECTED to the logits and, if
+*  softmax is set, SOFTMAX, all int8, as in the CNN of models/. Without the
+*  softmax the model outputs the logits.
+*
+*******************************************************************************/
+static const tflite::Model* build_head(host_test_model_t* model, const head_case_t* head_case,
+                                       const head_data_t* data, bool softmax)
+{
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+
+    const int input = host_test_model_tensor(model, {1, data->size, data->size, data->depth},
+                                             tflite::TensorType_INT8, data->input_scale, 0);
+    const int axis = host_test_model_constant(model, {2}, tflite::TensorType_INT32, {1.0f}, 0,
+                                              std::vector<int32_t>{1, 2});
+    const int mean = host_test_model_tensor(model, {1, data->depth}, tflite::TensorType_INT8, data->mean_scale, 0);
+    const int weights = host_test_model_constant(model, {head_case->classes, data->depth}, tflite::TensorType_INT8,
+                                                 {data->weights_scale}, 0, data->weights);
+    const int bias = host_test_model_constant(model, {head_case->classes}, tflite::TensorType_INT32,
+                                              {data->mean_scale * data->weights_scale}, 0, data->bias);
+    const int logits = host_test_model_tensor(model, {1, head_case->classes}, tflite::TensorType_INT8,
+                                              head_case->logit_scale, 0);
+
+    host_test_model_operator(model, tflite::BuiltinOperator_MEAN, {input, axis}, {mean},
+                             tflite::BuiltinOptions_ReducerOptions, tflite::CreateReducerOptions(builder).Union());
+    host_test_model_operator(model, tflite::BuiltinOperator_FULLY_CONNECTED, {mean, weights, bias}, {logits},
+                             tflite::BuiltinOptions_FullyConnectedOptions,
+                             tflite::CreateFullyConnectedOptions(builder).Union());
+    if (!softmax) {
+        return host_test_model_finish(model, {input}, {logits});
+    }
+    const int output = host_test_model_tensor(model, {1, head_case->classes}, tflite::TensorType_INT8,
+                                              1.0f / 256.0f, -128);
+    host_test_model_operator(model, tflite::BuiltinOperator_SOFTMAX, {logits}, {output},
+                             tflite::BuiltinOptions_SoftmaxOptions,
+                             tflite::CreateSoftmaxOptions(builder, 1.0f).Union());
+    return host_test_model_finish(model, {input}, {output});
+}
+
+
+/* Runs the model on every input. */
+static std::vector<std::vector<int8_t>> run_model(tflite::MicroInterpreter* interpreter,
+                                                  const std::vector<std::vector<int8_t>>& inputs)
+{
+    std::vector<std::vector<int8_t>> outputs;
+
+    for (const std::vector<int8_t>& input : inputs) {
+        memcpy(interpreter->input(0)->data.int8, input.data(), input.size());
+        HOST_TEST_EXPECT_EQ(interpreter->Invoke(), kTfLiteOk);
+        const TfLiteTensor* output = interpreter->output(0);
+        outputs.push_back(std::vector<int8_t>(output->data.int8, output->data.int8 + output->bytes));
+    }
+    return outputs;
+}
+
+
+/* Outputs of the head run by the built-in operators, with or without the softmax. */
+static std::vector<std::vector<int8_t>> run_unfused(const head_case_t* head_case, const head_data_t* data,
+                                                    bool softmax)
+{
+    host_test_model_t model;
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    op_resolver.AddMean();
+    op_resolver.AddFullyConnected();
+    op_resolver.AddSoftmax();
+    tflite::MicroInterpreter interpreter(build_head(&model, head_case, data, softmax), op_resolver, arena,
+                                         ARENA_SIZE);
+    if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+        return std::vector<std::vector<int8_t>>();
+    }
+    return run_model(&interpreter, data->inputs);
+}
+
+
+/*******************************************************************************
+* Function Name: expected_argmax
+********************************************************************************
+* Summary:
+*  One-hot output of the argmax head: the largest value at the lowest index
+*  of the largest logit, if the softmax output there reaches threshold, and
+*  the lowest value everywhere else.
+*
+*******************************************************************************/
+static std::vector<int8_t> expected_argmax(const std::vector<int8_t>& logits, const std::vector<int8_t>& softmax,
+                                           int8_t threshold)
+{
+    std::vector<int8_t> output(logits.size(), -128);
+    size_t arg_max = 0;
+
+    for (size_t i = 1; i < logits.size(); i++) {
+        if (logits[i] > logits[arg_max]) {
+            arg_max = i;
+        }
+    }
+    if (softmax[arg_max] >= threshold) {
+        output[arg_max] = 127;
+    }
+    return output;
+}
+
+
+/*******************************************************************************
+* Function Name: test_argmax_confidence
+********************************************************************************
+* Summary:
+*  Sweeps the confidence threshold over the int8 range on one interpreter,
+*  each set after AllocateTensors, so the margins are recomputed by
+*  UpdateArgMaxConfidenceThreshold, and checks every decision against the
+*  softmax of the unfused head. A threshold set before AllocateTensors, where
+*  Prepare computes the margins, has to give the same decisions.
+*
+*******************************************************************************/
+static void test_argmax_confidence(const head_case_t* head_case)
+{
+    const head_data_t data = random_head(head_case);
+    const std::vector<std::vector<int8_t>> logits = run_unfused(head_case, &data, false);
+    const std::vector<std::vector<int8_t>> softmax = run_unfused(head_case, &data, true);
+    if (!HOST_TEST_EXPECT(logits.size() == data.inputs.size() && softmax.size() == data.inputs.size())) {
+        return;
+    }
+
+    /*The decisions have to cover both sides of the margins and, with a duplicated class, ties*/
+    int accepted = 0;
+    int rejected = 0;
+    int ties = 0;
+    std::vector<int> thresholds;
+    for (int threshold = -128; threshold < 127; threshold += THRESHOLD_STEP) {
+        thresholds.push_back(threshold);
+    }
+    thresholds.push_back(127);
+
+    tflite::MicroMutableOpResolver<4> op_resolver;
+    op_resolver.AddMean();
+    op_resolver.AddFullyConnected();
+    op_resolver.AddSoftmax();
+    op_resolver.AddMeanFullyConnectedArgMax();
+    host_test_model_t model;
+    const tflite::Model* built = build_head(&model, head_case, &data, true);
+    {
+        tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+        if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+            return;
+        }
+        for (int threshold : thresholds) {
+            HOST_TEST_EXPECT_EQ(interpreter.SetArgMaxConfidenceThreshold((int8_t)threshold), kTfLiteOk);
+            const std::vector<std::vector<int8_t>> outputs = run_model(&interpreter, data.inputs);
+            for (size_t i = 0; i < outputs.size(); i++) {
+                const std::vector<int8_t> expected = expected_argmax(logits[i], softmax[i], (int8_t)threshold);
+                if (!HOST_TEST_EXPECT(outputs[i] == expected)) {
+                    printf("input %zu, threshold %d\n", i, threshold);
+                }
+                const bool confident = std::find(expected.begin(), expected.end(), 127) != expected.end();
+                accepted += confident;
+                rejected += !confident;
+            }
+        }
+    }
+    if (head_case->duplicate >= 0) {
+        for (const std::vector<int8_t>& input_logits : logits) {
+            const int8_t largest = *std::max_element(input_logits.begin(), input_logits.end());
+            ties += input_logits[head_case->duplicate] == largest && input_logits[head_case->duplicate_of] == largest;
+        }
+        HOST_TEST_EXPECT(ties > RANDOM_INPUTS / 2);
+    }
+    HOST_TEST_EXPECT(accepted > 0 && rejected > 0);
+    printf("%d accepted, %d rejected, %d ties\n", accepted, rejected, ties);
+
+    /*Margins computed by Prepare, on a threshold set before the allocation*/
+    const int8_t threshold = 40;
+    tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+    HOST_TEST_EXPECT_EQ(interpreter.SetArgMaxConfidenceThreshold(threshold), kTfLiteOk);
+    if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+        return;
+    }
+    const std::vector<std::vector<int8_t>> outputs = run_model(&interpreter, data.inputs);
+    for (size_t i = 0; i < outputs.size(); i++) {
+        HOST_TEST_EXPECT(outputs[i] == expected_argmax(logits[i], softmax[i], threshold));
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_softmax_head
+********************************************************************************
+* Summary:
+*  MEAN_FULLY_CONNECTED_SOFTMAX has to give the softmax of the unfused head
+*  byte for byte, in a single step. The argmax head computes the softmax
+*  output at the largest logit on its own, with SoftmaxExp and
+*  SoftmaxOfLargest: a threshold at the value arm_softmax_s8 outputs there
+*  has to accept every input, and one above it has to reject it.
+*
+*******************************************************************************/
+static void test_softmax_head(const head_case_t* head_case)
+{
+    const head_data_t data = random_head(head_case);
+    const std::vector<std::vector<int8_t>> logits = run_unfused(head_case, &data, false);
+    const std::vector<std::vector<int8_t>> softmax = run_unfused(head_case, &data, true);
+    if (!HOST_TEST_EXPECT(logits.size() == data.inputs.size() && softmax.size() == data.inputs.size())) {
+        return;
+    }
+    host_test_model_t model;
+    const tflite::Model* built = build_head(&model, head_case, &data, true);
+
+    {
+        tflite::MicroMutableOpResolver<4> op_resolver;
+        op_resolver.AddMean();
+        op_resolver.AddFullyConnected();
+        op_resolver.AddSoftmax();
+        op_resolver.AddMeanFullyConnectedSoftmax();
+        tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+        if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk) ||
+            !HOST_TEST_EXPECT(interpreter.PrepareLeanInvoke() == kTfLiteOk)) {
+            return;
+        }
+        HOST_TEST_EXPECT(run_model(&interpreter, data.inputs) == softmax);
+
+        /*The three operators are one node*/
+        memcpy(interpreter.input(0)->data.int8, data.inputs[0].data(), data.inputs[0].size());
+        tflite::InvokeResumeToken token;
+        HOST_TEST_EXPECT_EQ(interpreter.InvokeStep(&token), kTfLiteOk);
+        HOST_TEST_EXPECT(token.finished);
+    }
+
+    tflite::MicroMutableOpResolver<4> op_resolver;
+    op_resolver.AddMean();
+    op_resolver.AddFullyConnected();
+    op_resolver.AddSoftmax();
+    op_resolver.AddMeanFullyConnectedArgMax();
+    tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+    if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+        return;
+    }
+    for (size_t i = 0; i < data.inputs.size(); i++) {
+        const size_t arg_max = std::max_element(logits[i].begin(), logits[i].end()) - logits[i].begin();
+        const int largest = softmax[i][arg_max];
+        for (int threshold = largest; threshold <= std::min(largest + 1, 127); threshold++) {
+            HOST_TEST_EXPECT_EQ(interpreter.SetArgMaxConfidenceThreshold((int8_t)threshold), kTfLiteOk);
+            const std::vector<int8_t> output = run_model(&interpreter, {data.inputs[i]})[0];
+            HOST_TEST_EXPECT_EQ_CASE(output[arg_max], threshold == largest ? 127 : -128, head_case->name);
+        }
+    }
+}
+
+
+int main(void)
+{
+    const head_case_t cases[] = {
+        {"10 classes, logit scale 0.02", 10, 0.02f, -1, -1, false},
+        {"10 classes, logit scale 0.0625", 10, 0.0625f, -1, -1, false},
+        {"10 classes, logit scale 0.15", 10, 0.15f, -1, -1, false},
+        {"10 classes, logit scale 0.4", 10, 0.4f, -1, -1, false},
+        {"3 classes, logit scale 0.05", 3, 0.05f, -1, -1, false},
+        {"2 classes, logit scale 0.1", 2, 0.1f, -1, -1, false},
+        /*Class 7 ties with class 2, which has to win*/
+        {"10 classes, tied largest logits, logit scale 0.05", 10, 0.05f, 7, 2, false},
+        {"10 classes, tied largest logits, logit scale 0.3", 10, 0.3f, 7, 2, false},
+        /*Every margin between the two largest logits*/
+        {"direct logits, 10 classes, logit scale 0.02", 10, 0.02f, -1, -1, true},
+        {"direct logits, 10 classes, logit scale 0.1", 10, 0.1f, -1, -1, true},
+        {"direct logits, 10 classes, logit scale 0.4", 10, 0.4f, -1, -1, true},
+        {"direct logits, 3 classes, logit scale 0.0625", 3, 0.0625f, -1, -1, true},
+    };
+
+    for (const head_case_t& head_case : cases) {
+        printf("test_argmax_confidence: %s\n", head_case.name);
+        test_argmax_confidence(&head_case);
+    }
+    for (const head_case_t& head_case : cases) {
+        printf("test_softmax_head: %s\n", head_case.name);
+        test_softmax_head(&head_case);
+    }
+    return host_test_result();
+}
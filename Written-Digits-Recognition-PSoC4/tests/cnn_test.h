@@ -0,0 +1,109 @@
+/*
+ * cnn_test.h
+ *
+ *  The CNN of models/ in the configurations the interpreter tests compare:
+ *  run by the built-in operators only, with the fused operators the
+ *  application registers, and with patch based execution of its leading
+ *  layers. The arena is large enough for the plain graph, which does not fit
+ *  in the 10000 bytes of the application.
+ */
+
+#ifndef TESTS_CNN_TEST_H_
+#define TESTS_CNN_TEST_H_
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "host_test.h"
+#include "written-digit-recognition-cnn-8bit.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define HOST_TEST_CNN_OPS           (12)
+#define HOST_TEST_CNN_ARENA_SIZE    (64 * 1024)
+#define HOST_TEST_CNN_PIXELS        (28 * 28)
+
+typedef tflite::MicroMutableOpResolver<HOST_TEST_CNN_OPS> host_test_cnn_resolver_t;
+
+/* Operators of the CNN, and the fused ones of main.cpp (RegisterOps) if fused is set. */
+static inline void host_test_cnn_ops(host_test_cnn_resolver_t* op_resolver, bool fused)
+{
+    op_resolver->AddFullyConnected();
+    op_resolver->AddConv2D();
+    op_resolver->AddMaxPool2D();
+    op_resolver->AddQuantize();
+    op_resolver->AddSoftmax();
+    op_resolver->AddReshape();
+    op_resolver->AddMean();
+    op_resolver->AddAveragePool2D();
+    if (fused) {
+        op_resolver->AddConv2DMaxPool2D();
+        op_resolver->AddMeanFullyConnectedSoftmax();
+        op_resolver->AddPatchConvStack();
+    }
+}
+
+static inline const tflite::Model* host_test_cnn_model(void)
+{
+    return tflite::GetModel(written_digit_recognition_cnn_8bit_tflite);
+}
+
+/* Patch based execution of the first num_layers layers, 0 for none. */
+static inline tflite::PatchExecutionConfig host_test_patch_config(int num_layers, int tile_height, int tile_width)
+{
+    tflite::PatchExecutionConfig config;
+
+    config.num_layers = num_layers;
+    config.tile_height = tile_height;
+    config.tile_width = tile_width;
+    return config;
+}
+
+/*******************************************************************************
+* Function Name: host_test_random_image
+********************************************************************************
+* Summary:
+*  Input of the CNN: either uniform noise, or a drawing as the stroke
+*  matrix gives, mostly blank with a few strokes of full intensity and their
+*  grey borders, so that the kernels also skip empty windows.
+*
+*******************************************************************************/
+static inline std::vector<uint8_t> host_test_random_image(void)
+{
+    std::vector<uint8_t> image(HOST_TEST_CNN_PIXELS, 0);
+
+    if (host_test_random(0, 1) == 0) {
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = (uint8_t)host_test_random(0, 255);
+        }
+        return image;
+    }
+    const int strokes = host_test_random(1, 4);
+    for (int stroke = 0; stroke < strokes; stroke++) {
+        int row = host_test_random(1, 26);
+        int column = host_test_random(1, 25);
+        for (int length = host_test_random(3, 20); length > 0; length--) {
+            image[row * 28 + column] = 255;
+            image[row * 28 + column + 1] = (uint8_t)host_test_random(64, 255);
+            row = std::min(std::max(row + host_test_random(-1, 1), 1), 26);
+            column = std::min(std::max(column + host_test_random(-1, 1), 1), 25);
+        }
+    }
+    return image;
+}
+
+/* Writes input, runs Invoke() and returns the output. */
+static inline std::vector<uint8_t> host_test_invoke(tflite::MicroInterpreter* interpreter,
+                                                    const std::vector<uint8_t>& input)
+{
+    memcpy(interpreter->input(0)->data.uint8, input.data(), input.size());
+    if (!HOST_TEST_EXPECT(interpreter->Invoke() == kTfLiteOk)) {
+        return std::vector<uint8_t>();
+    }
+    const TfLiteTensor* output = interpreter->output(0);
+    return std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes);
+}
+
+#endif /* TESTS_CNN_TEST_H_ */
@@ -0,0 +1,381 @@
+/*
+ * command_shell_test.cpp
+ *
+ *  Benchmark and settings shell (src/command_shell.h) on the CNN of models/,
+ *  set up as main.cpp does: packed weights, patch based execution and the
+ *  lean invoke. The requests and their replies go through the UART frames,
+ *  and the benchmark is timed with FakeMicroTime, so that its ticks are
+ *  known. The benchmark runs the test digit of test_data/test_sample.h,
+ *  which the CNN has to score as the quantized reference does.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "command_shell.h"
+#include "config.h"
+#include "host_test.h"
+#include "packed_weights.h"
+#include "patch_config.h"
+#include "test_sample.h"
+#include "written-digit-recognition-cnn-8bit.h"
+#include "tensorflow/lite/micro/fake_micro_time.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+
+#define ARENA_SIZE                  (10000)
+/*Without patches the CNN does not fit in ARENA_SIZE*/
+#define REFERENCE_ARENA_SIZE        (64 * 1024)
+#define TICKS_PER_READ              (10u)
+#define REJECTED_PEN_UP_MS          (1234u)
+
+#define BENCHMARK_SIZE              (23u)
+#define MEMORY_SIZE                 (24u)
+
+/*Digit of the test sample*/
+#define TEST_DIGIT                  (3u)
+/*Prediction for an output below the confidence threshold*/
+#define COMMAND_SHELL_NO_PREDICTION (11u)
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+alignas(16) static uint8_t reference_arena[REFERENCE_ARENA_SIZE];
+static uint8_t blank_input[sizeof(test_input_qnt)];
+static tflite::MicroInterpreter* interpreter;
+static command_shell_t shell;
+static uart_frame_decoder_t request_decoder;
+static uart_frame_decoder_t reply_decoder;
+static std::vector<std::vector<uint8_t>> replies;
+static int reply_command;
+static int applied;
+
+
+static uint16_t read_u16(const uint8_t* data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+
+static uint32_t read_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+static void send(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (uart_frame_decode(&reply_decoder, data[i])) {
+            reply_command = reply_decoder.command;
+            replies.push_back(std::vector<uint8_t>(reply_decoder.payload, reply_decoder.payload + reply_decoder.length));
+        }
+    }
+}
+
+
+static void read_stack(stack_usage_t* usage)
+{
+    usage->used = 700;
+    usage->headroom = 300;
+    usage->reserved = 1024;
+}
+
+
+/* Stands in for apply_settings of main.cpp, with a pen up timeout the timer refuses. */
+static bool apply(tflite::MicroInterpreter* model, const command_shell_settings_t* settings)
+{
+    applied++;
+    return settings->pen_up_timeout_ms != REJECTED_PEN_UP_MS;
+}
+
+
+/*******************************************************************************
+* Function Name: request
+********************************************************************************
+* Summary:
+*  Sends one request through the frame decoder to command_shell_handle and
+*  returns its reply, which has to be the only one and carry the command of
+*  the request.
+*
+*******************************************************************************/
+static std::vector<uint8_t> request(uint8_t command, const std::vector<uint8_t>& payload, bool busy = false)
+{
+    uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+    const size_t size = uart_frame_encode(command, payload.data(), (uint16_t)payload.size(), frame);
+
+    replies.clear();
+    for (size_t i = 0; i < size; i++) {
+        if (uart_frame_decode(&request_decoder, frame[i])) {
+            command_shell_handle(&shell, request_decoder.command, request_decoder.payload, request_decoder.length,
+                                 busy);
+        }
+    }
+    HOST_TEST_EXPECT_EQ(replies.size(), 1);
+    HOST_TEST_EXPECT_EQ(reply_command, command | UART_FRAME_REPLY);
+    return replies.empty() ? std::vector<uint8_t>(1, 0xFF) : replies.back();
+}
+
+
+/*******************************************************************************
+* Function Name: reference_output
+********************************************************************************
+* Summary:
+*  Output of the CNN on input, run by a plain interpreter with the built-in
+*  operators only: no packed weights, no fused operators, no patch based
+*  execution and no lean invoke.
+*
+*******************************************************************************/
+static std::vector<uint8_t> reference_output(const uint8_t* input, size_t size)
+{
+    tflite::MicroMutableOpResolver<8> op_resolver;
+    op_resolver.AddFullyConnected();
+    op_resolver.AddConv2D();
+    op_resolver.AddMaxPool2D();
+    op_resolver.AddQuantize();
+    op_resolver.AddSoftmax();
+    op_resolver.AddReshape();
+    op_resolver.AddMean();
+    op_resolver.AddAveragePool2D();
+    tflite::MicroInterpreter reference(tflite::GetModel(written_digit_recognition_cnn_8bit_tflite), op_resolver,
+                                       reference_arena, REFERENCE_ARENA_SIZE);
+
+    if (!HOST_TEST_EXPECT(reference.AllocateTensors() == kTfLiteOk && reference.input(0)->bytes == size)) {
+        return std::vector<uint8_t>();
+    }
+    memcpy(reference.input(0)->data.uint8, input, size);
+    HOST_TEST_EXPECT_EQ(reference.Invoke(), kTfLiteOk);
+    const TfLiteTensor* output = reference.output(0);
+    return std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes);
+}
+
+
+/* Checks a benchmark record of runs of ticks_per_run each. */
+static void check_benchmark(const uint8_t* benchmark, uint16_t runs, uint32_t ticks_per_run, uint8_t prediction)
+{
+    HOST_TEST_EXPECT_EQ(read_u16(benchmark), runs);
+    HOST_TEST_EXPECT_EQ(read_u32(benchmark + 2), tflite::FakeMicroTime::kTicksPerSecond);
+    HOST_TEST_EXPECT_EQ(read_u32(benchmark + 6), ticks_per_run);
+    HOST_TEST_EXPECT_EQ(read_u32(benchmark + 10), ticks_per_run);
+    HOST_TEST_EXPECT_EQ(read_u32(benchmark + 14), runs * ticks_per_run);
+    HOST_TEST_EXPECT_EQ(read_u32(benchmark + 18), 0);
+    HOST_TEST_EXPECT_EQ(benchmark[22], prediction);
+}
+
+
+/* Runs a benchmark of one run and checks its prediction. */
+static void check_prediction(uint8_t prediction)
+{
+    const std::vector<uint8_t> reply = request(COMMAND_SHELL_BENCH, {1, 0});
+
+    HOST_TEST_EXPECT_EQ(reply.size(), 1 + BENCHMARK_SIZE);
+    if (reply.size() == 1 + BENCHMARK_SIZE) {
+        HOST_TEST_EXPECT_EQ(reply[0], COMMAND_SHELL_OK);
+        check_benchmark(&reply[1], 1, TICKS_PER_READ, prediction);
+    }
+}
+
+
+/* Checks a settings reply and the settings the shell keeps. */
+static void check_settings(const std::vector<uint8_t>& reply, uint8_t status, uint8_t threshold,
+                           uint16_t pen_up_ms, uint8_t verbosity)
+{
+    HOST_TEST_EXPECT_EQ(reply.size(), 5);
+    if (reply.size() == 5) {
+        HOST_TEST_EXPECT_EQ(reply[0], status);
+        HOST_TEST_EXPECT_EQ(reply[1], threshold);
+        HOST_TEST_EXPECT_EQ(read_u16(&reply[2]), pen_up_ms);
+        HOST_TEST_EXPECT_EQ(reply[4], verbosity);
+    }
+    HOST_TEST_EXPECT_EQ(shell.settings.confidence_threshold, threshold);
+    HOST_TEST_EXPECT_EQ(shell.settings.pen_up_timeout_ms, pen_up_ms);
+    HOST_TEST_EXPECT_EQ(shell.settings.verbosity, verbosity);
+}
+
+
+/*******************************************************************************
+* Function Name: test_benchmark
+********************************************************************************
+* Summary:
+*  BENCH, and STATS after it. The time is read twice per run, so with a
+*  fixed step per read every run takes one step. The output of the last run
+*  has to be the quantized reference output of the test digit. BENCH is
+*  refused while an inference of the main loop is running and for run counts
+*  out of range. With a profiler every run is also recorded as an event.
+*
+*******************************************************************************/
+static void test_benchmark(void)
+{
+    tflite::FakeMicroTime::Install(TICKS_PER_READ);
+    std::vector<uint8_t> reply = request(COMMAND_SHELL_BENCH, {5, 0});
+    HOST_TEST_EXPECT_EQ(reply.size(), 1 + BENCHMARK_SIZE);
+    if (reply.size() == 1 + BENCHMARK_SIZE) {
+        HOST_TEST_EXPECT_EQ(reply[0], COMMAND_SHELL_OK);
+        check_benchmark(&reply[1], 5, TICKS_PER_READ, TEST_DIGIT);
+    }
+    const TfLiteTensor* output = interpreter->output(0);
+    const std::vector<uint8_t> expected = reference_output(test_input_qnt, sizeof(test_input_qnt));
+    HOST_TEST_EXPECT(std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes) == expected);
+    const std::vector<uint8_t> benchmark(reply.begin() + 1, reply.end());
+
+    reply = request(COMMAND_SHELL_STATS, {});
+    HOST_TEST_EXPECT_EQ(reply.size(), 1 + MEMORY_SIZE + BENCHMARK_SIZE);
+    if (reply.size() == 1 + MEMORY_SIZE + BENCHMARK_SIZE) {
+        HOST_TEST_EXPECT_EQ(reply[0], COMMAND_SHELL_OK);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[1]), 700);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[5]), 300);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[9]), 1024);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[13]), ARENA_SIZE);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[17]), interpreter->arena_used_bytes());
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[21]), interpreter->arena_head_high_water_bytes());
+        HOST_TEST_EXPECT(interpreter->arena_head_high_water_bytes() > 0);
+        HOST_TEST_EXPECT(std::vector<uint8_t>(reply.begin() + 1 + MEMORY_SIZE, reply.end()) == benchmark);
+    }
+    reply = request(COMMAND_SHELL_STATS, {0});
+    HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == COMMAND_SHELL_ERROR);
+
+    /*Refused requests run nothing and keep the last benchmark*/
+    tflite::FakeMicroTime::Install(TICKS_PER_READ);
+    reply = request(COMMAND_SHELL_BENCH, {5, 0}, true);
+    HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == COMMAND_SHELL_BUSY);
+    const std::vector<std::vector<uint8_t>> refused = {
+        {0, 0}, {COMMAND_SHELL_MAX_RUNS + 1, 0}, {0, 1}, {1}, {1, 0, 0},
+    };
+    for (const std::vector<uint8_t>& payload : refused) {
+        reply = request(COMMAND_SHELL_BENCH, payload);
+        HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == COMMAND_SHELL_ERROR);
+    }
+    HOST_TEST_EXPECT_EQ(tflite::FakeMicroTime::ticks(), 0);
+    reply = request(COMMAND_SHELL_STATS, {});
+    HOST_TEST_EXPECT(std::vector<uint8_t>(reply.begin() + 1 + MEMORY_SIZE, reply.end()) == benchmark);
+
+    /*With a profiler, the begin and end of each event are read too*/
+    tflite::MicroProfiler profiler;
+    shell.profiler = &profiler;
+    reply = request(COMMAND_SHELL_BENCH, {3, 0});
+    if (reply.size() == 1 + BENCHMARK_SIZE) {
+        HOST_TEST_EXPECT_EQ(reply[0], COMMAND_SHELL_OK);
+        check_benchmark(&reply[1], 3, 3 * TICKS_PER_READ, TEST_DIGIT);
+    }
+    HOST_TEST_EXPECT_EQ(profiler.GetTotalTicks(), 3 * TICKS_PER_READ);
+    shell.profiler = NULL;
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_settings
+********************************************************************************
+* Summary:
+*  SETTINGS_GET and SETTINGS_SET: the bounds of the pen up timeout and of the
+*  verbosity, settings the application refuses and requests of the wrong
+*  size, which all keep the settings as they were. The benchmark prediction
+*  is "none" for a best score below the confidence threshold, and the digit
+*  from the threshold on.
+*
+*******************************************************************************/
+static void test_settings(void)
+{
+    check_settings(request(COMMAND_SHELL_SETTINGS_GET, {}), COMMAND_SHELL_OK, CONFIDENCE_THRESHOLD,
+                   PEN_UP_TIMEOUT_MS, OUTPUT_VERBOSITY);
+    check_settings(request(COMMAND_SHELL_SETTINGS_GET, {0}), COMMAND_SHELL_ERROR, CONFIDENCE_THRESHOLD,
+                   PEN_UP_TIMEOUT_MS, OUTPUT_VERBOSITY);
+
+    applied = 0;
+    check_settings(request(COMMAND_SHELL_SETTINGS_SET, {255, 50, 0, 0}), COMMAND_SHELL_OK, 255,
+                   COMMAND_SHELL_MIN_PEN_UP_MS, COMMAND_SHELL_VERBOSITY_QUIET);
+    check_settings(request(COMMAND_SHELL_SETTINGS_SET, {255, 0x64, 0x19, 1}), COMMAND_SHELL_OK, 255,
+                   COMMAND_SHELL_MAX_PEN_UP_MS, COMMAND_SHELL_VERBOSITY_RESULT);
+    HOST_TEST_EXPECT_EQ(applied, 2);
+
+    /*The test digit scores 255, which is not below the threshold*/
+    tflite::FakeMicroTime::Install(TICKS_PER_READ);
+    check_prediction(TEST_DIGIT);
+
+    /*A blank input has a less confident best score: no prediction above it, its digit at it*/
+    const std::vector<uint8_t> blank = reference_output(blank_input, sizeof(blank_input));
+    uint8_t blank_digit = 0;
+    for (uint8_t i = 0; i < blank.size(); i++) {
+        if (blank[i] > blank[blank_digit]) {
+            blank_digit = i;
+        }
+    }
+    const uint8_t blank_score = blank.empty() ? 0 : blank[blank_digit];
+    HOST_TEST_EXPECT(blank_score > 0 && blank_score < 255);
+    shell.test_input = blank_input;
+    check_prediction(COMMAND_SHELL_NO_PREDICTION);
+    request(COMMAND_SHELL_SETTINGS_SET, {blank_score, 0x64, 0x19, 1});
+    check_prediction(blank_digit);
+    check_settings(request(COMMAND_SHELL_SETTINGS_SET, {255, 0x64, 0x19, 1}), COMMAND_SHELL_OK, 255,
+                   COMMAND_SHELL_MAX_PEN_UP_MS, COMMAND_SHELL_VERBOSITY_RESULT);
+    shell.test_input = test_input_qnt;
+    tflite::FakeMicroTime::Uninstall();
+
+    /*Out of range, refused by the application, or of the wrong size*/
+    const std::vector<std::vector<uint8_t>> refused = {
+        {128, 49, 0, 1},
+        {128, 0x65, 0x19, 1},
+        {128, 0xbc, 0x02, COMMAND_SHELL_VERBOSITY_FULL + 1},
+        {128, (uint8_t)REJECTED_PEN_UP_MS, (uint8_t)(REJECTED_PEN_UP_MS >> 8), 1},
+        {128, 0xbc, 0x02},
+        {128, 0xbc, 0x02, 1, 0},
+    };
+    applied = 0;
+    for (const std::vector<uint8_t>& payload : refused) {
+        check_settings(request(COMMAND_SHELL_SETTINGS_SET, payload), COMMAND_SHELL_ERROR, 255,
+                       COMMAND_SHELL_MAX_PEN_UP_MS, COMMAND_SHELL_VERBOSITY_RESULT);
+    }
+    /*Only the request in range reached the application*/
+    HOST_TEST_EXPECT_EQ(applied, 1);
+
+    check_settings(request(COMMAND_SHELL_SETTINGS_SET, {CONFIDENCE_THRESHOLD, 0xbc, 0x02, 2}), COMMAND_SHELL_OK,
+                   CONFIDENCE_THRESHOLD, 700, COMMAND_SHELL_VERBOSITY_FULL);
+
+    /*Commands of the other protocols are left to their handlers*/
+    replies.clear();
+    command_shell_handle(&shell, COMMAND_SHELL_BENCH - 1, NULL, 0, false);
+    command_shell_handle(&shell, COMMAND_SHELL_SETTINGS_SET + 1, NULL, 0, false);
+    HOST_TEST_EXPECT_EQ(replies.size(), 0);
+}
+
+
+int main(void)
+{
+    tflite::MicroMutableOpResolver<11> op_resolver;
+    op_resolver.AddFullyConnected();
+    op_resolver.AddConv2D();
+    op_resolver.AddMaxPool2D();
+    op_resolver.AddQuantize();
+    op_resolver.AddSoftmax();
+    op_resolver.AddReshape();
+    op_resolver.AddMean();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddConv2DMaxPool2D();
+    op_resolver.AddMeanFullyConnectedSoftmax();
+    op_resolver.AddPatchConvStack();
+
+    tflite::MicroInterpreter cnn(tflite::GetModel(written_digit_recognition_cnn_8bit_tflite), op_resolver, arena,
+                                 ARENA_SIZE);
+    tflite::PatchExecutionConfig patch_config;
+    patch_config.num_layers = PATCH_NUM_LAYERS;
+    patch_config.tile_height = PATCH_TILE_HEIGHT;
+    patch_config.tile_width = PATCH_TILE_WIDTH;
+    /*Set up as in main.cpp, with the arena watermarks for STATS*/
+    if (!HOST_TEST_EXPECT(cnn.SetPackedWeights(&packed_weights) == kTfLiteOk &&
+                          cnn.SetPatchExecutionConfig(patch_config) == kTfLiteOk &&
+                          cnn.AllocateTensors() == kTfLiteOk && cnn.PrepareLeanInvoke() == kTfLiteOk &&
+                          cnn.EnableArenaWatermarks() == kTfLiteOk)) {
+        return host_test_result();
+    }
+    interpreter = &cnn;
+
+    const command_shell_settings_t settings = {CONFIDENCE_THRESHOLD, PEN_UP_TIMEOUT_MS, OUTPUT_VERBOSITY};
+    command_shell_init(&shell, interpreter, NULL, test_input_qnt, sizeof(test_input_qnt), ARENA_SIZE, &settings,
+                       read_stack, apply, send);
+    uart_frame_decoder_init(&request_decoder);
+    uart_frame_decoder_init(&reply_decoder);
+
+    HOST_TEST_RUN(test_benchmark);
+    HOST_TEST_RUN(test_settings);
+    return host_test_result();
+}
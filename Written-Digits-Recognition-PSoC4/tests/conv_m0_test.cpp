@@ -0,0 +1,580 @@
+/*
+ * conv_m0_test.cpp
+ *
+ *  ConvM0S8, its shape specialized variants, ConvM0S4 and FullyConnectedM0S8
+ *  (kernels/conv_m0.h) against reference_integer_ops::ConvPerChannel and
+ *  FullyConnected, on random shapes, strides, dilations, padding, zero points
+ *  and requantization parameters, with dense and block sparse weights. The
+ *  outputs have to be bit-exact.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "host_test.h"
+#include "kernel_test.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+
+#define RANDOM_CASES                (300)
+
+typedef struct {
+    cmsis_nn_dims input_dims;
+    cmsis_nn_dims filter_dims;
+    cmsis_nn_dims output_dims;
+    cmsis_nn_conv_params params;
+    std::vector<int8_t> input;
+    std::vector<int8_t> filter;
+    std::vector<int32_t> bias;
+    std::vector<int32_t> multiplier;
+    std::vector<int32_t> shift;
+} conv_case_t;
+
+
+static int filter_depth(const conv_case_t* c)
+{
+    return c->filter_dims.h * c->filter_dims.w * c->filter_dims.c;
+}
+
+
+/* One line that identifies a case in the failure messages. */
+static const char* describe(const conv_case_t* c)
+{
+    static char text[160];
+
+    snprintf(text, sizeof(text), "in %dx%dx%dx%d filter %dx%dx%dx%d stride %d,%d dilation %d,%d pad %d,%d",
+             c->input_dims.n, c->input_dims.h, c->input_dims.w, c->input_dims.c, c->filter_dims.n,
+             c->filter_dims.h, c->filter_dims.w, c->filter_dims.c, c->params.stride.h, c->params.stride.w,
+             c->params.dilation.h, c->params.dilation.w, c->params.padding.h, c->params.padding.w);
+    return text;
+}
+
+
+/* Output size and padding of one dimension, with SAME or VALID padding. */
+static void output_size(int input, int filter, int stride, int dilation, bool same, int* output, int* padding)
+{
+    const int extent = (filter - 1) * dilation + 1;
+
+    if (same) {
+        *output = (input + stride - 1) / stride;
+        const int total = (*output - 1) * stride + extent - input;
+        *padding = total > 0 ? total / 2 : 0;
+    } else {
+        *output = (input - extent) / stride + 1;
+        *padding = 0;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: make_conv_case
+********************************************************************************
+* Summary:
+*  Fills a case of the given filter shape and strides with a random input
+*  size, padding and data. sparse_input leaves most input pixels at the zero
+*  point, as the strokes of a digit do.
+*
+*******************************************************************************/
+static void make_conv_case(conv_case_t* c, int filter_height, int filter_width, int input_depth,
+                           int output_depth, int stride_height, int stride_width, int dilation,
+                           bool sparse_input)
+{
+    const bool same = host_test_random(0, 1) != 0;
+    const int min_height = (filter_height - 1) * dilation + 1;
+    const int min_width = (filter_width - 1) * dilation + 1;
+
+    c->input_dims.n = host_test_random(1, 2);
+    c->input_dims.h = host_test_random(min_height, min_height + 12);
+    c->input_dims.w = host_test_random(min_width, min_width + 12);
+    c->input_dims.c = input_depth;
+    c->filter_dims.n = output_depth;
+    c->filter_dims.h = filter_height;
+    c->filter_dims.w = filter_width;
+    c->filter_dims.c = input_depth;
+    c->params.stride.h = stride_height;
+    c->params.stride.w = stride_width;
+    c->params.dilation.h = dilation;
+    c->params.dilation.w = dilation;
+    output_size(c->input_dims.h, filter_height, stride_height, dilation, same, &c->output_dims.h,
+                &c->params.padding.h);
+    output_size(c->input_dims.w, filter_width, stride_width, dilation, same, &c->output_dims.w,
+                &c->params.padding.w);
+    c->output_dims.n = c->input_dims.n;
+    c->output_dims.c = output_depth;
+
+    const int32_t input_zero_point = host_test_random(-128, 127);
+    c->params.input_offset = -input_zero_point;
+    c->params.output_offset = host_test_random(-128, 127);
+    c->params.activation.min = host_test_random(0, 3) == 0 ? host_test_random(-128, 0) : -128;
+    c->params.activation.max = host_test_random(0, 3) == 0 ? host_test_random(0, 127) : 127;
+
+    c->input.resize(c->input_dims.n * c->input_dims.h * c->input_dims.w * input_depth);
+    for (size_t pixel = 0; pixel < c->input.size(); pixel += input_depth) {
+        const bool occupied = !sparse_input || host_test_random(0, 9) == 0;
+        for (int i = 0; i < input_depth; i++) {
+            c->input[pixel + i] = (int8_t)(occupied ? host_test_random(-128, 127) : input_zero_point);
+        }
+    }
+    c->filter.resize(output_depth * filter_depth(c));
+    for (size_t i = 0; i < c->filter.size(); i++) {
+        c->filter[i] = (int8_t)host_test_random(-127, 127);
+    }
+    c->bias.resize(output_depth);
+    c->multiplier.resize(output_depth);
+    c->shift.resize(output_depth);
+    for (int i = 0; i < output_depth; i++) {
+        c->bias[i] = host_test_random(-(1 << 16), 1 << 16);
+        c->multiplier[i] = host_test_random(1 << 30, INT32_MAX);
+        c->shift[i] = host_test_random(-14, 0);
+    }
+}
+
+
+static void random_conv_case(conv_case_t* c)
+{
+    make_conv_case(c, host_test_random(1, 3), host_test_random(1, 3), host_test_random(1, 9),
+                   host_test_random(1, 9), host_test_random(1, 2), host_test_random(1, 2),
+                   host_test_random(0, 3) == 0 ? 2 : 1, false);
+}
+
+
+static std::vector<int8_t> reference_conv(const conv_case_t* c)
+{
+    std::vector<int8_t> output(c->output_dims.n * c->output_dims.h * c->output_dims.w * c->output_dims.c);
+
+    tflite::reference_integer_ops::ConvPerChannel(
+        host_test_conv_params(c->params), c->multiplier.data(), c->shift.data(),
+        host_test_shape(c->input_dims), c->input.data(), host_test_shape(c->filter_dims),
+        c->filter.data(), host_test_shape(c->filter_dims.n), c->bias.data(),
+        host_test_shape(c->output_dims), output.data());
+    return output;
+}
+
+
+/*******************************************************************************
+* Function Name: make_occupancy
+********************************************************************************
+* Summary:
+*  The occupancy mask of the input of c and the output of an empty window, as
+*  the kernels build them for kernel in Prepare and once per invoke. Returns
+*  false when kernel computes every window.
+*
+*******************************************************************************/
+static bool make_occupancy(const conv_case_t* c, tflite::ConvM0S8Kernel kernel, const tflite::PackedWeights& packed,
+                           std::vector<uint32_t>* mask, std::vector<int8_t>* empty_output)
+{
+    const int32_t size = tflite::ConvM0S8GetOccupancyBufferSize(kernel, &c->input_dims);
+    cmsis_nn_per_channel_quant_params quant_params = {(int32_t*)c->multiplier.data(),
+                                                      (int32_t*)c->shift.data()};
+
+    if (size == 0) {
+        return false;
+    }
+    mask->assign(size / sizeof(uint32_t), 0);
+    empty_output->assign(c->filter_dims.n, 0);
+    tflite::ConvM0S8ComputeOccupancy(&c->input_dims, c->input.data(), c->params.input_offset, mask->data());
+    tflite::ConvM0S8EmptyOutput(&c->params, &quant_params, &c->filter_dims, packed, empty_output->data());
+    return true;
+}
+
+
+/* Runs a kernel with the signature of ConvM0S8 on packed weights and compares it with the reference. */
+static void check_conv(const conv_case_t* c, tflite::ConvM0S8Kernel kernel, const tflite::PackedWeights& packed)
+{
+    std::vector<int8_t> expected = reference_conv(c);
+    std::vector<int8_t> output(expected.size());
+    std::vector<int8_t> buffer(tflite::ConvM0S8GetBufferSize(&c->filter_dims));
+    cmsis_nn_context ctx = {buffer.data(), (int32_t)buffer.size()};
+    cmsis_nn_per_channel_quant_params quant_params = {(int32_t*)c->multiplier.data(),
+                                                      (int32_t*)c->shift.data()};
+    std::vector<uint32_t> mask;
+    std::vector<int8_t> empty_output;
+    tflite::ConvM0Occupancy occupancy = {nullptr, 0, nullptr};
+    if (make_occupancy(c, kernel, packed, &mask, &empty_output)) {
+        occupancy = tflite::ConvM0S8Occupancy(mask.data(), &c->input_dims, 0, 0, 0, empty_output.data());
+    }
+
+    const arm_cmsis_nn_status status = kernel(&ctx, &c->params, &quant_params, &c->input_dims,
+                                              c->input.data(), &c->filter_dims, packed,
+                                              &c->output_dims, output.data(), &occupancy);
+    HOST_TEST_EXPECT_EQ_CASE(status, ARM_CMSIS_NN_SUCCESS, describe(c));
+    for (size_t i = 0; i < output.size(); i++) {
+        if (!HOST_TEST_EXPECT_EQ_CASE(output[i], expected[i], describe(c))) {
+            break;
+        }
+    }
+}
+
+
+/* Dense weights packed at Prepare time, as PreparePackedWeights does. */
+static std::vector<int32_t> pack_dense(const conv_case_t* c, tflite::PackedWeights* packed)
+{
+    std::vector<int32_t> buffer(tflite::PackedWeightsBufferSize(c->filter_dims.n, filter_depth(c)) / 4);
+
+    tflite::PackWeights(c->filter.data(), c->bias.data(), c->filter_dims.n, filter_depth(c),
+                        c->params.input_offset, buffer.data(), packed);
+    return buffer;
+}
+
+
+/* Zeroes about half of the 1x4 blocks of the filter, the four weights of one group of output channels for one input element. */
+static void prune_blocks(conv_case_t* c)
+{
+    const int depth = filter_depth(c);
+
+    for (int channel = 0; channel < c->filter_dims.n; channel += 4) {
+        for (int i = 0; i < depth; i++) {
+            if (host_test_random(0, 1) == 0) {
+                for (int k = channel; k < channel + 4 && k < c->filter_dims.n; k++) {
+                    c->filter[k * depth + i] = 0;
+                }
+            }
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: pack_block_sparse
+********************************************************************************
+* Summary:
+*  Block sparse weights as tools/pack_weights.py writes them: the dense packed
+*  weights without their all-zero blocks, with the bitmap of the blocks left.
+*  Returns the weights and biases, block_map gets the bitmap.
+*
+*******************************************************************************/
+static std::vector<int32_t> pack_block_sparse(const conv_case_t* c, std::vector<uint32_t>* block_map,
+                                              tflite::PackedWeights* packed)
+{
+    const int depth = filter_depth(c);
+    const int groups = (c->filter_dims.n + 3) / 4;
+    const int map_words = tflite::PackedWeightsBlockMapWords(depth);
+    tflite::PackedWeights dense;
+    std::vector<int32_t> dense_buffer = pack_dense(c, &dense);
+    std::vector<int32_t> sparse;
+
+    block_map->assign(groups * map_words, 0);
+    for (int group = 0; group < groups; group++) {
+        for (int i = 0; i < depth; i++) {
+            const int32_t* block = dense.weights + (group * depth + i) * 2;
+            if (block[0] != 0 || block[1] != 0) {
+                sparse.push_back(block[0]);
+                sparse.push_back(block[1]);
+                (*block_map)[group * map_words + i / 32] |= 1u << (i % 32);
+            }
+        }
+    }
+    const size_t weight_words = sparse.size();
+    sparse.insert(sparse.end(), dense.bias, dense.bias + groups * 4);
+    packed->weights = sparse.data();
+    packed->bias = sparse.data() + weight_words;
+    packed->block_map = block_map->data();
+    return sparse;
+}
+
+
+static void test_conv_m0_s8(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        conv_case_t c;
+        tflite::PackedWeights packed;
+
+        random_conv_case(&c);
+        std::vector<int32_t> buffer = pack_dense(&c, &packed);
+        check_conv(&c, tflite::ConvM0S8, packed);
+    }
+}
+
+
+/* Pruned filters packed block sparse. SelectConvM0S8Kernel has no variant for them, they all run on ConvM0S8. */
+static void test_conv_m0_s8_block_sparse(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        conv_case_t c;
+        tflite::PackedWeights packed;
+        std::vector<uint32_t> block_map;
+
+        if (i % 3 == 0) {
+            make_conv_case(&c, 3, 3, 16, 16, 1, 1, 1, false);
+        } else {
+            random_conv_case(&c);
+        }
+        prune_blocks(&c);
+        std::vector<int32_t> buffer = pack_block_sparse(&c, &block_map, &packed);
+        HOST_TEST_EXPECT(tflite::SelectConvM0S8Kernel(&c.filter_dims, c.params.stride, c.params.dilation, packed) ==
+                         tflite::ConvM0S8);
+        check_conv(&c, tflite::ConvM0S8, packed);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_conv_m0_s8_variants
+********************************************************************************
+* Summary:
+*  The variants SelectConvM0S8Kernel returns for the layer shapes of the CNN,
+*  on dense inputs and on inputs with most pixels at the zero point, where the
+*  empty windows are skipped, and on a dense batch following a sparse one.
+*
+*******************************************************************************/
+static void test_conv_m0_s8_variants(void)
+{
+    static const int shapes[][3] = {
+        /*input depth, output depth, stride*/
+        {1, 16, 2},
+        {16, 16, 1},
+    };
+
+    for (const int* shape : shapes) {
+        for (int i = 0; i < RANDOM_CASES / 2; i++) {
+            conv_case_t c;
+            tflite::PackedWeights packed;
+
+            make_conv_case(&c, 3, 3, shape[0], shape[1], shape[2], shape[2], 1, (i & 1) != 0);
+            if (i % 4 == 3) {
+                /*A dense batch after a sparse one, read through the mask of the sparse one, with an empty top left window*/
+                const int h = c.input_dims.h;
+                const int w = c.input_dims.w;
+                const int depth = c.input_dims.c;
+                c.input_dims.n = c.output_dims.n = 2;
+                c.input.resize(2 * h * w * depth);
+                for (int pixel = 0; pixel < h * w; pixel++) {
+                    const bool empty = pixel / w < 3 && pixel % w < 3 &&
+                                       900 < (100 - TF_LITE_CONV_M0_SPARSE_DENSITY) * h * w;
+                    for (int k = 0; k < depth; k++) {
+                        c.input[(h * w + pixel) * depth + k] =
+                            (int8_t)(empty ? -c.params.input_offset : host_test_random(-128, 127));
+                    }
+                }
+            }
+            std::vector<int32_t> buffer = pack_dense(&c, &packed);
+            const tflite::ConvM0S8Kernel kernel =
+                tflite::SelectConvM0S8Kernel(&c.filter_dims, c.params.stride, c.params.dilation, packed);
+            HOST_TEST_EXPECT(kernel != tflite::ConvM0S8);
+            HOST_TEST_EXPECT(tflite::ConvM0S8GetOccupancyBufferSize(kernel, &c.input_dims) ==
+                             (int32_t)(c.input_dims.n * (1 + c.input_dims.h) * sizeof(uint32_t)));
+            check_conv(&c, kernel, packed);
+        }
+    }
+}
+
+
+/* Half open range of the input a range of output rows or columns reads, clipped to the input. */
+static void input_range(int out_start, int out_end, int stride, int filter, int padding, int size, int* start,
+                        int* end)
+{
+    *start = out_start * stride - padding;
+    *end = (out_end - 1) * stride - padding + filter;
+    *start = *start < 0 ? 0 : *start;
+    *end = *end > size ? size : *end;
+}
+
+
+/*******************************************************************************
+* Function Name: test_conv_m0_s8_variant_windows
+********************************************************************************
+* Summary:
+*  The variants on windows of sparse inputs, as the time sliced convolution,
+*  the fused max pool and the patch stack call them: every block of output
+*  rows and columns is computed from a copy of the input it reads, with the
+*  mask of the whole input built once and offset to the window. The blocks
+*  have to give the reference output.
+*
+*******************************************************************************/
+static void test_conv_m0_s8_variant_windows(void)
+{
+    static const int shapes[][3] = {
+        /*input depth, output depth, stride*/
+        {1, 16, 2},
+        {16, 16, 1},
+    };
+
+    for (const int* shape : shapes) {
+        for (int i = 0; i < RANDOM_CASES / 4; i++) {
+            conv_case_t c;
+            tflite::PackedWeights packed;
+            std::vector<uint32_t> mask;
+            std::vector<int8_t> empty_output;
+
+            make_conv_case(&c, 3, 3, shape[0], shape[1], shape[2], shape[2], 1, true);
+            std::vector<int32_t> weights = pack_dense(&c, &packed);
+            const tflite::ConvM0S8Kernel kernel =
+                tflite::SelectConvM0S8Kernel(&c.filter_dims, c.params.stride, c.params.dilation, packed);
+            if (!HOST_TEST_EXPECT(make_occupancy(&c, kernel, packed, &mask, &empty_output))) {
+                continue;
+            }
+            const std::vector<int8_t> expected = reference_conv(&c);
+            std::vector<int8_t> col(tflite::ConvM0S8GetBufferSize(&c.filter_dims));
+            cmsis_nn_context ctx = {col.data(), (int32_t)col.size()};
+            cmsis_nn_per_channel_quant_params quant_params = {c.multiplier.data(), c.shift.data()};
+            const int block_height = host_test_random(1, c.output_dims.h);
+            const int block_width = host_test_random(1, c.output_dims.w);
+            const int depth = c.input_dims.c;
+
+            for (int batch = 0; batch < c.input_dims.n; batch++) {
+                for (int y = 0; y < c.output_dims.h; y += block_height) {
+                    for (int x = 0; x < c.output_dims.w; x += block_width) {
+                        const int y_end = std::min(y + block_height, c.output_dims.h);
+                        const int x_end = std::min(x + block_width, c.output_dims.w);
+                        int row_start, row_end, col_start, col_end;
+                        input_range(y, y_end, c.params.stride.h, 3, c.params.padding.h, c.input_dims.h, &row_start,
+                                    &row_end);
+                        input_range(x, x_end, c.params.stride.w, 3, c.params.padding.w, c.input_dims.w, &col_start,
+                                    &col_end);
+
+                        const cmsis_nn_dims window_dims = {1, row_end - row_start, col_end - col_start, depth};
+                        const cmsis_nn_dims output_dims = {1, y_end - y, x_end - x, c.output_dims.c};
+                        cmsis_nn_conv_params params = c.params;
+                        params.padding.h = row_start - (y * c.params.stride.h - c.params.padding.h);
+                        params.padding.w = col_start - (x * c.params.stride.w - c.params.padding.w);
+                        std::vector<int8_t> window;
+                        for (int row = row_start; row < row_end; row++) {
+                            const int8_t* in =
+                                &c.input[((batch * c.input_dims.h + row) * c.input_dims.w + col_start) * depth];
+                            window.insert(window.end(), in, in + window_dims.w * depth);
+                        }
+                        std::vector<int8_t> output(output_dims.h * output_dims.w * output_dims.c);
+                        const tflite::ConvM0Occupancy occupancy = tflite::ConvM0S8Occupancy(
+                            mask.data(), &c.input_dims, batch, row_start, col_start, empty_output.data());
+
+                        HOST_TEST_EXPECT_EQ_CASE(kernel(&ctx, &params, &quant_params, &window_dims, window.data(),
+                                                        &c.filter_dims, packed, &output_dims, output.data(),
+                                                        &occupancy),
+                                                 ARM_CMSIS_NN_SUCCESS, describe(&c));
+                        for (int oy = y; oy < y_end; oy++) {
+                            const int8_t* expected_row =
+                                &expected[((batch * c.output_dims.h + oy) * c.output_dims.w + x) * c.output_dims.c];
+                            const int8_t* output_row = &output[(oy - y) * output_dims.w * output_dims.c];
+                            HOST_TEST_EXPECT_EQ_CASE(
+                                memcmp(output_row, expected_row, output_dims.w * output_dims.c), 0, describe(&c));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_conv_m0_s4
+********************************************************************************
+* Summary:
+*  ConvM0S4 on int4 filters, packed two per byte with the low nibble first and
+*  with the biases folded as PrepareInt4Weights does, against the reference
+*  convolution of the same filters as int8.
+*
+*******************************************************************************/
+static void test_conv_m0_s4(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        conv_case_t c;
+
+        random_conv_case(&c);
+        const int depth = filter_depth(&c);
+        std::vector<uint8_t> nibbles((c.filter.size() + 1) / 2, 0);
+        for (size_t k = 0; k < c.filter.size(); k++) {
+            c.filter[k] = (int8_t)host_test_random(-8, 7);
+            nibbles[k / 2] |= (uint8_t)((c.filter[k] & 0xf) << ((k & 1) * 4));
+        }
+        std::vector<int32_t> folded_bias((c.filter_dims.n + 3) / 4 * 4, 0);
+        for (int channel = 0; channel < c.filter_dims.n; channel++) {
+            int32_t sum = 0;
+            for (int k = 0; k < depth; k++) {
+                HOST_TEST_EXPECT_EQ(tflite::Int4WeightAt(nibbles.data(), channel * depth + k),
+                                    c.filter[channel * depth + k]);
+                sum += c.filter[channel * depth + k];
+            }
+            folded_bias[channel] = c.bias[channel] + c.params.input_offset * sum;
+        }
+        const tflite::Int4Weights weights = {nibbles.data(), folded_bias.data()};
+
+        std::vector<int8_t> expected = reference_conv(&c);
+        std::vector<int8_t> output(expected.size());
+        std::vector<int8_t> buffer(tflite::ConvM0S8GetBufferSize(&c.filter_dims));
+        cmsis_nn_context ctx = {buffer.data(), (int32_t)buffer.size()};
+        cmsis_nn_per_channel_quant_params quant_params = {c.multiplier.data(), c.shift.data()};
+        const arm_cmsis_nn_status status = tflite::ConvM0S4(&ctx, &c.params, &quant_params, &c.input_dims,
+                                                            c.input.data(), &c.filter_dims, weights,
+                                                            &c.output_dims, output.data());
+        HOST_TEST_EXPECT_EQ_CASE(status, ARM_CMSIS_NN_SUCCESS, describe(&c));
+        for (size_t k = 0; k < output.size(); k++) {
+            if (!HOST_TEST_EXPECT_EQ_CASE(output[k], expected[k], describe(&c))) {
+                break;
+            }
+        }
+    }
+}
+
+
+/* Dense and, every other case, pruned and block sparse weights. */
+static void test_fully_connected_m0_s8(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        conv_case_t c;
+        tflite::PackedWeights packed;
+        std::vector<uint32_t> block_map;
+        std::vector<int32_t> buffer;
+
+        /*A 1x1 convolution of a 1x1 input holds the data of a fully connected layer*/
+        make_conv_case(&c, 1, 1, host_test_random(1, 80), host_test_random(1, 12), 1, 1, 1, false);
+        c.input_dims.h = c.input_dims.w = c.output_dims.h = c.output_dims.w = 1;
+        c.params.padding.h = c.params.padding.w = 0;
+        c.input.resize(c.input_dims.n * c.input_dims.c);
+        if ((i & 1) != 0) {
+            prune_blocks(&c);
+            buffer = pack_block_sparse(&c, &block_map, &packed);
+        } else {
+            buffer = pack_dense(&c, &packed);
+        }
+
+        tflite::FullyConnectedParams op_params = {};
+        op_params.input_offset = c.params.input_offset;
+        op_params.weights_offset = 0;
+        op_params.output_offset = c.params.output_offset;
+        op_params.output_multiplier = c.multiplier[0];
+        op_params.output_shift = c.shift[0];
+        op_params.quantized_activation_min = c.params.activation.min;
+        op_params.quantized_activation_max = c.params.activation.max;
+        std::vector<int8_t> expected(c.input_dims.n * c.filter_dims.n);
+        tflite::reference_integer_ops::FullyConnected(
+            op_params, host_test_shape(c.input_dims.n, c.input_dims.c), c.input.data(),
+            host_test_shape(c.filter_dims.n, c.filter_dims.c), c.filter.data(),
+            host_test_shape(c.filter_dims.n), c.bias.data(),
+            host_test_shape(c.input_dims.n, c.filter_dims.n), expected.data());
+
+        cmsis_nn_fc_params fc_params = {};
+        fc_params.input_offset = c.params.input_offset;
+        fc_params.filter_offset = 0;
+        fc_params.output_offset = c.params.output_offset;
+        fc_params.activation = c.params.activation;
+        cmsis_nn_per_tensor_quant_params quant_params = {c.multiplier[0], c.shift[0]};
+        cmsis_nn_dims output_dims = {c.input_dims.n, 1, 1, c.filter_dims.n};
+        std::vector<int8_t> output(expected.size());
+        const arm_cmsis_nn_status status = tflite::FullyConnectedM0S8(
+            &fc_params, &quant_params, &c.input_dims, c.input.data(), packed, &output_dims, output.data());
+        HOST_TEST_EXPECT_EQ_CASE(status, ARM_CMSIS_NN_SUCCESS, describe(&c));
+        for (size_t k = 0; k < output.size(); k++) {
+            if (!HOST_TEST_EXPECT_EQ_CASE(output[k], expected[k], describe(&c))) {
+                break;
+            }
+        }
+    }
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_conv_m0_s8);
+    HOST_TEST_RUN(test_conv_m0_s8_variants);
+    HOST_TEST_RUN(test_conv_m0_s8_variant_windows);
+    HOST_TEST_RUN(test_conv_m0_s4);
+    HOST_TEST_RUN(test_conv_m0_s8_block_sparse);
+    HOST_TEST_RUN(test_fully_connected_m0_s8);
+    return host_test_result();
+}
@@ -0,0 +1,270 @@
+/*
+ * conv_max_pool_test.cpp
+ *
+ *  Fused CONV_2D_MAX_POOL_2D against the CONV_2D and MAX_POOL_2D it replaces,
+ *  on models built for the test: pool strides equal to, smaller and larger
+ *  than the pool size, SAME and VALID padding of both operators, and pooling
+ *  windows that wrap around the ring buffer of convolution rows, on dense
+ *  inputs and on inputs with most pixels at the zero point, whose empty
+ *  windows the shape specialized convolution kernels skip. The fused operator
+ *  has to give the output of the pair byte for byte, with Invoke() and one
+ *  pooled row at a time with InvokeStep.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "host_test.h"
+#include "model_builder.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define ARENA_SIZE                  (64 * 1024)
+#define RANDOM_INPUTS               (8)
+#define OUTPUT_CANARY               (0x5A)
+
+typedef struct {
+    int height;
+    int width;
+    int stride_height;
+    int stride_width;
+    tflite::Padding padding;
+    tflite::ActivationFunctionType activation;
+} window_t;
+
+typedef struct {
+    const char* name;
+    /*Shape of the input and depth of the convolution output, of a single batch: the CMSIS-NN
+      MAX_POOL_2D of the tree pools the first batch only*/
+    int input_height;
+    int input_width;
+    int input_depth;
+    int output_depth;
+    window_t conv;
+    int dilation;
+    window_t pool;
+} conv_pool_case_t;
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+
+
+static std::vector<int32_t> random_values(size_t count, int32_t low, int32_t high)
+{
+    std::vector<int32_t> values(count);
+
+    for (size_t i = 0; i < count; i++) {
+        values[i] = host_test_random(low, high);
+    }
+    return values;
+}
+
+
+/* Output size of a window sliding over size, as ComputePaddingHeightWidth gives it. */
+static int window_output_size(tflite::Padding padding, int size, int window, int stride, int dilation)
+{
+    const int effective_window = (window - 1) * dilation + 1;
+
+    return padding == tflite::Padding_SAME ? (size + stride - 1) / stride
+                                           : (size - effective_window + stride) / stride;
+}
+
+
+/*******************************************************************************
+* Function Name: build_model
+********************************************************************************
+* Summary:
+*  CONV_2D with random per-channel weights and biases, followed by
+*  MAX_POOL_2D. The convolution output and the pooled output have the same
+*  quantization, as the fusion requires. Returns the number of pooled rows.
+*
+*******************************************************************************/
+static int build_model(host_test_model_t* model, const conv_pool_case_t* test_case, const tflite::Model** built)
+{
+    const float input_scale = 0.05f;
+    const float output_scale = 0.4f;
+    const int conv_height = window_output_size(test_case->conv.padding, test_case->input_height,
+                                               test_case->conv.height, test_case->conv.stride_height,
+                                               test_case->dilation);
+    const int conv_width = window_output_size(test_case->conv.padding, test_case->input_width,
+                                              test_case->conv.width, test_case->conv.stride_width,
+                                              test_case->dilation);
+    const int pooled_height = window_output_size(test_case->pool.padding, conv_height, test_case->pool.height,
+                                                 test_case->pool.stride_height, 1);
+    const int pooled_width = window_output_size(test_case->pool.padding, conv_width, test_case->pool.width,
+                                                test_case->pool.stride_width, 1);
+
+    std::vector<float> filter_scales(test_case->output_depth);
+    std::vector<float> bias_scales(test_case->output_depth);
+    for (int channel = 0; channel < test_case->output_depth; channel++) {
+        filter_scales[channel] = 0.005f + 0.001f * (float)host_test_random(0, 15);
+        bias_scales[channel] = input_scale * filter_scales[channel];
+    }
+    std::vector<int8_t> filter_values;
+    for (int32_t value : random_values((size_t)test_case->output_depth * test_case->conv.height *
+                                       test_case->conv.width * test_case->input_depth, -127, 127)) {
+        filter_values.push_back((int8_t)value);
+    }
+
+    const int input = host_test_model_tensor(
+        model, {1, test_case->input_height, test_case->input_width, test_case->input_depth},
+        tflite::TensorType_INT8, input_scale, host_test_random(-10, 10));
+    const int filter = host_test_model_constant(
+        model, {test_case->output_depth, test_case->conv.height, test_case->conv.width, test_case->input_depth},
+        tflite::TensorType_INT8, filter_scales, 0, filter_values);
+    const int bias = host_test_model_constant(model, {test_case->output_depth}, tflite::TensorType_INT32,
+                                              bias_scales, 0,
+                                              random_values(test_case->output_depth, -20000, 20000));
+    const int64_t output_zero_point = host_test_random(-10, 10);
+    const int intermediate = host_test_model_tensor(
+        model, {1, conv_height, conv_width, test_case->output_depth}, tflite::TensorType_INT8,
+        output_scale, output_zero_point);
+    const int output = host_test_model_tensor(
+        model, {1, pooled_height, pooled_width, test_case->output_depth}, tflite::TensorType_INT8,
+        output_scale, output_zero_point);
+
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+    const auto conv_options = tflite::CreateConv2DOptions(
+        builder, test_case->conv.padding, test_case->conv.stride_width, test_case->conv.stride_height,
+        test_case->conv.activation, test_case->dilation, test_case->dilation);
+    host_test_model_operator(model, tflite::BuiltinOperator_CONV_2D, {input, filter, bias}, {intermediate},
+                             tflite::BuiltinOptions_Conv2DOptions, conv_options.Union());
+    const auto pool_options = tflite::CreatePool2DOptions(
+        builder, test_case->pool.padding, test_case->pool.stride_width, test_case->pool.stride_height,
+        test_case->pool.width, test_case->pool.height, test_case->pool.activation);
+    host_test_model_operator(model, tflite::BuiltinOperator_MAX_POOL_2D, {intermediate}, {output},
+                             tflite::BuiltinOptions_Pool2DOptions, pool_options.Union());
+
+    *built = host_test_model_finish(model, {input}, {output});
+    return pooled_height;
+}
+
+
+/* Writes input, after clearing the output: the unfused pair can put its output over its input. */
+static void set_input(tflite::MicroInterpreter* interpreter, const std::vector<int8_t>& input)
+{
+    TfLiteTensor* output = interpreter->output(0);
+
+    memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+    memcpy(interpreter->input(0)->data.int8, input.data(), input.size());
+}
+
+
+static std::vector<int8_t> output_of(tflite::MicroInterpreter* interpreter)
+{
+    const TfLiteTensor* output = interpreter->output(0);
+
+    return std::vector<int8_t>(output->data.int8, output->data.int8 + output->bytes);
+}
+
+
+/*******************************************************************************
+* Function Name: test_case
+********************************************************************************
+* Summary:
+*  Runs the model with the unfused pair, then fused, on random inputs, every
+*  other one sparse. The fused operator takes one step per pooled row, which
+*  shows that the pair was actually fused.
+*
+*******************************************************************************/
+static void test_case(const conv_pool_case_t* test_case)
+{
+    host_test_model_t model;
+    const tflite::Model* built;
+    const int pooled_rows = build_model(&model, test_case, &built);
+
+    std::vector<std::vector<int8_t>> inputs;
+    std::vector<std::vector<int8_t>> expected_outputs;
+    {
+        tflite::MicroMutableOpResolver<2> op_resolver;
+        op_resolver.AddConv2D();
+        op_resolver.AddMaxPool2D();
+        tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+        if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+            return;
+        }
+        const TfLiteTensor* input_tensor = interpreter.input(0);
+        const int depth = test_case->input_depth;
+        for (int i = 0; i < RANDOM_INPUTS; i++) {
+            std::vector<int8_t> input;
+            for (int32_t value : random_values(input_tensor->bytes, -128, 127)) {
+                input.push_back((int8_t)value);
+            }
+            /*Sparse inputs keep one pixel in ten*/
+            for (size_t pixel = 0; (i & 1) != 0 && pixel < input.size(); pixel += depth) {
+                if (host_test_random(0, 9) != 0) {
+                    memset(&input[pixel], (int8_t)input_tensor->params.zero_point, depth);
+                }
+            }
+            inputs.push_back(input);
+            set_input(&interpreter, input);
+            HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+            expected_outputs.push_back(output_of(&interpreter));
+        }
+    }
+
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    op_resolver.AddConv2D();
+    op_resolver.AddMaxPool2D();
+    op_resolver.AddConv2DMaxPool2D();
+    tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+    if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk) ||
+        !HOST_TEST_EXPECT(interpreter.PrepareLeanInvoke() == kTfLiteOk)) {
+        return;
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+        set_input(&interpreter, inputs[i]);
+        HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+        HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+
+        set_input(&interpreter, inputs[i]);
+        tflite::InvokeResumeToken token;
+        int steps = 0;
+        while (!token.finished && HOST_TEST_EXPECT(interpreter.InvokeStep(&token) == kTfLiteOk) &&
+               steps <= pooled_rows) {
+            steps++;
+        }
+        HOST_TEST_EXPECT_EQ(steps, pooled_rows);
+        HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+    }
+}
+
+
+int main(void)
+{
+    const tflite::Padding SAME = tflite::Padding_SAME;
+    const tflite::Padding VALID = tflite::Padding_VALID;
+    const tflite::ActivationFunctionType NONE = tflite::ActivationFunctionType_NONE;
+    const tflite::ActivationFunctionType RELU = tflite::ActivationFunctionType_RELU;
+    const tflite::ActivationFunctionType RELU6 = tflite::ActivationFunctionType_RELU6;
+    const conv_pool_case_t cases[] = {
+        /*The pair of the CNN, with the shape specialized convolution kernel*/
+        {"3x3 conv 16 channels, 2x2 pool stride 2 VALID", 14, 14, 16, 16, {3, 3, 1, 1, SAME, NONE}, 1,
+         {2, 2, 2, 2, VALID, NONE}},
+        {"3x3 conv stride 2 on 1 channel, 2x2 pool stride 2 VALID", 28, 28, 1, 16, {3, 3, 2, 2, SAME, NONE}, 1,
+         {2, 2, 2, 2, VALID, NONE}},
+        {"2x2 pool stride 2 VALID, relu", 12, 12, 3, 8, {3, 3, 1, 1, SAME, RELU}, 1, {2, 2, 2, 2, VALID, NONE}},
+        /*Windows overlap by a row: rows 2, 3 and 4 are in ring slots 2, 0 and 1*/
+        {"3x3 pool stride 2 SAME", 13, 11, 2, 4, {3, 3, 1, 1, SAME, NONE}, 1, {3, 3, 2, 2, SAME, NONE}},
+        {"3x3 pool stride 2 VALID, odd sizes", 11, 9, 3, 5, {3, 3, 1, 1, VALID, NONE}, 1,
+         {3, 3, 2, 2, VALID, RELU}},
+        /*Every window but the first wraps around the ring*/
+        {"3x3 pool stride 1 VALID", 11, 9, 2, 4, {3, 3, 1, 1, VALID, NONE}, 1, {3, 3, 1, 1, VALID, NONE}},
+        {"3x2 pool stride 2x1 SAME, conv stride 2", 15, 13, 4, 4, {3, 3, 2, 2, SAME, NONE}, 1,
+         {3, 2, 2, 1, SAME, NONE}},
+        /*Convolution rows in between two windows are never computed*/
+        {"2x2 pool stride 3 VALID", 14, 14, 1, 8, {3, 3, 1, 1, SAME, RELU}, 1, {2, 2, 3, 3, VALID, NONE}},
+        {"2x3 pool stride 3x2 SAME", 13, 12, 2, 4, {2, 2, 1, 1, VALID, NONE}, 1, {2, 3, 3, 2, SAME, NONE}},
+        {"dilated conv VALID, 2x2 pool stride 2 SAME, relu6", 12, 11, 3, 4, {3, 3, 1, 1, VALID, NONE}, 2,
+         {2, 2, 2, 2, SAME, RELU6}},
+        {"5x5 conv stride 2, 3x3 pool stride 2 SAME", 17, 15, 2, 4, {5, 5, 2, 2, SAME, RELU}, 1,
+         {3, 3, 2, 2, SAME, NONE}},
+    };
+
+    for (const conv_pool_case_t& conv_pool_case : cases) {
+        printf("test_case: %s\n", conv_pool_case.name);
+        test_case(&conv_pool_case);
+    }
+    return host_test_result();
+}
@@ -0,0 +1,79 @@
+/*
+ * host_test.h
+ *
+ *  Checks shared by the host tests. A failed check prints its location and
+ *  the values compared, and the test goes on so that one run reports all the
+ *  failures; host_test_result() is the exit code of main(). The random cases
+ *  come from a fixed seed, so a failure is reproduced by running the test
+ *  again.
+ */
+
+#ifndef TESTS_HOST_TEST_H_
+#define TESTS_HOST_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <random>
+
+#define HOST_TEST_SEED              (20231003u)
+
+/* The arguments are evaluated once, so they can have side effects. */
+#define HOST_TEST_EXPECT(condition) \
+    host_test_check((condition), #condition, "", 0, 0, __FILE__, __LINE__)
+
+#define HOST_TEST_EXPECT_EQ(actual, expected) \
+    host_test_check_eq((long long)(actual), (long long)(expected), #actual " == " #expected, "", \
+                       __FILE__, __LINE__)
+
+/* Same as HOST_TEST_EXPECT_EQ, with the random case that failed in the message. */
+#define HOST_TEST_EXPECT_EQ_CASE(actual, expected, test_case) \
+    host_test_check_eq((long long)(actual), (long long)(expected), #actual " == " #expected, (test_case), \
+                       __FILE__, __LINE__)
+
+#define HOST_TEST_RUN(function) \
+    do { \
+        printf("%s\n", #function); \
+        function(); \
+    } while (0)
+
+static int host_test_checks = 0;
+static int host_test_failures = 0;
+
+static inline bool host_test_check(bool passed, const char* text, const char* test_case,
+                                   long long actual, long long expected, const char* file, int line)
+{
+    host_test_checks++;
+    if (!passed) {
+        /*Only the first failures, a broken kernel fails every element*/
+        if (host_test_failures < 20) {
+            printf("%s:%d: FAILED %s (%lld, expected %lld) %s\n", file, line, text, actual,
+                   expected, test_case);
+        }
+        host_test_failures++;
+    }
+    return passed;
+}
+
+static inline bool host_test_check_eq(long long actual, long long expected, const char* text, const char* test_case,
+                                      const char* file, int line)
+{
+    return host_test_check(actual == expected, text, test_case, actual, expected, file, line);
+}
+
+/* Random integer in [low, high] from the generator of the test. */
+static inline int32_t host_test_random(int32_t low, int32_t high)
+{
+    static std::mt19937 generator(HOST_TEST_SEED);
+
+    return std::uniform_int_distribution<int32_t>(low, high)(generator);
+}
+
+/* Prints the number of checks and failures, and returns the exit code of the test. */
+static inline int host_test_result(void)
+{
+    printf("%d checks, %d failed\n", host_test_checks, host_test_failures);
+    return host_test_failures == 0 ? 0 : 1;
+}
+
+#endif /* TESTS_HOST_TEST_H_ */
@@ -0,0 +1,141 @@
+/*
+ * image_rescale_test.cpp
+ *
+ *  rescale_image, which counts the 4x4 blocks of the stroke matrix a word at
+ *  a time with a SWAR popcount, against the loop it replaced, which reads
+ *  the 16 bits of every block one by one. Both have to give the same image
+ *  on empty and full matrices, on single bits at every position of a word and
+ *  at the boundaries between words and rows, and on random matrices of every
+ *  density.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "image_rescale.h"
+#include "intensity_LUT.h"
+
+#define RANDOM_MATRICES             (500)
+
+#define SET_BIT(matrix, row, col)   ((matrix)->data[row][(col) >> 4] |= (1U << ((col) & 0x0F)))
+#define READ_BIT(matrix, row, col)  (((matrix)->data[row][(col) >> 4] >> ((col) & 0x0F)) & 0x01)
+
+static BitMatrix112x112 matrix;
+
+
+/* The per-bit loop of the original application, as the reference. */
+static void rescale_image_reference(BitMatrix112x112* raw_data, uint8_t input_data[28][28])
+{
+    for (int row = 0; row < 28; row++) {
+        for (int col = 0; col < 28; col++) {
+            int sum = 0;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    if (READ_BIT(raw_data, row * 4 + i, col * 4 + j) == 1) {
+                        sum++;
+                    }
+                }
+            }
+            input_data[row][col] = intensity_table[sum];
+        }
+    }
+}
+
+
+/* Rescales matrix both ways; the output is filled beforehand, so that every pixel has to be written. */
+static void expect_reference(const char* name)
+{
+    uint8_t expected[28][28];
+    uint8_t output[28][28];
+
+    memset(expected, 0xA5, sizeof(expected));
+    memset(output, 0x5A, sizeof(output));
+    rescale_image_reference(&matrix, expected);
+    rescale_image(&matrix, output);
+    HOST_TEST_EXPECT_EQ_CASE(memcmp(output, expected, sizeof(output)), 0, name);
+}
+
+
+static void test_uniform(void)
+{
+    memset(&matrix, 0, sizeof(matrix));
+    expect_reference("all clear");
+    memset(&matrix, 0xff, sizeof(matrix));
+    expect_reference("all set");
+
+    /*Every block count from 0 to 16, on every block, in the top-left corner of the blocks first*/
+    for (int count = 0; count <= 16; count++) {
+        memset(&matrix, 0, sizeof(matrix));
+        for (int row = 0; row < 112; row++) {
+            for (int col = 0; col < 112; col++) {
+                if ((row % 4) * 4 + (col % 4) < count) {
+                    SET_BIT(&matrix, row, col);
+                }
+            }
+        }
+        expect_reference("uniform count");
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_single_bits
+********************************************************************************
+* Summary:
+*  A single bit set at every position of the first block row and of the
+*  last one, which covers every bit of a word and of each of its 4 blocks,
+*  the 7 words of a row and the 4 rows of a block. Then a single bit clear
+*  in a full matrix, at the same positions.
+*
+*******************************************************************************/
+static void test_single_bits(void)
+{
+    const int rows[] = {0, 1, 2, 3, 52, 55, 108, 109, 110, 111};
+
+    for (int row : rows) {
+        for (int col = 0; col < 112; col++) {
+            memset(&matrix, 0, sizeof(matrix));
+            SET_BIT(&matrix, row, col);
+            expect_reference("single bit set");
+
+            memset(&matrix, 0xff, sizeof(matrix));
+            matrix.data[row][col >> 4] &= ~(1U << (col & 0x0F));
+            expect_reference("single bit clear");
+        }
+    }
+}
+
+
+/* Random matrices, from almost empty to almost full, and random single words. */
+static void test_random(void)
+{
+    for (int i = 0; i < RANDOM_MATRICES; i++) {
+        const int density = host_test_random(0, 16);
+        for (int row = 0; row < 112; row++) {
+            for (int word = 0; word < 7; word++) {
+                uint16_t value = 0;
+                for (int bit = 0; bit < 16; bit++) {
+                    if (host_test_random(0, 15) < density) {
+                        value |= (uint16_t)(1u << bit);
+                    }
+                }
+                matrix.data[row][word] = value;
+            }
+        }
+        expect_reference("random density");
+
+        memset(&matrix, 0, sizeof(matrix));
+        matrix.data[host_test_random(0, 111)][host_test_random(0, 6)] = (uint16_t)host_test_random(0, 0xffff);
+        expect_reference("random word");
+    }
+}
+
+
+int main(void)
+{
+    test_uniform();
+    test_single_bits();
+    test_random();
+    return host_test_result();
+}
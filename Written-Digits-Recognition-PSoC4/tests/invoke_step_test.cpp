@@ -0,0 +1,174 @@
+/*
+ * invoke_step_test.cpp
+ *
+ *  Time sliced invoke of MicroInterpreter (InvokeStep, InvokeFor) on the CNN
+ *  of models/, with the plain graph, the fused operators and patch based
+ *  execution of its leading layers at several tile sizes. An inference run
+ *  step by step has to give the output of Invoke() byte for byte, which also
+ *  has to be the output of the plain graph.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "cnn_test.h"
+#include "host_test.h"
+#include "packed_weights.h"
+#include "tensorflow/lite/micro/fake_micro_time.h"
+
+#define RANDOM_INPUTS               (12)
+#define OUTPUT_CANARY               (0x5A)
+/*Budget of InvokeFor, with every read of the time taking one tick*/
+#define SLICE_TICKS                 (5u)
+
+typedef struct {
+    const char* name;
+    bool fused;
+    bool packed;
+    tflite::PatchExecutionConfig patch;
+    /*Steps of an inference: a CONV_2D takes one per output row, a PATCH_CONV_STACK one per tile*/
+    int steps;
+} graph_config_t;
+
+alignas(16) static uint8_t arena[HOST_TEST_CNN_ARENA_SIZE];
+static std::vector<std::vector<uint8_t>> inputs;
+static std::vector<std::vector<uint8_t>> expected_outputs;
+
+
+static std::vector<uint8_t> output_of(tflite::MicroInterpreter* interpreter)
+{
+    const TfLiteTensor* output = interpreter->output(0);
+
+    return std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes);
+}
+
+
+static void clear_output(tflite::MicroInterpreter* interpreter)
+{
+    TfLiteTensor* output = interpreter->output(0);
+
+    memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+}
+
+
+/* Outputs of the plain graph, run by Invoke(), which every configuration has to give. */
+static void compute_expected_outputs(void)
+{
+    host_test_cnn_resolver_t op_resolver;
+    host_test_cnn_ops(&op_resolver, false);
+    tflite::MicroInterpreter interpreter(host_test_cnn_model(), op_resolver, arena, sizeof(arena));
+    HOST_TEST_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+    for (int i = 0; i < RANDOM_INPUTS; i++) {
+        inputs.push_back(host_test_random_image());
+        expected_outputs.push_back(host_test_invoke(&interpreter, inputs.back()));
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: run_steps
+********************************************************************************
+* Summary:
+*  Runs a whole inference with InvokeStep, or with InvokeFor slices of
+*  SLICE_TICKS if sliced is set, and returns the number of calls it took.
+*  The token has to be finished after the last call only.
+*
+*******************************************************************************/
+static int run_steps(tflite::MicroInterpreter* interpreter, tflite::InvokeResumeToken* token, bool sliced)
+{
+    int calls = 0;
+
+    while (!token->finished) {
+        const TfLiteStatus status =
+            sliced ? interpreter->InvokeFor(SLICE_TICKS, token) : interpreter->InvokeStep(token);
+        if (!HOST_TEST_EXPECT(status == kTfLiteOk) || !HOST_TEST_EXPECT(calls < 100000)) {
+            break;
+        }
+        calls++;
+    }
+    return calls;
+}
+
+
+/*******************************************************************************
+* Function Name: test_graph
+********************************************************************************
+* Summary:
+*  On every input: Invoke(), InvokeStep and InvokeFor all give the output
+*  of the plain graph. A finished token runs nothing, neither with InvokeStep
+*  nor with InvokeFor, and a new token starts the next inference over.
+*
+*******************************************************************************/
+static void test_graph(const graph_config_t* config)
+{
+    host_test_cnn_resolver_t op_resolver;
+    host_test_cnn_ops(&op_resolver, config->fused);
+    tflite::MicroInterpreter interpreter(host_test_cnn_model(), op_resolver, arena, sizeof(arena));
+
+    if (config->packed) {
+        HOST_TEST_EXPECT_EQ(interpreter.SetPackedWeights(&packed_weights), kTfLiteOk);
+    }
+    HOST_TEST_EXPECT_EQ(interpreter.SetPatchExecutionConfig(config->patch), kTfLiteOk);
+    if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk) ||
+        !HOST_TEST_EXPECT(interpreter.PrepareLeanInvoke() == kTfLiteOk)) {
+        return;
+    }
+
+    int slices = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        HOST_TEST_EXPECT(host_test_invoke(&interpreter, inputs[i]) == expected_outputs[i]);
+
+        /*The output can share memory with the input, which is written last*/
+        clear_output(&interpreter);
+        memcpy(interpreter.input(0)->data.uint8, inputs[i].data(), inputs[i].size());
+        tflite::InvokeResumeToken token;
+        HOST_TEST_EXPECT_EQ(run_steps(&interpreter, &token, false), config->steps);
+        HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+
+        /*Resuming a finished inference runs nothing*/
+        clear_output(&interpreter);
+        HOST_TEST_EXPECT_EQ(interpreter.InvokeStep(&token), kTfLiteOk);
+        HOST_TEST_EXPECT_EQ(interpreter.InvokeFor(SLICE_TICKS, &token), kTfLiteOk);
+        HOST_TEST_EXPECT(token.finished);
+        HOST_TEST_EXPECT(output_of(&interpreter) == std::vector<uint8_t>(expected_outputs[i].size(), OUTPUT_CANARY));
+
+        /*A new token starts over, here in slices*/
+        tflite::FakeMicroTime::Install(1);
+        clear_output(&interpreter);
+        memcpy(interpreter.input(0)->data.uint8, inputs[i].data(), inputs[i].size());
+        token = tflite::InvokeResumeToken();
+        slices = run_steps(&interpreter, &token, true);
+        tflite::FakeMicroTime::Uninstall();
+        HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+    }
+    /*Every read of the time takes a tick, so a slice runs several steps*/
+    printf("%d steps, %d slices of %u ticks\n", config->steps, slices, SLICE_TICKS);
+    HOST_TEST_EXPECT(slices > 1 && slices < config->steps);
+}
+
+
+int main(void)
+{
+    const graph_config_t configs[] = {
+        /*QUANTIZE, 3 CONV_2D of 14 rows, MAX_POOL_2D, MEAN, FULLY_CONNECTED, SOFTMAX, QUANTIZE*/
+        {"plain", false, false, host_test_patch_config(0, 0, 0), 1 + 3 * 14 + 5},
+        /*The last CONV_2D and the MAX_POOL_2D fused, into 7 pooled rows, and the classifier head*/
+        {"fused", true, false, host_test_patch_config(0, 0, 0), 1 + 2 * 14 + 7 + 2},
+        {"fused, packed weights", true, true, host_test_patch_config(0, 0, 0), 1 + 2 * 14 + 7 + 2},
+        /*Tiles of the 7x7 output of the MAX_POOL_2D*/
+        {"patched 4 layers, 2x4 tiles, packed weights", true, true, host_test_patch_config(4, 2, 4), 1 + 4 * 2 + 2},
+        {"patched 4 layers, 3x5 tiles", true, false, host_test_patch_config(4, 3, 5), 1 + 3 * 2 + 2},
+        /*Tiles of the 14x14 output of the last CONV_2D, then the MAX_POOL_2D alone*/
+        {"patched 3 layers, 5x3 tiles", true, false, host_test_patch_config(3, 5, 3), 1 + 3 * 5 + 1 + 2},
+    };
+
+    compute_expected_outputs();
+    for (const graph_config_t& config : configs) {
+        printf("test_graph: %s\n", config.name);
+        test_graph(&config);
+    }
+    return host_test_result();
+}
@@ -0,0 +1,54 @@
+/*
+ * kernel_test.h
+ *
+ *  Conversions from the CMSIS-NN arguments of the Cortex-M0+ kernels to the
+ *  arguments of the TFLite reference kernels they are compared with.
+ */
+
+#ifndef TESTS_KERNEL_TEST_H_
+#define TESTS_KERNEL_TEST_H_
+
+#include "Include/arm_nn_types.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+/* NHWC shape of a tensor. */
+static inline tflite::RuntimeShape host_test_shape(const cmsis_nn_dims& dims)
+{
+    const int32_t shape[4] = {dims.n, dims.h, dims.w, dims.c};
+
+    return tflite::RuntimeShape(4, shape);
+}
+
+/* One or two dimensional shape, for the biases and the fully connected tensors. */
+static inline tflite::RuntimeShape host_test_shape(int32_t size)
+{
+    return tflite::RuntimeShape(1, &size);
+}
+
+static inline tflite::RuntimeShape host_test_shape(int32_t rows, int32_t columns)
+{
+    const int32_t shape[2] = {rows, columns};
+
+    return tflite::RuntimeShape(2, shape);
+}
+
+/* ConvParams of reference_integer_ops::ConvPerChannel, whose filter offset is always 0. */
+static inline tflite::ConvParams host_test_conv_params(const cmsis_nn_conv_params& params)
+{
+    tflite::ConvParams op_params = {};
+
+    op_params.input_offset = params.input_offset;
+    op_params.weights_offset = 0;
+    op_params.output_offset = params.output_offset;
+    op_params.stride_height = params.stride.h;
+    op_params.stride_width = params.stride.w;
+    op_params.dilation_height_factor = params.dilation.h;
+    op_params.dilation_width_factor = params.dilation.w;
+    op_params.padding_values.height = params.padding.h;
+    op_params.padding_values.width = params.padding.w;
+    op_params.quantized_activation_min = params.activation.min;
+    op_params.quantized_activation_max = params.activation.max;
+    return op_params;
+}
+
+#endif /* TESTS_KERNEL_TEST_H_ */
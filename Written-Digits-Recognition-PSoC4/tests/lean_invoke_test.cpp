@@ -0,0 +1,118 @@
+/*
+ * lean_invoke_test.cpp
+ *
+ *  Lean invoke of MicroInterpreter (PrepareLeanInvoke, InvokeLean) on the
+ *  digit gatekeeper of models/: the same outputs as Invoke(), and an error,
+ *  with no node run, when the dispatch table was never built.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "digit-gatekeeper-8bit.h"
+#include "host_test.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define ARENA_SIZE                  (10000)
+#define OUTPUT_CANARY               (0x5A)
+#define RANDOM_INPUTS               (20)
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+
+
+static std::vector<uint8_t> random_input(const TfLiteTensor* tensor)
+{
+    std::vector<uint8_t> input(tensor->bytes);
+
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (uint8_t)host_test_random(0, 255);
+    }
+    return input;
+}
+
+
+/* The input is written before every inference: an inference may reuse its memory once it is read. */
+static void set_input(tflite::MicroInterpreter* interpreter, const std::vector<uint8_t>& input)
+{
+    memcpy(interpreter->input(0)->data.uint8, input.data(), input.size());
+}
+
+
+static std::vector<uint8_t> output_of(tflite::MicroInterpreter* interpreter)
+{
+    const TfLiteTensor* output = interpreter->output(0);
+
+    return std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes);
+}
+
+
+/*******************************************************************************
+* Function Name: test_lean_invoke
+********************************************************************************
+* Summary:
+*  Before PrepareLeanInvoke, InvokeLean and InvokeStep fail and leave the
+*  output as it was, so that a caller ignoring the status does not read the
+*  output of an earlier inference as a new one. After it, InvokeLean gives
+*  the output of Invoke() on random inputs.
+*
+*******************************************************************************/
+static void test_lean_invoke(void)
+{
+    tflite::MicroMutableOpResolver<3> op_resolver;
+
+    op_resolver.AddQuantize();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddFullyConnected();
+    tflite::MicroInterpreter interpreter(tflite::GetModel(digit_gatekeeper_8bit_tflite), op_resolver, arena,
+                                         ARENA_SIZE);
+    HOST_TEST_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+    TfLiteTensor* output = interpreter.output(0);
+    set_input(&interpreter, random_input(interpreter.input(0)));
+    memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+    HOST_TEST_EXPECT_EQ(interpreter.InvokeLean(), kTfLiteError);
+    tflite::InvokeResumeToken token;
+    HOST_TEST_EXPECT_EQ(interpreter.InvokeStep(&token), kTfLiteError);
+    HOST_TEST_EXPECT(!token.finished);
+    for (size_t i = 0; i < output->bytes; i++) {
+        HOST_TEST_EXPECT_EQ(output->data.uint8[i], OUTPUT_CANARY);
+    }
+
+    HOST_TEST_EXPECT_EQ(interpreter.PrepareLeanInvoke(), kTfLiteOk);
+    for (int i = 0; i < RANDOM_INPUTS; i++) {
+        const std::vector<uint8_t> input = random_input(interpreter.input(0));
+        set_input(&interpreter, input);
+        HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+        const std::vector<uint8_t> expected = output_of(&interpreter);
+        memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+        set_input(&interpreter, input);
+        HOST_TEST_EXPECT_EQ(interpreter.InvokeLean(), kTfLiteOk);
+        HOST_TEST_EXPECT(output_of(&interpreter) == expected);
+    }
+}
+
+
+/* PrepareLeanInvoke needs the tensors to be allocated. */
+static void test_prepare_before_allocation(void)
+{
+    tflite::MicroMutableOpResolver<3> op_resolver;
+
+    op_resolver.AddQuantize();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddFullyConnected();
+    tflite::MicroInterpreter interpreter(tflite::GetModel(digit_gatekeeper_8bit_tflite), op_resolver, arena,
+                                         ARENA_SIZE);
+    HOST_TEST_EXPECT_EQ(interpreter.PrepareLeanInvoke(), kTfLiteError);
+    HOST_TEST_EXPECT_EQ(interpreter.InvokeLean(), kTfLiteError);
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_lean_invoke);
+    HOST_TEST_RUN(test_prepare_before_allocation);
+    return host_test_result();
+}
@@ -0,0 +1,209 @@
+/*
+ * max_pool_swar_test.cpp
+ *
+ *  MaxPoolSwarS8 (kernels/max_pool_swar.h) against
+ *  reference_integer_ops::MaxPool and arm_max_pool_s8, on random shapes,
+ *  strides, padding, activation ranges and buffer alignments, and its lane
+ *  primitives against the int8 comparisons. The outputs have to be
+ *  bit-exact.
+ *
+ *  The test also prints the time of both kernels on a 2x2 pooling of a
+ *  14x14x16 tensor. A wide out-of-order core runs the byte loop of
+ *  arm_max_pool_s8 about as fast as the word loop, so that time only shows
+ *  that MaxPoolSwarS8 costs nothing on the host; the gain is on the
+ *  Cortex-M0+, which executes one instruction at a time.
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "host_test.h"
+#include "kernel_test.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+#include "tensorflow/lite/micro/kernels/max_pool_swar.h"
+
+#define RANDOM_CASES                (2000)
+#define TIMING_RUNS                 (20000)
+
+typedef struct {
+    cmsis_nn_dims input_dims;
+    cmsis_nn_dims filter_dims;
+    cmsis_nn_dims output_dims;
+    cmsis_nn_pool_params params;
+} pool_case_t;
+
+
+/* One line that identifies a case in the failure messages. */
+static const char* describe(const pool_case_t* c, int alignment)
+{
+    static char text[128];
+
+    snprintf(text, sizeof(text), "in %dx%dx%d filter %dx%d stride %d,%d pad %d,%d alignment %d",
+             c->input_dims.h, c->input_dims.w, c->input_dims.c, c->filter_dims.h, c->filter_dims.w,
+             c->params.stride.h, c->params.stride.w, c->params.padding.h, c->params.padding.w, alignment);
+    return text;
+}
+
+
+/* Output size and padding of one dimension, with SAME or VALID padding. */
+static void output_size(int input, int filter, int stride, bool same, int* output, int* padding)
+{
+    if (same) {
+        *output = (input + stride - 1) / stride;
+        const int total = (*output - 1) * stride + filter - input;
+        *padding = total > 0 ? total / 2 : 0;
+    } else {
+        *output = (input - filter) / stride + 1;
+        *padding = 0;
+    }
+}
+
+
+static void make_pool_case(pool_case_t* c, int height, int width, int depth, int filter, int stride, bool same)
+{
+    c->input_dims = {1, height, width, depth};
+    c->filter_dims = {1, filter, filter, 1};
+    c->params.stride = {stride, stride};
+    output_size(width, filter, stride, same, &c->output_dims.w, &c->params.padding.w);
+    output_size(height, filter, stride, same, &c->output_dims.h, &c->params.padding.h);
+    c->output_dims.n = 1;
+    c->output_dims.c = depth;
+    c->params.activation.min = host_test_random(0, 3) == 0 ? host_test_random(-128, 0) : -128;
+    c->params.activation.max = host_test_random(0, 3) == 0 ? host_test_random(0, 127) : 127;
+}
+
+
+static void reference_max_pool(const pool_case_t* c, const int8_t* input, int8_t* output)
+{
+    tflite::PoolParams op_params = {};
+
+    op_params.stride_height = c->params.stride.h;
+    op_params.stride_width = c->params.stride.w;
+    op_params.filter_height = c->filter_dims.h;
+    op_params.filter_width = c->filter_dims.w;
+    op_params.padding_values.height = c->params.padding.h;
+    op_params.padding_values.width = c->params.padding.w;
+    op_params.quantized_activation_min = c->params.activation.min;
+    op_params.quantized_activation_max = c->params.activation.max;
+    tflite::reference_integer_ops::MaxPool(op_params, host_test_shape(c->input_dims), input,
+                                           host_test_shape(c->output_dims), output);
+}
+
+
+/* Every pair of int8 values in every lane, the other lanes random. */
+static void test_lanes(void)
+{
+    for (int a = -128; a <= 127; a++) {
+        for (int b = -128; b <= 127; b++) {
+            const int lane = (a + b) & 3;
+            const uint32_t noise_a = (uint32_t)host_test_random(INT32_MIN, INT32_MAX) & ~(0xffu << (lane * 8));
+            const uint32_t noise_b = (uint32_t)host_test_random(INT32_MIN, INT32_MAX) & ~(0xffu << (lane * 8));
+            const uint32_t word_a = noise_a | ((uint32_t)(uint8_t)a << (lane * 8));
+            const uint32_t word_b = noise_b | ((uint32_t)(uint8_t)b << (lane * 8));
+
+            HOST_TEST_EXPECT_EQ((tflite::LessThanS8x4(word_a, word_b) >> (lane * 8)) & 0xff, a < b ? 0xff : 0);
+            HOST_TEST_EXPECT_EQ((int8_t)(tflite::MaxS8x4(word_a, word_b) >> (lane * 8)), std::max(a, b));
+            HOST_TEST_EXPECT_EQ((int8_t)(tflite::MinS8x4(word_a, word_b) >> (lane * 8)), std::min(a, b));
+        }
+        HOST_TEST_EXPECT_EQ(tflite::BroadcastS8x4(a), (uint32_t)(uint8_t)a * 0x01010101u);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_max_pool_swar_s8
+********************************************************************************
+* Summary:
+*  Random cases, with the input and output placed at every byte offset from a
+*  word, so that both the word path and the byte path are taken.
+*
+*******************************************************************************/
+static void test_max_pool_swar_s8(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        pool_case_t c;
+        const int filter = host_test_random(1, 3);
+        const int depth = host_test_random(0, 1) != 0 ? 4 * host_test_random(1, 5) : host_test_random(1, 20);
+        const int alignment = host_test_random(0, 3);
+
+        make_pool_case(&c, host_test_random(filter, filter + 12), host_test_random(filter, filter + 12), depth,
+                       filter, host_test_random(1, 3), host_test_random(0, 1) != 0);
+
+        const int input_count = c.input_dims.h * c.input_dims.w * depth;
+        const int output_count = c.output_dims.h * c.output_dims.w * depth;
+        std::vector<int32_t> input_words(input_count / 4 + 2);
+        std::vector<int32_t> output_words(output_count / 4 + 2);
+        int8_t* input = (int8_t*)input_words.data() + alignment;
+        int8_t* output = (int8_t*)output_words.data() + alignment;
+        std::vector<int8_t> expected(output_count);
+        std::vector<int8_t> cmsis_output(output_count);
+        cmsis_nn_context ctx = {nullptr, 0};
+
+        for (int k = 0; k < input_count; k++) {
+            input[k] = (int8_t)host_test_random(-128, 127);
+        }
+        reference_max_pool(&c, input, expected.data());
+        HOST_TEST_EXPECT_EQ_CASE(tflite::MaxPoolSwarS8(&ctx, &c.params, &c.input_dims, input, &c.filter_dims,
+                                                       &c.output_dims, output),
+                                 ARM_CMSIS_NN_SUCCESS, describe(&c, alignment));
+        HOST_TEST_EXPECT_EQ_CASE(arm_max_pool_s8(&ctx, &c.params, &c.input_dims, input, &c.filter_dims,
+                                                 &c.output_dims, cmsis_output.data()),
+                                 ARM_CMSIS_NN_SUCCESS, describe(&c, alignment));
+        for (int k = 0; k < output_count; k++) {
+            if (!HOST_TEST_EXPECT_EQ_CASE(output[k], expected[k], describe(&c, alignment)) ||
+                !HOST_TEST_EXPECT_EQ_CASE(cmsis_output[k], expected[k], describe(&c, alignment))) {
+                break;
+            }
+        }
+    }
+}
+
+
+/* Mean time of a call, in ns, over TIMING_RUNS runs. */
+template <typename Kernel>
+static double time_kernel(Kernel kernel)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < TIMING_RUNS; i++) {
+        kernel();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / TIMING_RUNS;
+}
+
+
+static void test_max_pool_swar_s8_timing(void)
+{
+    pool_case_t c;
+    std::vector<int32_t> input_words(14 * 14 * 16 / 4);
+    std::vector<int32_t> output_words(7 * 7 * 16 / 4);
+    int8_t* input = (int8_t*)input_words.data();
+    int8_t* output = (int8_t*)output_words.data();
+    cmsis_nn_context ctx = {nullptr, 0};
+
+    make_pool_case(&c, 14, 14, 16, 2, 2, false);
+    c.params.activation = {-128, 127};
+    for (size_t k = 0; k < input_words.size() * 4; k++) {
+        input[k] = (int8_t)host_test_random(-128, 127);
+    }
+    const double swar = time_kernel([&]() {
+        tflite::MaxPoolSwarS8(&ctx, &c.params, &c.input_dims, input, &c.filter_dims, &c.output_dims, output);
+    });
+    const double cmsis = time_kernel([&]() {
+        arm_max_pool_s8(&ctx, &c.params, &c.input_dims, input, &c.filter_dims, &c.output_dims, output);
+    });
+    printf("  2x2 pooling of 14x14x16 on the host: MaxPoolSwarS8 %.0f ns, arm_max_pool_s8 %.0f ns\n", swar, cmsis);
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_lanes);
+    HOST_TEST_RUN(test_max_pool_swar_s8);
+    HOST_TEST_RUN(test_max_pool_swar_s8_timing);
+    return host_test_result();
+}
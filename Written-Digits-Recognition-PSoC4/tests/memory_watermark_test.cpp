@@ -0,0 +1,246 @@
+/*
+ * memory_watermark_test.cpp
+ *
+ *  Stack painting and scan (src/stack_watermark.h), the arena watermarks of
+ *  MicroInterpreter::EnableArenaWatermarks, and their read out over the UART
+ *  frames (src/memory_dump.h). The arena watermarks come from the digit
+ *  gatekeeper of models/ run on a canary filled arena: every byte an
+ *  inference writes has to lie below the high-water mark it reports.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "digit-gatekeeper-8bit.h"
+#include "host_test.h"
+#include "memory_dump.h"
+#include "stack_watermark.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+#define STACK_WORDS                 (256)
+#define ARENA_SIZE                  (10000)
+#define ARENA_CANARY                (0xA5u)
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+static uart_frame_decoder_t reply_decoder;
+static std::vector<std::vector<uint8_t>> replies;
+static int reply_command;
+
+
+static uint32_t read_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+static void send(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (uart_frame_decode(&reply_decoder, data[i])) {
+            reply_command = reply_decoder.command;
+            replies.push_back(std::vector<uint8_t>(reply_decoder.payload, reply_decoder.payload + reply_decoder.length));
+        }
+    }
+}
+
+
+static void read_stack(stack_usage_t* usage)
+{
+    usage->used = 700;
+    usage->headroom = 300;
+    usage->reserved = 1024;
+}
+
+
+/* Runs a request and returns its reply, which has to be the only one. */
+static std::vector<uint8_t> request(memory_dump_t* dump, uint8_t command, const uint8_t* payload, uint16_t length)
+{
+    replies.clear();
+    memory_dump_handle(dump, command, payload, length);
+    HOST_TEST_EXPECT_EQ(replies.size(), 1);
+    HOST_TEST_EXPECT_EQ(reply_command, command | UART_FRAME_REPLY);
+    return replies.empty() ? std::vector<uint8_t>() : replies.back();
+}
+
+
+/*******************************************************************************
+* Function Name: test_stack_watermark
+********************************************************************************
+* Summary:
+*  Paints a buffer standing in for the free stack, with guard words around it
+*  that must not be painted, and lets a stack growing down from its top touch
+*  it. The scan finds the deepest word touched, also when a deeper frame left
+*  words above it untouched.
+*
+*******************************************************************************/
+static void test_stack_watermark(void)
+{
+    uint32_t memory[STACK_WORDS + 2];
+    uint32_t* low = memory + 1;
+    uint32_t* high = low + STACK_WORDS;
+
+    memory[0] = 0;
+    memory[STACK_WORDS + 1] = 0;
+    stack_watermark_paint(low, high);
+    HOST_TEST_EXPECT_EQ(memory[0], 0);
+    HOST_TEST_EXPECT_EQ(memory[STACK_WORDS + 1], 0);
+    for (int i = 0; i < STACK_WORDS; i++) {
+        HOST_TEST_EXPECT_EQ(low[i], STACK_WATERMARK_PAINT);
+    }
+    /*Untouched stack*/
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, high) == high);
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, low) == low);
+
+    /*Frames down to word 200*/
+    for (int i = STACK_WORDS - 1; i >= 200; i--) {
+        low[i] = (uint32_t)i;
+    }
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, high) == low + 200);
+    /*A deeper frame that only wrote its lowest words, e.g. a large local array left unused*/
+    low[120] = 0;
+    low[121] = 0;
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, high) == low + 120);
+    /*A single byte changed is enough*/
+    low[3] ^= 0x00000100u;
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, high) == low + 3);
+
+    /*Painting again starts over*/
+    stack_watermark_paint(low, high);
+    HOST_TEST_EXPECT(stack_watermark_deepest(low, high) == high);
+}
+
+
+/*******************************************************************************
+* Function Name: test_arena_watermarks
+********************************************************************************
+* Summary:
+*  Fills the head of the arena, below the persistent tail, with a canary
+*  after AllocateTensors, and runs an inference. The highest byte that no
+*  longer holds the canary has to lie below the inference high-water mark,
+*  which is the largest of the node marks. Reset clears them and the next
+*  inference, on the same input, reaches the same marks. Also checks the read
+*  out of the marks through memory_dump_handle.
+*
+*******************************************************************************/
+static void test_arena_watermarks(void)
+{
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    const tflite::Model* model = tflite::GetModel(digit_gatekeeper_8bit_tflite);
+    const int nodes = (int)model->subgraphs()->Get(0)->operators()->size();
+
+    op_resolver.AddQuantize();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddFullyConnected();
+    tflite::MicroInterpreter interpreter(model, op_resolver, arena, ARENA_SIZE);
+    HOST_TEST_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(interpreter.arena_watermark_nodes(), 0);
+    HOST_TEST_EXPECT_EQ(interpreter.EnableArenaWatermarks(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(interpreter.arena_watermark_nodes(), nodes);
+    /*Enabling twice keeps the marks*/
+    HOST_TEST_EXPECT_EQ(interpreter.EnableArenaWatermarks(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(interpreter.arena_watermark_nodes(), nodes);
+
+    const size_t head_size = ARENA_SIZE - interpreter.arena_tail_used_bytes();
+    memset(arena, ARENA_CANARY, head_size);
+    TfLiteTensor* input = interpreter.input(0);
+    for (size_t i = 0; i < input->bytes; i++) {
+        input->data.uint8[i] = (uint8_t)host_test_random(0, 255);
+    }
+    HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+
+    size_t touched = 0;
+    for (size_t i = 0; i < head_size; i++) {
+        if (arena[i] != ARENA_CANARY) {
+            touched = i + 1;
+        }
+    }
+    const size_t high_water = interpreter.arena_head_high_water_bytes();
+    printf("arena head touched %u bytes, high-water mark %u, tail %u\n", (unsigned)touched,
+           (unsigned)high_water, (unsigned)interpreter.arena_tail_used_bytes());
+    HOST_TEST_EXPECT(touched > 0);
+    HOST_TEST_EXPECT(touched <= high_water);
+    HOST_TEST_EXPECT(high_water <= head_size);
+
+    std::vector<size_t> node_marks(nodes);
+    size_t highest_node_mark = 0;
+    for (int i = 0; i < nodes; i++) {
+        node_marks[i] = interpreter.node_arena_head_high_water_bytes(i);
+        HOST_TEST_EXPECT(node_marks[i] > 0);
+        if (node_marks[i] > highest_node_mark) {
+            highest_node_mark = node_marks[i];
+        }
+    }
+    HOST_TEST_EXPECT_EQ(highest_node_mark, high_water);
+
+    /*Read out: summary, the model, a missing record and a request of the wrong size*/
+    memory_dump_t dump;
+    memory_dump_init(&dump, ARENA_SIZE, read_stack, send);
+    uart_frame_decoder_init(&reply_decoder);
+    HOST_TEST_EXPECT(memory_dump_add_model(&dump, &interpreter));
+    uint8_t index = 0;
+    std::vector<uint8_t> reply = request(&dump, MEMORY_DUMP_READ, &index, 1);
+    HOST_TEST_EXPECT_EQ(reply.size(), 24);
+    if (reply.size() == 24) {
+        HOST_TEST_EXPECT_EQ(reply[0], MEMORY_DUMP_OK);
+        HOST_TEST_EXPECT_EQ(reply[1], 0);
+        HOST_TEST_EXPECT_EQ(reply[2], 1);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[3]), 700);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[7]), 300);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[11]), 1024);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[15]), ARENA_SIZE);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[19]), interpreter.arena_tail_used_bytes());
+        HOST_TEST_EXPECT_EQ(reply[23], 1);
+    }
+    index = 1;
+    reply = request(&dump, MEMORY_DUMP_READ, &index, 1);
+    HOST_TEST_EXPECT_EQ(reply.size(), 8 + 4 * (size_t)nodes);
+    if (reply.size() == 8 + 4 * (size_t)nodes) {
+        HOST_TEST_EXPECT_EQ(reply[0], MEMORY_DUMP_OK);
+        HOST_TEST_EXPECT_EQ(reply[1], 1);
+        HOST_TEST_EXPECT_EQ(reply[2], 0);
+        HOST_TEST_EXPECT_EQ(read_u32(&reply[3]), high_water);
+        HOST_TEST_EXPECT_EQ(reply[7], nodes);
+        for (int i = 0; i < nodes; i++) {
+            HOST_TEST_EXPECT_EQ(read_u32(&reply[8 + 4 * i]), node_marks[i]);
+        }
+    }
+    index = 2;
+    reply = request(&dump, MEMORY_DUMP_READ, &index, 1);
+    HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == MEMORY_DUMP_ERROR);
+    reply = request(&dump, MEMORY_DUMP_READ, NULL, 0);
+    HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == MEMORY_DUMP_ERROR);
+
+    /*Reset, through the read out, then the same inference again*/
+    reply = request(&dump, MEMORY_DUMP_RESET, NULL, 0);
+    HOST_TEST_EXPECT(reply.size() == 1 && reply[0] == MEMORY_DUMP_OK);
+    HOST_TEST_EXPECT_EQ(interpreter.arena_head_high_water_bytes(), 0);
+    for (int i = 0; i < nodes; i++) {
+        HOST_TEST_EXPECT_EQ(interpreter.node_arena_head_high_water_bytes(i), 0);
+    }
+    HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(interpreter.arena_head_high_water_bytes(), high_water);
+    for (int i = 0; i < nodes; i++) {
+        HOST_TEST_EXPECT_EQ(interpreter.node_arena_head_high_water_bytes(i), node_marks[i]);
+    }
+
+    /*Other commands are left to their handlers*/
+    replies.clear();
+    memory_dump_handle(&dump, MEMORY_DUMP_RESET + 1, NULL, 0);
+    HOST_TEST_EXPECT_EQ(replies.size(), 0);
+    for (uint8_t i = 1; i < MEMORY_DUMP_MAX_MODELS; i++) {
+        HOST_TEST_EXPECT(memory_dump_add_model(&dump, &interpreter));
+    }
+    HOST_TEST_EXPECT(!memory_dump_add_model(&dump, &interpreter));
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_stack_watermark);
+    HOST_TEST_RUN(test_arena_watermarks);
+    return host_test_result();
+}
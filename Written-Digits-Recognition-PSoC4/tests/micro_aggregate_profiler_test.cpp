@@ -0,0 +1,395 @@
+/*
+ * micro_aggregate_profiler_test.cpp
+ *
+ *  MicroAggregateProfiler on FakeMicroTime: the statistics and the histogram
+ *  of every (tag, parent) pair against the durations of the events, nesting,
+ *  the events dropped when the tags or the open events run out, saturation,
+ *  and the byte layout of the records SerializeRecord writes, which
+ *  tools/profile_report.py decodes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "host_test.h"
+#include "tensorflow/lite/micro/fake_micro_time.h"
+#include "tensorflow/lite/micro/micro_aggregate_profiler.h"
+
+typedef tflite::MicroAggregateProfiler profiler_t;
+
+/* The events of a (tag, parent) pair, from which the test computes what the profiler has to report. */
+typedef struct {
+    std::string tag;
+    int parent;
+    std::vector<uint32_t> durations;
+} expected_tag_t;
+
+static uint8_t record[profiler_t::kMaxRecordSize + 16];
+
+
+static int bit_length(uint32_t value)
+{
+    int length = 0;
+
+    for (; value != 0; value >>= 1) {
+        length++;
+    }
+    return length;
+}
+
+
+/* Runs an event of the given duration. */
+static void timed_event(profiler_t* profiler, const char* tag, uint32_t ticks)
+{
+    const uint32_t handle = profiler->BeginEvent(tag);
+
+    tflite::FakeMicroTime::Advance(ticks);
+    profiler->EndEvent(handle);
+}
+
+
+static uint64_t read_little_endian(const uint8_t** in, int bytes)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)(*in)[i] << (8 * i);
+    }
+    *in += bytes;
+    return value;
+}
+
+
+/*******************************************************************************
+* Function Name: expect_tag
+********************************************************************************
+* Summary:
+*  Checks the statistics of tag index against the durations of expected,
+*  then decodes its record field by field: count, minimum, maximum, sums,
+*  and the histogram cut to its non-empty bins.
+*
+*******************************************************************************/
+static void expect_tag(const profiler_t& profiler, int index, const expected_tag_t& expected)
+{
+    const char* name = expected.tag.c_str();
+    uint32_t min_ticks = 0;
+    uint32_t max_ticks = 0;
+    uint64_t sum_ticks = 0;
+    uint64_t sum_squared_ticks = 0;
+    bool saturated = false;
+    uint32_t histogram[profiler_t::kHistogramBins] = {0};
+    for (size_t i = 0; i < expected.durations.size(); i++) {
+        const uint32_t ticks = expected.durations[i];
+        const uint64_t squared = (uint64_t)ticks * ticks;
+        min_ticks = i == 0 || ticks < min_ticks ? ticks : min_ticks;
+        max_ticks = ticks > max_ticks ? ticks : max_ticks;
+        sum_ticks += ticks;
+        saturated = saturated || sum_squared_ticks > std::numeric_limits<uint64_t>::max() - squared;
+        sum_squared_ticks = saturated ? std::numeric_limits<uint64_t>::max() : sum_squared_ticks + squared;
+        histogram[bit_length(ticks)]++;
+    }
+
+    const profiler_t::TagStats& stats = profiler.tag_stats(index);
+    HOST_TEST_EXPECT_EQ_CASE(strcmp(stats.tag, name), 0, name);
+    HOST_TEST_EXPECT_EQ_CASE(stats.parent, expected.parent, name);
+    HOST_TEST_EXPECT_EQ_CASE(stats.count, expected.durations.size(), name);
+    HOST_TEST_EXPECT_EQ_CASE(stats.max_ticks, max_ticks, name);
+    HOST_TEST_EXPECT_EQ_CASE(stats.sum_ticks, sum_ticks, name);
+    HOST_TEST_EXPECT_EQ_CASE(stats.sum_squared_ticks, sum_squared_ticks, name);
+    int first_bin = profiler_t::kHistogramBins;
+    int end_bin = 0;
+    for (int bin = 0; bin < profiler_t::kHistogramBins; bin++) {
+        const uint32_t count = histogram[bin] < 0xffff ? histogram[bin] : 0xffff;
+        HOST_TEST_EXPECT_EQ_CASE(stats.histogram[bin], count, name);
+        if (count != 0) {
+            first_bin = bin < first_bin ? bin : first_bin;
+            end_bin = bin + 1;
+        }
+    }
+    if (end_bin == 0) {
+        first_bin = 0;
+    }
+
+    const size_t name_length = expected.tag.size() < (size_t)profiler_t::kMaxRecordTagLength
+                                   ? expected.tag.size()
+                                   : (size_t)profiler_t::kMaxRecordTagLength;
+    const size_t size = 4 + name_length + 28 + 2 + 2 * (end_bin - first_bin);
+    memset(record, 0xA5, sizeof(record));
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(index + 1, record, sizeof(record)), size, name);
+    HOST_TEST_EXPECT_EQ_CASE(record[size], 0xA5, name);
+    const uint8_t* in = record;
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), 1, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), index, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), expected.parent, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), name_length, name);
+    HOST_TEST_EXPECT_EQ_CASE(memcmp(in, name, name_length), 0, name);
+    in += name_length;
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 4), expected.durations.size(), name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 4), min_ticks, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 4), max_ticks, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 8), sum_ticks, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 8) == sum_squared_ticks, true, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), first_bin, name);
+    HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), end_bin - first_bin, name);
+    for (int bin = first_bin; bin < end_bin; bin++) {
+        HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 2), stats.histogram[bin], name);
+    }
+
+    /*A buffer one byte short gets nothing*/
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(index + 1, record, size - 1), 0, name);
+}
+
+
+/* The summary record, byte for byte. */
+static void expect_summary(const profiler_t& profiler, int tags, uint32_t dropped_events)
+{
+    const uint8_t expected[] = {0, 1, 0x40, 0x42, 0x0f, 0x00, (uint8_t)tags, (uint8_t)dropped_events,
+                                (uint8_t)(dropped_events >> 8), (uint8_t)(dropped_events >> 16),
+                                (uint8_t)(dropped_events >> 24)};
+
+    HOST_TEST_EXPECT_EQ(profiler.num_tags(), tags);
+    HOST_TEST_EXPECT_EQ(profiler.num_records(), tags + 1);
+    HOST_TEST_EXPECT_EQ(profiler.dropped_events(), dropped_events);
+    memset(record, 0xA5, sizeof(record));
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(0, record, sizeof(record)), sizeof(expected));
+    HOST_TEST_EXPECT_EQ(memcmp(record, expected, sizeof(expected)), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(0, record, sizeof(expected) - 1), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(-1, record, sizeof(record)), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(tags + 1, record, sizeof(record)), 0);
+}
+
+
+/*******************************************************************************
+* Function Name: test_tag_statistics
+********************************************************************************
+* Summary:
+*  Operators nested in inferences, with random durations of every bit
+*  length. The same tag under another parent, or at the top level, is a
+*  pair of its own; a tag is matched by its text, not by its address.
+*
+*******************************************************************************/
+static void test_tag_statistics(void)
+{
+    profiler_t profiler;
+    std::vector<expected_tag_t> expected = {
+        {"inference", profiler_t::kNoParent, {}},
+        {"CONV_2D", 0, {}},
+        {"MAX_POOL_2D", 0, {}},
+        {"gatekeeper", profiler_t::kNoParent, {}},
+        {"CONV_2D", 3, {}},
+        {"CONV_2D", profiler_t::kNoParent, {}},
+    };
+    char conv_copy[] = "CONV_2D";
+
+    tflite::FakeMicroTime::Install();
+    for (int i = 0; i < 40; i++) {
+        const uint32_t inference_start = tflite::FakeMicroTime::ticks();
+        const uint32_t inference = profiler.BeginEvent("inference");
+        for (int layer = 0; layer < 3; layer++) {
+            const uint32_t ticks = (uint32_t)host_test_random(0, 1 << host_test_random(0, 20));
+            timed_event(&profiler, layer == 1 ? conv_copy : "CONV_2D", ticks);
+            expected[1].durations.push_back(ticks);
+        }
+        tflite::FakeMicroTime::Advance(3);
+        const uint32_t ticks = (uint32_t)host_test_random(0, 100);
+        timed_event(&profiler, "MAX_POOL_2D", ticks);
+        expected[2].durations.push_back(ticks);
+        profiler.EndEvent(inference);
+        expected[0].durations.push_back(tflite::FakeMicroTime::ticks() - inference_start);
+
+        if (i % 4 == 0) {
+            const uint32_t gatekeeper = profiler.BeginEvent("gatekeeper");
+            timed_event(&profiler, "CONV_2D", 7);
+            expected[4].durations.push_back(7);
+            tflite::FakeMicroTime::Advance(1);
+            profiler.EndEvent(gatekeeper);
+            expected[3].durations.push_back(8);
+        }
+    }
+    timed_event(&profiler, "CONV_2D", 0x80000000u);
+    expected[5].durations.push_back(0x80000000u);
+
+    expect_summary(profiler, (int)expected.size(), 0);
+    for (size_t i = 0; i < expected.size(); i++) {
+        expect_tag(profiler, (int)i, expected[i]);
+    }
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_histogram
+********************************************************************************
+* Summary:
+*  The bin edges: 0 ticks in bin 0, 2^(b - 1) and 2^b - 1 ticks in bin b,
+*  up to the largest duration in bin 32. A bin saturates at 65535 events,
+*  the count and the sums go on; the sum of squared ticks saturates on the
+*  second event of the largest duration.
+*
+*******************************************************************************/
+static void test_histogram(void)
+{
+    profiler_t profiler;
+    expected_tag_t edges = {"edges", profiler_t::kNoParent, {}};
+    expected_tag_t saturated = {"saturated", profiler_t::kNoParent, {}};
+    expected_tag_t largest = {"largest", profiler_t::kNoParent, {}};
+    expected_tag_t narrow = {"narrow", profiler_t::kNoParent, {}};
+
+    tflite::FakeMicroTime::Install();
+    timed_event(&profiler, "edges", 0);
+    edges.durations.push_back(0);
+    for (int bin = 1; bin < profiler_t::kHistogramBins; bin++) {
+        const uint32_t low = 1u << (bin - 1);
+        const uint32_t high = low + (low - 1);
+        timed_event(&profiler, "edges", low);
+        timed_event(&profiler, "edges", high);
+        edges.durations.push_back(low);
+        edges.durations.push_back(high);
+    }
+    for (int i = 0; i < 70000; i++) {
+        timed_event(&profiler, "saturated", 5);
+        saturated.durations.push_back(5);
+    }
+    for (int i = 0; i < 3; i++) {
+        timed_event(&profiler, "largest", 0xffffffffu);
+        largest.durations.push_back(0xffffffffu);
+    }
+    /*Bins 3 to 5 only, with an empty bin in between*/
+    timed_event(&profiler, "narrow", 4);
+    timed_event(&profiler, "narrow", 31);
+    narrow.durations.push_back(4);
+    narrow.durations.push_back(31);
+
+    expect_tag(profiler, 0, edges);
+    expect_tag(profiler, 1, saturated);
+    expect_tag(profiler, 2, largest);
+    expect_tag(profiler, 3, narrow);
+    HOST_TEST_EXPECT_EQ(profiler.tag_stats(1).histogram[3], 0xffff);
+    HOST_TEST_EXPECT_EQ(profiler.tag_stats(1).count, 70000);
+    HOST_TEST_EXPECT(profiler.tag_stats(2).sum_squared_ticks == std::numeric_limits<uint64_t>::max());
+    /*The whole histogram, in a record of the largest size*/
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(1, record, sizeof(record)),
+                        4 + 5 + 28 + 2 + 2 * profiler_t::kHistogramBins);
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_dropped_events
+********************************************************************************
+* Summary:
+*  Once the kMaxTags pairs are in use, the events of a new pair are dropped
+*  and counted, while the known pairs are still counted; so are the events
+*  begun with kMaxOpenEvents open. Ending a dropped event, or one that is no
+*  longer open, does nothing. Ending an event discards the events nested in
+*  it that are still open, and ClearEvents() clears the statistics, the
+*  drop counter and the open events.
+*
+*******************************************************************************/
+static void test_dropped_events(void)
+{
+    profiler_t profiler;
+    static char tags[profiler_t::kMaxTags + 1][8];
+
+    tflite::FakeMicroTime::Install();
+    for (int i = 0; i <= profiler_t::kMaxTags; i++) {
+        snprintf(tags[i], sizeof(tags[i]), "tag%d", i);
+    }
+    for (int i = 0; i < profiler_t::kMaxTags; i++) {
+        timed_event(&profiler, tags[i], (uint32_t)i);
+    }
+    timed_event(&profiler, tags[profiler_t::kMaxTags], 10);
+    timed_event(&profiler, tags[profiler_t::kMaxTags], 10);
+    timed_event(&profiler, tags[3], 100);
+    expect_summary(profiler, profiler_t::kMaxTags, 2);
+    expect_tag(profiler, 3, {"tag3", profiler_t::kNoParent, {3, 100}});
+
+    /*kMaxOpenEvents nested events of the same tag, under one another, then one more*/
+    profiler.ClearEvents();
+    expect_summary(profiler, 0, 0);
+    uint32_t handles[profiler_t::kMaxOpenEvents + 1];
+    for (int i = 0; i <= profiler_t::kMaxOpenEvents; i++) {
+        handles[i] = profiler.BeginEvent("nested");
+        tflite::FakeMicroTime::Advance(1);
+    }
+    profiler.EndEvent(handles[profiler_t::kMaxOpenEvents]);
+    for (int i = profiler_t::kMaxOpenEvents - 1; i >= 0; i--) {
+        profiler.EndEvent(handles[i]);
+    }
+    expect_summary(profiler, profiler_t::kMaxOpenEvents, 1);
+    for (int i = 0; i < profiler_t::kMaxOpenEvents; i++) {
+        expect_tag(profiler, i, {"nested", i == 0 ? profiler_t::kNoParent : i - 1,
+                                 {(uint32_t)(profiler_t::kMaxOpenEvents + 1 - i)}});
+    }
+
+    /*Ending the outer event discards the inner one, which can no longer be ended*/
+    profiler.ClearEvents();
+    const uint32_t outer = profiler.BeginEvent("outer");
+    const uint32_t inner = profiler.BeginEvent("inner");
+    tflite::FakeMicroTime::Advance(20);
+    profiler.EndEvent(outer);
+    tflite::FakeMicroTime::Advance(20);
+    profiler.EndEvent(inner);
+    profiler.EndEvent(outer);
+    profiler.EndEvent(0xffffffffu);
+    expect_summary(profiler, 2, 0);
+    expect_tag(profiler, 0, {"outer", profiler_t::kNoParent, {20}});
+    expect_tag(profiler, 1, {"inner", 0, {}});
+
+    /*An event open across ClearEvents() is not counted, and does not hold its place*/
+    const uint32_t open = profiler.BeginEvent("open");
+    profiler.ClearEvents();
+    profiler.EndEvent(open);
+    timed_event(&profiler, "after", 4);
+    expect_summary(profiler, 1, 0);
+    expect_tag(profiler, 0, {"after", profiler_t::kNoParent, {4}});
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/* A record of a short tag, byte for byte, and a long tag name cut to kMaxRecordTagLength. */
+static void test_record_layout(void)
+{
+    profiler_t profiler;
+    const char* long_tag = "a_tag_name_longer_than_the_record_allows";
+
+    tflite::FakeMicroTime::Install();
+    const uint32_t parent = profiler.BeginEvent("p");
+    timed_event(&profiler, "ab", 3);
+    timed_event(&profiler, "ab", 0x1234);
+    profiler.EndEvent(parent);
+    timed_event(&profiler, long_tag, 1);
+
+    const uint8_t expected[] = {
+        1, 1, 0, 2, 'a', 'b',
+        0x02, 0x00, 0x00, 0x00,                         /*count*/
+        0x03, 0x00, 0x00, 0x00,                         /*min*/
+        0x34, 0x12, 0x00, 0x00,                         /*max*/
+        0x37, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /*sum*/
+        0x99, 0x5a, 0x4b, 0x01, 0x00, 0x00, 0x00, 0x00, /*sum of squares, 9 + 0x14b5a90*/
+        2, 12,                                          /*bins 2 to 13*/
+        1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+    };
+    memset(record, 0xA5, sizeof(record));
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(2, record, sizeof(record)), sizeof(expected));
+    HOST_TEST_EXPECT_EQ(memcmp(record, expected, sizeof(expected)), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(2, record, sizeof(expected)), sizeof(expected));
+
+    expect_tag(profiler, 2, {long_tag, profiler_t::kNoParent, {1}});
+    HOST_TEST_EXPECT_EQ(record[3], profiler_t::kMaxRecordTagLength);
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_tag_statistics);
+    HOST_TEST_RUN(test_histogram);
+    HOST_TEST_RUN(test_dropped_events);
+    HOST_TEST_RUN(test_record_layout);
+    return host_test_result();
+}
@@ -0,0 +1,123 @@
+/*
+ * micro_time_test.cpp
+ *
+ *  Tick source of TFLM (micro_time.h): the host build of the platform
+ *  counter, which has no time, a source registered with SetMicroTimeSource,
+ *  and FakeMicroTime, with MicroProfiler timing events on it.
+ */
+
+#include <stdio.h>
+
+#include "host_test.h"
+#include "tensorflow/lite/micro/fake_micro_time.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+static uint32_t registered_ticks;
+
+
+static uint32_t get_registered_ticks()
+{
+    return registered_ticks;
+}
+
+
+/* A registered source replaces the platform counter until nullptr is registered. */
+static void test_time_source(void)
+{
+    HOST_TEST_EXPECT_EQ(tflite::ticks_per_second(), 0);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0);
+
+    registered_ticks = 1234;
+    tflite::SetMicroTimeSource(get_registered_ticks, 32768);
+    HOST_TEST_EXPECT_EQ(tflite::ticks_per_second(), 32768);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 1234);
+    registered_ticks = 0xFFFFFFFFu;
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0xFFFFFFFFu);
+    HOST_TEST_EXPECT_EQ(tflite::TicksToMs(32768), 1000);
+
+    /*The rate of a cleared source is not kept*/
+    tflite::SetMicroTimeSource(nullptr, 32768);
+    HOST_TEST_EXPECT_EQ(tflite::ticks_per_second(), 0);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0);
+}
+
+
+static void test_fake_micro_time(void)
+{
+    tflite::FakeMicroTime::Install();
+    HOST_TEST_EXPECT_EQ(tflite::ticks_per_second(), tflite::FakeMicroTime::kTicksPerSecond);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0);
+    tflite::FakeMicroTime::Advance(250);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 250);
+    HOST_TEST_EXPECT_EQ(tflite::TicksToMs(tflite::GetCurrentTimeTicks()), 0);
+    tflite::FakeMicroTime::Advance(tflite::FakeMicroTime::kTicksPerSecond);
+    HOST_TEST_EXPECT_EQ(tflite::TicksToMs(tflite::GetCurrentTimeTicks()), 1000);
+
+    /*Install starts again from 0, and the step moves the time after every read*/
+    tflite::FakeMicroTime::Install(7);
+    for (uint32_t i = 0; i < 5; i++) {
+        HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 7 * i);
+    }
+    HOST_TEST_EXPECT_EQ(tflite::FakeMicroTime::ticks(), 35);
+    HOST_TEST_EXPECT_EQ(tflite::FakeMicroTime::ticks(), 35);
+
+    tflite::FakeMicroTime::Uninstall();
+    HOST_TEST_EXPECT_EQ(tflite::ticks_per_second(), 0);
+    HOST_TEST_EXPECT_EQ(tflite::GetCurrentTimeTicks(), 0);
+}
+
+
+/*******************************************************************************
+* Function Name: test_profiler
+********************************************************************************
+* Summary:
+*  MicroProfiler events timed on FakeMicroTime: disjoint events add up and a
+*  scoped event covers its scope. Without a time source every event lasts 0
+*  ticks.
+*
+*******************************************************************************/
+static void test_profiler(void)
+{
+    tflite::MicroProfiler profiler;
+
+    tflite::FakeMicroTime::Install();
+    uint32_t handle = profiler.BeginEvent("conv");
+    tflite::FakeMicroTime::Advance(1000);
+    profiler.EndEvent(handle);
+    tflite::FakeMicroTime::Advance(50);
+    handle = profiler.BeginEvent("pool");
+    tflite::FakeMicroTime::Advance(200);
+    profiler.EndEvent(handle);
+    HOST_TEST_EXPECT_EQ(profiler.GetTotalTicks(), 1200);
+
+    {
+        tflite::ScopedMicroProfiler scoped("fc", &profiler);
+        tflite::FakeMicroTime::Advance(30);
+    }
+    HOST_TEST_EXPECT_EQ(profiler.GetTotalTicks(), 1230);
+
+    /*Every read takes 3 ticks*/
+    profiler.ClearEvents();
+    tflite::FakeMicroTime::Install(3);
+    for (int i = 0; i < 4; i++) {
+        profiler.EndEvent(profiler.BeginEvent("step"));
+    }
+    HOST_TEST_EXPECT_EQ(profiler.GetTotalTicks(), 12);
+
+    profiler.ClearEvents();
+    tflite::FakeMicroTime::Uninstall();
+    handle = profiler.BeginEvent("untimed");
+    profiler.EndEvent(handle);
+    HOST_TEST_EXPECT_EQ(profiler.GetTotalTicks(), 0);
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_time_source);
+    HOST_TEST_RUN(test_fake_micro_time);
+    HOST_TEST_RUN(test_profiler);
+    return host_test_result();
+}
@@ -0,0 +1,341 @@
+/*
+ * micro_trace_profiler_test.cpp
+ *
+ *  MicroTraceProfiler on FakeMicroTime: the timeline of begin, end and
+ *  instant trace events, spans ended by tag with EndEventOf, the events
+ *  dropped when the buffer or the tags run out, unmatched ends, and the
+ *  records SerializeRecord writes, which tools/trace_to_chrome.py decodes.
+ *  Every check reads the trace back from the records, as the tool does.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "host_test.h"
+#include "tensorflow/lite/micro/fake_micro_time.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_trace_profiler.h"
+
+typedef tflite::MicroTraceProfiler profiler_t;
+
+typedef struct {
+    uint32_t ticks;
+    int tag;
+    int phase;
+} trace_event_t;
+
+/* What the records of a profiler have to decode to. */
+typedef struct {
+    std::vector<std::string> tags;
+    std::vector<trace_event_t> events;
+    uint32_t dropped_events;
+} trace_t;
+
+static uint8_t record[profiler_t::kMaxRecordSize + 16];
+
+
+static uint32_t read_little_endian(const uint8_t** in, int bytes)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint32_t)(*in)[i] << (8 * i);
+    }
+    *in += bytes;
+    return value;
+}
+
+
+/* Adds an event to expected, at the current fake time. */
+static void expect_event(trace_t* expected, int tag, int phase)
+{
+    expected->events.push_back({tflite::FakeMicroTime::ticks(), tag, phase});
+}
+
+
+/*******************************************************************************
+* Function Name: expect_trace
+********************************************************************************
+* Summary:
+*  Reads every record of profiler, each into a buffer of its exact size,
+*  and checks the summary, the tag names and the trace events against
+*  expected. A buffer one byte short, or a record past the last one, gets
+*  nothing.
+*
+*******************************************************************************/
+static void expect_trace(const profiler_t& profiler, const trace_t& expected, const char* name)
+{
+    const int num_tags = (int)expected.tags.size();
+    const int num_events = (int)expected.events.size();
+    const int event_records = (num_events + profiler_t::kRecordEvents - 1) / profiler_t::kRecordEvents;
+
+    HOST_TEST_EXPECT_EQ_CASE(profiler.num_tags(), num_tags, name);
+    HOST_TEST_EXPECT_EQ_CASE(profiler.num_events(), num_events, name);
+    HOST_TEST_EXPECT_EQ_CASE(profiler.dropped_events(), expected.dropped_events, name);
+    HOST_TEST_EXPECT_EQ_CASE(profiler.num_records(), 1 + num_tags + event_records, name);
+
+    const uint8_t summary[] = {0, 1, 0x40, 0x42, 0x0f, 0x00, (uint8_t)num_tags, (uint8_t)num_events,
+                               (uint8_t)(num_events >> 8), (uint8_t)expected.dropped_events,
+                               (uint8_t)(expected.dropped_events >> 8), (uint8_t)(expected.dropped_events >> 16),
+                               (uint8_t)(expected.dropped_events >> 24)};
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(0, record, sizeof(summary)), sizeof(summary), name);
+    HOST_TEST_EXPECT_EQ_CASE(memcmp(record, summary, sizeof(summary)), 0, name);
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(0, record, sizeof(summary) - 1), 0, name);
+
+    for (int tag = 0; tag < num_tags; tag++) {
+        const std::string cut = expected.tags[tag].substr(0, profiler_t::kMaxRecordTagLength);
+        const size_t size = 3 + cut.size();
+        memset(record, 0xA5, sizeof(record));
+        HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(1 + tag, record, size), size, name);
+        HOST_TEST_EXPECT_EQ_CASE(record[0], 1, name);
+        HOST_TEST_EXPECT_EQ_CASE(record[1], tag, name);
+        HOST_TEST_EXPECT_EQ_CASE(record[2], cut.size(), name);
+        HOST_TEST_EXPECT_EQ_CASE(memcmp(record + 3, cut.data(), cut.size()), 0, name);
+        HOST_TEST_EXPECT_EQ_CASE(record[size], 0xA5, name);
+        HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(1 + tag, record, size - 1), 0, name);
+    }
+
+    for (int r = 0; r < event_records; r++) {
+        const int first = r * profiler_t::kRecordEvents;
+        const int count = std::min(num_events - first, (int)profiler_t::kRecordEvents);
+        const size_t size = 4 + 5 * (size_t)count;
+        memset(record, 0xA5, sizeof(record));
+        HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(1 + num_tags + r, record, size), size, name);
+        HOST_TEST_EXPECT_EQ_CASE(record[size], 0xA5, name);
+        HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(1 + num_tags + r, record, size - 1), 0, name);
+        const uint8_t* in = record;
+        HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), 2, name);
+        HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 2), first, name);
+        HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 1), count, name);
+        for (int i = first; i < first + count; i++) {
+            const trace_event_t& event = expected.events[i];
+            HOST_TEST_EXPECT_EQ_CASE(read_little_endian(&in, 4), event.ticks, name);
+            const uint32_t tag_phase = read_little_endian(&in, 1);
+            HOST_TEST_EXPECT_EQ_CASE(tag_phase & 0x3f, event.tag, name);
+            HOST_TEST_EXPECT_EQ_CASE(tag_phase >> 6, event.phase, name);
+        }
+    }
+
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(profiler.num_records(), record, sizeof(record)), 0, name);
+    HOST_TEST_EXPECT_EQ_CASE(profiler.SerializeRecord(-1, record, sizeof(record)), 0, name);
+}
+
+
+/*******************************************************************************
+* Function Name: test_timeline
+********************************************************************************
+* Summary:
+*  An inference as the application traces it: a span begun in one scope
+*  and ended in another by its tag, operators nested in it, an instant, and
+*  a tag matched by its text. The ticks are stored as read, also across the
+*  wrap around of the counter.
+*
+*******************************************************************************/
+static void test_timeline(void)
+{
+    profiler_t profiler;
+    trace_t expected = {{"stroke", "CONV_2D", "touch", "MAX_POOL_2D"}, {}, 0};
+    char conv_copy[] = "CONV_2D";
+
+    tflite::FakeMicroTime::Install();
+    tflite::FakeMicroTime::Advance(0xffffffffu - 150);
+    for (int stroke = 0; stroke < 2; stroke++) {
+        profiler.BeginEvent("stroke");
+        expect_event(&expected, 0, profiler_t::kBegin);
+        for (int layer = 0; layer < 3; layer++) {
+            tflite::FakeMicroTime::Advance(10);
+            const uint32_t handle = profiler.BeginEvent(layer == 1 ? conv_copy : "CONV_2D");
+            HOST_TEST_EXPECT_EQ(handle, 1);
+            expect_event(&expected, 1, profiler_t::kBegin);
+            tflite::FakeMicroTime::Advance(40);
+            profiler.EndEvent(handle);
+            expect_event(&expected, 1, profiler_t::kEnd);
+        }
+        profiler.InstantEvent("touch");
+        expect_event(&expected, 2, profiler_t::kInstant);
+        {
+            tflite::ScopedMicroProfiler scoped("MAX_POOL_2D", &profiler);
+            expect_event(&expected, 3, profiler_t::kBegin);
+            tflite::FakeMicroTime::Advance(5);
+            expect_event(&expected, 3, profiler_t::kEnd);
+        }
+        tflite::FakeMicroTime::Advance(1);
+        profiler.EndEventOf("stroke");
+        expect_event(&expected, 0, profiler_t::kEnd);
+    }
+    expect_trace(profiler, expected, "timeline");
+
+    /*Cleared, the tags start over*/
+    profiler.ClearEvents();
+    expected = {{"touch"}, {}, 0};
+    profiler.InstantEvent("touch");
+    expect_event(&expected, 0, profiler_t::kInstant);
+    expect_trace(profiler, expected, "cleared");
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_buffer_full
+********************************************************************************
+* Summary:
+*  kMaxEvents trace events fill the buffer, in records of kRecordEvents and
+*  a shorter last one. The begins, ends and instants after it are dropped
+*  and counted; new tags are still added. ClearEvents() empties the buffer
+*  and the counter.
+*
+*******************************************************************************/
+static void test_buffer_full(void)
+{
+    profiler_t profiler;
+    trace_t expected = {{"step"}, {}, 0};
+
+    tflite::FakeMicroTime::Install();
+    for (int i = 0; i < profiler_t::kMaxEvents; i++) {
+        tflite::FakeMicroTime::Advance((uint32_t)host_test_random(0, 1000));
+        if (i % 2 == 0) {
+            profiler.BeginEvent("step");
+            expect_event(&expected, 0, profiler_t::kBegin);
+        } else {
+            profiler.EndEvent(0);
+            expect_event(&expected, 0, profiler_t::kEnd);
+        }
+    }
+    expect_trace(profiler, expected, "full");
+
+    HOST_TEST_EXPECT_EQ(profiler.BeginEvent("step"), 0);
+    profiler.EndEvent(0);
+    profiler.EndEventOf("step");
+    profiler.InstantEvent("late");
+    expected.tags.push_back("late");
+    expected.dropped_events = 4;
+    expect_trace(profiler, expected, "dropped");
+
+    profiler.ClearEvents();
+    expect_trace(profiler, {{}, {}, 0}, "cleared");
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_tags_full
+********************************************************************************
+* Summary:
+*  kMaxTags tags fill the tag table; the last one still fits below the
+*  phase bits. The trace events of a further tag are dropped and counted,
+*  including the end of the handle its begin returned, while the events of
+*  the known tags are still stored.
+*
+*******************************************************************************/
+static void test_tags_full(void)
+{
+    profiler_t profiler;
+    trace_t expected = {{}, {}, 0};
+    static char tags[profiler_t::kMaxTags + 1][8];
+
+    tflite::FakeMicroTime::Install();
+    for (int i = 0; i <= profiler_t::kMaxTags; i++) {
+        snprintf(tags[i], sizeof(tags[i]), "tag%d", i);
+    }
+    for (int i = 0; i < profiler_t::kMaxTags; i++) {
+        profiler.InstantEvent(tags[i]);
+        expected.tags.push_back(tags[i]);
+        expect_event(&expected, i, profiler_t::kInstant);
+        tflite::FakeMicroTime::Advance(1);
+    }
+
+    const uint32_t handle = profiler.BeginEvent(tags[profiler_t::kMaxTags]);
+    HOST_TEST_EXPECT(handle >= (uint32_t)profiler_t::kMaxTags);
+    profiler.EndEvent(handle);
+    profiler.EndEventOf(tags[profiler_t::kMaxTags]);
+    profiler.InstantEvent(tags[profiler_t::kMaxTags]);
+    expected.dropped_events = 4;
+
+    const uint32_t last = profiler.BeginEvent(tags[profiler_t::kMaxTags - 1]);
+    HOST_TEST_EXPECT_EQ(last, profiler_t::kMaxTags - 1);
+    expect_event(&expected, profiler_t::kMaxTags - 1, profiler_t::kBegin);
+    tflite::FakeMicroTime::Advance(9);
+    profiler.EndEvent(last);
+    expect_event(&expected, profiler_t::kMaxTags - 1, profiler_t::kEnd);
+    expect_trace(profiler, expected, "tags full");
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/*******************************************************************************
+* Function Name: test_unmatched_end
+********************************************************************************
+* Summary:
+*  An end by tag of a span that never began is stored, with its tag, for
+*  the decoder to discard; an end of a handle that is not a tag, or of a
+*  handle from before ClearEvents(), is dropped and counted.
+*
+*******************************************************************************/
+static void test_unmatched_end(void)
+{
+    profiler_t profiler;
+    trace_t expected = {{"stroke", "never begun"}, {}, 0};
+
+    tflite::FakeMicroTime::Install();
+    const uint32_t stale = profiler.BeginEvent("before clear");
+    profiler.ClearEvents();
+    profiler.EndEvent(stale);
+
+    tflite::FakeMicroTime::Advance(3);
+    profiler.BeginEvent("stroke");
+    expect_event(&expected, 0, profiler_t::kBegin);
+    tflite::FakeMicroTime::Advance(3);
+    profiler.EndEventOf("never begun");
+    expect_event(&expected, 1, profiler_t::kEnd);
+    profiler.EndEvent(2);
+    profiler.EndEvent(0xffffffffu);
+    expected.dropped_events = 3;
+    expect_trace(profiler, expected, "unmatched end");
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+/* A tag record and an event record byte for byte, and a long tag name cut to kMaxRecordTagLength. */
+static void test_record_layout(void)
+{
+    profiler_t profiler;
+    const char* long_tag = "a_tag_name_longer_than_the_record_allows";
+
+    tflite::FakeMicroTime::Install();
+    tflite::FakeMicroTime::Advance(0x12345678u);
+    profiler.BeginEvent("ab");
+    tflite::FakeMicroTime::Advance(0x100);
+    profiler.InstantEvent(long_tag);
+    profiler.EndEventOf("ab");
+
+    const uint8_t tag_record[] = {1, 0, 2, 'a', 'b'};
+    const uint8_t event_record[] = {
+        2, 0x00, 0x00, 3,
+        0x78, 0x56, 0x34, 0x12, 0x00,
+        0x78, 0x57, 0x34, 0x12, 0x81,
+        0x78, 0x57, 0x34, 0x12, 0x40,
+    };
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(1, record, sizeof(record)), sizeof(tag_record));
+    HOST_TEST_EXPECT_EQ(memcmp(record, tag_record, sizeof(tag_record)), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(2, record, sizeof(record)), 3 + profiler_t::kMaxRecordTagLength);
+    HOST_TEST_EXPECT_EQ(record[2], profiler_t::kMaxRecordTagLength);
+    HOST_TEST_EXPECT_EQ(memcmp(record + 3, long_tag, profiler_t::kMaxRecordTagLength), 0);
+    HOST_TEST_EXPECT_EQ(profiler.SerializeRecord(3, record, sizeof(record)), sizeof(event_record));
+    HOST_TEST_EXPECT_EQ(memcmp(record, event_record, sizeof(event_record)), 0);
+    tflite::FakeMicroTime::Uninstall();
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_timeline);
+    HOST_TEST_RUN(test_buffer_full);
+    HOST_TEST_RUN(test_tags_full);
+    HOST_TEST_RUN(test_unmatched_end);
+    HOST_TEST_RUN(test_record_layout);
+    return host_test_result();
+}
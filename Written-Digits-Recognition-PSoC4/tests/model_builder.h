@@ -0,0 +1,138 @@
+/*
+ * model_builder.h
+ *
+ *  Builds small TFLite models in memory, for the tests of the fused and
+ *  patched operators on shapes and quantization parameters that the models
+ *  of models/ do not have. A model has a single subgraph; tensors are int8,
+ *  uint8 or int32 with per-tensor or per-channel quantization, and constant
+ *  tensors get their own buffer.
+ *
+ *      host_test_model_t model;
+ *      const int input = host_test_model_tensor(&model, {1, 8, 8, 1}, tflite::TensorType_INT8, 0.1f, 0);
+ *      ...
+ *      host_test_model_operator(&model, tflite::BuiltinOperator_MAX_POOL_2D, {input}, {output},
+ *                               tflite::BuiltinOptions_Pool2DOptions, options.Union());
+ *      const tflite::Model* built = host_test_model_finish(&model, {input}, {output});
+ *
+ *  The model lives in the builder, as long as the host_test_model_t.
+ */
+
+#ifndef TESTS_MODEL_BUILDER_H_
+#define TESTS_MODEL_BUILDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "flatbuffers/default_allocator.h"
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+typedef struct {
+    /*The builder of the TFLM tree has no allocator of its own*/
+    flatbuffers::DefaultAllocator allocator;
+    flatbuffers::FlatBufferBuilder builder{1024, &allocator};
+    std::vector<flatbuffers::Offset<tflite::Buffer>> buffers;
+    std::vector<flatbuffers::Offset<tflite::Tensor>> tensors;
+    std::vector<flatbuffers::Offset<tflite::Operator>> operators;
+    std::vector<flatbuffers::Offset<tflite::OperatorCode>> operator_codes;
+    /*Builtin operator of each entry of operator_codes*/
+    std::vector<tflite::BuiltinOperator> builtins;
+} host_test_model_t;
+
+/*******************************************************************************
+* Function Name: host_test_model_quantized_tensor
+********************************************************************************
+* Summary:
+*  Adds a tensor quantized with one scale per entry of scales along
+*  quantized_dimension, or per tensor for a single scale, and returns its
+*  index. data, if not NULL, holds the bytes of a constant tensor; they are
+*  aligned to 16 bytes in the model, as the converter does.
+*
+*******************************************************************************/
+static inline int host_test_model_quantized_tensor(host_test_model_t* model, const std::vector<int32_t>& shape,
+                                                   tflite::TensorType type, const std::vector<float>& scales,
+                                                   int64_t zero_point, int32_t quantized_dimension,
+                                                   const void* data, size_t bytes)
+{
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+
+    /*Buffer 0 is the empty buffer of every tensor that is not constant*/
+    if (model->buffers.empty()) {
+        model->buffers.push_back(tflite::CreateBuffer(builder));
+    }
+    uint32_t buffer = 0;
+    if (data != NULL) {
+        builder.ForceVectorAlignment(bytes, sizeof(uint8_t), 16);
+        const auto vector = builder.CreateVector(static_cast<const uint8_t*>(data), bytes);
+        buffer = (uint32_t)model->buffers.size();
+        model->buffers.push_back(tflite::CreateBuffer(builder, vector));
+    }
+
+    const std::vector<int64_t> zero_points(scales.size(), zero_point);
+    const auto quantization = tflite::CreateQuantizationParameters(
+        builder, 0, 0, builder.CreateVector(scales), builder.CreateVector(zero_points),
+        tflite::QuantizationDetails_NONE, 0, quantized_dimension);
+    model->tensors.push_back(tflite::CreateTensor(builder, builder.CreateVector(shape), type, buffer, 0,
+                                                  quantization));
+    return (int)model->tensors.size() - 1;
+}
+
+/* Tensor computed by the model, quantized per tensor. */
+static inline int host_test_model_tensor(host_test_model_t* model, const std::vector<int32_t>& shape,
+                                         tflite::TensorType type, float scale, int64_t zero_point)
+{
+    return host_test_model_quantized_tensor(model, shape, type, {scale}, zero_point, 0, NULL, 0);
+}
+
+/* Constant tensor, of symmetric quantization as the weights and the biases are. */
+template <typename T>
+static inline int host_test_model_constant(host_test_model_t* model, const std::vector<int32_t>& shape,
+                                           tflite::TensorType type, const std::vector<float>& scales,
+                                           int32_t quantized_dimension, const std::vector<T>& values)
+{
+    return host_test_model_quantized_tensor(model, shape, type, scales, 0, quantized_dimension, values.data(),
+                                            values.size() * sizeof(T));
+}
+
+/* Adds an operator, with options built in model->builder. */
+static inline void host_test_model_operator(host_test_model_t* model, tflite::BuiltinOperator op,
+                                            const std::vector<int32_t>& inputs,
+                                            const std::vector<int32_t>& outputs,
+                                            tflite::BuiltinOptions options_type,
+                                            flatbuffers::Offset<void> options)
+{
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+
+    size_t opcode = std::find(model->builtins.begin(), model->builtins.end(), op) - model->builtins.begin();
+    if (opcode == model->builtins.size()) {
+        /*The code below 127 also goes into the deprecated field, which older readers take*/
+        const int8_t deprecated_code = (int8_t)std::min<int>(op, tflite::BuiltinOperator_PLACEHOLDER_FOR_GREATER_OP_CODES);
+        model->operator_codes.push_back(tflite::CreateOperatorCode(builder, deprecated_code, 0, 1, op));
+        model->builtins.push_back(op);
+    }
+    model->operators.push_back(tflite::CreateOperator(builder, (uint32_t)opcode, builder.CreateVector(inputs),
+                                                      builder.CreateVector(outputs), options_type, options));
+}
+
+/* Finishes the model, with the given subgraph inputs and outputs. */
+static inline const tflite::Model* host_test_model_finish(host_test_model_t* model,
+                                                          const std::vector<int32_t>& inputs,
+                                                          const std::vector<int32_t>& outputs)
+{
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+
+    const auto subgraph = tflite::CreateSubGraph(builder, builder.CreateVector(model->tensors),
+                                                 builder.CreateVector(inputs), builder.CreateVector(outputs),
+                                                 builder.CreateVector(model->operators));
+    const auto root = tflite::CreateModel(builder, TFLITE_SCHEMA_VERSION, builder.CreateVector(model->operator_codes),
+                                          builder.CreateVector(&subgraph, 1), 0,
+                                          builder.CreateVector(model->buffers));
+    tflite::FinishModelBuffer(builder, root);
+    return tflite::GetModel(builder.GetBufferPointer());
+}
+
+#endif /* TESTS_MODEL_BUILDER_H_ */
@@ -0,0 +1,343 @@
+/*
+ * model_upload_test.cpp
+ *
+ *  Upload of a model over the UART protocol (src/model_upload.h) into a
+ *  model slot (src/model_slot.h) on a RAM buffer standing in for the flash.
+ *  The requests are encoded into frames and decoded as the application does,
+ *  and the replies are decoded the way tools/upload_model.py does. The model
+ *  sent is the digit gatekeeper of models/, as is and edited.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "digit-gatekeeper-8bit.h"
+#include "host_test.h"
+#include "model_slot.h"
+#include "model_upload.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "uart_frame.h"
+
+#define ROW_SIZE                    (128u)
+#define SLOT_SIZE                   (32u * ROW_SIZE)
+#define PIXELS                      (28u * 28u)
+
+typedef struct {
+    uint8_t status;
+    uint32_t value;
+} reply_t;
+
+/*Input and output of the gatekeeper, and the ones main.cpp requires of an uploaded model*/
+static const model_slot_tensors_t gatekeeper_tensors = {kTfLiteUInt8, PIXELS, kTfLiteInt8, 1};
+static const model_slot_tensors_t application_tensors = {kTfLiteUInt8, PIXELS, kTfLiteUInt8, 10};
+
+alignas(16) static uint8_t flash_memory[SLOT_SIZE];
+static uart_frame_decoder_t request_decoder;
+static uart_frame_decoder_t reply_decoder;
+static std::vector<reply_t> replies;
+static int reply_command;
+
+
+static uint32_t read_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+static void write_u32(uint8_t* data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        data[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+
+/* The UART of the board: the replies are decoded as the host would. */
+static void send(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (uart_frame_decode(&reply_decoder, data[i])) {
+            HOST_TEST_EXPECT_EQ(reply_decoder.length, 5);
+            reply_command = reply_decoder.command;
+            replies.push_back({reply_decoder.payload[0], read_u32(&reply_decoder.payload[1])});
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: request
+********************************************************************************
+* Summary:
+*  Sends one request through the frame decoder to model_upload_handle and
+*  returns its reply, which has to be the only one and carry the command of
+*  the request. activated gets the result of model_upload_handle.
+*
+*******************************************************************************/
+static reply_t request(model_upload_t* upload, uint8_t command, const uint8_t* payload, uint16_t length,
+                       bool* activated = NULL)
+{
+    uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+    const size_t size = uart_frame_encode(command, payload, length, frame);
+    bool handled = false;
+    bool result = false;
+
+    replies.clear();
+    for (size_t i = 0; i < size; i++) {
+        if (uart_frame_decode(&request_decoder, frame[i])) {
+            handled = true;
+            result = model_upload_handle(upload, request_decoder.command, request_decoder.payload,
+                                         request_decoder.length);
+        }
+    }
+    HOST_TEST_EXPECT(handled);
+    HOST_TEST_EXPECT_EQ(replies.size(), 1);
+    HOST_TEST_EXPECT_EQ(reply_command, command | UART_FRAME_REPLY);
+    if (activated != NULL) {
+        *activated = result;
+    }
+    return replies.empty() ? reply_t{0xFF, 0} : replies.back();
+}
+
+
+static reply_t begin(model_upload_t* upload, uint32_t size, uint32_t crc)
+{
+    uint8_t payload[8];
+
+    write_u32(payload, size);
+    write_u32(payload + 4, crc);
+    return request(upload, MODEL_UPLOAD_BEGIN, payload, sizeof(payload));
+}
+
+
+static reply_t data(model_upload_t* upload, uint32_t offset, const uint8_t* chunk, uint32_t length)
+{
+    uint8_t payload[UART_FRAME_MAX_PAYLOAD];
+
+    write_u32(payload, offset);
+    memcpy(payload + 4, chunk, length);
+    return request(upload, MODEL_UPLOAD_DATA, payload, (uint16_t)(length + 4));
+}
+
+
+/* Sends the whole model in MODEL_UPLOAD_MAX_CHUNK chunks, each one twice as after a lost acknowledge. */
+static void send_model(model_upload_t* upload, const uint8_t* model, uint32_t size)
+{
+    for (uint32_t offset = 0; offset < size; offset += MODEL_UPLOAD_MAX_CHUNK) {
+        const uint32_t length = size - offset < MODEL_UPLOAD_MAX_CHUNK ? size - offset : MODEL_UPLOAD_MAX_CHUNK;
+        for (int repeat = 0; repeat < 2; repeat++) {
+            const reply_t reply = data(upload, offset, model + offset, length);
+            HOST_TEST_EXPECT_EQ(reply.status, MODEL_SLOT_OK);
+            HOST_TEST_EXPECT_EQ(reply.value, offset + length);
+        }
+    }
+}
+
+
+/* A complete upload of model, returning the status of its commit. */
+static uint8_t upload_model(model_upload_t* upload, const uint8_t* model, uint32_t size)
+{
+    HOST_TEST_EXPECT_EQ(begin(upload, size, model_slot_crc32(0, model, size)).status, MODEL_SLOT_OK);
+    send_model(upload, model, size);
+    return request(upload, MODEL_UPLOAD_COMMIT, NULL, 0).status;
+}
+
+
+/*******************************************************************************
+* Function Name: test_upload
+********************************************************************************
+* Summary:
+*  A complete upload, then the errors a broken upload has to give: a model
+*  too large, a chunk out of order, a corrupted chunk (CRC), data that is not
+*  a model (Verifier), a model with an operator the resolver lacks, and
+*  requests of the wrong size. The slot never holds a model after a failed
+*  upload.
+*
+*******************************************************************************/
+static void test_upload(void)
+{
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    model_slot_flash_t flash;
+    model_slot_t slot;
+    model_upload_t upload;
+    const uint8_t* model = digit_gatekeeper_8bit_tflite;
+    const uint32_t size = digit_gatekeeper_8bit_tflite_len;
+    const uint32_t crc = model_slot_crc32(0, model, size);
+    bool activated = true;
+    uint32_t active_size = 0;
+
+    op_resolver.AddQuantize();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddFullyConnected();
+    model_slot_ram_flash_init(&flash, flash_memory, sizeof(flash_memory), ROW_SIZE);
+    model_slot_init(&slot, &flash);
+    model_upload_init(&upload, &slot, &op_resolver, &gatekeeper_tensors, send);
+    uart_frame_decoder_init(&request_decoder);
+    uart_frame_decoder_init(&reply_decoder);
+
+    /*Empty slot*/
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_INFO, NULL, 0).value, 0);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_ACTIVATE, NULL, 0, &activated).status, MODEL_SLOT_ERROR_STATE);
+    HOST_TEST_EXPECT(!activated);
+
+    /*Complete upload, with a repeated commit*/
+    reply_t reply = begin(&upload, size, crc);
+    HOST_TEST_EXPECT_EQ(reply.status, MODEL_SLOT_OK);
+    HOST_TEST_EXPECT_EQ(reply.value, SLOT_SIZE - ROW_SIZE);
+    send_model(&upload, model, size);
+    for (int repeat = 0; repeat < 2; repeat++) {
+        reply = request(&upload, MODEL_UPLOAD_COMMIT, NULL, 0);
+        HOST_TEST_EXPECT_EQ(reply.status, MODEL_SLOT_OK);
+        HOST_TEST_EXPECT_EQ(reply.value, size);
+    }
+    const uint8_t* active = model_slot_active_model(&slot, &active_size);
+    HOST_TEST_EXPECT(active == flash_memory + ROW_SIZE);
+    HOST_TEST_EXPECT_EQ(active_size, size);
+    HOST_TEST_EXPECT(active != NULL && memcmp(active, model, size) == 0);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_INFO, NULL, 0).value, size);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_ACTIVATE, NULL, 0, &activated).status, MODEL_SLOT_OK);
+    HOST_TEST_EXPECT(activated);
+
+    /*A model larger than the slot is refused and leaves the slot as it was*/
+    HOST_TEST_EXPECT_EQ(begin(&upload, SLOT_SIZE, crc).status, MODEL_SLOT_ERROR_SIZE);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) != NULL);
+
+    /*BEGIN empties the slot, a chunk out of order is refused*/
+    HOST_TEST_EXPECT_EQ(begin(&upload, size, crc).status, MODEL_SLOT_OK);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+    HOST_TEST_EXPECT_EQ(data(&upload, MODEL_UPLOAD_MAX_CHUNK, model + MODEL_UPLOAD_MAX_CHUNK, 16).status,
+                        MODEL_SLOT_ERROR_OFFSET);
+    /*Committing an incomplete model fails*/
+    HOST_TEST_EXPECT_EQ(data(&upload, 0, model, 16).status, MODEL_SLOT_OK);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_COMMIT, NULL, 0).status, MODEL_SLOT_ERROR_SIZE);
+
+    /*A byte corrupted on the way, the CRC of the upload does not match*/
+    std::vector<uint8_t> corrupted(model, model + size);
+    corrupted[size / 2] ^= 0x01;
+    HOST_TEST_EXPECT_EQ(begin(&upload, size, crc).status, MODEL_SLOT_OK);
+    send_model(&upload, corrupted.data(), size);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_COMMIT, NULL, 0).status, MODEL_SLOT_ERROR_CRC);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+
+    /*Data that is not a model, with a matching CRC*/
+    std::vector<uint8_t> text(300, 'x');
+    HOST_TEST_EXPECT_EQ(begin(&upload, (uint32_t)text.size(), model_slot_crc32(0, text.data(), text.size())).status,
+                        MODEL_SLOT_OK);
+    send_model(&upload, text.data(), (uint32_t)text.size());
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_COMMIT, NULL, 0).status, MODEL_SLOT_ERROR_VERIFY);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+
+    /*A valid model with an operator the application does not register*/
+    tflite::MicroMutableOpResolver<2> missing_op_resolver;
+    missing_op_resolver.AddQuantize();
+    missing_op_resolver.AddFullyConnected();
+    model_upload_init(&upload, &slot, &missing_op_resolver, &gatekeeper_tensors, send);
+    HOST_TEST_EXPECT_EQ(begin(&upload, size, crc).status, MODEL_SLOT_OK);
+    send_model(&upload, model, size);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_COMMIT, NULL, 0).status, MODEL_SLOT_ERROR_OPS);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_INFO, NULL, 0).value, 0);
+
+    /*Requests of the wrong size*/
+    const uint8_t short_payload[3] = {0, 0, 0};
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_BEGIN, short_payload, 3).status, MODEL_SLOT_ERROR_SIZE);
+    HOST_TEST_EXPECT_EQ(request(&upload, MODEL_UPLOAD_DATA, short_payload, 3).status, MODEL_SLOT_ERROR_SIZE);
+}
+
+
+/*******************************************************************************
+* Function Name: test_tensors
+********************************************************************************
+* Summary:
+*  Valid models whose input or output is not the one the application copies
+*  its data into and its scores out of: the gatekeeper, whose single int8
+*  logit is not the 10 uint8 scores main.cpp requires of an uploaded model,
+*  and copies of the gatekeeper edited to take a smaller input, and an int8
+*  input. Running any of these would copy past the tensor into the arena.
+*
+*******************************************************************************/
+static void test_tensors(void)
+{
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    model_slot_flash_t flash;
+    model_slot_t slot;
+    model_upload_t upload;
+    const uint32_t size = digit_gatekeeper_8bit_tflite_len;
+
+    op_resolver.AddQuantize();
+    op_resolver.AddAveragePool2D();
+    op_resolver.AddFullyConnected();
+    model_slot_ram_flash_init(&flash, flash_memory, sizeof(flash_memory), ROW_SIZE);
+    model_slot_init(&slot, &flash);
+    uart_frame_decoder_init(&request_decoder);
+    uart_frame_decoder_init(&reply_decoder);
+
+    model_upload_init(&upload, &slot, &op_resolver, &application_tensors, send);
+    HOST_TEST_EXPECT_EQ(upload_model(&upload, digit_gatekeeper_8bit_tflite, size), MODEL_SLOT_ERROR_TENSORS);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+
+    /*The input tensor of a copy, edited in place: its height halved, then its type changed*/
+    alignas(16) static uint8_t edited[4096];
+    memcpy(edited, digit_gatekeeper_8bit_tflite, size);
+    const tflite::SubGraph* subgraph = tflite::GetModel(edited)->subgraphs()->Get(0);
+    const tflite::Tensor* input = subgraph->tensors()->Get(subgraph->inputs()->Get(0));
+    int32_t* height = const_cast<int32_t*>(input->shape()->data() + 1);
+    uint8_t* type = const_cast<uint8_t*>(
+        reinterpret_cast<const flatbuffers::Table*>(input)->GetAddressOf(tflite::Tensor::VT_TYPE));
+    HOST_TEST_EXPECT_EQ(*height, 28);
+    HOST_TEST_EXPECT(type != NULL && *type == tflite::TensorType_UINT8);
+
+    model_upload_init(&upload, &slot, &op_resolver, &gatekeeper_tensors, send);
+    HOST_TEST_EXPECT_EQ(upload_model(&upload, edited, size), MODEL_SLOT_OK);
+    *height = 14;
+    HOST_TEST_EXPECT_EQ(upload_model(&upload, edited, size), MODEL_SLOT_ERROR_TENSORS);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+    *height = 28;
+    *type = tflite::TensorType_INT8;
+    HOST_TEST_EXPECT_EQ(upload_model(&upload, edited, size), MODEL_SLOT_ERROR_TENSORS);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) == NULL);
+    *type = tflite::TensorType_UINT8;
+    HOST_TEST_EXPECT_EQ(upload_model(&upload, edited, size), MODEL_SLOT_OK);
+    HOST_TEST_EXPECT(model_slot_active_model(&slot, NULL) != NULL);
+}
+
+
+/* Commands of the other protocols on the same UART are left to their handlers. */
+static void test_other_commands(void)
+{
+    tflite::MicroMutableOpResolver<1> op_resolver;
+    model_slot_flash_t flash;
+    model_slot_t slot;
+    model_upload_t upload;
+
+    model_slot_ram_flash_init(&flash, flash_memory, sizeof(flash_memory), ROW_SIZE);
+    model_slot_init(&slot, &flash);
+    model_upload_init(&upload, &slot, &op_resolver, &application_tensors, send);
+    replies.clear();
+    for (uint8_t command = MODEL_UPLOAD_INFO + 1; command < UART_FRAME_REPLY; command++) {
+        HOST_TEST_EXPECT(!model_upload_handle(&upload, command, NULL, 0));
+    }
+    HOST_TEST_EXPECT_EQ(replies.size(), 0);
+}
+
+
+static void test_crc32(void)
+{
+    /*Check value of the IEEE 802.3 CRC-32, as zlib.crc32*/
+    HOST_TEST_EXPECT_EQ(model_slot_crc32(0, (const uint8_t*)"123456789", 9), 0xCBF43926u);
+    HOST_TEST_EXPECT_EQ(model_slot_crc32(model_slot_crc32(0, (const uint8_t*)"1234", 4), (const uint8_t*)"56789", 5),
+                        0xCBF43926u);
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_crc32);
+    HOST_TEST_RUN(test_upload);
+    HOST_TEST_RUN(test_tensors);
+    HOST_TEST_RUN(test_other_commands);
+    return host_test_result();
+}
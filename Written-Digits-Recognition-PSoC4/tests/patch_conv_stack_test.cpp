@@ -0,0 +1,298 @@
+/*
+ * patch_conv_stack_test.cpp
+ *
+ *  Patch based execution (PATCH_CONV_STACK) against the unpatched graph, on
+ *  stacks of CONV_2D and MAX_POOL_2D built for the test: strided, dilated,
+ *  SAME and VALID layers, tiles from a single pixel to the whole output,
+ *  tiles that do not divide the output, and patched prefixes of the stack.
+ *  The tiles at the image edges take the padding of every layer, the others
+ *  their halo from the neighbouring tiles' receptive fields; the output has
+ *  to be the one of the unpatched graph byte for byte.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cmath>
+#include <vector>
+
+#include "host_test.h"
+#include "model_builder.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+#define ARENA_SIZE                  (64 * 1024)
+#define RANDOM_INPUTS               (6)
+#define OUTPUT_CANARY               (0x5A)
+#define MAX_LAYERS                  (4)
+#define MAX_TILINGS                 (8)
+
+typedef struct {
+    tflite::BuiltinOperator op;
+    int filter_height;
+    int filter_width;
+    int stride_height;
+    int stride_width;
+    int dilation;
+    tflite::Padding padding;
+    tflite::ActivationFunctionType activation;
+    /*Output depth of a CONV_2D, a MAX_POOL_2D keeps its input depth*/
+    int depth;
+} layer_t;
+
+typedef struct {
+    const char* name;
+    int input_height;
+    int input_width;
+    int input_depth;
+    int num_layers;
+    layer_t layers[MAX_LAYERS];
+    /*Tilings of the stack, num_layers 0 ends the list*/
+    tflite::PatchExecutionConfig tilings[MAX_TILINGS];
+} stack_case_t;
+
+alignas(16) static uint8_t arena[ARENA_SIZE];
+
+
+static int window_output_size(tflite::Padding padding, int size, int window, int stride, int dilation)
+{
+    const int effective_window = (window - 1) * dilation + 1;
+
+    return padding == tflite::Padding_SAME ? (size + stride - 1) / stride
+                                           : (size - effective_window + stride) / stride;
+}
+
+
+/*******************************************************************************
+* Function Name: build_stack
+********************************************************************************
+* Summary:
+*  Builds the layers of stack_case one after the other, CONV_2D with random
+*  per-channel weights and biases. The output scale of a CONV_2D follows the
+*  spread of its accumulators, so that its output is not mostly saturated; a
+*  MAX_POOL_2D keeps the quantization of its input, which patching requires.
+*  The output heights and widths of the layers go to output_sizes.
+*
+*******************************************************************************/
+static const tflite::Model* build_stack(host_test_model_t* model, const stack_case_t* stack_case,
+                                        std::vector<std::pair<int, int>>* output_sizes)
+{
+    flatbuffers::FlatBufferBuilder& builder = model->builder;
+    int height = stack_case->input_height;
+    int width = stack_case->input_width;
+    int depth = stack_case->input_depth;
+    float scale = 0.05f;
+    int64_t zero_point = host_test_random(-10, 10);
+
+    const int input = host_test_model_tensor(model, {1, height, width, depth}, tflite::TensorType_INT8, scale,
+                                             zero_point);
+    int tensor = input;
+    for (int l = 0; l < stack_case->num_layers; l++) {
+        const layer_t& layer = stack_case->layers[l];
+        height = window_output_size(layer.padding, height, layer.filter_height, layer.stride_height, layer.dilation);
+        width = window_output_size(layer.padding, width, layer.filter_width, layer.stride_width, layer.dilation);
+        output_sizes->push_back(std::make_pair(height, width));
+
+        if (layer.op == tflite::BuiltinOperator_MAX_POOL_2D) {
+            const int output = host_test_model_tensor(model, {1, height, width, depth}, tflite::TensorType_INT8,
+                                                      scale, zero_point);
+            const auto options = tflite::CreatePool2DOptions(builder, layer.padding, layer.stride_width,
+                                                             layer.stride_height, layer.filter_width,
+                                                             layer.filter_height, layer.activation);
+            host_test_model_operator(model, layer.op, {tensor}, {output}, tflite::BuiltinOptions_Pool2DOptions,
+                                     options.Union());
+            tensor = output;
+            continue;
+        }
+
+        const int filter_size = layer.filter_height * layer.filter_width * depth;
+        std::vector<float> filter_scales(layer.depth);
+        std::vector<float> bias_scales(layer.depth);
+        std::vector<int8_t> filter_values(layer.depth * filter_size);
+        std::vector<int32_t> bias_values(layer.depth);
+        for (int channel = 0; channel < layer.depth; channel++) {
+            filter_scales[channel] = 0.005f + 0.001f * (float)host_test_random(0, 15);
+            bias_scales[channel] = scale * filter_scales[channel];
+            bias_values[channel] = host_test_random(-5000, 5000);
+        }
+        for (int8_t& value : filter_values) {
+            value = (int8_t)host_test_random(-127, 127);
+        }
+        const int filter = host_test_model_constant(model, {layer.depth, layer.filter_height, layer.filter_width, depth},
+                                                    tflite::TensorType_INT8, filter_scales, 0, filter_values);
+        const int bias = host_test_model_constant(model, {layer.depth}, tflite::TensorType_INT32, bias_scales, 0,
+                                                  bias_values);
+        /*The accumulators of random inputs and weights spread with the square root of the filter size*/
+        scale *= std::sqrt((float)filter_size);
+        zero_point = host_test_random(-10, 10);
+        const int output = host_test_model_tensor(model, {1, height, width, layer.depth}, tflite::TensorType_INT8,
+                                                  scale, zero_point);
+        const auto options = tflite::CreateConv2DOptions(builder, layer.padding, layer.stride_width,
+                                                         layer.stride_height, layer.activation, layer.dilation,
+                                                         layer.dilation);
+        host_test_model_operator(model, layer.op, {tensor, filter, bias}, {output},
+                                 tflite::BuiltinOptions_Conv2DOptions, options.Union());
+        tensor = output;
+        depth = layer.depth;
+    }
+    return host_test_model_finish(model, {input}, {tensor});
+}
+
+
+/* Writes input, after clearing the output: the output can share memory with the input. */
+static void set_input(tflite::MicroInterpreter* interpreter, const std::vector<int8_t>& input)
+{
+    TfLiteTensor* output = interpreter->output(0);
+
+    memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+    memcpy(interpreter->input(0)->data.int8, input.data(), input.size());
+}
+
+
+static std::vector<int8_t> output_of(tflite::MicroInterpreter* interpreter)
+{
+    const TfLiteTensor* output = interpreter->output(0);
+
+    return std::vector<int8_t>(output->data.int8, output->data.int8 + output->bytes);
+}
+
+
+/*******************************************************************************
+* Function Name: test_stack
+********************************************************************************
+* Summary:
+*  Runs the stack unpatched, then with each of its tilings, on random inputs.
+*  With Invoke() and with InvokeStep the output has to match the unpatched
+*  graph. When the whole stack is patched, an inference takes one step per
+*  tile, which shows that the layers did run as a patch stack.
+*
+*******************************************************************************/
+static void test_stack(const stack_case_t* stack_case)
+{
+    host_test_model_t model;
+    std::vector<std::pair<int, int>> output_sizes;
+    const tflite::Model* built = build_stack(&model, stack_case, &output_sizes);
+
+    std::vector<std::vector<int8_t>> inputs;
+    std::vector<std::vector<int8_t>> expected_outputs;
+    {
+        tflite::MicroMutableOpResolver<2> op_resolver;
+        op_resolver.AddConv2D();
+        op_resolver.AddMaxPool2D();
+        tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+        if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk)) {
+            return;
+        }
+        for (int i = 0; i < RANDOM_INPUTS; i++) {
+            std::vector<int8_t> input(interpreter.input(0)->bytes);
+            for (int8_t& value : input) {
+                value = (int8_t)host_test_random(-128, 127);
+            }
+            inputs.push_back(input);
+            set_input(&interpreter, input);
+            HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+            expected_outputs.push_back(output_of(&interpreter));
+        }
+    }
+
+    tflite::MicroMutableOpResolver<3> op_resolver;
+    op_resolver.AddConv2D();
+    op_resolver.AddMaxPool2D();
+    op_resolver.AddPatchConvStack();
+    for (const tflite::PatchExecutionConfig& tiling : stack_case->tilings) {
+        if (tiling.num_layers == 0) {
+            break;
+        }
+        const std::pair<int, int>& tiled = output_sizes[tiling.num_layers - 1];
+        printf("  %d layers, %dx%d tiles of %dx%d\n", tiling.num_layers, tiling.tile_height, tiling.tile_width,
+               tiled.first, tiled.second);
+
+        tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+        HOST_TEST_EXPECT_EQ(interpreter.SetPatchExecutionConfig(tiling), kTfLiteOk);
+        if (!HOST_TEST_EXPECT(interpreter.AllocateTensors() == kTfLiteOk) ||
+            !HOST_TEST_EXPECT(interpreter.PrepareLeanInvoke() == kTfLiteOk)) {
+            continue;
+        }
+        const int tiles = ((tiled.first + tiling.tile_height - 1) / tiling.tile_height) *
+                          ((tiled.second + tiling.tile_width - 1) / tiling.tile_width);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            set_input(&interpreter, inputs[i]);
+            HOST_TEST_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+            HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+
+            set_input(&interpreter, inputs[i]);
+            tflite::InvokeResumeToken token;
+            int steps = 0;
+            while (!token.finished && HOST_TEST_EXPECT(interpreter.InvokeStep(&token) == kTfLiteOk) &&
+                   steps < 100000) {
+                steps++;
+            }
+            if (tiling.num_layers == stack_case->num_layers) {
+                HOST_TEST_EXPECT_EQ_CASE(steps, tiles, stack_case->name);
+            }
+            HOST_TEST_EXPECT(output_of(&interpreter) == expected_outputs[i]);
+        }
+    }
+
+    /*A tile larger than the output of the stack is refused*/
+    const std::pair<int, int>& last = output_sizes.back();
+    tflite::PatchExecutionConfig too_large;
+    too_large.num_layers = stack_case->num_layers;
+    too_large.tile_height = last.first + 1;
+    too_large.tile_width = last.second;
+    tflite::MicroInterpreter interpreter(built, op_resolver, arena, ARENA_SIZE);
+    HOST_TEST_EXPECT_EQ(interpreter.SetPatchExecutionConfig(too_large), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteError);
+}
+
+
+/* Tiling of the first num_layers layers. */
+static tflite::PatchExecutionConfig tiling(int num_layers, int tile_height, int tile_width)
+{
+    tflite::PatchExecutionConfig config;
+
+    config.num_layers = num_layers;
+    config.tile_height = tile_height;
+    config.tile_width = tile_width;
+    return config;
+}
+
+
+int main(void)
+{
+    const tflite::BuiltinOperator CONV = tflite::BuiltinOperator_CONV_2D;
+    const tflite::BuiltinOperator POOL = tflite::BuiltinOperator_MAX_POOL_2D;
+    const tflite::Padding SAME = tflite::Padding_SAME;
+    const tflite::Padding VALID = tflite::Padding_VALID;
+    const tflite::ActivationFunctionType NONE = tflite::ActivationFunctionType_NONE;
+    const tflite::ActivationFunctionType RELU = tflite::ActivationFunctionType_RELU;
+    const stack_case_t cases[] = {
+        /*The leading layers of the CNN: 14x14 after the first CONV_2D, 7x7 after the MAX_POOL_2D*/
+        {"CNN layers", 28, 28, 1, 4,
+         {{CONV, 3, 3, 2, 2, 1, SAME, RELU, 16}, {CONV, 3, 3, 1, 1, 1, SAME, NONE, 16},
+          {CONV, 3, 3, 1, 1, 1, SAME, NONE, 16}, {POOL, 2, 2, 2, 2, 1, VALID, NONE, 0}},
+         {tiling(4, 1, 1), tiling(4, 2, 3), tiling(4, 4, 4), tiling(4, 7, 7), tiling(4, 7, 2), tiling(2, 5, 6),
+          tiling(1, 14, 1)}},
+        /*Odd sizes: 9x8, then 5x4, then 3x2*/
+        {"strided SAME and VALID", 19, 17, 2, 3,
+         {{CONV, 3, 3, 2, 2, 1, VALID, RELU, 4}, {POOL, 3, 3, 2, 2, 1, SAME, NONE, 0},
+          {CONV, 3, 3, 1, 1, 1, VALID, NONE, 6}},
+         {tiling(3, 1, 1), tiling(3, 2, 2), tiling(3, 3, 2), tiling(3, 1, 2), tiling(2, 2, 3), tiling(2, 4, 4),
+          tiling(1, 4, 5)}},
+        /*A receptive field of 9x9 per output pixel, against 13x11 feature maps*/
+        {"dilated and large filters", 13, 11, 3, 3,
+         {{CONV, 3, 3, 1, 1, 2, SAME, NONE, 4}, {CONV, 5, 5, 1, 1, 1, SAME, RELU, 5},
+          {POOL, 3, 3, 1, 1, 1, SAME, NONE, 0}},
+         {tiling(3, 1, 1), tiling(3, 4, 3), tiling(3, 6, 5), tiling(3, 13, 11), tiling(3, 13, 4), tiling(2, 3, 7)}},
+        {"1x1 conv and pool stride larger than its size", 16, 16, 3, 3,
+         {{CONV, 1, 1, 1, 1, 1, VALID, RELU, 4}, {POOL, 2, 2, 3, 3, 1, VALID, NONE, 0},
+          {CONV, 3, 3, 1, 1, 1, SAME, NONE, 4}},
+         {tiling(3, 1, 1), tiling(3, 2, 2), tiling(3, 4, 3), tiling(3, 5, 5)}},
+    };
+
+    for (const stack_case_t& stack_case : cases) {
+        printf("test_stack: %s\n", stack_case.name);
+        test_stack(&stack_case);
+    }
+    return host_test_result();
+}
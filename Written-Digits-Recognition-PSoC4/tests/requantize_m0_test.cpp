@@ -0,0 +1,128 @@
+/*
+ * requantize_m0_test.cpp
+ *
+ *  MultiplyByQuantizedMultiplier32 (kernels/requantize_m0.h) against the
+ *  double rounding tflite::MultiplyByQuantizedMultiplier, for every shift
+ *  from -31 to 7, multipliers over the whole non-negative int32 range and
+ *  inputs over the whole range the reference accepts: x * 2^max(shift, 0)
+ *  has to fit in int32. The results have to be bit-exact.
+ */
+
+#include <stdio.h>
+
+#include "host_test.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/micro/kernels/requantize_m0.h"
+
+#define MIN_SHIFT                   (-31)
+#define MAX_SHIFT                   (7)
+#define RANDOM_CASES                (2000000)
+#define TIE_RANGE                   (1 << 12)
+
+static const int32_t special_multipliers[] = {
+    0, 1, 2, 0x7fff, 0x8000, 0xffff, 0x10000, 0x10001, 1 << 30, (1 << 30) + 1, 0x55555555,
+    INT32_MAX - 1, INT32_MAX,
+};
+
+
+/* Compares one value, with its arguments in the failure message. */
+static void check(int32_t x, int32_t multiplier, int shift)
+{
+    char text[64];
+
+    snprintf(text, sizeof(text), "x %ld multiplier %ld shift %d", (long)x, (long)multiplier, shift);
+    HOST_TEST_EXPECT_EQ_CASE(tflite::MultiplyByQuantizedMultiplier32(x, multiplier, shift),
+                             tflite::MultiplyByQuantizedMultiplier(x, multiplier, shift), text);
+}
+
+
+/* Largest magnitude of x whose scaled value x * 2^max(shift, 0) fits in int32. */
+static int32_t input_limit(int shift)
+{
+    return shift > 0 ? INT32_MAX >> shift : INT32_MAX;
+}
+
+
+/* The ends of the input range and the values around zero and the powers of two, with the special multipliers. */
+static void test_special_values(void)
+{
+    for (int shift = MIN_SHIFT; shift <= MAX_SHIFT; shift++) {
+        const int32_t limit = input_limit(shift);
+        for (const int32_t multiplier : special_multipliers) {
+            for (int32_t x = -2; x <= 2; x++) {
+                check(x, multiplier, shift);
+            }
+            check(limit, multiplier, shift);
+            check(-limit, multiplier, shift);
+            check(-limit - 1, multiplier, shift);
+            for (int bit = 0; bit < 31 - (shift > 0 ? shift : 0); bit++) {
+                for (int32_t delta = -1; delta <= 1; delta++) {
+                    check((1 << bit) + delta, multiplier, shift);
+                    check(-(1 << bit) + delta, multiplier, shift);
+                }
+            }
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_rounding_ties
+********************************************************************************
+* Summary:
+*  A multiplier of 2^30 halves the input, so every odd input is a tie of the
+*  first rounding, and the right shifts put the second rounding on ties too.
+*  Both round half away from zero, which the sign handling of the 32-bit
+*  version has to reproduce.
+*
+*******************************************************************************/
+static void test_rounding_ties(void)
+{
+    for (int shift = MIN_SHIFT; shift <= MAX_SHIFT; shift++) {
+        for (int32_t x = -TIE_RANGE; x <= TIE_RANGE; x++) {
+            check(x, 1 << 30, shift);
+            check(x, (1 << 30) + 1, shift);
+        }
+    }
+}
+
+
+static void test_random_values(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        const int shift = host_test_random(MIN_SHIFT, MAX_SHIFT);
+        const int32_t limit = input_limit(shift);
+        /*Half of the multipliers in the usual range of QuantizeMultiplier*/
+        const int32_t multiplier = host_test_random(0, 1) != 0 ? host_test_random(1 << 30, INT32_MAX)
+                                                               : host_test_random(0, INT32_MAX);
+        /*Accumulators are mostly small, so half of the inputs are*/
+        const int32_t x = host_test_random(0, 1) != 0 ? host_test_random(-limit - 1, limit)
+                                                      : host_test_random(-(1 << 16), 1 << 16);
+
+        check(x, multiplier, shift);
+    }
+}
+
+
+/* RequantizeM0, which the kernels call, with TF_LITE_REQUANTIZE_32BIT at its default. */
+static void test_requantize_m0(void)
+{
+    for (int i = 0; i < RANDOM_CASES / 10; i++) {
+        const int shift = host_test_random(MIN_SHIFT, 0);
+        const int32_t multiplier = host_test_random(1 << 30, INT32_MAX);
+        const int32_t x = host_test_random(INT32_MIN, INT32_MAX);
+
+        HOST_TEST_EXPECT_EQ(tflite::RequantizeM0(x, multiplier, shift),
+                            tflite::MultiplyByQuantizedMultiplier(x, multiplier, shift));
+    }
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_special_values);
+    HOST_TEST_RUN(test_rounding_ties);
+    HOST_TEST_RUN(test_random_values);
+    HOST_TEST_RUN(test_requantize_m0);
+    return host_test_result();
+}
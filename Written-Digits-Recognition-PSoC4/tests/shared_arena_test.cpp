@@ -0,0 +1,169 @@
+/*
+ * shared_arena_test.cpp
+ *
+ *  Two interpreters on one MicroAllocator, as main.cpp builds the digit
+ *  gatekeeper and the CNN of models/: the outputs of both have to be the ones
+ *  they give in arenas of their own, whatever order they run in, and a time
+ *  sliced inference has to fail once the other interpreter took the head
+ *  section of the arena.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "cnn_test.h"
+#include "digit-gatekeeper-8bit.h"
+#include "host_test.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+
+#define RANDOM_INPUTS               (10)
+#define OUTPUT_CANARY               (0x5A)
+
+alignas(16) static uint8_t arena[HOST_TEST_CNN_ARENA_SIZE];
+alignas(16) static uint8_t gatekeeper_arena[HOST_TEST_CNN_ARENA_SIZE];
+static std::vector<std::vector<uint8_t>> inputs;
+static std::vector<std::vector<uint8_t>> expected_cnn_outputs;
+static std::vector<std::vector<uint8_t>> expected_gatekeeper_outputs;
+
+
+static const tflite::Model* gatekeeper_model(void)
+{
+    return tflite::GetModel(digit_gatekeeper_8bit_tflite);
+}
+
+
+static std::vector<uint8_t> output_of(tflite::MicroInterpreter* interpreter)
+{
+    const TfLiteTensor* output = interpreter->output(0);
+
+    return std::vector<uint8_t>(output->data.uint8, output->data.uint8 + output->bytes);
+}
+
+
+/* Writes input, after clearing the output: the output can share memory with the input. */
+static void set_input(tflite::MicroInterpreter* interpreter, const std::vector<uint8_t>& input)
+{
+    TfLiteTensor* output = interpreter->output(0);
+
+    memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+    memcpy(interpreter->input(0)->data.uint8, input.data(), input.size());
+}
+
+
+/* Runs a whole inference with InvokeStep. */
+static void run_steps(tflite::MicroInterpreter* interpreter, tflite::InvokeResumeToken* token)
+{
+    for (int steps = 0; !token->finished; steps++) {
+        if (!HOST_TEST_EXPECT(interpreter->InvokeStep(token) == kTfLiteOk) || !HOST_TEST_EXPECT(steps < 100000)) {
+            break;
+        }
+    }
+}
+
+
+/* Outputs of the gatekeeper and of the CNN, each one in its own arena. */
+static void compute_expected_outputs(const host_test_cnn_resolver_t* op_resolver)
+{
+    tflite::MicroInterpreter gatekeeper(gatekeeper_model(), *op_resolver, gatekeeper_arena, sizeof(gatekeeper_arena));
+    tflite::MicroInterpreter cnn(host_test_cnn_model(), *op_resolver, arena, sizeof(arena));
+    HOST_TEST_EXPECT_EQ(gatekeeper.AllocateTensors(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(cnn.AllocateTensors(), kTfLiteOk);
+
+    for (int i = 0; i < RANDOM_INPUTS; i++) {
+        inputs.push_back(host_test_random_image());
+        expected_gatekeeper_outputs.push_back(host_test_invoke(&gatekeeper, inputs.back()));
+        expected_cnn_outputs.push_back(host_test_invoke(&cnn, inputs.back()));
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_shared_arena
+********************************************************************************
+* Summary:
+*  Both interpreters on one allocator, allocated one after the other as in
+*  main.cpp. On every input, the gatekeeper and the CNN run in both orders,
+*  with Invoke(), InvokeLean and InvokeStep, and give the outputs of separate
+*  arenas. A time sliced CNN inference fails once the gatekeeper ran, or
+*  allocated its tensors, in its middle; the output is then not written, and
+*  a new token runs the CNN again from the start.
+*
+*******************************************************************************/
+static void test_shared_arena(const host_test_cnn_resolver_t* op_resolver)
+{
+    tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(arena, sizeof(arena));
+    tflite::MicroInterpreter gatekeeper(gatekeeper_model(), *op_resolver, allocator);
+    tflite::MicroInterpreter cnn(host_test_cnn_model(), *op_resolver, allocator);
+    if (!HOST_TEST_EXPECT(gatekeeper.AllocateTensors() == kTfLiteOk) ||
+        !HOST_TEST_EXPECT(cnn.AllocateTensors() == kTfLiteOk) ||
+        !HOST_TEST_EXPECT(gatekeeper.PrepareLeanInvoke() == kTfLiteOk) ||
+        !HOST_TEST_EXPECT(cnn.PrepareLeanInvoke() == kTfLiteOk)) {
+        return;
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        /*Gatekeeper first, as in the main loop*/
+        HOST_TEST_EXPECT(host_test_invoke(&gatekeeper, inputs[i]) == expected_gatekeeper_outputs[i]);
+        HOST_TEST_EXPECT(host_test_invoke(&cnn, inputs[i]) == expected_cnn_outputs[i]);
+
+        /*CNN first, lean and time sliced*/
+        set_input(&cnn, inputs[i]);
+        tflite::InvokeResumeToken token;
+        run_steps(&cnn, &token);
+        HOST_TEST_EXPECT(output_of(&cnn) == expected_cnn_outputs[i]);
+        set_input(&gatekeeper, inputs[i]);
+        HOST_TEST_EXPECT_EQ(gatekeeper.InvokeLean(), kTfLiteOk);
+        HOST_TEST_EXPECT(output_of(&gatekeeper) == expected_gatekeeper_outputs[i]);
+        set_input(&cnn, inputs[i]);
+        HOST_TEST_EXPECT_EQ(cnn.InvokeLean(), kTfLiteOk);
+        HOST_TEST_EXPECT(output_of(&cnn) == expected_cnn_outputs[i]);
+
+        /*The gatekeeper runs in the middle of a time sliced CNN inference, after a random number of steps*/
+        set_input(&cnn, inputs[i]);
+        token = tflite::InvokeResumeToken();
+        for (int steps = host_test_random(1, 20); steps > 0; steps--) {
+            HOST_TEST_EXPECT_EQ(cnn.InvokeStep(&token), kTfLiteOk);
+        }
+        HOST_TEST_EXPECT(host_test_invoke(&gatekeeper, inputs[i]) == expected_gatekeeper_outputs[i]);
+        TfLiteTensor* output = cnn.output(0);
+        memset(output->data.raw, OUTPUT_CANARY, output->bytes);
+        HOST_TEST_EXPECT_EQ(cnn.InvokeStep(&token), kTfLiteError);
+        HOST_TEST_EXPECT_EQ(cnn.InvokeFor(1, &token), kTfLiteError);
+        HOST_TEST_EXPECT(!token.finished);
+        HOST_TEST_EXPECT(output_of(&cnn) == std::vector<uint8_t>(output->bytes, OUTPUT_CANARY));
+
+        /*The gatekeeper itself, time sliced, and the CNN in between*/
+        set_input(&gatekeeper, inputs[i]);
+        token = tflite::InvokeResumeToken();
+        HOST_TEST_EXPECT_EQ(gatekeeper.InvokeStep(&token), kTfLiteOk);
+        HOST_TEST_EXPECT(host_test_invoke(&cnn, inputs[i]) == expected_cnn_outputs[i]);
+        HOST_TEST_EXPECT_EQ(gatekeeper.InvokeStep(&token), kTfLiteError);
+
+        /*A new token starts over*/
+        set_input(&cnn, inputs[i]);
+        token = tflite::InvokeResumeToken();
+        run_steps(&cnn, &token);
+        HOST_TEST_EXPECT(output_of(&cnn) == expected_cnn_outputs[i]);
+    }
+
+    /*Allocating the tensors of the gatekeeper again also takes the head*/
+    set_input(&cnn, inputs[0]);
+    tflite::InvokeResumeToken token;
+    HOST_TEST_EXPECT_EQ(cnn.InvokeStep(&token), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(gatekeeper.AllocateTensors(), kTfLiteOk);
+    HOST_TEST_EXPECT_EQ(cnn.InvokeStep(&token), kTfLiteError);
+}
+
+
+int main(void)
+{
+    /*The operators of both models, with the fused ones of the CNN as the application registers them*/
+    host_test_cnn_resolver_t op_resolver;
+    host_test_cnn_ops(&op_resolver, true);
+
+    compute_expected_outputs(&op_resolver);
+    test_shared_arena(&op_resolver);
+    return host_test_result();
+}
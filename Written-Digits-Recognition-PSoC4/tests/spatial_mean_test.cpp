@@ -0,0 +1,79 @@
+/*
+ * spatial_mean_test.cpp
+ *
+ *  SpatialMeanS8 (kernels/spatial_mean.h) against
+ *  reference_ops::QuantizedMeanOrSum over axes 1 and 2, on random shapes,
+ *  zero points, multipliers and input alignments. Inputs of more than 257
+ *  pixels are summed in several passes of the 16-bit lanes. The outputs have
+ *  to be bit-exact.
+ */
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "host_test.h"
+#include "tensorflow/lite/kernels/internal/reference/reduce.h"
+#include "tensorflow/lite/micro/kernels/spatial_mean.h"
+
+#define RANDOM_CASES                (2000)
+
+
+static void test_spatial_mean_s8(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        const int side = host_test_random(0, 3) == 0 ? 24 : 8;
+        const cmsis_nn_dims input_dims = {host_test_random(1, 2), host_test_random(1, side),
+                                          host_test_random(1, side),
+                                          host_test_random(0, 1) != 0 ? 4 * host_test_random(1, 8)
+                                                                      : host_test_random(1, 20)};
+        const int alignment = host_test_random(0, 3);
+        const int input_count = input_dims.n * input_dims.h * input_dims.w * input_dims.c;
+        const int output_count = input_dims.n * input_dims.c;
+        std::vector<int32_t> input_words(input_count / 4 + 2);
+        int8_t* input = (int8_t*)input_words.data() + alignment;
+        std::vector<int8_t> output(output_count);
+        std::vector<int8_t> expected(output_count);
+        char text[96];
+
+        snprintf(text, sizeof(text), "in %dx%dx%dx%d alignment %d", input_dims.n, input_dims.h, input_dims.w,
+                 input_dims.c, alignment);
+        /*Input to output scale ratios from about 1/1000 to 4*/
+        const int32_t multiplier = host_test_random(1 << 30, INT32_MAX);
+        const int shift = host_test_random(-10, 2);
+        tflite::SpatialMeanParams params;
+        params.input_zero_point = host_test_random(-128, 127);
+        params.output_zero_point = host_test_random(-128, 127);
+        tflite::SpatialMeanMultiplier(multiplier, shift, input_dims.h * input_dims.w, &params.multiplier,
+                                      &params.shift);
+        for (int k = 0; k < input_count; k++) {
+            input[k] = (int8_t)host_test_random(-128, 127);
+        }
+
+        const int input_shape[4] = {input_dims.n, input_dims.h, input_dims.w, input_dims.c};
+        const int output_shape[4] = {input_dims.n, 1, 1, input_dims.c};
+        const int axis[2] = {1, 2};
+        int temp_index[4];
+        int resolved_axis[2];
+        std::vector<int32_t> temp_sum(output_count);
+        const bool reduced = tflite::reference_ops::QuantizedMeanOrSum<int8_t, int32_t>(
+            input, params.input_zero_point, input_shape, 4, expected.data(), multiplier, shift,
+            params.output_zero_point, output_shape, 4, axis, 2, true, temp_index, resolved_axis,
+            temp_sum.data(), false);
+        HOST_TEST_EXPECT(reduced);
+
+        tflite::SpatialMeanS8(params, input_dims, input, output.data());
+        for (int k = 0; k < output_count; k++) {
+            if (!HOST_TEST_EXPECT_EQ_CASE(output[k], expected[k], text)) {
+                break;
+            }
+        }
+    }
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_spatial_mean_s8);
+    return host_test_result();
+}
@@ -0,0 +1,186 @@
+/*
+ * uart_frame_test.cpp
+ *
+ *  Encoder and decoder of the binary UART frames (src/uart_frame.h): the
+ *  CRC check value, frames of every payload length through the decoder one
+ *  byte at a time, and the streams the decoder has to skip: the text output
+ *  of the application, corrupted and truncated frames and too long payloads.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "host_test.h"
+#include "uart_frame.h"
+
+typedef struct {
+    uint8_t command;
+    std::vector<uint8_t> payload;
+} frame_t;
+
+
+static void append_frame(std::vector<uint8_t>* stream, uint8_t command, const std::vector<uint8_t>& payload)
+{
+    uint8_t frame[UART_FRAME_MAX_PAYLOAD + UART_FRAME_OVERHEAD];
+    const size_t size = uart_frame_encode(command, payload.data(), (uint16_t)payload.size(), frame);
+
+    HOST_TEST_EXPECT_EQ(size, payload.size() + UART_FRAME_OVERHEAD);
+    stream->insert(stream->end(), frame, frame + size);
+}
+
+
+static void append_text(std::vector<uint8_t>* stream, const char* text)
+{
+    stream->insert(stream->end(), text, text + strlen(text));
+}
+
+
+/* Feeds the stream to a new decoder and returns the frames it completes. */
+static std::vector<frame_t> decode(const std::vector<uint8_t>& stream)
+{
+    uart_frame_decoder_t decoder;
+    std::vector<frame_t> frames;
+
+    uart_frame_decoder_init(&decoder);
+    for (const uint8_t byte : stream) {
+        if (uart_frame_decode(&decoder, byte)) {
+            frames.push_back({decoder.command, std::vector<uint8_t>(decoder.payload,
+                                                                    decoder.payload + decoder.length)});
+        }
+    }
+    return frames;
+}
+
+
+static std::vector<uint8_t> random_payload(int length)
+{
+    std::vector<uint8_t> payload(length);
+
+    for (int i = 0; i < length; i++) {
+        payload[i] = (uint8_t)host_test_random(0, 255);
+    }
+    return payload;
+}
+
+
+static void test_crc16(void)
+{
+    /*Check value of CRC-16/CCITT-FALSE*/
+    HOST_TEST_EXPECT_EQ(uart_frame_crc16(0xFFFFu, (const uint8_t*)"123456789", 9), 0x29B1);
+    /*The CRC can be computed in pieces*/
+    const uint16_t crc = uart_frame_crc16(0xFFFFu, (const uint8_t*)"1234", 4);
+    HOST_TEST_EXPECT_EQ(uart_frame_crc16(crc, (const uint8_t*)"56789", 5), 0x29B1);
+}
+
+
+/* Every payload length, each frame completed by its last byte only. */
+static void test_round_trip(void)
+{
+    for (int length = 0; length <= (int)UART_FRAME_MAX_PAYLOAD; length++) {
+        std::vector<uint8_t> stream;
+        const std::vector<uint8_t> payload = random_payload(length);
+        const uint8_t command = (uint8_t)host_test_random(0, 255);
+        uart_frame_decoder_t decoder;
+
+        append_frame(&stream, command, payload);
+        HOST_TEST_EXPECT_EQ(stream[0], UART_FRAME_SYNC0);
+        HOST_TEST_EXPECT_EQ(stream[1], UART_FRAME_SYNC1);
+        HOST_TEST_EXPECT_EQ(stream[3] | (stream[4] << 8), length);
+        uart_frame_decoder_init(&decoder);
+        for (size_t i = 0; i < stream.size(); i++) {
+            HOST_TEST_EXPECT_EQ(uart_frame_decode(&decoder, stream[i]), i == stream.size() - 1);
+        }
+        HOST_TEST_EXPECT_EQ(decoder.command, command);
+        HOST_TEST_EXPECT_EQ(decoder.length, length);
+        HOST_TEST_EXPECT(memcmp(decoder.payload, payload.data(), length) == 0);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: test_noise
+********************************************************************************
+* Summary:
+*  Frames mixed with the text of the application, with sync bytes in the text
+*  and repeated sync bytes, and with frames that have to be dropped: a flipped
+*  bit, a payload longer than UART_FRAME_MAX_PAYLOAD and a truncated frame.
+*  Only the valid frames come out, in order.
+*
+*******************************************************************************/
+static void test_noise(void)
+{
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> corrupted;
+    const std::vector<uint8_t> first = random_payload(10);
+    const std::vector<uint8_t> second = random_payload(UART_FRAME_MAX_PAYLOAD);
+    const std::vector<uint8_t> third = random_payload(0);
+
+    append_text(&stream, "Prediction: 3\r\nScores: 0 0 0 255 0 0 0 0 0 0\r\n");
+    stream.push_back(UART_FRAME_SYNC0);
+    stream.push_back(UART_FRAME_SYNC0);
+    append_frame(&stream, 0x01, first);
+
+    append_frame(&corrupted, 0x02, random_payload(20));
+    corrupted[10] ^= 0x10;
+    stream.insert(stream.end(), corrupted.begin(), corrupted.end());
+
+    append_text(&stream, "\xA5 text after a sync byte\r\n");
+    /*Header of a payload one byte too long, dropped before its payload*/
+    const uint8_t too_long[] = {UART_FRAME_SYNC0, UART_FRAME_SYNC1, 0x03,
+                                (uint8_t)(UART_FRAME_MAX_PAYLOAD + 1), 0};
+    stream.insert(stream.end(), too_long, too_long + sizeof(too_long));
+    append_frame(&stream, 0x04, second);
+
+    append_frame(&stream, 0x16, third);
+
+    std::vector<frame_t> frames = decode(stream);
+    HOST_TEST_EXPECT_EQ(frames.size(), 3);
+    if (frames.size() == 3) {
+        HOST_TEST_EXPECT_EQ(frames[0].command, 0x01);
+        HOST_TEST_EXPECT(frames[0].payload == first);
+        HOST_TEST_EXPECT_EQ(frames[1].command, 0x04);
+        HOST_TEST_EXPECT(frames[1].payload == second);
+        HOST_TEST_EXPECT_EQ(frames[2].command, 0x16);
+        HOST_TEST_EXPECT(frames[2].payload.empty());
+    }
+
+    /*A truncated frame takes the bytes after it as the rest of its payload, then fails its CRC*/
+    std::vector<uint8_t> truncated;
+    append_frame(&truncated, 0x05, random_payload(30));
+    truncated.resize(20);
+    append_text(&truncated, "0123456789012345678901234567890123456789");
+    append_frame(&truncated, 0x06, first);
+    frames = decode(truncated);
+    HOST_TEST_EXPECT_EQ(frames.size(), 1);
+    if (frames.size() == 1) {
+        HOST_TEST_EXPECT_EQ(frames[0].command, 0x06);
+    }
+}
+
+
+/* Every single bit flip of a frame is caught by the CRC. */
+static void test_bit_flips(void)
+{
+    std::vector<uint8_t> frame;
+
+    append_frame(&frame, 0x12, random_payload(24));
+    for (size_t byte = 2; byte < frame.size(); byte++) {
+        for (int bit = 0; bit < 8; bit++) {
+            std::vector<uint8_t> stream = frame;
+            stream[byte] ^= (uint8_t)(1u << bit);
+            HOST_TEST_EXPECT_EQ(decode(stream).size(), 0);
+        }
+    }
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_crc16);
+    HOST_TEST_RUN(test_round_trip);
+    HOST_TEST_RUN(test_noise);
+    HOST_TEST_RUN(test_bit_flips);
+    return host_test_result();
+}
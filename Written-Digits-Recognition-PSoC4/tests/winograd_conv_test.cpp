@@ -0,0 +1,185 @@
+/*
+ * winograd_conv_test.cpp
+ *
+ *  WinogradConvS8 (kernels/winograd_conv.h) against the direct convolution,
+ *  reference_integer_ops::ConvPerChannel, on random 3x3 stride 1 layers
+ *  with SAME or VALID padding. The filters are transformed here with 2G, as
+ *  tools/winograd_filters.py does. The outputs have to be bit-exact, also at
+ *  kWinogradMaxInputDepth with inputs and weights at the ends of their range,
+ *  where the accumulators come closest to overflowing.
+ */
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "host_test.h"
+#include "kernel_test.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
+
+#define RANDOM_CASES                (300)
+#define EXTREME_CASES               (20)
+
+/* 2G of F(2x2, 3x3), which keeps the transformed filters in integers. */
+static const int g2[4][3] = {{2, 0, 0}, {1, 1, 1}, {1, -1, 1}, {0, 0, 2}};
+
+
+/*******************************************************************************
+* Function Name: transform_filters
+********************************************************************************
+* Summary:
+*  (2G) g (2G)^T of every 3x3 filter g of an [output][3][3][input] filter, in
+*  the [output channel][tile element][input channel] order of the kernel.
+*
+*******************************************************************************/
+static std::vector<int16_t> transform_filters(const std::vector<int8_t>& filter, int output_depth, int depth)
+{
+    std::vector<int16_t> transformed(output_depth * tflite::kWinogradTileSize * depth);
+
+    for (int oc = 0; oc < output_depth; oc++) {
+        for (int c = 0; c < depth; c++) {
+            int32_t gg[4][3];
+            for (int i = 0; i < 4; i++) {
+                for (int x = 0; x < 3; x++) {
+                    gg[i][x] = 0;
+                    for (int y = 0; y < 3; y++) {
+                        gg[i][x] += g2[i][y] * filter[((oc * 3 + y) * 3 + x) * depth + c];
+                    }
+                }
+            }
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    int32_t u = 0;
+                    for (int x = 0; x < 3; x++) {
+                        u += gg[i][x] * g2[j][x];
+                    }
+                    transformed[(oc * tflite::kWinogradTileSize + i * 4 + j) * depth + c] = (int16_t)u;
+                }
+            }
+        }
+    }
+    return transformed;
+}
+
+
+/*******************************************************************************
+* Function Name: check_winograd_case
+********************************************************************************
+* Summary:
+*  One layer of random size with the given depths. extreme puts every input
+*  at -128 or 127 and every weight at -127 or 127, with the input zero point
+*  at the other end of the range.
+*
+*******************************************************************************/
+static void check_winograd_case(int depth, int output_depth, bool extreme)
+{
+    const bool same = host_test_random(0, 1) != 0;
+    cmsis_nn_dims input_dims = {host_test_random(1, 2), host_test_random(3, 14), host_test_random(3, 14), depth};
+    cmsis_nn_dims filter_dims = {output_depth, 3, 3, depth};
+    cmsis_nn_dims bias_dims = {1, 1, 1, output_depth};
+    cmsis_nn_dims output_dims = {input_dims.n, same ? input_dims.h : input_dims.h - 2,
+                                 same ? input_dims.w : input_dims.w - 2, output_depth};
+    cmsis_nn_conv_params params = {};
+    char text[96];
+
+    /*The input offset is minus the zero point*/
+    params.input_offset = extreme ? (host_test_random(0, 1) != 0 ? 128 : -127) : -host_test_random(-128, 127);
+    params.output_offset = host_test_random(-128, 127);
+    params.stride = {1, 1};
+    params.dilation = {1, 1};
+    params.padding = same ? cmsis_nn_tile{1, 1} : cmsis_nn_tile{0, 0};
+    params.activation.min = -128;
+    params.activation.max = 127;
+    snprintf(text, sizeof(text), "in %dx%dx%dx%d out %d %s%s", input_dims.n, input_dims.h, input_dims.w, depth,
+             output_depth, same ? "SAME" : "VALID", extreme ? " extreme" : "");
+
+    std::vector<int8_t> input(input_dims.n * input_dims.h * input_dims.w * depth);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (int8_t)(extreme ? (host_test_random(0, 1) ? 127 : -128) : host_test_random(-128, 127));
+    }
+    std::vector<int8_t> filter(output_depth * 9 * depth);
+    for (size_t i = 0; i < filter.size(); i++) {
+        filter[i] = (int8_t)(extreme ? (host_test_random(0, 1) ? 127 : -127) : host_test_random(-127, 127));
+    }
+    std::vector<int32_t> bias(output_depth);
+    std::vector<int32_t> multiplier(output_depth);
+    std::vector<int32_t> shift(output_depth);
+    for (int i = 0; i < output_depth; i++) {
+        bias[i] = host_test_random(-(1 << 16), 1 << 16);
+        multiplier[i] = host_test_random(1 << 30, INT32_MAX);
+        /*Large accumulators of the extreme cases need a large scale down to stay inside int8*/
+        shift[i] = extreme ? host_test_random(-24, -16) : host_test_random(-14, 0);
+    }
+
+    const int output_count = output_dims.n * output_dims.h * output_dims.w * output_depth;
+    std::vector<int8_t> expected(output_count);
+    tflite::reference_integer_ops::ConvPerChannel(
+        host_test_conv_params(params), multiplier.data(), shift.data(), host_test_shape(input_dims),
+        input.data(), host_test_shape(filter_dims), filter.data(), host_test_shape(output_depth), bias.data(),
+        host_test_shape(output_dims), expected.data());
+
+    const std::vector<int16_t> transformed = transform_filters(filter, output_depth, depth);
+    std::vector<int8_t> output(output_count);
+    std::vector<int8_t> buffer(tflite::WinogradConvS8GetBufferSize(&filter_dims));
+    cmsis_nn_context ctx = {buffer.data(), (int32_t)buffer.size()};
+    cmsis_nn_per_channel_quant_params quant_params = {multiplier.data(), shift.data()};
+    HOST_TEST_EXPECT_EQ_CASE(tflite::WinogradConvS8(&ctx, &params, &quant_params, &input_dims, input.data(),
+                                                    &filter_dims, transformed.data(), &bias_dims, bias.data(),
+                                                    &output_dims, output.data()),
+                             ARM_CMSIS_NN_SUCCESS, text);
+    for (int i = 0; i < output_count; i++) {
+        if (!HOST_TEST_EXPECT_EQ_CASE(output[i], expected[i], text)) {
+            break;
+        }
+    }
+}
+
+
+static void test_winograd_conv_s8(void)
+{
+    for (int i = 0; i < RANDOM_CASES; i++) {
+        check_winograd_case(host_test_random(1, 20), host_test_random(1, 9), false);
+    }
+}
+
+
+static void test_winograd_conv_s8_extremes(void)
+{
+    for (int i = 0; i < EXTREME_CASES; i++) {
+        check_winograd_case(tflite::kWinogradMaxInputDepth, host_test_random(1, 4), true);
+    }
+}
+
+
+/* Shapes the kernel does not handle are refused rather than computed. */
+static void test_winograd_conv_s8_arguments(void)
+{
+    cmsis_nn_dims input_dims = {1, 8, 8, tflite::kWinogradMaxInputDepth + 1};
+    cmsis_nn_dims filter_dims = {1, 3, 3, tflite::kWinogradMaxInputDepth + 1};
+    cmsis_nn_dims bias_dims = {1, 1, 1, 1};
+    cmsis_nn_dims output_dims = {1, 6, 6, 1};
+    cmsis_nn_conv_params params = {};
+    std::vector<int8_t> buffer(tflite::WinogradConvS8GetBufferSize(&filter_dims));
+    cmsis_nn_context ctx = {buffer.data(), (int32_t)buffer.size()};
+
+    params.stride = {1, 1};
+    params.dilation = {1, 1};
+    HOST_TEST_EXPECT_EQ(tflite::WinogradConvS8(&ctx, &params, nullptr, &input_dims, nullptr, &filter_dims, nullptr,
+                                               &bias_dims, nullptr, &output_dims, nullptr),
+                        ARM_CMSIS_NN_ARG_ERROR);
+    input_dims.c = filter_dims.c = 8;
+    params.stride = {2, 2};
+    HOST_TEST_EXPECT_EQ(tflite::WinogradConvS8(&ctx, &params, nullptr, &input_dims, nullptr, &filter_dims, nullptr,
+                                               &bias_dims, nullptr, &output_dims, nullptr),
+                        ARM_CMSIS_NN_ARG_ERROR);
+}
+
+
+int main(void)
+{
+    HOST_TEST_RUN(test_winograd_conv_s8);
+    HOST_TEST_RUN(test_winograd_conv_s8_extremes);
+    HOST_TEST_RUN(test_winograd_conv_s8_arguments);
+    return host_test_result();
+}
@@ -90,6 +90,11 @@ class INonPersistentBufferAllocator {
   // Returns the size of non-persistent buffer in use.
   virtual size_t GetNonPersistentUsedBytes() const = 0;
 
+  // Returns the end of the temporary allocations made since the last
+  // ResetTempAllocations(), as an offset from the overlay memory address, or 0
+  // if there are none.
+  virtual size_t GetTempEndOffset() const = 0;
+
   // Returns the number of bytes available with a given alignment. This number
   // takes in account any temporary allocations.
   virtual size_t GetAvailableMemory(size_t alignment) const = 0;
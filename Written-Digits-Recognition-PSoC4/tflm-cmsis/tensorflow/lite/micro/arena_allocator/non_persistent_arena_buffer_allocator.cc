@@ -158,6 +158,10 @@ size_t NonPersistentArenaBufferAllocator::GetNonPersistentUsedBytes() const {
   return (next_temp_ - buffer_head_);
 }
 
+size_t NonPersistentArenaBufferAllocator::GetTempEndOffset() const {
+  return next_temp_ != head_temp_ ? next_temp_ - buffer_head_ : 0;
+}
+
 // Returns the number of bytes available with a given alignment. This number
 // takes in account any temporary allocations.
 size_t NonPersistentArenaBufferAllocator::GetAvailableMemory(
@@ -70,6 +70,10 @@ class NonPersistentArenaBufferAllocator : public INonPersistentBufferAllocator {
   // Returns the size of non-persistent buffer in use.
   size_t GetNonPersistentUsedBytes() const override;
 
+  // Returns the end of the temp allocations made since the last
+  // ResetTempAllocations() as an offset from the head of the arena, or 0.
+  size_t GetTempEndOffset() const override;
+
   // Returns the number of bytes available with a given alignment. This number
   // takes in account any temporary allocations.
   size_t GetAvailableMemory(size_t alignment) const override;
@@ -174,6 +174,10 @@ size_t SingleArenaBufferAllocator::GetNonPersistentUsedBytes() const {
   return std::max(head_ - buffer_head_, temp_ - buffer_head_);
 }
 
+size_t SingleArenaBufferAllocator::GetTempEndOffset() const {
+  return temp_ != head_ ? temp_ - buffer_head_ : 0;
+}
+
 size_t SingleArenaBufferAllocator::GetPersistentUsedBytes() const {
   return buffer_tail_ - tail_;
 }
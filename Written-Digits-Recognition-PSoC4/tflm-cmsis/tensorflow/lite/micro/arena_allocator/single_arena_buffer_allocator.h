@@ -99,6 +99,10 @@ class SingleArenaBufferAllocator : public INonPersistentBufferAllocator,
   // Returns the size of the head section in bytes.
   size_t GetNonPersistentUsedBytes() const override;
 
+  // Returns the end of the temp allocations made since the last
+  // ResetTempAllocations() as an offset from the head of the arena, or 0.
+  size_t GetTempEndOffset() const override;
+
   // Returns the size of all allocations in the tail section in bytes.
   size_t GetPersistentUsedBytes() const override;
 
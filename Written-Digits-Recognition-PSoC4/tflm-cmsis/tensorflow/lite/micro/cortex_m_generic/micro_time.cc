@@ -21,26 +21,102 @@ limitations under the License.
 #include CMSIS_DEVICE_ARM_CORTEX_M_XX_HEADER_FILE
 #endif
 
+#if (defined(ARMCM0) || defined(ARMCM0plus)) && \
+    !defined(TF_LITE_STRIP_ERROR_STRINGS)
+// The CMSIS core clock frequency, kept by the device's system file.
+extern "C" uint32_t SystemCoreClock;
+#endif
+
 namespace tflite {
 
-#if defined(PROJECT_GENERATION)
+namespace {
+
+MicroTimeTicksFunction registered_ticks = nullptr;
+uint32_t registered_ticks_per_second = 0;
+
+#if defined(PROJECT_GENERATION) || (!defined(__arm__) && !defined(__ICCARM__))
 
 // Stub functions for the project_generation target since these will be replaced
 // by the target-specific implementation in the overall infrastructure that the
-// TFLM project generation will be a part of.
-uint32_t ticks_per_second() { return 0; }
-uint32_t GetCurrentTimeTicks() { return 0; }
+// TFLM project generation will be a part of. Host builds of this file have no
+// counter either and rely on a registered source, e.g. FakeMicroTime.
+uint32_t PlatformTicksPerSecond() { return 0; }
+uint32_t PlatformTicks() { return 0; }
+
+#elif (defined(ARMCM0) || defined(ARMCM0plus)) && \
+    !defined(TF_LITE_STRIP_ERROR_STRINGS)
+
+// The Cortex-M0 and M0+ have neither the DWT cycle counter nor a PMU, so the
+// ticks come from SysTick, which every Cortex-M has at the same address. It
+// counts down to 0, reloads, and sets COUNTFLAG, which reading CTRL clears.
+// Each call adds the periods it sees to a software count. The time stays
+// right as long as GetCurrentTimeTicks is called at least once a period,
+// 2^24 cycles (350 ms at 48 MHz) unless the application set up SysTick with
+// a shorter one; a longer gap loses whole periods.
+struct SysTickRegisters {
+  volatile uint32_t ctrl;
+  volatile uint32_t load;
+  volatile uint32_t val;
+};
+
+constexpr uintptr_t kSysTickBase = 0xE000E010u;
+constexpr uint32_t kSysTickEnable = 1u << 0;
+constexpr uint32_t kSysTickProcessorClock = 1u << 2;
+constexpr uint32_t kSysTickCountFlag = 1u << 16;
+constexpr uint32_t kSysTickMaxReload = 0xFFFFFFu;
+
+bool systick_started = false;
+bool systick_on_processor_clock = false;
+uint32_t systick_elapsed_ticks = 0;
+
+SysTickRegisters* StartSysTick() {
+  SysTickRegisters* systick =
+      reinterpret_cast<SysTickRegisters*>(kSysTickBase);
+  if (!systick_started) {
+    // A SysTick already running for the application is used as it is. Apart
+    // from here only PlatformTicks reads CTRL, as that clears COUNTFLAG.
+    const uint32_t ctrl = systick->ctrl;
+    if ((ctrl & kSysTickEnable) == 0) {
+      systick->load = kSysTickMaxReload;
+      systick->val = 0;
+      systick->ctrl = kSysTickProcessorClock | kSysTickEnable;
+      systick_on_processor_clock = true;
+    } else {
+      systick_on_processor_clock = (ctrl & kSysTickProcessorClock) != 0;
+    }
+    systick_started = true;
+  }
+  return systick;
+}
+
+// SysTick on its external reference clock runs at a device specific rate;
+// register a source with that rate to use it.
+uint32_t PlatformTicksPerSecond() {
+  StartSysTick();
+  return systick_on_processor_clock ? SystemCoreClock : 0;
+}
+
+uint32_t PlatformTicks() {
+  SysTickRegisters* systick = StartSysTick();
+  const uint32_t period = systick->load + 1;
+  uint32_t value = systick->val;
+  if ((systick->ctrl & kSysTickCountFlag) != 0) {
+    // The counter may have reloaded after |value| was read.
+    systick_elapsed_ticks += period;
+    value = systick->val;
+  }
+  return systick_elapsed_ticks + (period - 1 - value);
+}
 
 #else
 
-uint32_t ticks_per_second() { return 0; }
+uint32_t PlatformTicksPerSecond() { return 0; }
 
-uint32_t GetCurrentTimeTicks() {
+uint32_t PlatformTicks() {
   static bool is_initialized = false;
 
   if (!is_initialized) {
-#if (!defined(TF_LITE_STRIP_ERROR_STRINGS) && !defined(ARMCM0) && \
-     !defined(ARMCM0plus))
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
 #ifdef ARM_MODEL_USE_PMU_COUNTERS
     ARM_PMU_Enable();
     DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
@@ -64,8 +140,7 @@ uint32_t GetCurrentTimeTicks() {
     is_initialized = true;
   }
 
-#if (!defined(TF_LITE_STRIP_ERROR_STRINGS) && !defined(ARMCM0) && \
-     !defined(ARMCM0plus))
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
 #ifdef ARM_MODEL_USE_PMU_COUNTERS
   return ARM_PMU_Get_CCNTR();
 #else
@@ -76,6 +151,23 @@ uint32_t GetCurrentTimeTicks() {
 #endif
 }
 
-#endif  // defined(PROJECT_GENERATION)
+#endif  // defined(PROJECT_GENERATION) || ...
+
+}  // namespace
+
+void SetMicroTimeSource(MicroTimeTicksFunction get_ticks,
+                        uint32_t ticks_per_second) {
+  registered_ticks = get_ticks;
+  registered_ticks_per_second = get_ticks != nullptr ? ticks_per_second : 0;
+}
+
+uint32_t ticks_per_second() {
+  return registered_ticks != nullptr ? registered_ticks_per_second
+                                     : PlatformTicksPerSecond();
+}
+
+uint32_t GetCurrentTimeTicks() {
+  return registered_ticks != nullptr ? registered_ticks() : PlatformTicks();
+}
 
 }  // namespace tflite
@@ -0,0 +1,39 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/fake_micro_time.h"
+
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+uint32_t FakeMicroTime::ticks_ = 0;
+uint32_t FakeMicroTime::step_ticks_ = 0;
+
+void FakeMicroTime::Install(uint32_t step_ticks) {
+  ticks_ = 0;
+  step_ticks_ = step_ticks;
+  SetMicroTimeSource(&FakeMicroTime::GetTicks, kTicksPerSecond);
+}
+
+void FakeMicroTime::Uninstall() { SetMicroTimeSource(nullptr, 0); }
+
+uint32_t FakeMicroTime::GetTicks() {
+  const uint32_t ticks = ticks_;
+  ticks_ += step_ticks_;
+  return ticks;
+}
+
+}  // namespace tflite
@@ -0,0 +1,52 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_FAKE_MICRO_TIME_H_
+#define TENSORFLOW_LITE_MICRO_FAKE_MICRO_TIME_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// A fake tick source for host tests of code timed with GetCurrentTimeTicks(),
+// e.g. MicroProfiler or MicroInterpreter::InvokeFor. Time only moves when the
+// test advances it, or by a fixed step on every read, so the ticks are
+// deterministic.
+class FakeMicroTime {
+ public:
+  static constexpr uint32_t kTicksPerSecond = 1000000;
+
+  // Registers the fake with SetMicroTimeSource, starting at 0 ticks and moving
+  // |step_ticks| after every read.
+  static void Install(uint32_t step_ticks = 0);
+
+  // Goes back to the platform's tick source.
+  static void Uninstall();
+
+  static void Advance(uint32_t ticks) { ticks_ += ticks; }
+
+  // Current ticks, without a step.
+  static uint32_t ticks() { return ticks_; }
+
+ private:
+  static uint32_t GetTicks();
+
+  static uint32_t ticks_;
+  static uint32_t step_ticks_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_FAKE_MICRO_TIME_H_
@@ -0,0 +1,64 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CLASSIFIER_HEAD_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CLASSIFIER_HEAD_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_common.h"
+
+namespace tflite {
+
+// Names under which the fused MEAN + FULLY_CONNECTED + SOFTMAX kernels are
+// registered with the op resolver. The operator fusion pass prefers the
+// argmax variant when both are registered.
+extern const char* const kMeanFullyConnectedSoftmaxOpName;
+extern const char* const kMeanFullyConnectedArgMaxOpName;
+
+// Builtin data of a fused classifier head node. The node takes the input of
+// the original MEAN followed by the weights and optional bias of the
+// FULLY_CONNECTED, and writes the output of the original SOFTMAX. The MEAN and
+// FULLY_CONNECTED outputs are listed as node intermediates: they are not
+// allocated but still provide the quantization parameters of each stage.
+struct TfLiteClassifierHeadParams {
+  TfLiteReducerParams mean;
+  TfLiteFullyConnectedParams fully_connected;
+  TfLiteSoftmaxParams softmax;
+};
+
+// Returns a TFLMRegistration struct for the fused head. Only int8 is
+// supported, and the MEAN has to reduce the two spatial dimensions of a 4D
+// input. The result is bit-exact with running the three ops in sequence.
+TFLMRegistration* Register_MEAN_FULLY_CONNECTED_SOFTMAX();
+
+// Same as above, but skips the softmax: the output is one-hot, holding the
+// largest representable value at the argmax of the logits and the smallest
+// one everywhere else. The lowest index wins on ties. With a threshold set by
+// MicroInterpreter::SetArgMaxConfidenceThreshold, the output is the smallest
+// value everywhere whenever the softmax output at the argmax would be below
+// it. That test is exact: the threshold is turned into margins between the
+// two largest logits, and only the inputs between those margins sum the
+// exponentials of the logits, with no division.
+TFLMRegistration* Register_MEAN_FULLY_CONNECTED_ARGMAX();
+
+// Recomputes the margins of a prepared argmax head for a new |threshold|.
+// |user_data| is that of a node registered with
+// Register_MEAN_FULLY_CONNECTED_ARGMAX. MicroInterpreter calls this for a
+// threshold set after AllocateTensors(), so that Eval only reads them.
+void UpdateArgMaxConfidenceThreshold(void* user_data, int8_t threshold);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CLASSIFIER_HEAD_H_
@@ -0,0 +1,399 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/classifier_head.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "Include/arm_nnfunctions.h"
+#include "Include/arm_nnsupportfunctions.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/softmax.h"
+#include "tensorflow/lite/micro/kernels/spatial_mean.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+const char* const kMeanFullyConnectedSoftmaxOpName =
+    "MEAN_FULLY_CONNECTED_SOFTMAX";
+const char* const kMeanFullyConnectedArgMaxOpName =
+    "MEAN_FULLY_CONNECTED_ARGMAX";
+
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kWeightsTensor = 1;
+constexpr int kBiasTensor = 2;
+constexpr int kOutputTensor = 0;
+constexpr int kMeanOutputIntermediate = 0;
+constexpr int kFullyConnectedOutputIntermediate = 1;
+
+// Fractional bits of the sum of exponentials in arm_nn_softmax_common_s8.
+constexpr int kSoftmaxAccumBits = 12;
+// Margin between two int8 logits that is larger than any actual one.
+constexpr int32_t kNoMargin = 256;
+
+struct OpData {
+  // Requantization of the spatial sum into the MEAN output.
+  SpatialMeanParams mean;
+  int32_t num_spatial_elements;
+
+  OpDataFullyConnected fully_connected;
+  SoftmaxParams softmax;
+
+  int32_t batches;
+  int32_t channels;
+  int32_t output_depth;
+
+  // Confidence test of the argmax variant. The softmax output of the largest
+  // logit only depends on the sum of the exponentials of the other logits,
+  // relative to it, and falls as that sum grows: it reaches the threshold set
+  // with MicroInterpreter::SetArgMaxConfidenceThreshold as long as the sum
+  // stays at most |max_other_sum|. The top two logits decide most inputs:
+  // below |reject_margin| the second one alone exceeds that sum, from
+  // |accept_margin| on all the others together cannot. The sum is only
+  // computed in between.
+  int32_t max_other_sum;
+  int32_t reject_margin;
+  int32_t accept_margin;
+
+  // Index to the scratch buffer used by arm_fully_connected_s8.
+  int fc_buffer_idx;
+  // Index to the scratch buffer holding the means and logits of a batch.
+  int activations_buffer_idx;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Exponential of the difference of a logit to the largest one, in the fixed
+// point format arm_nn_softmax_common_s8 sums them in.
+int32_t SoftmaxExp(const SoftmaxParams& softmax, int32_t diff) {
+  if (diff < softmax.diff_min) {
+    return 0;
+  }
+  return DIV_POW2(
+      EXP_ON_NEG(MUL_SAT(diff * (1 << softmax.input_left_shift),
+                         softmax.input_multiplier)),
+      kSoftmaxAccumBits);
+}
+
+// Output of arm_nn_softmax_common_s8 for the largest logit, given the sum of
+// the exponentials of all the logits.
+int32_t SoftmaxOfLargest(const SoftmaxParams& softmax, int32_t sum) {
+  const int32_t headroom = CLZ(sum);
+  const int32_t shifted_scale =
+      ONE_OVER1((sum > 0 ? sum << headroom : 0) - (1 << 31));
+  const int32_t bits_over_unit = kSoftmaxAccumBits - headroom + 23;
+  const int32_t exp_of_zero = EXP_ON_NEG(MUL_SAT(0, softmax.input_multiplier));
+  const int32_t output =
+      DIV_POW2(MUL_SAT(shifted_scale, exp_of_zero), bits_over_unit) + NN_Q7_MIN;
+  return CLAMP(output, static_cast<int32_t>(NN_Q7_MAX),
+               static_cast<int32_t>(NN_Q7_MIN));
+}
+
+// Turns the confidence threshold into the sum and margins of OpData.
+void PrepareConfidenceTest(int8_t threshold, OpData* data) {
+  const SoftmaxParams& softmax = data->softmax;
+  const int32_t largest = SoftmaxExp(softmax, 0);
+  // Largest sum of exponentials that still reaches the threshold, found by
+  // bisection over the sums the logits can produce.
+  int32_t low = largest;
+  int32_t high = largest * data->output_depth;
+  if (SoftmaxOfLargest(softmax, low) < threshold) {
+    data->max_other_sum = -1;
+  } else {
+    while (low < high) {
+      const int32_t mid = low + (high - low + 1) / 2;
+      if (SoftmaxOfLargest(softmax, mid) >= threshold) {
+        low = mid;
+      } else {
+        high = mid - 1;
+      }
+    }
+    data->max_other_sum = low - largest;
+  }
+
+  data->reject_margin = kNoMargin + 1;
+  data->accept_margin = kNoMargin + 1;
+  if (data->output_depth == 1) {
+    // No other logit adds to the sum.
+    if (data->max_other_sum >= 0) {
+      data->reject_margin = 0;
+      data->accept_margin = 0;
+    }
+    return;
+  }
+  for (int32_t margin = kNoMargin; margin >= 0; --margin) {
+    const int64_t term = SoftmaxExp(softmax, -margin);
+    if (term <= data->max_other_sum) {
+      data->reject_margin = margin;
+    }
+    if (term * (data->output_depth - 1) <= data->max_other_sum) {
+      data->accept_margin = margin;
+    }
+  }
+}
+
+template <bool kArgMax>
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  TF_LITE_ENSURE(context, node->intermediates != nullptr);
+  TF_LITE_ENSURE_EQ(context, node->intermediates->size, 2);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto& params =
+      *(static_cast<const TfLiteClassifierHeadParams*>(node->builtin_data));
+
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* filter =
+      micro_context->AllocateTempInputTensor(node, kWeightsTensor);
+  TF_LITE_ENSURE(context, filter != nullptr);
+  TfLiteTensor* bias = micro_context->AllocateTempInputTensor(node, kBiasTensor);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+  TfLiteTensor* mean_output = micro_context->AllocateTempIntermediateTensor(
+      node, kMeanOutputIntermediate);
+  TF_LITE_ENSURE(context, mean_output != nullptr);
+  TfLiteTensor* fc_output = micro_context->AllocateTempIntermediateTensor(
+      node, kFullyConnectedOutputIntermediate);
+  TF_LITE_ENSURE(context, fc_output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, mean_output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, fc_output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(input), 4);
+
+  const RuntimeShape input_shape = GetTensorShape(input);
+  const RuntimeShape filter_shape = GetTensorShape(filter);
+  data->batches = input_shape.Dims(0);
+  data->num_spatial_elements = input_shape.Dims(1) * input_shape.Dims(2);
+  data->channels = input_shape.Dims(3);
+  data->output_depth = filter_shape.Dims(0);
+  TF_LITE_ENSURE_EQ(context, filter_shape.Dims(1), data->channels);
+  TF_LITE_ENSURE_EQ(context, NumElements(output),
+                    data->batches * data->output_depth);
+  TF_LITE_ENSURE(context, data->num_spatial_elements > 0);
+
+  // Mirrors PrepareMeanHelper().
+  int32_t multiplier;
+  int shift;
+  QuantizeMultiplier(static_cast<double>(input->params.scale) /
+                         static_cast<double>(mean_output->params.scale),
+                     &multiplier, &shift);
+  SpatialMeanMultiplier(multiplier, shift, data->num_spatial_elements,
+                        &data->mean.multiplier, &data->mean.shift);
+  data->mean.input_zero_point = input->params.zero_point;
+  data->mean.output_zero_point = mean_output->params.zero_point;
+
+  TF_LITE_ENSURE_STATUS(CalculateOpDataFullyConnected(
+      context, params.fully_connected.activation, kTfLiteInt8, mean_output,
+      filter, bias, fc_output, &data->fully_connected));
+
+  TF_LITE_ENSURE_STATUS(CalculateSoftmaxParams(
+      context, fc_output, output, &params.softmax, &data->softmax));
+  if (kArgMax) {
+    PrepareConfidenceTest(micro_context->argmax_confidence_threshold(), data);
+  }
+
+  cmsis_nn_dims filter_dims;
+  filter_dims.n = data->channels;
+  filter_dims.h = 1;
+  filter_dims.w = 1;
+  filter_dims.c = data->output_depth;
+  const int32_t fc_buf_size =
+      arm_fully_connected_s8_get_buffer_size(&filter_dims);
+  data->fc_buffer_idx = -1;
+  if (fc_buf_size > 0) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, fc_buf_size, &data->fc_buffer_idx));
+  }
+  TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+      context, data->channels + data->output_depth,
+      &data->activations_buffer_idx));
+
+  micro_context->DeallocateTempTfLiteTensor(fc_output);
+  micro_context->DeallocateTempTfLiteTensor(mean_output);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  if (bias != nullptr) {
+    micro_context->DeallocateTempTfLiteTensor(bias);
+  }
+  micro_context->DeallocateTempTfLiteTensor(filter);
+  micro_context->DeallocateTempTfLiteTensor(input);
+
+  return kTfLiteOk;
+}
+
+// Computes the logits of one batch.
+TfLiteStatus Logits(TfLiteContext* context, const OpData& data,
+                    const int8_t* means, const int8_t* filter_data,
+                    const int32_t* bias_data, int8_t* logits) {
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.fc_buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.fc_buffer_idx);
+  }
+
+  cmsis_nn_fc_params fc_params;
+  fc_params.input_offset = -data.fully_connected.input_zero_point;
+  fc_params.output_offset = data.fully_connected.output_zero_point;
+  fc_params.filter_offset = 0;
+  fc_params.activation.min = data.fully_connected.output_activation_min;
+  fc_params.activation.max = data.fully_connected.output_activation_max;
+
+  cmsis_nn_per_tensor_quant_params quant_params;
+  quant_params.multiplier = data.fully_connected.output_multiplier;
+  quant_params.shift = data.fully_connected.output_shift;
+
+  cmsis_nn_dims input_dims = {1, 1, 1, data.channels};
+  cmsis_nn_dims filter_dims = {data.channels, 1, 1, data.output_depth};
+  cmsis_nn_dims bias_dims = {1, 1, 1, data.output_depth};
+  cmsis_nn_dims output_dims = {1, 1, 1, data.output_depth};
+
+  TF_LITE_ENSURE_EQ(
+      context,
+      arm_fully_connected_s8(&ctx, &fc_params, &quant_params, &input_dims,
+                             means, &filter_dims, filter_data, &bias_dims,
+                             bias_data, &output_dims, logits),
+      ARM_CMSIS_NN_SUCCESS);
+  return kTfLiteOk;
+}
+
+// Whether the softmax output of |logits[arg_max]|, the largest logit, would
+// reach the confidence threshold.
+bool IsConfident(const OpData& data, const int8_t* logits, int arg_max) {
+  // With a single class, the margin to a second one counts as kNoMargin.
+  int32_t second = logits[arg_max] - kNoMargin;
+  for (int i = 0; i < data.output_depth; ++i) {
+    if (i != arg_max && logits[i] > second) {
+      second = logits[i];
+    }
+  }
+  const int32_t margin = logits[arg_max] - second;
+  if (margin < data.reject_margin) {
+    return false;
+  }
+  if (margin >= data.accept_margin) {
+    return true;
+  }
+  int32_t sum = 0;
+  for (int i = 0; i < data.output_depth; ++i) {
+    if (i != arg_max) {
+      sum += SoftmaxExp(data.softmax, logits[i] - logits[arg_max]);
+    }
+  }
+  return sum <= data.max_other_sum;
+}
+
+template <bool kArgMax>
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  int8_t* means = static_cast<int8_t*>(
+      context->GetScratchBuffer(context, data.activations_buffer_idx));
+  int8_t* logits = means + data.channels;
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+
+  const cmsis_nn_dims input_dims = {1, 1, data.num_spatial_elements,
+                                    data.channels};
+  for (int b = 0; b < data.batches; ++b) {
+    SpatialMeanS8(data.mean, input_dims, input_data, means);
+    TF_LITE_ENSURE_STATUS(
+        Logits(context, data, means, filter_data, bias_data, logits));
+
+    if (kArgMax) {
+      int arg_max = 0;
+      for (int i = 1; i < data.output_depth; ++i) {
+        if (logits[i] > logits[arg_max]) {
+          arg_max = i;
+        }
+      }
+      for (int i = 0; i < data.output_depth; ++i) {
+        output_data[i] = std::numeric_limits<int8_t>::lowest();
+      }
+      if (IsConfident(data, logits, arg_max)) {
+        output_data[arg_max] = std::numeric_limits<int8_t>::max();
+      }
+    } else {
+      arm_softmax_s8(logits, 1, data.output_depth,
+                     data.softmax.input_multiplier,
+                     data.softmax.input_left_shift, data.softmax.diff_min,
+                     output_data);
+    }
+
+    input_data += data.num_spatial_elements * data.channels;
+    output_data += data.output_depth;
+  }
+
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TFLMRegistration* Register_MEAN_FULLY_CONNECTED_SOFTMAX() {
+  static TFLMRegistration r =
+      tflite::micro::RegisterOpWithoutTempAllocations(
+          Init, Prepare</*kArgMax=*/false>, Eval</*kArgMax=*/false>);
+  return &r;
+}
+
+void UpdateArgMaxConfidenceThreshold(void* user_data, int8_t threshold) {
+  TFLITE_DCHECK(user_data != nullptr);
+  PrepareConfidenceTest(threshold, static_cast<OpData*>(user_data));
+}
+
+TFLMRegistration* Register_MEAN_FULLY_CONNECTED_ARGMAX() {
+  static TFLMRegistration r =
+      tflite::micro::RegisterOpWithoutTempAllocations(
+          Init, Prepare</*kArgMax=*/true>, Eval</*kArgMax=*/true>);
+  return &r;
+}
+
+}  // namespace tflite
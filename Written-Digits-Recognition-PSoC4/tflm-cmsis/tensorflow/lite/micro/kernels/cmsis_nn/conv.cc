@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/conv.h"
 
+#include <algorithm>
+
 #include "Include/arm_nnfunctions.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -25,7 +27,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -36,6 +40,24 @@ struct OpData {
 
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
+
+  // int8 filter packed for ConvM0S8, weights is nullptr when the CMSIS-NN
+  // kernels are used instead.
+  PackedWeights m0_filter;
+  // ConvM0S8 or its variant for the shape of the layer.
+  ConvM0S8Kernel m0_kernel;
+  // Index to the occupancy mask of the input, built once per invoke for the
+  // variant to skip the empty windows, -1 when every window is computed.
+  int occupancy_buffer_idx;
+  // Output of an empty window of that variant.
+  int8_t* m0_empty_output;
+  // int4 filter run in place by ConvM0S4, weights is nullptr when the filter
+  // is unpacked to int8 instead.
+  Int4Weights m0_filter_s4;
+
+  // Filter transformed for WinogradConvS8 by the Register_CONV_2D_WINOGRAD
+  // variant, nullptr when the layer uses the regular path.
+  const int16_t* winograd_filter;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -43,7 +65,10 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
-TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+// |winograd| is set by the Register_CONV_2D_WINOGRAD variant, which looks the
+// filter up in the Winograd filter table of the interpreter.
+TfLiteStatus PrepareConv(TfLiteContext* context, TfLiteNode* node,
+                         bool winograd) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
 
@@ -88,7 +113,20 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   output_dims.w = output->dims->data[2];
   output_dims.c = output_shape.Dims(3);
 
-  if (filter->type == kTfLiteInt4) {
+  // On the M0 an int4 filter is read in place by ConvM0S4, elsewhere it is
+  // unpacked to int8 into a scratch buffer on every invoke.
+  data->m0_filter_s4.weights = nullptr;
+  if (filter->type == kTfLiteInt4 && kConvM0Enabled &&
+      input->type == kTfLiteInt8 && IsConstantTensor(filter)) {
+    TfLiteTensor* bias =
+        micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
+    TF_LITE_ENSURE_STATUS(PrepareInt4Weights(context, filter, bias,
+                                             input->params.zero_point,
+                                             &data->m0_filter_s4));
+    if (bias != nullptr) {
+      micro_context->DeallocateTempTfLiteTensor(bias);
+    }
+  } else if (filter->type == kTfLiteInt4) {
     int filter_size =
         RuntimeShape(filter->dims->size,
                      reinterpret_cast<const int32_t*>(filter->dims->data))
@@ -126,7 +164,59 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     conv_params.activation.min = data->reference_op_data.output_activation_min;
     conv_params.activation.max = data->reference_op_data.output_activation_max;
 
-    if (input->type == kTfLiteInt8) {
+    data->m0_filter.weights = nullptr;
+    data->winograd_filter = nullptr;
+    data->occupancy_buffer_idx = -1;
+    if (winograd && input->type == kTfLiteInt8 && filter_dims.h == 3 &&
+        filter_dims.w == 3 && params.stride_height == 1 &&
+        params.stride_width == 1 && params.dilation_height_factor == 1 &&
+        params.dilation_width_factor == 1 &&
+        input_dims.c <= kWinogradMaxInputDepth) {
+      TfLiteTensor* bias =
+          micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
+      data->winograd_filter = FindWinogradFilter(context, filter, bias,
+                                                 input->params.zero_point);
+      if (bias != nullptr) {
+        micro_context->DeallocateTempTfLiteTensor(bias);
+      }
+    }
+    if (data->winograd_filter == nullptr && input->type == kTfLiteInt8 &&
+        kConvM0Enabled && filter->type == kTfLiteInt8 &&
+        IsConstantTensor(filter)) {
+      TfLiteTensor* bias =
+          micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
+      TF_LITE_ENSURE_STATUS(PreparePackedWeights(context, filter, bias,
+                                                 input->params.zero_point,
+                                                 &data->m0_filter));
+      if (bias != nullptr) {
+        micro_context->DeallocateTempTfLiteTensor(bias);
+      }
+    }
+    if (data->winograd_filter != nullptr) {
+      buf_size = WinogradConvS8GetBufferSize(&filter_dims);
+    } else if (data->m0_filter.weights != nullptr) {
+      data->m0_kernel =
+          SelectConvM0S8Kernel(&filter_dims, conv_params.stride,
+                               conv_params.dilation, data->m0_filter);
+      buf_size = ConvM0S8GetBufferSize(&filter_dims);
+      const int32_t occupancy_buf_size =
+          ConvM0S8GetOccupancyBufferSize(data->m0_kernel, &input_dims);
+      if (occupancy_buf_size > 0) {
+        TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+            context, occupancy_buf_size, &data->occupancy_buffer_idx));
+        data->m0_empty_output = static_cast<int8_t*>(
+            context->AllocatePersistentBuffer(context, output_dims.c));
+        TF_LITE_ENSURE(context, data->m0_empty_output != nullptr);
+        cmsis_nn_per_channel_quant_params quant_params;
+        quant_params.multiplier =
+            data->reference_op_data.per_channel_output_multiplier;
+        quant_params.shift = data->reference_op_data.per_channel_output_shift;
+        ConvM0S8EmptyOutput(&conv_params, &quant_params, &filter_dims,
+                            data->m0_filter, data->m0_empty_output);
+      }
+    } else if (data->m0_filter_s4.weights != nullptr) {
+      buf_size = ConvM0S8GetBufferSize(&filter_dims);
+    } else if (input->type == kTfLiteInt8) {
       buf_size = arm_convolve_wrapper_s8_get_buffer_size(
           &conv_params, &input_dims, &filter_dims, &output_dims);
     } else if (input->type == kTfLiteInt16) {
@@ -151,6 +241,62 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  return PrepareConv(context, node, /*winograd=*/false);
+}
+
+TfLiteStatus PrepareWinograd(TfLiteContext* context, TfLiteNode* node) {
+  return PrepareConv(context, node, /*winograd=*/true);
+}
+
+// Runs WinogradConvS8 when the layer has a transformed filter, ConvM0S8, or
+// its variant for the layer shape, when the filter has been packed for it,
+// ConvM0S4 for an int4 filter read in place, and the CMSIS-NN kernel picked
+// by arm_convolve_wrapper_s8 otherwise. |occupancy| is only read by the
+// ConvM0S8 variants.
+arm_cmsis_nn_status ConvolveS8(
+    const OpData& data, const cmsis_nn_context* ctx,
+    const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const int8_t* filter_data,
+    const cmsis_nn_dims* bias_dims, const int32_t* bias_data,
+    const cmsis_nn_dims* output_dims, int8_t* output_data,
+    const ConvM0Occupancy* occupancy) {
+  if (data.winograd_filter != nullptr) {
+    return WinogradConvS8(ctx, conv_params, quant_params, input_dims,
+                          input_data, filter_dims, data.winograd_filter,
+                          bias_dims, bias_data, output_dims, output_data);
+  }
+  if (data.m0_filter.weights != nullptr) {
+    return data.m0_kernel(ctx, conv_params, quant_params, input_dims,
+                          input_data, filter_dims, data.m0_filter,
+                          output_dims, output_data, occupancy);
+  }
+  if (data.m0_filter_s4.weights != nullptr) {
+    return ConvM0S4(ctx, conv_params, quant_params, input_dims, input_data,
+                    filter_dims, data.m0_filter_s4, output_dims, output_data);
+  }
+  return arm_convolve_wrapper_s8(ctx, conv_params, quant_params, input_dims,
+                                 input_data, filter_dims, filter_data,
+                                 bias_dims, bias_data, output_dims,
+                                 output_data);
+}
+
+// Returns |filter| as an int8 tensor: int4 filters are unpacked into their
+// scratch buffer, except for the ones ConvM0S4 reads in place, which are only
+// relabeled since ConvolveS8 does not read their data.
+TfLiteEvalTensor MakeInt8Filter(TfLiteContext* context, const OpData& data,
+                                const TfLiteEvalTensor* filter) {
+  if (data.m0_filter_s4.weights != nullptr) {
+    TfLiteEvalTensor filter_int8 = *filter;
+    filter_int8.type = kTfLiteInt8;
+    return filter_int8;
+  }
+  return tflite::micro::MakeUnpackedInt4Tensor(
+      context, data.reference_op_data.filter_buffer_index, filter);
+}
+
 TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                      const TfLiteConvParams& params,
                                      const OpData& data,
@@ -237,15 +383,120 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
     // arm_convolve_wrapper_s8_get_buffer_size
   }
 
+  ConvM0Occupancy occupancy = {nullptr, 0, nullptr};
+  if (data.occupancy_buffer_idx > -1) {
+    uint32_t* occupancy_buffer = static_cast<uint32_t*>(
+        context->GetScratchBuffer(context, data.occupancy_buffer_idx));
+    ConvM0S8ComputeOccupancy(&input_dims,
+                             tflite::micro::GetTensorData<int8_t>(input),
+                             conv_params.input_offset, occupancy_buffer);
+    occupancy = ConvM0S8Occupancy(occupancy_buffer, &input_dims, 0, 0, 0,
+                                  data.m0_empty_output);
+  }
+
   // arm_convolve_wrapper_s8 dispatches the optimized kernel accordingly with
   // the parameters passed
   TFLITE_DCHECK_EQ(
-      arm_convolve_wrapper_s8(
-          &ctx, &conv_params, &quant_params, &input_dims,
+      ConvolveS8(
+          data, &ctx, &conv_params, &quant_params, &input_dims,
           tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
           tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
           tflite::micro::GetOptionalTensorData<int32_t>(bias), &output_dims,
-          tflite::micro::GetTensorData<int8_t>(output)),
+          tflite::micro::GetTensorData<int8_t>(output), &occupancy),
+      ARM_CMSIS_NN_SUCCESS);
+
+  return kTfLiteOk;
+}
+
+// Computes the output rows [output_row_start, output_row_end) of one batch.
+// Only the input rows they read are passed to CMSIS-NN, with the padding
+// shifted accordingly, so the result is the same as for the full convolution.
+// The occupancy mask of the whole input is built by the first rows of the
+// first batch, the steps of an invoke run in order.
+TfLiteStatus EvalQuantizedPerChannelRows(
+    TfLiteContext* context, const TfLiteConvParams& params, const OpData& data,
+    const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+    const TfLiteEvalTensor* bias, TfLiteEvalTensor* output, int batch,
+    int output_row_start, int output_row_end) {
+  const int input_height = input->dims->data[1];
+  const int input_width = input->dims->data[2];
+  const int input_depth = input->dims->data[3];
+  const int filter_height = filter->dims->data[1];
+  const int output_height = output->dims->data[1];
+  const int output_width = output->dims->data[2];
+  const int output_depth = output->dims->data[3];
+
+  const int first_row = output_row_start * params.stride_height -
+                        data.reference_op_data.padding.height;
+  const int input_row_start = std::max(first_row, 0);
+  const int input_row_end = std::min(
+      (output_row_end - 1) * params.stride_height -
+          data.reference_op_data.padding.height +
+          (filter_height - 1) * params.dilation_height_factor + 1,
+      input_height);
+
+  cmsis_nn_conv_params conv_params;
+  conv_params.dilation.h = params.dilation_height_factor;
+  conv_params.dilation.w = params.dilation_width_factor;
+  conv_params.input_offset = -data.reference_op_data.input_zero_point;
+  conv_params.output_offset = data.reference_op_data.output_zero_point;
+  conv_params.stride.h = params.stride_height;
+  conv_params.stride.w = params.stride_width;
+  conv_params.padding.h = input_row_start - first_row;
+  conv_params.padding.w = data.reference_op_data.padding.width;
+  conv_params.activation.min = data.reference_op_data.output_activation_min;
+  conv_params.activation.max = data.reference_op_data.output_activation_max;
+
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier = const_cast<int32_t*>(
+      data.reference_op_data.per_channel_output_multiplier);
+  quant_params.shift =
+      const_cast<int32_t*>(data.reference_op_data.per_channel_output_shift);
+
+  const cmsis_nn_dims input_dims = {1, input_row_end - input_row_start,
+                                    input_width, input_depth};
+  const cmsis_nn_dims filter_dims = {output_depth, filter_height,
+                                     filter->dims->data[2], input_depth};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, output_depth};
+  const cmsis_nn_dims output_dims = {1, output_row_end - output_row_start,
+                                     output_width, output_depth};
+
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
+  }
+
+  ConvM0Occupancy occupancy = {nullptr, 0, nullptr};
+  if (data.occupancy_buffer_idx > -1) {
+    const cmsis_nn_dims full_input_dims = {input->dims->data[0], input_height,
+                                           input_width, input_depth};
+    uint32_t* occupancy_buffer = static_cast<uint32_t*>(
+        context->GetScratchBuffer(context, data.occupancy_buffer_idx));
+    if (batch == 0 && output_row_start == 0) {
+      ConvM0S8ComputeOccupancy(&full_input_dims,
+                               tflite::micro::GetTensorData<int8_t>(input),
+                               conv_params.input_offset, occupancy_buffer);
+    }
+    occupancy = ConvM0S8Occupancy(occupancy_buffer, &full_input_dims, batch,
+                                  input_row_start, 0, data.m0_empty_output);
+  }
+
+  const int8_t* input_data =
+      tflite::micro::GetTensorData<int8_t>(input) +
+      ((batch * input_height + input_row_start) * input_width) * input_depth;
+  int8_t* output_data =
+      tflite::micro::GetTensorData<int8_t>(output) +
+      ((batch * output_height + output_row_start) * output_width) *
+          output_depth;
+
+  TFLITE_DCHECK_EQ(
+      ConvolveS8(
+          data, &ctx, &conv_params, &quant_params, &input_dims, input_data,
+          &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
+          &bias_dims, tflite::micro::GetOptionalTensorData<int32_t>(bias),
+          &output_dims, output_data, &occupancy),
       ARM_CMSIS_NN_SUCCESS);
 
   return kTfLiteOk;
@@ -364,8 +615,7 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
       *(reinterpret_cast<TfLiteConvParams*>(node->builtin_data));
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
+  TfLiteEvalTensor filter_int8 = MakeInt8Filter(context, data, filter);
 
   return EvalQuantizedPerChannel(context, node, params, data, input,
                                  &filter_int8, bias, output);
@@ -419,8 +669,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           (input->type == kTfLiteInt8 && filter->type == kTfLiteInt4),
       "Hybrid models are not supported on TFLite Micro.");
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
+  TfLiteEvalTensor filter_int8 = MakeInt8Filter(context, data, filter);
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
@@ -464,18 +713,73 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+// Time sliced invoke: for int8 every step computes one output row, or the two
+// rows of a Winograd tile, other types run in a single step.
+TfLiteStatus EvalStep(TfLiteContext* context, TfLiteNode* node, int step,
+                      bool* done) {
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kConvBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kConvOutputTensor);
+
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const auto& params =
+      *(reinterpret_cast<TfLiteConvParams*>(node->builtin_data));
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  TfLiteEvalTensor filter_int8 = MakeInt8Filter(context, data, filter);
+  if (input->type != kTfLiteInt8 || filter_int8.type != kTfLiteInt8) {
+    *done = true;
+    return Eval(context, node);
+  }
+
+  const int output_height = output->dims->data[1];
+  const int rows_per_step = data.winograd_filter != nullptr ? 2 : 1;
+  const int steps_per_batch =
+      (output_height + rows_per_step - 1) / rows_per_step;
+  const int batch = step / steps_per_batch;
+  const int row = (step % steps_per_batch) * rows_per_step;
+  TF_LITE_ENSURE(context, batch < output->dims->data[0]);
+  *done = step + 1 == steps_per_batch * output->dims->data[0];
+  return EvalQuantizedPerChannelRows(
+      context, params, data, input, &filter_int8, bias, output, batch, row,
+      std::min(row + rows_per_step, output_height));
+}
+
 }  // namespace
 
 TFLMRegistration Register_CONV_2D() {
-  return tflite::micro::RegisterOp(Init, Prepare, Eval);
+  TFLMRegistration registration =
+      tflite::micro::RegisterOpWithoutTempAllocations(Init, Prepare, Eval);
+  registration.invoke_step = EvalStep;
+  return registration;
 }
 
 TFLMRegistration Register_CONV_2D_INT8() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+  TFLMRegistration registration =
+      tflite::micro::RegisterOpWithoutTempAllocations(Init, Prepare, EvalInt8);
+  registration.invoke_step = EvalStep;
+  return registration;
 }
 
 TFLMRegistration Register_CONV_2D_INT16() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt16x8);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, EvalInt16x8);
+}
+
+TFLMRegistration Register_CONV_2D_WINOGRAD() {
+  TFLMRegistration registration =
+      tflite::micro::RegisterOpWithoutTempAllocations(Init, PrepareWinograd,
+                                                      Eval);
+  registration.invoke_step = EvalStep;
+  return registration;
 }
 
 }  // namespace tflite
@@ -0,0 +1,701 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/micro/kernels/requantize_m0.h"
+
+namespace tflite {
+namespace {
+
+// Output channels per group of interleaved weights, see PackedWeights.
+constexpr int kChannelBlock = 4;
+
+// Requantizes the first |count| of the four |sums| of a channel group and
+// writes them to |output|.
+void Requantize4(const int32_t* sums, const int32_t* multiplier,
+                 const int32_t* shift, int32_t output_offset,
+                 int32_t activation_min, int32_t activation_max, int count,
+                 int8_t* output) {
+  for (int c = 0; c < count; ++c) {
+    int32_t acc =
+        RequantizeM0(sums[c], multiplier[c], shift[c]);
+    acc += output_offset;
+    acc = std::max(acc, activation_min);
+    acc = std::min(acc, activation_max);
+    output[c] = static_cast<int8_t>(acc);
+  }
+}
+
+// Computes the four output channels of the group starting at |weights| for
+// the |depth| int8 |input| elements, and writes the first |count| of them to
+// |output| after requantization. Returns the weights of the next group.
+const int32_t* DotProduct4(const int8_t* input, int depth,
+                           const int32_t* weights, const int32_t* bias,
+                           const int32_t* multiplier, const int32_t* shift,
+                           int32_t output_offset, int32_t activation_min,
+                           int32_t activation_max, int count,
+                           int8_t* output) {
+  int32_t sum0 = bias[0];
+  int32_t sum1 = bias[1];
+  int32_t sum2 = bias[2];
+  int32_t sum3 = bias[3];
+  const int8_t* input_end = input + depth;
+  do {
+    const int32_t x = *input++;
+    const int32_t w01 = *weights++;
+    const int32_t w23 = *weights++;
+    sum0 += static_cast<int16_t>(w01) * x;
+    sum1 += (w01 >> 16) * x;
+    sum2 += static_cast<int16_t>(w23) * x;
+    sum3 += (w23 >> 16) * x;
+  } while (input != input_end);
+
+  const int32_t sums[kChannelBlock] = {sum0, sum1, sum2, sum3};
+  Requantize4(sums, multiplier, shift, output_offset, activation_min,
+              activation_max, count, output);
+  return weights;
+}
+
+// DotProduct4 for block sparse weights: only the input elements whose bit is
+// set in the |block_map| of the group have weights. Returns the weights of
+// the next group.
+const int32_t* DotProduct4Sparse(const int8_t* input, int depth,
+                                 const int32_t* weights,
+                                 const uint32_t* block_map,
+                                 const int32_t* bias,
+                                 const int32_t* multiplier,
+                                 const int32_t* shift, int32_t output_offset,
+                                 int32_t activation_min,
+                                 int32_t activation_max, int count,
+                                 int8_t* output) {
+  int32_t sum0 = bias[0];
+  int32_t sum1 = bias[1];
+  int32_t sum2 = bias[2];
+  int32_t sum3 = bias[3];
+  for (int base = 0; base < depth; base += 32) {
+    uint32_t bits = *block_map++;
+    const int8_t* x = input + base;
+    while (bits != 0) {
+      // Cortex-M0+ has no count trailing zeros, skip the empty bytes first.
+      while ((bits & 0xff) == 0) {
+        bits >>= 8;
+        x += 8;
+      }
+      if ((bits & 1) != 0) {
+        const int32_t value = *x;
+        const int32_t w01 = *weights++;
+        const int32_t w23 = *weights++;
+        sum0 += static_cast<int16_t>(w01) * value;
+        sum1 += (w01 >> 16) * value;
+        sum2 += static_cast<int16_t>(w23) * value;
+        sum3 += (w23 >> 16) * value;
+      }
+      bits >>= 1;
+      ++x;
+    }
+  }
+
+  const int32_t sums[kChannelBlock] = {sum0, sum1, sum2, sum3};
+  Requantize4(sums, multiplier, shift, output_offset, activation_min,
+              activation_max, count, output);
+  return weights;
+}
+
+// Sign extends the low and the high nibble of a byte of int4 weights, loaded
+// sign extended.
+inline int32_t LowNibble(int32_t byte) {
+  return static_cast<int32_t>(static_cast<uint32_t>(byte) << 28) >> 28;
+}
+inline int32_t HighNibble(int32_t byte) { return byte >> 4; }
+
+// Dot product of the |depth| int8 |input| elements with the int4 weights
+// starting at element |start| of |weights|, which may be in the middle of a
+// byte.
+int32_t DotProductS4(const int8_t* input, int depth, const uint8_t* weights,
+                     int start) {
+  const int8_t* w = reinterpret_cast<const int8_t*>(weights) + start / 2;
+  int32_t sum = 0;
+  if (start % 2 != 0) {
+    sum += HighNibble(*w++) * *input++;
+    --depth;
+  }
+  for (; depth >= 2; depth -= 2) {
+    const int32_t byte = *w++;
+    sum += LowNibble(byte) * input[0] + HighNibble(byte) * input[1];
+    input += 2;
+  }
+  if (depth != 0) {
+    sum += LowNibble(*w) * *input;
+  }
+  return sum;
+}
+
+// Same as DotProduct4 for the int4 |weights| of the group starting at
+// |channel|. When |depth| is even every channel starts on a byte boundary and
+// the four channels are accumulated together, two elements per weight byte;
+// otherwise every other channel starts in the middle of a byte and they are
+// accumulated one after the other.
+void DotProduct4S4(const int8_t* input, int depth, const Int4Weights& weights,
+                   int channel, const int32_t* multiplier,
+                   const int32_t* shift, int32_t output_offset,
+                   int32_t activation_min, int32_t activation_max, int count,
+                   int8_t* output) {
+  const int32_t* bias = weights.bias + channel;
+  int32_t sum0 = bias[0];
+  int32_t sum1 = bias[1];
+  int32_t sum2 = bias[2];
+  int32_t sum3 = bias[3];
+  // The channels past |count| repeat the last one; their sums are dropped.
+  int rows[kChannelBlock];
+  for (int c = 0; c < kChannelBlock; ++c) {
+    rows[c] = (channel + std::min(c, count - 1)) * depth;
+  }
+
+  if (depth % 2 == 0) {
+    const int8_t* w0 = reinterpret_cast<const int8_t*>(weights.weights) +
+                       rows[0] / 2;
+    const int row1 = (rows[1] - rows[0]) / 2;
+    const int row2 = (rows[2] - rows[0]) / 2;
+    const int row3 = (rows[3] - rows[0]) / 2;
+    const int8_t* input_end = input + depth;
+    do {
+      const int32_t x0 = input[0];
+      const int32_t x1 = input[1];
+      input += 2;
+      int32_t w = *w0;
+      sum0 += LowNibble(w) * x0 + HighNibble(w) * x1;
+      w = w0[row1];
+      sum1 += LowNibble(w) * x0 + HighNibble(w) * x1;
+      w = w0[row2];
+      sum2 += LowNibble(w) * x0 + HighNibble(w) * x1;
+      w = w0[row3];
+      sum3 += LowNibble(w) * x0 + HighNibble(w) * x1;
+      ++w0;
+    } while (input != input_end);
+  } else {
+    sum0 += DotProductS4(input, depth, weights.weights, rows[0]);
+    sum1 += DotProductS4(input, depth, weights.weights, rows[1]);
+    sum2 += DotProductS4(input, depth, weights.weights, rows[2]);
+    sum3 += DotProductS4(input, depth, weights.weights, rows[3]);
+  }
+
+  const int32_t sums[kChannelBlock] = {sum0, sum1, sum2, sum3};
+  Requantize4(sums, multiplier, shift, output_offset, activation_min,
+              activation_max, count, output);
+}
+
+// Gathers the receptive field of the output pixel whose top left input
+// element is (|in_y|, |in_x|) into |col|. Elements outside of the input get
+// the input zero point, so that they add nothing once the offset folded into
+// the bias is accounted for.
+void Im2Col(const int8_t* input, int input_height, int input_width,
+            int input_depth, int filter_height, int filter_width,
+            int dilation_height, int dilation_width, int in_y, int in_x,
+            int8_t pad_value, int8_t* col) {
+  const int row_size = filter_width * input_depth;
+  for (int ky = 0; ky < filter_height; ++ky) {
+    const int y = in_y + ky * dilation_height;
+    if (y < 0 || y >= input_height) {
+      std::memset(col, pad_value, row_size);
+      col += row_size;
+      continue;
+    }
+    const int8_t* input_row = input + y * input_width * input_depth;
+    const int x_end = in_x + (filter_width - 1) * dilation_width;
+    if (dilation_width == 1 && in_x >= 0 && x_end < input_width) {
+      std::memcpy(col, input_row + in_x * input_depth, row_size);
+      col += row_size;
+      continue;
+    }
+    for (int kx = 0; kx < filter_width; ++kx) {
+      const int x = in_x + kx * dilation_width;
+      if (x < 0 || x >= input_width) {
+        std::memset(col, pad_value, input_depth);
+      } else {
+        std::memcpy(col, input_row + x * input_depth, input_depth);
+      }
+      col += input_depth;
+    }
+  }
+}
+
+// Accumulates the |kDepth| int8 |input| elements into the four |sums| of a
+// channel group. Returns the weights of the next input element.
+template <int kDepth>
+__attribute__((always_inline)) inline const int32_t* Accumulate4(
+    const int8_t* input, const int32_t* weights, int32_t* sums) {
+  for (int i = 0; i < kDepth; ++i) {
+    const int32_t x = input[i];
+    const int32_t w01 = *weights++;
+    const int32_t w23 = *weights++;
+    sums[0] += static_cast<int16_t>(w01) * x;
+    sums[1] += (w01 >> 16) * x;
+    sums[2] += static_cast<int16_t>(w23) * x;
+    sums[3] += (w23 >> 16) * x;
+  }
+  return weights;
+}
+
+// Accumulates the taps [kTap, kFilterHeight * kFilterWidth) of the window
+// whose top left element is |window|, with its rows |row_stride| elements
+// apart. The recursion unrolls the window at compile time.
+template <int kTap, int kFilterHeight, int kFilterWidth, int kDepth>
+__attribute__((always_inline)) inline const int32_t* AccumulateWindow4(
+    const int8_t* window, int row_stride, const int32_t* weights,
+    int32_t* sums) {
+  if constexpr (kTap == kFilterHeight * kFilterWidth) {
+    return weights;
+  } else {
+    weights = Accumulate4<kDepth>(window + (kTap / kFilterWidth) * row_stride +
+                                      (kTap % kFilterWidth) * kDepth,
+                                  weights, sums);
+    return AccumulateWindow4<kTap + 1, kFilterHeight, kFilterWidth, kDepth>(
+        window, row_stride, weights, sums);
+  }
+}
+
+// Largest input height and width for which ConvM0S8ComputeOccupancy builds
+// the occupancy masks, one bit per column in a word per row.
+constexpr int kMaxOccupancySize = 32;
+
+// Returns true when the window of |filter_height| rows starting at |in_y|
+// has no occupied pixel in the columns of |column_mask|. Rows outside of the
+// input are padding, which is empty.
+inline bool WindowEmpty(const uint32_t* occupancy, int input_height,
+                        int filter_height, int in_y, uint32_t column_mask) {
+  const int y_end = std::min(in_y + filter_height, input_height);
+  uint32_t rows = 0;
+  for (int y = std::max(in_y, 0); y < y_end; ++y) {
+    rows |= occupancy[y];
+  }
+  return (rows & column_mask) == 0;
+}
+
+// ConvM0S8 for a filter size, input and output depth and stride fixed at
+// compile time, without dilation. Output pixels whose window lies inside the
+// input read it in place; the column range for which that holds is computed
+// once, so only the pixels overlapping the padding go through Im2Col.
+template <int kFilterHeight, int kFilterWidth, int kInputDepth,
+          int kOutputDepth, int kStrideHeight, int kStrideWidth>
+arm_cmsis_nn_status ConvM0S8Fixed(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const PackedWeights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data,
+    const ConvM0Occupancy* occupancy) {
+  static_assert(kOutputDepth % kChannelBlock == 0,
+                "Output depth must be a multiple of the channel block.");
+  if (ctx->buf == nullptr) {
+    return ARM_CMSIS_NN_ARG_ERROR;
+  }
+  int8_t* col = static_cast<int8_t*>(ctx->buf);
+  constexpr int kColRowSize = kFilterWidth * kInputDepth;
+
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int input_row_size = input_width * kInputDepth;
+  const int output_height = output_dims->h;
+  const int output_width = output_dims->w;
+  const int pad_height = conv_params->padding.h;
+  const int pad_width = conv_params->padding.w;
+  const int32_t output_offset = conv_params->output_offset;
+  const int32_t activation_min = conv_params->activation.min;
+  const int32_t activation_max = conv_params->activation.max;
+  const int8_t pad_value = static_cast<int8_t>(-conv_params->input_offset);
+  const int32_t* multiplier = quant_params->multiplier;
+  const int32_t* shift = quant_params->shift;
+
+  // Output columns [x_begin, x_end) have their window inside the input
+  // columns.
+  const int x_begin =
+      std::min((pad_width + kStrideWidth - 1) / kStrideWidth, output_width);
+  const int last_in_x = input_width - kFilterWidth + pad_width;
+  const int x_end =
+      last_in_x < 0
+          ? x_begin
+          : std::max(x_begin, std::min(last_in_x / kStrideWidth + 1,
+                                       output_width));
+
+  // Computes the four channel groups of the window starting at |window|.
+  auto compute_pixel = [&](const int8_t* window, int row_stride,
+                           int8_t* output) {
+    const int32_t* weights = filter.weights;
+    for (int channel = 0; channel < kOutputDepth; channel += kChannelBlock) {
+      int32_t sums[kChannelBlock] = {
+          filter.bias[channel], filter.bias[channel + 1],
+          filter.bias[channel + 2], filter.bias[channel + 3]};
+      weights = AccumulateWindow4<0, kFilterHeight, kFilterWidth,
+                                  kInputDepth>(window, row_stride, weights,
+                                               sums);
+      Requantize4(sums, multiplier + channel, shift + channel, output_offset,
+                  activation_min, activation_max, kChannelBlock, output);
+      output += kChannelBlock;
+    }
+  };
+
+  // The mask of the first batch, nullptr when every window is computed.
+  const uint32_t* occupied_rows =
+      occupancy != nullptr ? occupancy->rows : nullptr;
+  const int occupancy_column = occupancy != nullptr ? occupancy->column : 0;
+  constexpr uint32_t kWindowColumns = (1u << kFilterWidth) - 1;
+
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y = out_y * kStrideHeight - pad_height;
+      const bool rows_inside =
+          in_y >= 0 && in_y + kFilterHeight <= input_height;
+      const int inside_begin = rows_inside ? x_begin : output_width;
+      const int inside_end = rows_inside ? x_end : output_width;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x = out_x * kStrideWidth - pad_width;
+        const int mask_x = in_x + occupancy_column;
+        if (occupied_rows != nullptr &&
+            WindowEmpty(occupied_rows, input_height, kFilterHeight, in_y,
+                        mask_x >= 0 ? kWindowColumns << mask_x
+                                    : kWindowColumns >> -mask_x)) {
+          std::memcpy(output_data, occupancy->empty_output, kOutputDepth);
+          output_data += kOutputDepth;
+          continue;
+        }
+        const int8_t* window = col;
+        int row_stride = kColRowSize;
+        if (out_x >= inside_begin && out_x < inside_end) {
+          window = input_data + in_y * input_row_size + in_x * kInputDepth;
+          row_stride = input_row_size;
+        } else {
+          Im2Col(input_data, input_height, input_width, kInputDepth,
+                 kFilterHeight, kFilterWidth, 1, 1, in_y, in_x, pad_value,
+                 col);
+        }
+        compute_pixel(window, row_stride, output_data);
+        output_data += kOutputDepth;
+      }
+    }
+    input_data += input_height * input_row_size;
+    if (occupied_rows != nullptr) {
+      occupied_rows += input_height;
+    }
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+struct ConvM0S8Variant {
+  int filter_height;
+  int filter_width;
+  int input_depth;
+  int output_depth;
+  int stride_height;
+  int stride_width;
+  ConvM0S8Kernel kernel;
+};
+
+// The convolution shapes of the digit recognition CNN: a 3x3 stride 2 layer
+// on the 1 channel image, then two 3x3 layers on 16 channels.
+constexpr ConvM0S8Variant kConvM0S8Variants[] = {
+    {3, 3, 1, 16, 2, 2, ConvM0S8Fixed<3, 3, 1, 16, 2, 2>},
+    {3, 3, 16, 16, 1, 1, ConvM0S8Fixed<3, 3, 16, 16, 1, 1>},
+};
+
+}  // namespace
+
+int32_t ConvM0S8GetBufferSize(const cmsis_nn_dims* filter_dims) {
+  return filter_dims->h * filter_dims->w * filter_dims->c;
+}
+
+int32_t ConvM0S8GetOccupancyBufferSize(ConvM0S8Kernel kernel,
+                                       const cmsis_nn_dims* input_dims) {
+  if (TF_LITE_CONV_M0_SPARSE_DENSITY <= 0 ||
+      input_dims->h > kMaxOccupancySize || input_dims->w > kMaxOccupancySize) {
+    return 0;
+  }
+  for (const ConvM0S8Variant& variant : kConvM0S8Variants) {
+    if (variant.kernel == kernel) {
+      return input_dims->n * (1 + input_dims->h) * sizeof(uint32_t);
+    }
+  }
+  return 0;
+}
+
+// The buffer holds a flag per batch, set when the batch is sparse, then the
+// rows of every batch. A batch following a sparse one is read through the
+// mask even when it is dense, which still gives the same output.
+void ConvM0S8ComputeOccupancy(const cmsis_nn_dims* input_dims,
+                              const int8_t* input, int32_t input_offset,
+                              uint32_t* buffer) {
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int input_depth = input_dims->c;
+  const int8_t zero_point = static_cast<int8_t>(-input_offset);
+  uint32_t* rows = buffer + input_dims->n;
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    int occupied = 0;
+    for (int y = 0; y < input_height; ++y) {
+      uint32_t row = 0;
+      for (int x = 0; x < input_width; ++x) {
+        for (int i = 0; i < input_depth; ++i) {
+          if (input[i] != zero_point) {
+            row |= 1u << x;
+            ++occupied;
+            break;
+          }
+        }
+        input += input_depth;
+      }
+      rows[y] = row;
+    }
+    buffer[batch] = occupied * 100 <= TF_LITE_CONV_M0_SPARSE_DENSITY *
+                                          input_height * input_width;
+    rows += input_height;
+  }
+}
+
+ConvM0Occupancy ConvM0S8Occupancy(const uint32_t* buffer,
+                                  const cmsis_nn_dims* input_dims, int batch,
+                                  int row, int column,
+                                  const int8_t* empty_output) {
+  ConvM0Occupancy occupancy = {nullptr, column, empty_output};
+  if (buffer[batch] != 0) {
+    occupancy.rows = buffer + input_dims->n + batch * input_dims->h + row;
+  }
+  return occupancy;
+}
+
+void ConvM0S8EmptyOutput(const cmsis_nn_conv_params* conv_params,
+                         const cmsis_nn_per_channel_quant_params* quant_params,
+                         const cmsis_nn_dims* filter_dims,
+                         const PackedWeights& filter, int8_t* output) {
+  // The folded bias plus the zero point times the sum of the weights of each
+  // channel, read from the dense interleaved groups.
+  const int depth = filter_dims->h * filter_dims->w * filter_dims->c;
+  const int32_t zero_point = -conv_params->input_offset;
+  const int32_t* weights = filter.weights;
+  for (int channel = 0; channel < filter_dims->n; channel += kChannelBlock) {
+    const int count = std::min(kChannelBlock, filter_dims->n - channel);
+    int32_t sums[kChannelBlock];
+    std::copy(filter.bias + channel, filter.bias + channel + kChannelBlock,
+              sums);
+    for (int i = 0; i < depth; ++i) {
+      const int32_t w01 = *weights++;
+      const int32_t w23 = *weights++;
+      sums[0] += static_cast<int16_t>(w01) * zero_point;
+      sums[1] += (w01 >> 16) * zero_point;
+      sums[2] += static_cast<int16_t>(w23) * zero_point;
+      sums[3] += (w23 >> 16) * zero_point;
+    }
+    Requantize4(sums, quant_params->multiplier + channel,
+                quant_params->shift + channel, conv_params->output_offset,
+                conv_params->activation.min, conv_params->activation.max,
+                count, output + channel);
+  }
+}
+
+arm_cmsis_nn_status ConvM0S8(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const PackedWeights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data,
+    const ConvM0Occupancy* /*occupancy*/) {
+  if (ctx->buf == nullptr) {
+    return ARM_CMSIS_NN_ARG_ERROR;
+  }
+  int8_t* col = static_cast<int8_t*>(ctx->buf);
+
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int input_depth = input_dims->c;
+  const int filter_height = filter_dims->h;
+  const int filter_width = filter_dims->w;
+  const int filter_size = filter_height * filter_width * input_depth;
+  const int block_map_words = PackedWeightsBlockMapWords(filter_size);
+  const int output_height = output_dims->h;
+  const int output_width = output_dims->w;
+  const int output_depth = output_dims->c;
+  const int stride_height = conv_params->stride.h;
+  const int stride_width = conv_params->stride.w;
+  const int dilation_height = conv_params->dilation.h;
+  const int dilation_width = conv_params->dilation.w;
+  const int pad_height = conv_params->padding.h;
+  const int pad_width = conv_params->padding.w;
+  const int32_t output_offset = conv_params->output_offset;
+  const int32_t activation_min = conv_params->activation.min;
+  const int32_t activation_max = conv_params->activation.max;
+  const int8_t pad_value = static_cast<int8_t>(-conv_params->input_offset);
+  const int32_t* multiplier = quant_params->multiplier;
+  const int32_t* shift = quant_params->shift;
+
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        Im2Col(input_data, input_height, input_width, input_depth,
+               filter_height, filter_width, dilation_height, dilation_width,
+               out_y * stride_height - pad_height,
+               out_x * stride_width - pad_width, pad_value, col);
+        const int32_t* weights = filter.weights;
+        const uint32_t* block_map = filter.block_map;
+        for (int channel = 0; channel < output_depth;
+             channel += kChannelBlock) {
+          const int count = std::min(kChannelBlock, output_depth - channel);
+          if (block_map != nullptr) {
+            weights = DotProduct4Sparse(
+                col, filter_size, weights, block_map, filter.bias + channel,
+                multiplier + channel, shift + channel, output_offset,
+                activation_min, activation_max, count, output_data);
+            block_map += block_map_words;
+          } else {
+            weights = DotProduct4(col, filter_size, weights,
+                                  filter.bias + channel, multiplier + channel,
+                                  shift + channel, output_offset,
+                                  activation_min, activation_max, count,
+                                  output_data);
+          }
+          output_data += count;
+        }
+      }
+    }
+    input_data += input_height * input_width * input_depth;
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+arm_cmsis_nn_status ConvM0S4(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const Int4Weights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data) {
+  if (ctx->buf == nullptr) {
+    return ARM_CMSIS_NN_ARG_ERROR;
+  }
+  int8_t* col = static_cast<int8_t*>(ctx->buf);
+
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int input_depth = input_dims->c;
+  const int filter_height = filter_dims->h;
+  const int filter_width = filter_dims->w;
+  const int filter_size = filter_height * filter_width * input_depth;
+  const int output_height = output_dims->h;
+  const int output_width = output_dims->w;
+  const int output_depth = output_dims->c;
+  const int stride_height = conv_params->stride.h;
+  const int stride_width = conv_params->stride.w;
+  const int dilation_height = conv_params->dilation.h;
+  const int dilation_width = conv_params->dilation.w;
+  const int pad_height = conv_params->padding.h;
+  const int pad_width = conv_params->padding.w;
+  const int32_t output_offset = conv_params->output_offset;
+  const int32_t activation_min = conv_params->activation.min;
+  const int32_t activation_max = conv_params->activation.max;
+  const int8_t pad_value = static_cast<int8_t>(-conv_params->input_offset);
+  const int32_t* multiplier = quant_params->multiplier;
+  const int32_t* shift = quant_params->shift;
+
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        Im2Col(input_data, input_height, input_width, input_depth,
+               filter_height, filter_width, dilation_height, dilation_width,
+               out_y * stride_height - pad_height,
+               out_x * stride_width - pad_width, pad_value, col);
+        for (int channel = 0; channel < output_depth;
+             channel += kChannelBlock) {
+          const int count = std::min(kChannelBlock, output_depth - channel);
+          DotProduct4S4(col, filter_size, filter, channel,
+                        multiplier + channel, shift + channel, output_offset,
+                        activation_min, activation_max, count, output_data);
+          output_data += count;
+        }
+      }
+    }
+    input_data += input_height * input_width * input_depth;
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+arm_cmsis_nn_status FullyConnectedM0S8(
+    const cmsis_nn_fc_params* fc_params,
+    const cmsis_nn_per_tensor_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const PackedWeights& filter, const cmsis_nn_dims* output_dims,
+    int8_t* output_data) {
+  if (fc_params->filter_offset != 0) {
+    return ARM_CMSIS_NN_ARG_ERROR;
+  }
+  const int depth = input_dims->c;
+  const int output_depth = output_dims->c;
+  // The per tensor parameters are repeated for every lane of DotProduct4.
+  const int32_t multiplier[kChannelBlock] = {
+      quant_params->multiplier, quant_params->multiplier,
+      quant_params->multiplier, quant_params->multiplier};
+  const int32_t shift[kChannelBlock] = {
+      quant_params->shift, quant_params->shift, quant_params->shift,
+      quant_params->shift};
+
+  const int block_map_words = PackedWeightsBlockMapWords(depth);
+
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    const int32_t* weights = filter.weights;
+    const uint32_t* block_map = filter.block_map;
+    for (int channel = 0; channel < output_depth; channel += kChannelBlock) {
+      const int count = std::min(kChannelBlock, output_depth - channel);
+      if (block_map != nullptr) {
+        weights = DotProduct4Sparse(
+            input_data, depth, weights, block_map, filter.bias + channel,
+            multiplier, shift, fc_params->output_offset,
+            fc_params->activation.min, fc_params->activation.max, count,
+            output_data);
+        block_map += block_map_words;
+      } else {
+        weights = DotProduct4(input_data, depth, weights,
+                              filter.bias + channel, multiplier, shift,
+                              fc_params->output_offset,
+                              fc_params->activation.min,
+                              fc_params->activation.max, count, output_data);
+      }
+      output_data += count;
+    }
+    input_data += depth;
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+ConvM0S8Kernel SelectConvM0S8Kernel(const cmsis_nn_dims* filter_dims,
+                                    const cmsis_nn_tile& stride,
+                                    const cmsis_nn_tile& dilation,
+                                    const PackedWeights& filter) {
+  if (dilation.h != 1 || dilation.w != 1 || filter.block_map != nullptr) {
+    return ConvM0S8;
+  }
+  for (const ConvM0S8Variant& variant : kConvM0S8Variants) {
+    if (variant.filter_height == filter_dims->h &&
+        variant.filter_width == filter_dims->w &&
+        variant.input_depth == filter_dims->c &&
+        variant.output_depth == filter_dims->n &&
+        variant.stride_height == stride.h &&
+        variant.stride_width == stride.w) {
+      return variant.kernel;
+    }
+  }
+  return ConvM0S8;
+}
+
+}  // namespace tflite
@@ -0,0 +1,466 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/conv_max_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "Include/arm_nnfunctions.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+const char* const kConv2DMaxPool2DOpName = "CONV_2D_MAX_POOL_2D";
+
+namespace {
+
+// The convolution output rows are produced one at a time into a ring buffer
+// holding filter_height rows of the pooling window. As soon as a window is
+// complete it is reduced into one row of the pooled output, so the full
+// resolution convolution output never exists in memory.
+struct OpData {
+  OpDataConv conv_op_data;
+
+  TfLitePaddingValues pool_padding;
+  int32_t pool_activation_min;
+  int32_t pool_activation_max;
+
+  // Index to the scratch buffer used by arm_convolve_s8 or ConvM0S8.
+  int conv_buffer_idx;
+  // Index to the ring buffer of convolution output rows.
+  int ring_buffer_idx;
+
+  // Filter packed for ConvM0S8, weights is nullptr when arm_convolve_s8 is
+  // used instead.
+  PackedWeights m0_filter;
+  // ConvM0S8 or its variant for the shape of the convolution.
+  ConvM0S8Kernel m0_kernel;
+  // Index to the occupancy mask of the input batch, built by its first
+  // pooled row for the variant to skip the empty windows, -1 when every
+  // window is computed.
+  int occupancy_buffer_idx;
+  // Output of an empty window of that variant.
+  int8_t* m0_empty_output;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  const auto& params =
+      *(static_cast<const TfLiteConvMaxPoolParams*>(node->builtin_data));
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kConvInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* filter =
+      micro_context->AllocateTempInputTensor(node, kConvWeightsTensor);
+  TF_LITE_ENSURE(context, filter != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+
+  const int input_height = input->dims->data[1];
+  const int input_width = input->dims->data[2];
+  const int input_depth = input->dims->data[3];
+  const int filter_height = filter->dims->data[1];
+  const int filter_width = filter->dims->data[2];
+  const int output_depth = filter->dims->data[kConvQuantizedDimension];
+  TF_LITE_ENSURE_EQ(context, output->dims->data[3], output_depth);
+
+  data->conv_op_data.per_channel_output_multiplier =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, output_depth * sizeof(int32_t)));
+  data->conv_op_data.per_channel_output_shift =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, output_depth * sizeof(int32_t)));
+
+  // The pooled output shares its quantization parameters with the
+  // convolution output it replaces, which is checked by the fusion pass, so
+  // the requantization and the fused activation are computed against it.
+  TF_LITE_ENSURE_STATUS(CalculateOpDataConv(
+      context, node, params.conv, input_width, input_height, filter_width,
+      filter_height, params.conv_output_width, params.conv_output_height,
+      input->type, &data->conv_op_data));
+
+  int pooled_height;
+  int pooled_width;
+  data->pool_padding = ComputePaddingHeightWidth(
+      params.pool.stride_height, params.pool.stride_width,
+      /*dilation_rate_height=*/1,
+      /*dilation_rate_width=*/1, params.conv_output_height,
+      params.conv_output_width, params.pool.filter_height,
+      params.pool.filter_width, params.pool.padding, &pooled_height,
+      &pooled_width);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[1], pooled_height);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[2], pooled_width);
+
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, params.pool.activation, output, &data->pool_activation_min,
+      &data->pool_activation_max));
+
+  cmsis_nn_dims input_dims;
+  input_dims.n = 1;
+  input_dims.h = input_height;
+  input_dims.w = input_width;
+  input_dims.c = input_depth;
+
+  cmsis_nn_dims filter_dims;
+  filter_dims.n = output_depth;
+  filter_dims.h = filter_height;
+  filter_dims.w = filter_width;
+  filter_dims.c = input_depth;
+
+  int32_t conv_buf_size;
+  int32_t occupancy_buf_size = 0;
+  data->m0_filter.weights = nullptr;
+  if (kConvM0Enabled && IsConstantTensor(filter)) {
+    TfLiteTensor* bias =
+        micro_context->AllocateTempInputTensor(node, kConvBiasTensor);
+    TF_LITE_ENSURE_STATUS(PreparePackedWeights(context, filter, bias,
+                                               input->params.zero_point,
+                                               &data->m0_filter));
+    if (bias != nullptr) {
+      micro_context->DeallocateTempTfLiteTensor(bias);
+    }
+  }
+  if (data->m0_filter.weights != nullptr) {
+    data->m0_kernel = SelectConvM0S8Kernel(
+        &filter_dims, {params.conv.stride_width, params.conv.stride_height},
+        {params.conv.dilation_width_factor,
+         params.conv.dilation_height_factor},
+        data->m0_filter);
+    conv_buf_size = ConvM0S8GetBufferSize(&filter_dims);
+    occupancy_buf_size =
+        ConvM0S8GetOccupancyBufferSize(data->m0_kernel, &input_dims);
+  } else {
+    conv_buf_size = arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims);
+  }
+  if (conv_buf_size > 0) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, conv_buf_size, &data->conv_buffer_idx));
+  } else {
+    data->conv_buffer_idx = -1;
+  }
+  if (occupancy_buf_size > 0) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, occupancy_buf_size, &data->occupancy_buffer_idx));
+    data->m0_empty_output = static_cast<int8_t*>(
+        context->AllocatePersistentBuffer(context, output_depth));
+    TF_LITE_ENSURE(context, data->m0_empty_output != nullptr);
+    cmsis_nn_conv_params conv_params;
+    conv_params.input_offset = -data->conv_op_data.input_zero_point;
+    conv_params.output_offset = data->conv_op_data.output_zero_point;
+    conv_params.activation.min = data->conv_op_data.output_activation_min;
+    conv_params.activation.max = data->conv_op_data.output_activation_max;
+    cmsis_nn_per_channel_quant_params quant_params;
+    quant_params.multiplier = data->conv_op_data.per_channel_output_multiplier;
+    quant_params.shift = data->conv_op_data.per_channel_output_shift;
+    ConvM0S8EmptyOutput(&conv_params, &quant_params, &filter_dims,
+                        data->m0_filter, data->m0_empty_output);
+  } else {
+    data->occupancy_buffer_idx = -1;
+  }
+
+  const size_t ring_buf_size = params.pool.filter_height *
+                               params.conv_output_width * output_depth;
+  TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+      context, ring_buf_size, &data->ring_buffer_idx));
+
+  micro_context->DeallocateTempTfLiteTensor(output);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(filter);
+
+  return kTfLiteOk;
+}
+
+// Computes a single row of the convolution output by handing arm_convolve_s8
+// (or ConvM0S8 when the filter has been packed for it) only the input rows
+// that the row depends on. Rows above the input are expressed as top padding,
+// rows below it are cut off by the slice height. |occupancy| is the mask of
+// the whole input batch, nullptr when there is none.
+void ConvolveRow(const cmsis_nn_context& ctx,
+                 const cmsis_nn_conv_params& conv_params,
+                 const cmsis_nn_per_channel_quant_params& quant_params,
+                 const cmsis_nn_dims& input_dims, const int8_t* input_data,
+                 const cmsis_nn_dims& filter_dims, const int8_t* filter_data,
+                 const cmsis_nn_dims& bias_dims, const int32_t* bias_data,
+                 const PackedWeights& m0_filter, ConvM0S8Kernel m0_kernel,
+                 const uint32_t* occupancy, const int8_t* m0_empty_output,
+                 const cmsis_nn_dims& row_dims, int row, int8_t* row_data) {
+  const int first_input_row = row * conv_params.stride.h - conv_params.padding.h;
+  const int last_input_row =
+      first_input_row + (filter_dims.h - 1) * conv_params.dilation.h;
+  const int slice_start = std::max(first_input_row, 0);
+  const int slice_end = std::min(last_input_row + 1, input_dims.h);
+  TFLITE_DCHECK_GT(slice_end, slice_start);
+
+  cmsis_nn_dims slice_dims = input_dims;
+  slice_dims.h = slice_end - slice_start;
+
+  cmsis_nn_conv_params slice_params = conv_params;
+  slice_params.padding.h = slice_start - first_input_row;
+
+  const int8_t* slice_data =
+      input_data + slice_start * input_dims.w * input_dims.c;
+  if (m0_filter.weights != nullptr) {
+    ConvM0Occupancy slice_occupancy = {nullptr, 0, nullptr};
+    if (occupancy != nullptr) {
+      slice_occupancy = ConvM0S8Occupancy(occupancy, &input_dims, 0,
+                                          slice_start, 0, m0_empty_output);
+    }
+    TFLITE_DCHECK_EQ(
+        m0_kernel(&ctx, &slice_params, &quant_params, &slice_dims, slice_data,
+                  &filter_dims, m0_filter, &row_dims, row_data,
+                  &slice_occupancy),
+        ARM_CMSIS_NN_SUCCESS);
+    return;
+  }
+  TFLITE_DCHECK_EQ(
+      arm_convolve_s8(&ctx, &slice_params, &quant_params, &slice_dims,
+                      slice_data, &filter_dims, filter_data, &bias_dims,
+                      bias_data, &row_dims, row_data),
+      ARM_CMSIS_NN_SUCCESS);
+}
+
+// Returns the half open range of convolution rows read by pooled row |out_y|.
+void PoolWindowRows(const TfLiteConvMaxPoolParams& params, const OpData& data,
+                    int out_y, int* y_start, int* y_end) {
+  const int in_y_origin =
+      out_y * params.pool.stride_height - data.pool_padding.height;
+  *y_start = std::max(in_y_origin, 0);
+  *y_end = std::min(in_y_origin + params.pool.filter_height,
+                    params.conv_output_height);
+}
+
+// Computes the pooled output rows [first_row, end_row), counted over all
+// batches. The rows have to be computed in order: convolution rows shared
+// with the previous pooled row are taken from the ring buffer.
+TfLiteStatus EvalRows(TfLiteContext* context, TfLiteNode* node, int first_row,
+                      int end_row) {
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kConvInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kConvWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 3)
+          ? tflite::micro::GetEvalInput(context, node, kConvBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kConvOutputTensor);
+
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const auto& params =
+      *(static_cast<const TfLiteConvMaxPoolParams*>(node->builtin_data));
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  cmsis_nn_conv_params conv_params;
+  conv_params.input_offset = -data.conv_op_data.input_zero_point;
+  conv_params.output_offset = data.conv_op_data.output_zero_point;
+  conv_params.stride.h = params.conv.stride_height;
+  conv_params.stride.w = params.conv.stride_width;
+  conv_params.dilation.h = params.conv.dilation_height_factor;
+  conv_params.dilation.w = params.conv.dilation_width_factor;
+  conv_params.padding.h = data.conv_op_data.padding.height;
+  conv_params.padding.w = data.conv_op_data.padding.width;
+  conv_params.activation.min = data.conv_op_data.output_activation_min;
+  conv_params.activation.max = data.conv_op_data.output_activation_max;
+
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier =
+      const_cast<int32_t*>(data.conv_op_data.per_channel_output_multiplier);
+  quant_params.shift =
+      const_cast<int32_t*>(data.conv_op_data.per_channel_output_shift);
+
+  const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  const RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int depth = MatchingDim(filter_shape, 0, output_shape, 3);
+
+  cmsis_nn_dims input_dims;
+  input_dims.n = 1;
+  input_dims.h = input_shape.Dims(1);
+  input_dims.w = input_shape.Dims(2);
+  input_dims.c = input_depth;
+
+  cmsis_nn_dims filter_dims;
+  filter_dims.n = depth;
+  filter_dims.h = filter_shape.Dims(1);
+  filter_dims.w = filter_shape.Dims(2);
+  filter_dims.c = input_depth;
+
+  cmsis_nn_dims bias_dims;
+  bias_dims.n = 1;
+  bias_dims.h = 1;
+  bias_dims.w = 1;
+  bias_dims.c = depth;
+
+  // Dimensions of a single convolution output row.
+  cmsis_nn_dims row_dims;
+  row_dims.n = 1;
+  row_dims.h = 1;
+  row_dims.w = params.conv_output_width;
+  row_dims.c = depth;
+
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.conv_buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.conv_buffer_idx);
+  }
+  int8_t* ring = static_cast<int8_t*>(
+      context->GetScratchBuffer(context, data.ring_buffer_idx));
+  uint32_t* occupancy = nullptr;
+  if (data.occupancy_buffer_idx > -1) {
+    occupancy = static_cast<uint32_t*>(
+        context->GetScratchBuffer(context, data.occupancy_buffer_idx));
+  }
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+
+  const int conv_width = params.conv_output_width;
+  const int ring_rows = params.pool.filter_height;
+  const int row_size = conv_width * depth;
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int input_batch_size = input_dims.h * input_dims.w * input_dims.c;
+  const int output_batch_size = output_height * output_width * depth;
+
+  TF_LITE_ENSURE(context, end_row <= batches * output_height);
+  for (int pooled_row = first_row; pooled_row < end_row; ++pooled_row) {
+    const int batch = pooled_row / output_height;
+    const int out_y = pooled_row % output_height;
+    const int8_t* batch_input = input_data + batch * input_batch_size;
+    int8_t* out = output_data + batch * output_batch_size +
+                  out_y * output_width * depth;
+
+    // First convolution row that has not been computed yet: rows are only
+    // ever needed in increasing order, the ones up to the end of the previous
+    // window are in the ring buffer, and rows that fall in between two
+    // pooling windows are skipped altogether.
+    int next_row = 0;
+    if (out_y > 0) {
+      int previous_start;
+      PoolWindowRows(params, data, out_y - 1, &previous_start, &next_row);
+    }
+    int y_start;
+    int y_end;
+    PoolWindowRows(params, data, out_y, &y_start, &y_end);
+
+    // The mask of the batch is built once, for all of its rows.
+    if (occupancy != nullptr && out_y == 0) {
+      ConvM0S8ComputeOccupancy(&input_dims, batch_input,
+                               conv_params.input_offset, occupancy);
+    }
+    for (int row = std::max(next_row, y_start); row < y_end; ++row) {
+      ConvolveRow(ctx, conv_params, quant_params, input_dims, batch_input,
+                  filter_dims, filter_data, bias_dims, bias_data,
+                  data.m0_filter, data.m0_kernel, occupancy,
+                  data.m0_empty_output, row_dims, row,
+                  ring + (row % ring_rows) * row_size);
+    }
+
+    for (int out_x = 0; out_x < output_width; ++out_x) {
+      const int in_x_origin =
+          out_x * params.pool.stride_width - data.pool_padding.width;
+      const int x_start = std::max(in_x_origin, 0);
+      const int x_end =
+          std::min(in_x_origin + params.pool.filter_width, conv_width);
+
+      for (int channel = 0; channel < depth; ++channel) {
+        out[channel] = std::numeric_limits<int8_t>::lowest();
+      }
+      for (int y = y_start; y < y_end; ++y) {
+        const int8_t* ring_row = ring + (y % ring_rows) * row_size;
+        for (int x = x_start; x < x_end; ++x) {
+          const int8_t* in = ring_row + x * depth;
+          for (int channel = 0; channel < depth; ++channel) {
+            out[channel] = std::max(out[channel], in[channel]);
+          }
+        }
+      }
+      for (int channel = 0; channel < depth; ++channel) {
+        int32_t value = std::max<int32_t>(out[channel],
+                                          data.pool_activation_min);
+        value = std::min<int32_t>(value, data.pool_activation_max);
+        out[channel] = static_cast<int8_t>(value);
+      }
+      out += depth;
+    }
+  }
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kConvOutputTensor);
+  return EvalRows(context, node, 0,
+                  output->dims->data[0] * output->dims->data[1]);
+}
+
+// Time sliced invoke: every step computes one pooled output row. The ring
+// buffer keeps the shared convolution rows from one step to the next.
+TfLiteStatus EvalStep(TfLiteContext* context, TfLiteNode* node, int step,
+                      bool* done) {
+  const TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kConvOutputTensor);
+  *done = step + 1 == output->dims->data[0] * output->dims->data[1];
+  return EvalRows(context, node, step, step + 1);
+}
+
+}  // namespace
+
+TFLMRegistration* Register_CONV_2D_MAX_POOL_2D() {
+  static TFLMRegistration r = [] {
+    TFLMRegistration registration =
+        tflite::micro::RegisterOpWithoutTempAllocations(Init, Prepare, Eval);
+    registration.invoke_step = EvalStep;
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace tflite
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
@@ -45,6 +46,10 @@ struct OpData {
   int32_t batches;
   int32_t accum_depth;
   int32_t output_depth;
+
+  // int8 weights packed for FullyConnectedM0S8, weights is nullptr when the
+  // CMSIS-NN kernels are used instead.
+  PackedWeights m0_filter;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -97,11 +102,20 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   int32_t buf_size = 0;
 
+  data->m0_filter.weights = nullptr;
+  if (input->type == kTfLiteInt8 && kConvM0Enabled &&
+      filter->type == kTfLiteInt8 && filter->params.zero_point == 0 &&
+      IsConstantTensor(filter)) {
+    TF_LITE_ENSURE_STATUS(PreparePackedWeights(context, filter, bias,
+                                               input->params.zero_point,
+                                               &data->m0_filter));
+  }
+
   if (input->type == kTfLiteInt16) {
     TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
     TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
     buf_size = arm_fully_connected_s16_get_buffer_size(&filter_dims);
-  } else if (input->type == kTfLiteInt8) {
+  } else if (input->type == kTfLiteInt8 && data->m0_filter.weights == nullptr) {
     const RuntimeShape input_shape = GetTensorShape(input);
 
     TFLITE_DCHECK_GE(output_dim_count, 2);
@@ -212,7 +226,22 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   const int32_t* bias_data =
       tflite::micro::GetOptionalTensorData<int32_t>(bias);
 
-  if (output_dim_count > 2 && data.accum_depth % 4 == 0) {
+  if (data.m0_filter.weights != nullptr) {
+    cmsis_nn_fc_params fc_params;
+    fc_params.input_offset = -data.reference_op_data.input_zero_point;
+    fc_params.output_offset = data.reference_op_data.output_zero_point;
+    fc_params.filter_offset = 0;
+    fc_params.activation.min = data.reference_op_data.output_activation_min;
+    fc_params.activation.max = data.reference_op_data.output_activation_max;
+
+    TF_LITE_ENSURE_EQ(
+        context,
+        FullyConnectedM0S8(&fc_params, &quant_params, &input_dims,
+                           tflite::micro::GetTensorData<int8_t>(input),
+                           data.m0_filter, &output_dims,
+                           tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+  } else if (output_dim_count > 2 && data.accum_depth % 4 == 0) {
     cmsis_nn_conv_params conv_params;
     conv_params.dilation.h = 1;
     conv_params.dilation.w = 1;
@@ -422,15 +451,17 @@ TfLiteStatus EvalInt16(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TFLMRegistration Register_FULLY_CONNECTED() {
-  return tflite::micro::RegisterOp(Init, Prepare, Eval);
+  return tflite::micro::RegisterOpWithoutTempAllocations(Init, Prepare, Eval);
 }
 
 TFLMRegistration Register_FULLY_CONNECTED_INT8() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, EvalInt8);
 }
 
 TFLMRegistration Register_FULLY_CONNECTED_INT16() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt16);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, EvalInt16);
 }
 
 }  // namespace tflite
@@ -0,0 +1,105 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/max_pool_swar.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace tflite {
+
+arm_cmsis_nn_status MaxPoolSwarS8(const cmsis_nn_context* ctx,
+                                  const cmsis_nn_pool_params* pool_params,
+                                  const cmsis_nn_dims* input_dims,
+                                  const int8_t* src,
+                                  const cmsis_nn_dims* filter_dims,
+                                  const cmsis_nn_dims* output_dims,
+                                  int8_t* dst) {
+  (void)ctx;
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int depth = input_dims->c;
+  const int output_height = output_dims->h;
+  const int output_width = output_dims->w;
+  const int stride_height = pool_params->stride.h;
+  const int stride_width = pool_params->stride.w;
+  const int filter_height = filter_dims->h;
+  const int filter_width = filter_dims->w;
+  const int pad_height = pool_params->padding.h;
+  const int pad_width = pool_params->padding.w;
+  const int32_t activation_min = pool_params->activation.min;
+  const int32_t activation_max = pool_params->activation.max;
+  const int row_size = input_width * depth;
+
+  const bool word_aligned =
+      depth % 4 == 0 &&
+      ((reinterpret_cast<uintptr_t>(src) | reinterpret_cast<uintptr_t>(dst)) &
+       3) == 0;
+  const uint32_t min_word = BroadcastS8x4(activation_min);
+  const uint32_t max_word = BroadcastS8x4(activation_max);
+
+  for (int out_y = 0; out_y < output_height; ++out_y) {
+    const int in_y_origin = out_y * stride_height - pad_height;
+    const int y_start = std::max(in_y_origin, 0);
+    const int y_end = std::min(in_y_origin + filter_height, input_height);
+    for (int out_x = 0; out_x < output_width; ++out_x) {
+      const int in_x_origin = out_x * stride_width - pad_width;
+      const int x_start = std::max(in_x_origin, 0);
+      const int x_end = std::min(in_x_origin + filter_width, input_width);
+      const int8_t* window = src + y_start * row_size + x_start * depth;
+      const int window_width = x_end - x_start;
+      const int window_height = y_end - y_start;
+
+      if (word_aligned) {
+        const uint32_t* in_words = reinterpret_cast<const uint32_t*>(window);
+        uint32_t* out_words = reinterpret_cast<uint32_t*>(dst);
+        const int row_words = row_size / 4;
+        const int depth_words = depth / 4;
+        for (int word = 0; word < depth_words; ++word) {
+          const uint32_t* in_row = in_words + word;
+          uint32_t max = *in_row;
+          for (int y = 0; y < window_height; ++y) {
+            const uint32_t* in = in_row;
+            for (int x = 0; x < window_width; ++x) {
+              max = MaxS8x4(max, *in);
+              in += depth_words;
+            }
+            in_row += row_words;
+          }
+          max = MaxS8x4(max, min_word);
+          out_words[word] = MinS8x4(max, max_word);
+        }
+      } else {
+        for (int channel = 0; channel < depth; ++channel) {
+          const int8_t* in_row = window + channel;
+          int32_t max = *in_row;
+          for (int y = 0; y < window_height; ++y) {
+            const int8_t* in = in_row;
+            for (int x = 0; x < window_width; ++x) {
+              max = std::max<int32_t>(max, *in);
+              in += depth;
+            }
+            in_row += row_size;
+          }
+          max = std::max(max, activation_min);
+          dst[channel] = static_cast<int8_t>(std::min(max, activation_max));
+        }
+      }
+      dst += depth;
+    }
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+}  // namespace tflite
@@ -0,0 +1,634 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/patch_conv_stack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Include/arm_nnfunctions.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/conv_m0.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/max_pool_swar.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+const char* const kPatchConvStackOpName = "PATCH_CONV_STACK";
+
+namespace {
+
+// Upper bound on the stack depth, only used to size arrays on the stack.
+constexpr int kMaxPatchLayers = 8;
+
+struct LayerData {
+  TfLitePatchLayerType type;
+
+  int input_height;
+  int input_width;
+  int input_depth;
+  int output_height;
+  int output_width;
+  int output_depth;
+  int filter_height;
+  int filter_width;
+  int stride_height;
+  int stride_width;
+  int dilation_height;
+  int dilation_width;
+  TfLitePaddingValues padding;
+
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+  int32_t* per_channel_output_multiplier;
+  int32_t* per_channel_output_shift;
+
+  // Filter packed for ConvM0S8, weights is nullptr when arm_convolve_s8 is
+  // used instead.
+  PackedWeights m0_filter;
+  // ConvM0S8 or its variant for the shape of the layer.
+  ConvM0S8Kernel m0_kernel;
+  // int4 filter run in place by ConvM0S4, weights is nullptr for int8
+  // filters.
+  Int4Weights m0_filter_s4;
+};
+
+struct OpData {
+  LayerData* layers;
+
+  // Size in bytes of each of the two buffers the tile activations ping-pong
+  // between.
+  int tile_buffer_size;
+  int tile_buffer_idx;
+  // Index to the scratch buffer used by arm_convolve_s8 or ConvM0S8.
+  int conv_buffer_idx;
+  // Index to the occupancy mask of the stack input, built by the first tile
+  // of every batch for the variant of the first layer to skip the empty
+  // windows, -1 when every window is computed. The later layers only exist
+  // per tile and are always computed densely.
+  int occupancy_buffer_idx;
+  // Output of an empty window of the first layer.
+  int8_t* m0_empty_output;
+};
+
+// Half open range of rows or columns.
+struct Range {
+  int start;
+  int end;
+};
+
+// Returns the part of a layer input needed to compute |output| along one
+// dimension, clipped to the input.
+Range InputRange(const Range& output, int stride, int dilation,
+                 int filter_size, int padding, int input_size) {
+  Range input;
+  input.start = std::max(output.start * stride - padding, 0);
+  input.end = std::min(
+      (output.end - 1) * stride - padding + (filter_size - 1) * dilation + 1,
+      input_size);
+  return input;
+}
+
+// Walks the receptive field of a tile of the stack output back to the stack
+// input. rows[l] and cols[l] receive the part of the input of layer l that is
+// needed; rows[num_layers] and cols[num_layers] hold the tile itself.
+void ComputeTileRanges(const LayerData* layers, int num_layers,
+                       const Range& tile_rows, const Range& tile_cols,
+                       Range* rows, Range* cols) {
+  rows[num_layers] = tile_rows;
+  cols[num_layers] = tile_cols;
+  for (int l = num_layers - 1; l >= 0; --l) {
+    const LayerData& layer = layers[l];
+    rows[l] = InputRange(rows[l + 1], layer.stride_height,
+                         layer.dilation_height, layer.filter_height,
+                         layer.padding.height, layer.input_height);
+    cols[l] = InputRange(cols[l + 1], layer.stride_width, layer.dilation_width,
+                         layer.filter_width, layer.padding.width,
+                         layer.input_width);
+  }
+}
+
+int RangeSize(const Range& range) { return range.end - range.start; }
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Prepares one layer. The input shape of the first layer comes from the
+// stack input, later layers take the output shape of the previous one.
+TfLiteStatus PrepareLayer(TfLiteContext* context,
+                          const TfLitePatchLayer& params,
+                          const LayerData* previous, LayerData* layer) {
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempTfLiteTensor(params.input_tensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempTfLiteTensor(params.output_tensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+
+  layer->type = params.type;
+  layer->m0_filter.weights = nullptr;
+  layer->m0_filter_s4.weights = nullptr;
+  if (previous == nullptr) {
+    TF_LITE_ENSURE_EQ(context, NumDimensions(input), 4);
+    layer->input_height = input->dims->data[1];
+    layer->input_width = input->dims->data[2];
+    layer->input_depth = input->dims->data[3];
+  } else {
+    layer->input_height = previous->output_height;
+    layer->input_width = previous->output_width;
+    layer->input_depth = previous->output_depth;
+  }
+  layer->output_height = params.output_height;
+  layer->output_width = params.output_width;
+  layer->output_depth = params.output_depth;
+  layer->input_zero_point = input->params.zero_point;
+  layer->output_zero_point = output->params.zero_point;
+
+  int output_height;
+  int output_width;
+  if (params.type == kTfLitePatchLayerConv2D) {
+    TfLiteTensor* filter =
+        micro_context->AllocateTempTfLiteTensor(params.filter_tensor);
+    TF_LITE_ENSURE(context, filter != nullptr);
+    TfLiteTensor* bias =
+        params.bias_tensor >= 0
+            ? micro_context->AllocateTempTfLiteTensor(params.bias_tensor)
+            : nullptr;
+    // int4 filters are only supported by ConvM0S4.
+    TF_LITE_ENSURE(context,
+                   filter->type == kTfLiteInt8 ||
+                       (filter->type == kTfLiteInt4 && kConvM0Enabled &&
+                        IsConstantTensor(filter)));
+    TF_LITE_ENSURE_EQ(context, filter->dims->data[0], layer->output_depth);
+    TF_LITE_ENSURE_EQ(context, filter->dims->data[3], layer->input_depth);
+
+    layer->filter_height = filter->dims->data[1];
+    layer->filter_width = filter->dims->data[2];
+    layer->stride_height = params.conv.stride_height;
+    layer->stride_width = params.conv.stride_width;
+    layer->dilation_height = params.conv.dilation_height_factor;
+    layer->dilation_width = params.conv.dilation_width_factor;
+
+    layer->per_channel_output_multiplier =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, layer->output_depth * sizeof(int32_t)));
+    layer->per_channel_output_shift =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, layer->output_depth * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, layer->per_channel_output_multiplier != nullptr);
+    TF_LITE_ENSURE(context, layer->per_channel_output_shift != nullptr);
+
+    int32_t output_multiplier;
+    int output_shift;
+    TF_LITE_ENSURE_STATUS(PopulateConvolutionQuantizationParams(
+        context, input, filter, bias, output, params.conv.activation,
+        &output_multiplier, &output_shift, &layer->output_activation_min,
+        &layer->output_activation_max, layer->per_channel_output_multiplier,
+        layer->per_channel_output_shift, layer->output_depth));
+
+    layer->padding = ComputePaddingHeightWidth(
+        layer->stride_height, layer->stride_width, layer->dilation_height,
+        layer->dilation_width, layer->input_height, layer->input_width,
+        layer->filter_height, layer->filter_width, params.conv.padding,
+        &output_height, &output_width);
+
+    if (filter->type == kTfLiteInt4) {
+      TF_LITE_ENSURE_STATUS(PrepareInt4Weights(context, filter, bias,
+                                               layer->input_zero_point,
+                                               &layer->m0_filter_s4));
+    } else if (kConvM0Enabled && IsConstantTensor(filter)) {
+      TF_LITE_ENSURE_STATUS(PreparePackedWeights(context, filter, bias,
+                                                 layer->input_zero_point,
+                                                 &layer->m0_filter));
+    }
+    if (layer->m0_filter.weights != nullptr) {
+      const cmsis_nn_dims filter_dims = {layer->output_depth,
+                                         layer->filter_height,
+                                         layer->filter_width,
+                                         layer->input_depth};
+      layer->m0_kernel = SelectConvM0S8Kernel(
+          &filter_dims, {layer->stride_width, layer->stride_height},
+          {layer->dilation_width, layer->dilation_height}, layer->m0_filter);
+    }
+
+    if (bias != nullptr) {
+      micro_context->DeallocateTempTfLiteTensor(bias);
+    }
+    micro_context->DeallocateTempTfLiteTensor(filter);
+  } else {
+    TF_LITE_ENSURE_EQ(context, layer->input_depth, layer->output_depth);
+    TF_LITE_ENSURE_EQ(context, layer->input_zero_point,
+                      layer->output_zero_point);
+
+    layer->filter_height = params.pool.filter_height;
+    layer->filter_width = params.pool.filter_width;
+    layer->stride_height = params.pool.stride_height;
+    layer->stride_width = params.pool.stride_width;
+    layer->dilation_height = 1;
+    layer->dilation_width = 1;
+    layer->per_channel_output_multiplier = nullptr;
+    layer->per_channel_output_shift = nullptr;
+
+    TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+        context, params.pool.activation, output,
+        &layer->output_activation_min, &layer->output_activation_max));
+
+    layer->padding = ComputePaddingHeightWidth(
+        layer->stride_height, layer->stride_width, /*dilation_rate_height=*/1,
+        /*dilation_rate_width=*/1, layer->input_height, layer->input_width,
+        layer->filter_height, layer->filter_width, params.pool.padding,
+        &output_height, &output_width);
+  }
+  TF_LITE_ENSURE_EQ(context, output_height, layer->output_height);
+  TF_LITE_ENSURE_EQ(context, output_width, layer->output_width);
+
+  micro_context->DeallocateTempTfLiteTensor(output);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  return kTfLiteOk;
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto& params =
+      *(static_cast<const TfLitePatchStackParams*>(node->builtin_data));
+  TF_LITE_ENSURE(context, params.num_layers > 0);
+  TF_LITE_ENSURE(context, params.num_layers <= kMaxPatchLayers);
+  TF_LITE_ENSURE(context, params.tile_height > 0 && params.tile_width > 0);
+
+  data->layers = static_cast<LayerData*>(context->AllocatePersistentBuffer(
+      context, params.num_layers * sizeof(LayerData)));
+  TF_LITE_ENSURE(context, data->layers != nullptr);
+
+  int conv_buffer_size = 0;
+  for (int l = 0; l < params.num_layers; ++l) {
+    TF_LITE_ENSURE_STATUS(PrepareLayer(
+        context, params.layers[l], l > 0 ? &data->layers[l - 1] : nullptr,
+        &data->layers[l]));
+    const LayerData& layer = data->layers[l];
+    if (l > 0) {
+      TF_LITE_ENSURE_EQ(context, params.layers[l].input_tensor,
+                        params.layers[l - 1].output_tensor);
+    }
+    if (layer.type == kTfLitePatchLayerConv2D) {
+      const cmsis_nn_dims input_dims = {1, layer.input_height,
+                                        layer.input_width, layer.input_depth};
+      const cmsis_nn_dims filter_dims = {layer.output_depth,
+                                         layer.filter_height,
+                                         layer.filter_width, layer.input_depth};
+      conv_buffer_size = std::max<int>(
+          conv_buffer_size,
+          layer.m0_filter.weights != nullptr ||
+                  layer.m0_filter_s4.weights != nullptr
+              ? ConvM0S8GetBufferSize(&filter_dims)
+              : arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims));
+    }
+  }
+
+  // The tile buffers have to hold the largest region of any activation over
+  // all tiles; tiles on the border can be larger than interior ones.
+  const LayerData& last = data->layers[params.num_layers - 1];
+  Range rows[kMaxPatchLayers + 1];
+  Range cols[kMaxPatchLayers + 1];
+  int tile_buffer_size = 0;
+  for (int y = 0; y < last.output_height; y += params.tile_height) {
+    for (int x = 0; x < last.output_width; x += params.tile_width) {
+      const Range tile_rows = {y, std::min(y + params.tile_height,
+                                           last.output_height)};
+      const Range tile_cols = {x,
+                               std::min(x + params.tile_width,
+                                        last.output_width)};
+      ComputeTileRanges(data->layers, params.num_layers, tile_rows, tile_cols,
+                        rows, cols);
+      for (int l = 0; l <= params.num_layers; ++l) {
+        const int depth = l < params.num_layers
+                              ? data->layers[l].input_depth
+                              : last.output_depth;
+        tile_buffer_size = std::max(
+            tile_buffer_size, RangeSize(rows[l]) * RangeSize(cols[l]) * depth);
+      }
+    }
+  }
+  // Keep the second buffer word aligned.
+  data->tile_buffer_size = (tile_buffer_size + 3) & ~3;
+
+  TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+      context, 2 * data->tile_buffer_size, &data->tile_buffer_idx));
+  data->conv_buffer_idx = -1;
+  if (conv_buffer_size > 0) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, conv_buffer_size, &data->conv_buffer_idx));
+  }
+
+  const LayerData& first = data->layers[0];
+  const cmsis_nn_dims input_dims = {1, first.input_height, first.input_width,
+                                    first.input_depth};
+  const int32_t occupancy_buffer_size =
+      first.m0_filter.weights != nullptr
+          ? ConvM0S8GetOccupancyBufferSize(first.m0_kernel, &input_dims)
+          : 0;
+  data->occupancy_buffer_idx = -1;
+  if (occupancy_buffer_size > 0) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, occupancy_buffer_size, &data->occupancy_buffer_idx));
+    data->m0_empty_output = static_cast<int8_t*>(
+        context->AllocatePersistentBuffer(context, first.output_depth));
+    TF_LITE_ENSURE(context, data->m0_empty_output != nullptr);
+    cmsis_nn_conv_params conv_params;
+    conv_params.input_offset = -first.input_zero_point;
+    conv_params.output_offset = first.output_zero_point;
+    conv_params.activation.min = first.output_activation_min;
+    conv_params.activation.max = first.output_activation_max;
+    cmsis_nn_per_channel_quant_params quant_params;
+    quant_params.multiplier = first.per_channel_output_multiplier;
+    quant_params.shift = first.per_channel_output_shift;
+    const cmsis_nn_dims filter_dims = {first.output_depth, first.filter_height,
+                                       first.filter_width, first.input_depth};
+    ConvM0S8EmptyOutput(&conv_params, &quant_params, &filter_dims,
+                        first.m0_filter, data->m0_empty_output);
+  }
+
+  return kTfLiteOk;
+}
+
+// Copies |rows| rows of |row_bytes| bytes between two buffers with different
+// row strides.
+void CopyRows(const int8_t* src, int src_stride, int8_t* dst, int dst_stride,
+              int rows, int row_bytes) {
+  for (int y = 0; y < rows; ++y) {
+    std::memcpy(dst, src, row_bytes);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+// Runs one layer on a window of its input. |in_rows| x |in_cols| is the part
+// of the input held in |input|, |out_rows| x |out_cols| the part of the output
+// to compute. Everything outside of the input window is either never read or
+// lies outside of the tensor, where it is handled as padding. |occupancy| is
+// the mask of the input window for ConvM0S8, nullptr when there is none.
+TfLiteStatus EvalLayerWindow(TfLiteContext* context, const LayerData& layer,
+                             const TfLitePatchLayer& params,
+                             const cmsis_nn_context& ctx,
+                             const ConvM0Occupancy* occupancy,
+                             const Range& in_rows, const Range& in_cols,
+                             const int8_t* input, const Range& out_rows,
+                             const Range& out_cols, int8_t* output) {
+  const cmsis_nn_dims input_dims = {1, RangeSize(in_rows), RangeSize(in_cols),
+                                    layer.input_depth};
+  const cmsis_nn_dims output_dims = {1, RangeSize(out_rows),
+                                     RangeSize(out_cols), layer.output_depth};
+  const int padding_height =
+      in_rows.start -
+      (out_rows.start * layer.stride_height - layer.padding.height);
+  const int padding_width =
+      in_cols.start -
+      (out_cols.start * layer.stride_width - layer.padding.width);
+
+  if (layer.type == kTfLitePatchLayerConv2D) {
+    const TfLiteEvalTensor* filter =
+        context->GetEvalTensor(context, params.filter_tensor);
+    const TfLiteEvalTensor* bias =
+        params.bias_tensor >= 0
+            ? context->GetEvalTensor(context, params.bias_tensor)
+            : nullptr;
+
+    cmsis_nn_conv_params conv_params;
+    conv_params.input_offset = -layer.input_zero_point;
+    conv_params.output_offset = layer.output_zero_point;
+    conv_params.stride.h = layer.stride_height;
+    conv_params.stride.w = layer.stride_width;
+    conv_params.dilation.h = layer.dilation_height;
+    conv_params.dilation.w = layer.dilation_width;
+    conv_params.padding.h = padding_height;
+    conv_params.padding.w = padding_width;
+    conv_params.activation.min = layer.output_activation_min;
+    conv_params.activation.max = layer.output_activation_max;
+
+    cmsis_nn_per_channel_quant_params quant_params;
+    quant_params.multiplier = layer.per_channel_output_multiplier;
+    quant_params.shift = layer.per_channel_output_shift;
+
+    const cmsis_nn_dims filter_dims = {layer.output_depth, layer.filter_height,
+                                       layer.filter_width, layer.input_depth};
+    const cmsis_nn_dims bias_dims = {1, 1, 1, layer.output_depth};
+
+    if (layer.m0_filter.weights != nullptr) {
+      TF_LITE_ENSURE_EQ(context,
+                        layer.m0_kernel(&ctx, &conv_params, &quant_params,
+                                        &input_dims, input, &filter_dims,
+                                        layer.m0_filter, &output_dims, output,
+                                        occupancy),
+                        ARM_CMSIS_NN_SUCCESS);
+      return kTfLiteOk;
+    }
+    if (layer.m0_filter_s4.weights != nullptr) {
+      TF_LITE_ENSURE_EQ(context,
+                        ConvM0S4(&ctx, &conv_params, &quant_params,
+                                 &input_dims, input, &filter_dims,
+                                 layer.m0_filter_s4, &output_dims, output),
+                        ARM_CMSIS_NN_SUCCESS);
+      return kTfLiteOk;
+    }
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_convolve_s8(&ctx, &conv_params, &quant_params, &input_dims, input,
+                        &filter_dims,
+                        tflite::micro::GetTensorData<int8_t>(filter),
+                        &bias_dims,
+                        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                        &output_dims, output),
+        ARM_CMSIS_NN_SUCCESS);
+  } else {
+    cmsis_nn_pool_params pool_params;
+    pool_params.stride.h = layer.stride_height;
+    pool_params.stride.w = layer.stride_width;
+    pool_params.padding.h = padding_height;
+    pool_params.padding.w = padding_width;
+    pool_params.activation.min = layer.output_activation_min;
+    pool_params.activation.max = layer.output_activation_max;
+
+    const cmsis_nn_dims filter_dims = {1, layer.filter_height,
+                                       layer.filter_width, 1};
+
+    if (kMaxPoolSwarEnabled) {
+      TF_LITE_ENSURE_EQ(context,
+                        MaxPoolSwarS8(&ctx, &pool_params, &input_dims, input,
+                                      &filter_dims, &output_dims, output),
+                        ARM_CMSIS_NN_SUCCESS);
+    } else {
+      TF_LITE_ENSURE_EQ(context,
+                        arm_max_pool_s8(&ctx, &pool_params, &input_dims, input,
+                                        &filter_dims, &output_dims, output),
+                        ARM_CMSIS_NN_SUCCESS);
+    }
+  }
+  return kTfLiteOk;
+}
+
+// Computes the tile of the stack output starting at row |y| and column |x|
+// of batch |batch|.
+TfLiteStatus EvalTile(TfLiteContext* context, TfLiteNode* node, int batch,
+                      int y, int x) {
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const auto& params =
+      *(static_cast<const TfLitePatchStackParams*>(node->builtin_data));
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  const int num_layers = params.num_layers;
+  const LayerData& first = data.layers[0];
+  const LayerData& last = data.layers[num_layers - 1];
+
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.conv_buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.conv_buffer_idx);
+  }
+  int8_t* tile_buffers[2];
+  tile_buffers[0] = static_cast<int8_t*>(
+      context->GetScratchBuffer(context, data.tile_buffer_idx));
+  tile_buffers[1] = tile_buffers[0] + data.tile_buffer_size;
+
+  const int input_batch_size =
+      first.input_height * first.input_width * first.input_depth;
+  const int output_batch_size =
+      last.output_height * last.output_width * last.output_depth;
+  const int8_t* batch_input =
+      tflite::micro::GetTensorData<int8_t>(input) + batch * input_batch_size;
+  int8_t* batch_output =
+      tflite::micro::GetTensorData<int8_t>(output) + batch * output_batch_size;
+
+  Range rows[kMaxPatchLayers + 1];
+  Range cols[kMaxPatchLayers + 1];
+  const Range tile_rows = {
+      y, std::min(y + params.tile_height, last.output_height)};
+  const Range tile_cols = {x,
+                           std::min(x + params.tile_width, last.output_width)};
+  ComputeTileRanges(data.layers, num_layers, tile_rows, tile_cols, rows, cols);
+
+  // The mask of the batch is built by its first tile, for all of its tiles.
+  ConvM0Occupancy occupancy = {nullptr, 0, nullptr};
+  if (data.occupancy_buffer_idx > -1) {
+    const cmsis_nn_dims input_dims = {1, first.input_height, first.input_width,
+                                      first.input_depth};
+    uint32_t* occupancy_buffer = static_cast<uint32_t*>(
+        context->GetScratchBuffer(context, data.occupancy_buffer_idx));
+    if (y == 0 && x == 0) {
+      ConvM0S8ComputeOccupancy(&input_dims, batch_input,
+                               -first.input_zero_point, occupancy_buffer);
+    }
+    occupancy = ConvM0S8Occupancy(occupancy_buffer, &input_dims, 0,
+                                  rows[0].start, cols[0].start,
+                                  data.m0_empty_output);
+  }
+
+  // Gather the receptive field of the tile from the stack input.
+  const int input_row_bytes = RangeSize(cols[0]) * first.input_depth;
+  CopyRows(batch_input +
+               (rows[0].start * first.input_width + cols[0].start) *
+                   first.input_depth,
+           first.input_width * first.input_depth, tile_buffers[0],
+           input_row_bytes, RangeSize(rows[0]), input_row_bytes);
+  for (int l = 0; l < num_layers; ++l) {
+    TF_LITE_ENSURE_STATUS(EvalLayerWindow(
+        context, data.layers[l], params.layers[l], ctx,
+        l == 0 ? &occupancy : nullptr, rows[l], cols[l], tile_buffers[l % 2],
+        rows[l + 1], cols[l + 1], tile_buffers[(l + 1) % 2]));
+  }
+  // Stitch the tile into the stack output.
+  const int output_row_bytes = RangeSize(tile_cols) * last.output_depth;
+  CopyRows(tile_buffers[num_layers % 2], output_row_bytes,
+           batch_output +
+               (tile_rows.start * last.output_width + tile_cols.start) *
+                   last.output_depth,
+           last.output_width * last.output_depth, RangeSize(tile_rows),
+           output_row_bytes);
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  const auto& params =
+      *(static_cast<const TfLitePatchStackParams*>(node->builtin_data));
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  const LayerData& last = data.layers[params.num_layers - 1];
+
+  const int batches = input->dims->data[0];
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int y = 0; y < last.output_height; y += params.tile_height) {
+      for (int x = 0; x < last.output_width; x += params.tile_width) {
+        TF_LITE_ENSURE_STATUS(EvalTile(context, node, batch, y, x));
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+// Time sliced invoke: every step computes one tile.
+TfLiteStatus EvalStep(TfLiteContext* context, TfLiteNode* node, int step,
+                      bool* done) {
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  const auto& params =
+      *(static_cast<const TfLitePatchStackParams*>(node->builtin_data));
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  const LayerData& last = data.layers[params.num_layers - 1];
+
+  const int tiles_x =
+      (last.output_width + params.tile_width - 1) / params.tile_width;
+  const int tiles_y =
+      (last.output_height + params.tile_height - 1) / params.tile_height;
+  const int tiles = tiles_x * tiles_y;
+  const int batch = step / tiles;
+  const int tile = step % tiles;
+  TF_LITE_ENSURE(context, batch < input->dims->data[0]);
+  *done = step + 1 == tiles * input->dims->data[0];
+  return EvalTile(context, node, batch, (tile / tiles_x) * params.tile_height,
+                  (tile % tiles_x) * params.tile_width);
+}
+
+}  // namespace
+
+TFLMRegistration* Register_PATCH_CONV_STACK() {
+  static TFLMRegistration r = [] {
+    TFLMRegistration registration =
+        tflite::micro::RegisterOpWithoutTempAllocations(Init, Prepare, Eval);
+    registration.invoke_step = EvalStep;
+    return registration;
+  }();
+  return &r;
+}
+
+}  // namespace tflite
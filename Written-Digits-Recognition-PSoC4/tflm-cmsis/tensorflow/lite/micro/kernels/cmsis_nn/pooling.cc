@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/max_pool_swar.h"
 #include "tensorflow/lite/micro/kernels/pooling.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
@@ -127,7 +128,13 @@ TfLiteStatus MaxEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   PopulateCommonParams(context, &input_dims, &output_dims, &pool_params, &ctx,
                        &filter_dims, data, input_shape, output_shape, params);
 
-  if (input->type == kTfLiteInt8) {
+  if (input->type == kTfLiteInt8 && kMaxPoolSwarEnabled) {
+    TFLITE_DCHECK_EQ(
+        MaxPoolSwarS8(&ctx, &pool_params, &input_dims,
+                      micro::GetTensorData<int8_t>(input), &filter_dims,
+                      &output_dims, micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+  } else if (input->type == kTfLiteInt8) {
     TFLITE_DCHECK_EQ(
         arm_max_pool_s8(&ctx, &pool_params, &input_dims,
                         micro::GetTensorData<int8_t>(input), &filter_dims,
@@ -320,27 +327,33 @@ TfLiteStatus MaxEvalInt16(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TFLMRegistration Register_AVERAGE_POOL_2D_INT8() {
-  return tflite::micro::RegisterOp(Init, AveragePrepare, AverageEvalInt8);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, AveragePrepare, AverageEvalInt8);
 }
 
 TFLMRegistration Register_AVERAGE_POOL_2D_INT16() {
-  return tflite::micro::RegisterOp(Init, AveragePrepare, AverageEvalInt16);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, AveragePrepare, AverageEvalInt16);
 }
 
 TFLMRegistration Register_AVERAGE_POOL_2D() {
-  return tflite::micro::RegisterOp(Init, AveragePrepare, AverageEval);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, AveragePrepare, AverageEval);
 }
 
 TFLMRegistration Register_MAX_POOL_2D_INT8() {
-  return tflite::micro::RegisterOp(Init, MaxPrepare, MaxEvalInt8);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, MaxPrepare, MaxEvalInt8);
 }
 
 TFLMRegistration Register_MAX_POOL_2D_INT16() {
-  return tflite::micro::RegisterOp(Init, MaxPrepare, MaxEvalInt16);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, MaxPrepare, MaxEvalInt16);
 }
 
 TFLMRegistration Register_MAX_POOL_2D() {
-  return tflite::micro::RegisterOp(Init, MaxPrepare, MaxEval);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, MaxPrepare, MaxEval);
 }
 
 }  // namespace tflite
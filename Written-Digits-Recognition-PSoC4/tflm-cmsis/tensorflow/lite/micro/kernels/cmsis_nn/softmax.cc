@@ -191,19 +191,23 @@ TfLiteStatus SoftmaxEvalInt16(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TFLMRegistration Register_SOFTMAX() {
-  return tflite::micro::RegisterOp(Init, Prepare, SoftmaxEval);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, SoftmaxEval);
 }
 
 TFLMRegistration Register_SOFTMAX_INT8() {
-  return tflite::micro::RegisterOp(Init, Prepare, SoftmaxEvalInt8);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, SoftmaxEvalInt8);
 }
 
 TFLMRegistration Register_SOFTMAX_INT8_INT16() {
-  return tflite::micro::RegisterOp(Init, Prepare, SoftmaxEvalInt8_Int16);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, SoftmaxEvalInt8_Int16);
 }
 
 TFLMRegistration Register_SOFTMAX_INT16() {
-  return tflite::micro::RegisterOp(Init, Prepare, SoftmaxEvalInt16);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, Prepare, SoftmaxEvalInt16);
 }
 
 }  // namespace tflite
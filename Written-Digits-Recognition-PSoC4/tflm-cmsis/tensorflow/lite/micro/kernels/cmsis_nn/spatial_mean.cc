@@ -0,0 +1,106 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/spatial_mean.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/micro/kernels/requantize_m0.h"
+
+namespace tflite {
+
+namespace {
+
+// Pixels a 16-bit lane can sum before it overflows: 257 * 255 = 0xffff.
+constexpr int kMaxLanePixels = 0xffff / 0xff;
+
+int8_t RequantizeMean(const SpatialMeanParams& params, int32_t sum,
+                      int32_t num_pixels) {
+  int32_t mean = RequantizeM0(sum - params.input_zero_point * num_pixels,
+                              params.multiplier, params.shift) +
+                 params.output_zero_point;
+  mean = std::max<int32_t>(mean, std::numeric_limits<int8_t>::min());
+  mean = std::min<int32_t>(mean, std::numeric_limits<int8_t>::max());
+  return static_cast<int8_t>(mean);
+}
+
+}  // namespace
+
+void SpatialMeanMultiplier(int32_t multiplier, int shift, int32_t num_pixels,
+                           int32_t* mean_multiplier, int* mean_shift) {
+  int pixels_shift =
+      63 - CountLeadingZeros(static_cast<uint64_t>(num_pixels));
+  pixels_shift = std::min(pixels_shift, 32);
+  pixels_shift = std::min(pixels_shift, 31 + shift);
+  *mean_multiplier = static_cast<int32_t>(
+      (static_cast<int64_t>(multiplier) << pixels_shift) / num_pixels);
+  *mean_shift = shift - pixels_shift;
+}
+
+void SpatialMeanS8(const SpatialMeanParams& params,
+                   const cmsis_nn_dims& input_dims, const int8_t* input,
+                   int8_t* output) {
+  const int32_t num_pixels = input_dims.h * input_dims.w;
+  const int depth = input_dims.c;
+  const bool word_path =
+      depth % 4 == 0 && (reinterpret_cast<uintptr_t>(input) & 3) == 0;
+  // The lanes sum the values biased to unsigned, x + 128.
+  const int32_t bias_sum = 128 * num_pixels;
+
+  for (int b = 0; b < input_dims.n; ++b) {
+    if (word_path) {
+      for (int c = 0; c < depth; c += 4) {
+        int32_t sums[4] = {0, 0, 0, 0};
+        const uint32_t* in = reinterpret_cast<const uint32_t*>(input + c);
+        for (int32_t start = 0; start < num_pixels; start += kMaxLanePixels) {
+          const int32_t end = std::min(num_pixels, start + kMaxLanePixels);
+          // Channels c and c + 2 in |even|, c + 1 and c + 3 in |odd|.
+          uint32_t even = 0;
+          uint32_t odd = 0;
+          for (int32_t i = start; i < end; ++i) {
+            const uint32_t word = *in ^ 0x80808080u;
+            even += word & 0x00ff00ffu;
+            odd += (word >> 8) & 0x00ff00ffu;
+            in += depth / 4;
+          }
+          sums[0] += even & 0xffffu;
+          sums[1] += odd & 0xffffu;
+          sums[2] += even >> 16;
+          sums[3] += odd >> 16;
+        }
+        for (int k = 0; k < 4; ++k) {
+          output[c + k] =
+              RequantizeMean(params, sums[k] - bias_sum, num_pixels);
+        }
+      }
+    } else {
+      for (int c = 0; c < depth; ++c) {
+        int32_t sum = 0;
+        const int8_t* in = input + c;
+        for (int32_t i = 0; i < num_pixels; ++i) {
+          sum += *in;
+          in += depth;
+        }
+        output[c] = RequantizeMean(params, sum, num_pixels);
+      }
+    }
+    input += num_pixels * depth;
+    output += depth;
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,207 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+#include "tensorflow/lite/micro/kernels/requantize_m0.h"
+#include "tensorflow/lite/micro/micro_context.h"
+
+namespace tflite {
+namespace {
+
+// Side of the input tile and of the block of outputs computed from it.
+constexpr int kTileSide = 4;
+constexpr int kOutputSide = 2;
+
+// Computes the transformed input tile B^T d B of every input channel into
+// |tile|, in [tile element][channel] order. |pixels| points to the 16 input
+// pixels of the tile, nullptr for the ones in the padding.
+void TransformInputTile(const int8_t* const* pixels, int depth,
+                        int32_t input_offset, int16_t* tile) {
+  for (int channel = 0; channel < depth; ++channel) {
+    int32_t d[kWinogradTileSize];
+    for (int i = 0; i < kWinogradTileSize; ++i) {
+      d[i] = pixels[i] != nullptr ? pixels[i][channel] + input_offset : 0;
+    }
+    // B^T = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1], applied to the columns
+    // and then to the rows.
+    int32_t t[kWinogradTileSize];
+    for (int x = 0; x < kTileSide; ++x) {
+      t[0 * kTileSide + x] = d[0 * kTileSide + x] - d[2 * kTileSide + x];
+      t[1 * kTileSide + x] = d[1 * kTileSide + x] + d[2 * kTileSide + x];
+      t[2 * kTileSide + x] = d[2 * kTileSide + x] - d[1 * kTileSide + x];
+      t[3 * kTileSide + x] = d[1 * kTileSide + x] - d[3 * kTileSide + x];
+    }
+    for (int y = 0; y < kTileSide; ++y) {
+      const int32_t* row = t + y * kTileSide;
+      int16_t* out = tile + y * kTileSide * depth + channel;
+      out[0 * depth] = static_cast<int16_t>(row[0] - row[2]);
+      out[1 * depth] = static_cast<int16_t>(row[1] + row[2]);
+      out[2 * depth] = static_cast<int16_t>(row[2] - row[1]);
+      out[3 * depth] = static_cast<int16_t>(row[1] - row[3]);
+    }
+  }
+}
+
+// Multiplies the transformed |tile| with the transformed filter of one output
+// channel and applies the output transform A^T m A, giving four times the
+// accumulators of the 2x2 outputs in |sums|.
+void MultiplyTile(const int16_t* tile, const int16_t* filter, int depth,
+                  int32_t* sums) {
+  int32_t m[kWinogradTileSize];
+  for (int i = 0; i < kWinogradTileSize; ++i) {
+    int32_t acc = 0;
+    for (int channel = 0; channel < depth; ++channel) {
+      acc += static_cast<int32_t>(*filter++) * (*tile++);
+    }
+    m[i] = acc;
+  }
+  // A^T = [1 1 1 0; 0 1 -1 -1], applied to the columns and then to the rows.
+  int32_t t[kOutputSide * kTileSide];
+  for (int x = 0; x < kTileSide; ++x) {
+    t[x] = m[0 * kTileSide + x] + m[1 * kTileSide + x] + m[2 * kTileSide + x];
+    t[kTileSide + x] =
+        m[1 * kTileSide + x] - m[2 * kTileSide + x] - m[3 * kTileSide + x];
+  }
+  for (int y = 0; y < kOutputSide; ++y) {
+    const int32_t* row = t + y * kTileSide;
+    sums[y * kOutputSide + 0] = row[0] + row[1] + row[2];
+    sums[y * kOutputSide + 1] = row[1] - row[2] - row[3];
+  }
+}
+
+}  // namespace
+
+const int16_t* FindWinogradFilter(TfLiteContext* context,
+                                  const TfLiteTensor* filter,
+                                  const TfLiteTensor* bias,
+                                  int32_t input_zero_point) {
+  const WinogradFilterTable* table =
+      GetMicroContext(context)->winograd_filters();
+  if (table == nullptr || filter->type != kTfLiteInt8 ||
+      !IsConstantTensor(filter)) {
+    return nullptr;
+  }
+  const int output_depth = filter->dims->data[0];
+  int depth = 1;
+  for (int i = 1; i < filter->dims->size; ++i) {
+    depth *= filter->dims->data[i];
+  }
+  const int32_t* bias_data =
+      bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr;
+  const uint32_t checksum =
+      PackedWeightsChecksum(GetTensorData<int8_t>(filter), bias_data,
+                            output_depth, depth, input_zero_point);
+  // The table holds the depth of the layer input, not of the filter.
+  const int input_depth = filter->dims->data[filter->dims->size - 1];
+  for (int i = 0; i < table->count; ++i) {
+    const WinogradFilterEntry& entry = table->entries[i];
+    if (entry.checksum == checksum && entry.output_depth == output_depth &&
+        entry.depth == input_depth) {
+      return entry.data;
+    }
+  }
+  return nullptr;
+}
+
+int32_t WinogradConvS8GetBufferSize(const cmsis_nn_dims* filter_dims) {
+  return kWinogradTileSize * filter_dims->c * sizeof(int16_t);
+}
+
+arm_cmsis_nn_status WinogradConvS8(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const int16_t* filter_data,
+    const cmsis_nn_dims* bias_dims, const int32_t* bias_data,
+    const cmsis_nn_dims* output_dims, int8_t* output_data) {
+  if (ctx->buf == nullptr || filter_dims->h != 3 || filter_dims->w != 3 ||
+      conv_params->stride.h != 1 || conv_params->stride.w != 1 ||
+      conv_params->dilation.h != 1 || conv_params->dilation.w != 1 ||
+      input_dims->c > kWinogradMaxInputDepth) {
+    return ARM_CMSIS_NN_ARG_ERROR;
+  }
+  int16_t* tile = static_cast<int16_t*>(ctx->buf);
+
+  const int input_height = input_dims->h;
+  const int input_width = input_dims->w;
+  const int depth = input_dims->c;
+  const int output_height = output_dims->h;
+  const int output_width = output_dims->w;
+  const int output_depth = output_dims->c;
+  const int pad_height = conv_params->padding.h;
+  const int pad_width = conv_params->padding.w;
+  const int32_t input_offset = conv_params->input_offset;
+  const int32_t output_offset = conv_params->output_offset;
+  const int32_t activation_min = conv_params->activation.min;
+  const int32_t activation_max = conv_params->activation.max;
+  const int filter_size = kWinogradTileSize * depth;
+
+  for (int batch = 0; batch < input_dims->n; ++batch) {
+    for (int out_y = 0; out_y < output_height; out_y += kOutputSide) {
+      for (int out_x = 0; out_x < output_width; out_x += kOutputSide) {
+        const int8_t* pixels[kWinogradTileSize];
+        for (int y = 0; y < kTileSide; ++y) {
+          const int in_y = out_y - pad_height + y;
+          for (int x = 0; x < kTileSide; ++x) {
+            const int in_x = out_x - pad_width + x;
+            const bool inside = in_y >= 0 && in_y < input_height &&
+                                in_x >= 0 && in_x < input_width;
+            pixels[y * kTileSide + x] =
+                inside ? input_data + (in_y * input_width + in_x) * depth
+                       : nullptr;
+          }
+        }
+        TransformInputTile(pixels, depth, input_offset, tile);
+
+        const int rows = std::min(kOutputSide, output_height - out_y);
+        const int cols = std::min(kOutputSide, output_width - out_x);
+        for (int channel = 0; channel < output_depth; ++channel) {
+          int32_t sums[kOutputSide * kOutputSide];
+          MultiplyTile(tile, filter_data + channel * filter_size, depth,
+                       sums);
+          const int32_t bias = bias_data != nullptr ? bias_data[channel] : 0;
+          for (int y = 0; y < rows; ++y) {
+            int8_t* out =
+                output_data +
+                ((out_y + y) * output_width + out_x) * output_depth + channel;
+            for (int x = 0; x < cols; ++x) {
+              // The transforms with 2G scale the sums by exactly four.
+              int32_t acc = (sums[y * kOutputSide + x] >> 2) + bias;
+              acc = RequantizeM0(acc, quant_params->multiplier[channel],
+                                 quant_params->shift[channel]);
+              acc += output_offset;
+              acc = std::max(acc, activation_min);
+              acc = std::min(acc, activation_max);
+              out[x * output_depth] = static_cast<int8_t>(acc);
+            }
+          }
+        }
+      }
+    }
+    input_data += input_height * input_width * depth;
+    output_data += output_height * output_width * output_depth;
+  }
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+}  // namespace tflite
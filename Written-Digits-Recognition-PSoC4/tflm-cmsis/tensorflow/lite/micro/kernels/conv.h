@@ -103,10 +103,20 @@ TFLMRegistration Register_CONV_2D_INT8();
 // implementations.
 TFLMRegistration Register_CONV_2D_INT16();
 
+// Returns a TFLMRegistration struct for kernel variant that runs the int8 3x3
+// stride 1 layers whose filter is in the table set with
+// MicroInterpreter::SetWinogradFilters with WinogradConvS8, and the other
+// layers like Register_CONV_2D.
+TFLMRegistration Register_CONV_2D_WINOGRAD();
+
 #else
 inline TFLMRegistration Register_CONV_2D_INT8() { return Register_CONV_2D(); }
 
 inline TFLMRegistration Register_CONV_2D_INT16() { return Register_CONV_2D(); }
+
+inline TFLMRegistration Register_CONV_2D_WINOGRAD() {
+  return Register_CONV_2D();
+}
 #endif
 
 }  // namespace tflite
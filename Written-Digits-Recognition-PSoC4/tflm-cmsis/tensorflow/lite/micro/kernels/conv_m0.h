@@ -0,0 +1,157 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CONV_M0_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CONV_M0_H_
+
+#include <cstdint>
+
+#include "Include/arm_nnfunctions.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+
+// Largest share of occupied input pixels, in percent, for which the variants
+// returned by SelectConvM0S8Kernel skip the empty windows. 0 disables the
+// skipping.
+#ifndef TF_LITE_CONV_M0_SPARSE_DENSITY
+#define TF_LITE_CONV_M0_SPARSE_DENSITY 60
+#endif
+
+namespace tflite {
+
+// int8 convolution and fully connected kernels for cores without the DSP
+// extension (Cortex-M0/M0+), where the CMSIS-NN kernels fall back to plain C
+// loops that add the input offset on every MAC. ConvM0S8 and
+// FullyConnectedM0S8 are drop-in replacements for arm_convolve_s8 and
+// arm_fully_connected_s8 that take their weights as PackedWeights, dense or
+// block sparse: four output channels are computed at a time, their
+// accumulators stay in registers for the whole dot product and the input
+// offset is already folded into the bias. Padding in the im2col column is
+// filled with the input zero point, which the folded offset cancels out.
+//
+// The results are bit-exact with reference_integer_ops::ConvPerChannel and
+// reference_integer_ops::FullyConnected.
+#if !defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+constexpr bool kConvM0Enabled = true;
+#else
+constexpr bool kConvM0Enabled = false;
+#endif
+
+// Size in bytes of the scratch buffer ConvM0S8 expects in ctx->buf.
+int32_t ConvM0S8GetBufferSize(const cmsis_nn_dims* filter_dims);
+
+// Occupancy mask of the input of a ConvM0S8 call, with which the variants
+// returned by SelectConvM0S8Kernel skip the empty windows. It is built once
+// per invoke by ConvM0S8ComputeOccupancy and shared by every call on a part
+// of that input.
+struct ConvM0Occupancy {
+  // Bit (column + x) of rows[y] is set when pixel (y, x) of the input has an
+  // element other than the zero point; the rows of the next batch follow.
+  // nullptr when every window has to be computed.
+  const uint32_t* rows;
+  int column;
+  // Output of a window holding only the zero point, see ConvM0S8EmptyOutput.
+  const int8_t* empty_output;
+};
+
+// Same arguments and result as arm_convolve_s8, with the filter and bias
+// replaced by the packed weights. |occupancy| is ignored, it is only there
+// for the signature of the variants.
+arm_cmsis_nn_status ConvM0S8(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const PackedWeights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data,
+    const ConvM0Occupancy* occupancy = nullptr);
+
+// Signature shared by ConvM0S8 and its variants specialized for one layer
+// shape. |occupancy| may be nullptr, every window is then computed.
+using ConvM0S8Kernel = arm_cmsis_nn_status (*)(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const PackedWeights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data,
+    const ConvM0Occupancy* occupancy);
+
+// Returns the variant of ConvM0S8 instantiated at compile time for the filter
+// size, input and output depth and stride of the layer, with the window
+// unrolled and the padding checks hoisted out of the pixel loop, or ConvM0S8
+// itself when no variant matches or |filter| is block sparse. The variants
+// take the same scratch buffer and any input size and padding, and give the
+// same results.
+//
+// The variants also skip the zeros of sparse inputs, such as the strokes of
+// a digit: given the ConvM0Occupancy of their input, they copy its empty
+// output to every output pixel whose window is empty instead of computing
+// it.
+ConvM0S8Kernel SelectConvM0S8Kernel(const cmsis_nn_dims* filter_dims,
+                                    const cmsis_nn_tile& stride,
+                                    const cmsis_nn_tile& dilation,
+                                    const PackedWeights& filter);
+
+// Size in bytes of the occupancy mask of |input_dims| for |kernel|, one word
+// per batch and per input row, or 0 when |kernel| computes every window: it
+// is not a variant, the input is wider or taller than 32 pixels, or
+// TF_LITE_CONV_M0_SPARSE_DENSITY is 0.
+int32_t ConvM0S8GetOccupancyBufferSize(ConvM0S8Kernel kernel,
+                                       const cmsis_nn_dims* input_dims);
+
+// Builds the occupancy mask of the input_dims->n batches of |input| into
+// |buffer|, of ConvM0S8GetOccupancyBufferSize bytes. The mask of a batch is
+// only used when at most TF_LITE_CONV_M0_SPARSE_DENSITY percent of its pixels
+// are occupied.
+void ConvM0S8ComputeOccupancy(const cmsis_nn_dims* input_dims,
+                              const int8_t* input, int32_t input_offset,
+                              uint32_t* buffer);
+
+// Returns the occupancy of the part of the input of the mask in |buffer| that
+// starts at |row| and |column| of |batch|, with rows set to nullptr when the
+// batch is not sparse enough.
+ConvM0Occupancy ConvM0S8Occupancy(const uint32_t* buffer,
+                                  const cmsis_nn_dims* input_dims, int batch,
+                                  int row, int column,
+                                  const int8_t* empty_output);
+
+// Writes the filter_dims->n channels of the output of a window holding only
+// the input zero point, the bias requantized, to |output|. Computed once in
+// Prepare for the ConvM0Occupancy of the layer.
+void ConvM0S8EmptyOutput(const cmsis_nn_conv_params* conv_params,
+                         const cmsis_nn_per_channel_quant_params* quant_params,
+                         const cmsis_nn_dims* filter_dims,
+                         const PackedWeights& filter, int8_t* output);
+
+// ConvM0S8 for int4 weights, read in place from the model and unpacked in the
+// inner loop. Takes the same scratch buffer as ConvM0S8 and gives the same
+// results as reference_integer_ops::ConvPerChannel on the unpacked filter.
+arm_cmsis_nn_status ConvM0S4(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const Int4Weights& filter,
+    const cmsis_nn_dims* output_dims, int8_t* output_data);
+
+// Same arguments and result as arm_fully_connected_s8 with a zero filter
+// offset, with the filter and bias replaced by the packed weights. Needs no
+// scratch buffer.
+arm_cmsis_nn_status FullyConnectedM0S8(
+    const cmsis_nn_fc_params* fc_params,
+    const cmsis_nn_per_tensor_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const PackedWeights& filter, const cmsis_nn_dims* output_dims,
+    int8_t* output_data);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CONV_M0_H_
@@ -0,0 +1,47 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CONV_MAX_POOL_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CONV_MAX_POOL_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_common.h"
+
+namespace tflite {
+
+// Name under which the fused CONV_2D + MAX_POOL_2D kernel is registered with
+// the op resolver. The operator fusion pass only rewrites the graph when a
+// kernel with this name has been registered.
+extern const char* const kConv2DMaxPool2DOpName;
+
+// Builtin data of a fused CONV_2D + MAX_POOL_2D node. The node keeps the
+// inputs of the original CONV_2D (input, filter, optional bias) and the output
+// of the original MAX_POOL_2D. The full resolution convolution output is never
+// materialized, so its shape is carried here instead.
+struct TfLiteConvMaxPoolParams {
+  TfLiteConvParams conv;
+  TfLitePoolParams pool;
+  int conv_output_height;
+  int conv_output_width;
+};
+
+// Returns a TFLMRegistration struct for the fused kernel. Only int8
+// activations with int8 weights are supported. The result is bit-exact with
+// running CONV_2D followed by MAX_POOL_2D.
+TFLMRegistration* Register_CONV_2D_MAX_POOL_2D();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CONV_MAX_POOL_H_
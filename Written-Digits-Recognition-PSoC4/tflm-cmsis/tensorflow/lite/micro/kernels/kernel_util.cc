@@ -50,7 +50,21 @@ TFLMRegistration RegisterOp(
           /*invoke=*/invoke,
           /*reset*/ reset,
           /*builtin_code=*/0,
-          /*custom_name=*/nullptr};
+          /*custom_name=*/nullptr,
+          /*invoke_without_temp_allocations=*/false,
+          /*invoke_step=*/nullptr};
+}
+
+TFLMRegistration RegisterOpWithoutTempAllocations(
+    void* (*init)(TfLiteContext* context, const char* buffer, size_t length),
+    TfLiteStatus (*prepare)(TfLiteContext* context, TfLiteNode* node),
+    TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node),
+    void (*free)(TfLiteContext* context, void* buffer),
+    void (*reset)(TfLiteContext* context, void* buffer)) {
+  TFLMRegistration registration =
+      RegisterOp(init, prepare, invoke, free, reset);
+  registration.invoke_without_temp_allocations = true;
+  return registration;
 }
 
 // Returns a mutable tensor for a given input index. is_variable must be checked
@@ -35,6 +35,15 @@ TFLMRegistration RegisterOp(
     void (*free)(TfLiteContext* context, void* buffer) = nullptr,
     void (*reset)(TfLiteContext* context, void* buffer) = nullptr);
 
+// Same as RegisterOp, for kernels whose invoke does not allocate any temp
+// tensor (see TFLMRegistration::invoke_without_temp_allocations).
+TFLMRegistration RegisterOpWithoutTempAllocations(
+    void* (*init)(TfLiteContext* context, const char* buffer, size_t length),
+    TfLiteStatus (*prepare)(TfLiteContext* context, TfLiteNode* node),
+    TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node),
+    void (*free)(TfLiteContext* context, void* buffer) = nullptr,
+    void (*reset)(TfLiteContext* context, void* buffer) = nullptr);
+
 // Prints out n bytes in a int8_t buffer as hex
 void PrintNBytes(const int8_t* tensor_data, int n_bytes,
                  const char* prefix = nullptr);
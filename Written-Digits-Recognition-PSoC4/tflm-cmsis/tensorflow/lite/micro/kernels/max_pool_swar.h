@@ -0,0 +1,76 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_MAX_POOL_SWAR_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_MAX_POOL_SWAR_H_
+
+#include <cstdint>
+
+#include "Include/arm_nnfunctions.h"
+
+namespace tflite {
+
+// int8 max pooling for cores without MVE, where arm_max_pool_s8 compares the
+// channels one byte at a time and clamps the output in a second pass.
+// MaxPoolSwarS8 handles four channels per 32-bit word with the lane-wise
+// signed max below, keeps the word in a register over the whole pooling
+// window and clamps it before storing. Its result is bit-exact with
+// arm_max_pool_s8.
+#if !defined(ARM_MATH_MVEI)
+constexpr bool kMaxPoolSwarEnabled = true;
+#else
+constexpr bool kMaxPoolSwarEnabled = false;
+#endif
+
+// 0xff in the bytes where the signed int8 lane of |a| is lower than the one
+// of |b|, 0x00 elsewhere. With the lanes biased to unsigned, x = a ^ 0x80 and
+// y = b ^ 0x80, x < y exactly when ~x + y carries out of the byte. That carry
+// is the top bit of the lane-wise average (~x & y) + ((~x ^ y) >> 1), which
+// cannot overflow into the next lane.
+inline uint32_t LessThanS8x4(uint32_t a, uint32_t b) {
+  const uint32_t average = ((a ^ 0x7f7f7f7fu) & (b ^ 0x80808080u)) +
+                           ((~(a ^ b) & 0xfefefefeu) >> 1);
+  const uint32_t less = average & 0x80808080u;
+  return (less - (less >> 7)) | less;
+}
+
+// Lane-wise signed maximum of four int8 values.
+inline uint32_t MaxS8x4(uint32_t a, uint32_t b) {
+  return a ^ ((a ^ b) & LessThanS8x4(a, b));
+}
+
+// Lane-wise signed minimum of four int8 values.
+inline uint32_t MinS8x4(uint32_t a, uint32_t b) {
+  return b ^ ((a ^ b) & LessThanS8x4(a, b));
+}
+
+// |value| repeated in the four lanes of a word.
+inline uint32_t BroadcastS8x4(int32_t value) {
+  return (static_cast<uint32_t>(value) & 0xffu) * 0x01010101u;
+}
+
+// Same arguments and result as arm_max_pool_s8. The word path is taken when
+// the depth is a multiple of four and |src| and |dst| are word aligned; other
+// cases fall back to the same loop one channel at a time.
+arm_cmsis_nn_status MaxPoolSwarS8(const cmsis_nn_context* ctx,
+                                  const cmsis_nn_pool_params* pool_params,
+                                  const cmsis_nn_dims* input_dims,
+                                  const int8_t* src,
+                                  const cmsis_nn_dims* filter_dims,
+                                  const cmsis_nn_dims* output_dims,
+                                  int8_t* dst);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_MAX_POOL_SWAR_H_
@@ -0,0 +1,201 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_context.h"
+
+namespace tflite {
+namespace {
+
+// Output channels per group of interleaved weights.
+constexpr int kChannelBlock = 4;
+
+constexpr uint32_t kFnvOffsetBasis = 2166136261u;
+constexpr uint32_t kFnvPrime = 16777619u;
+
+int ChannelGroups(int output_depth) {
+  return (output_depth + kChannelBlock - 1) / kChannelBlock;
+}
+
+uint32_t HashWord(uint32_t hash, int32_t value) {
+  const uint32_t word = static_cast<uint32_t>(value);
+  for (int byte = 0; byte < 4; ++byte) {
+    hash = (hash ^ ((word >> (byte * 8)) & 0xff)) * kFnvPrime;
+  }
+  return hash;
+}
+
+}  // namespace
+
+int PackedWeightsBufferSize(int output_depth, int depth) {
+  const int groups = ChannelGroups(output_depth);
+  return groups * (depth * 2 + kChannelBlock) * sizeof(int32_t);
+}
+
+void PackWeights(const int8_t* weights, const int32_t* bias, int output_depth,
+                 int depth, int32_t input_offset, void* buffer,
+                 PackedWeights* packed) {
+  const int groups = ChannelGroups(output_depth);
+  int32_t* packed_weights = static_cast<int32_t*>(buffer);
+  int32_t* folded_bias = packed_weights + groups * depth * 2;
+
+  for (int group = 0; group < groups; ++group) {
+    const int channel = group * kChannelBlock;
+    int32_t* out = packed_weights + group * depth * 2;
+    int32_t sums[kChannelBlock] = {0, 0, 0, 0};
+    for (int i = 0; i < depth; ++i) {
+      int32_t w[kChannelBlock];
+      for (int c = 0; c < kChannelBlock; ++c) {
+        w[c] = channel + c < output_depth ? weights[(channel + c) * depth + i]
+                                          : 0;
+        sums[c] += w[c];
+      }
+      *out++ = static_cast<int32_t>(static_cast<uint16_t>(w[0]) |
+                                    (static_cast<uint32_t>(w[1]) << 16));
+      *out++ = static_cast<int32_t>(static_cast<uint16_t>(w[2]) |
+                                    (static_cast<uint32_t>(w[3]) << 16));
+    }
+    for (int c = 0; c < kChannelBlock; ++c) {
+      const int32_t b =
+          bias != nullptr && channel + c < output_depth ? bias[channel + c] : 0;
+      folded_bias[channel + c] = b + input_offset * sums[c];
+    }
+  }
+
+  packed->weights = packed_weights;
+  packed->bias = folded_bias;
+  packed->block_map = nullptr;
+}
+
+uint32_t PackedWeightsChecksum(const int8_t* weights, const int32_t* bias,
+                               int output_depth, int depth,
+                               int32_t input_zero_point) {
+  uint32_t hash = kFnvOffsetBasis;
+  const int size = output_depth * depth;
+  for (int i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(weights[i])) * kFnvPrime;
+  }
+  if (bias != nullptr) {
+    for (int i = 0; i < output_depth; ++i) {
+      hash = HashWord(hash, bias[i]);
+    }
+  }
+  return HashWord(hash, input_zero_point);
+}
+
+TfLiteStatus PreparePackedWeights(TfLiteContext* context,
+                                  const TfLiteTensor* filter,
+                                  const TfLiteTensor* bias,
+                                  int32_t input_zero_point,
+                                  PackedWeights* packed) {
+  TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+  TF_LITE_ENSURE_MSG(context, IsConstantTensor(filter),
+                     "Packed weights need a constant filter.");
+  if (bias != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, bias->type, kTfLiteInt32);
+  }
+
+  const int output_depth = filter->dims->data[0];
+  int depth = 1;
+  for (int i = 1; i < filter->dims->size; ++i) {
+    depth *= filter->dims->data[i];
+  }
+  const int8_t* weights = GetTensorData<int8_t>(filter);
+  const int32_t* bias_data =
+      bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr;
+  const int buffer_size = PackedWeightsBufferSize(output_depth, depth);
+
+  const PackedWeightsTable* table = GetMicroContext(context)->packed_weights();
+  if (table != nullptr) {
+    const uint32_t checksum = PackedWeightsChecksum(
+        weights, bias_data, output_depth, depth, input_zero_point);
+    for (int i = 0; i < table->count; ++i) {
+      const PackedWeightsEntry& entry = table->entries[i];
+      if (entry.checksum == checksum && entry.output_depth == output_depth &&
+          entry.depth == depth) {
+        const int weight_words =
+            entry.block_map != nullptr
+                ? entry.blocks * 2
+                : ChannelGroups(output_depth) * depth * 2;
+        packed->weights = entry.data;
+        packed->bias = entry.data + weight_words;
+        packed->block_map = entry.block_map;
+        return kTfLiteOk;
+      }
+    }
+  }
+
+  packed->weights = nullptr;
+  packed->bias = nullptr;
+  packed->block_map = nullptr;
+  if (buffer_size > TF_LITE_PACKED_WEIGHTS_ARENA_LIMIT) {
+    return kTfLiteOk;
+  }
+  void* buffer = context->AllocatePersistentBuffer(context, buffer_size);
+  TF_LITE_ENSURE(context, buffer != nullptr);
+  PackWeights(weights, bias_data, output_depth, depth, -input_zero_point,
+              buffer, packed);
+  return kTfLiteOk;
+}
+
+TfLiteStatus PrepareInt4Weights(TfLiteContext* context,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* bias,
+                                int32_t input_zero_point,
+                                Int4Weights* weights) {
+  TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt4);
+  TF_LITE_ENSURE_MSG(context, IsConstantTensor(filter),
+                     "int4 weights need a constant filter.");
+  if (bias != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, bias->type, kTfLiteInt32);
+  }
+
+  const int output_depth = filter->dims->data[0];
+  int depth = 1;
+  for (int i = 1; i < filter->dims->size; ++i) {
+    depth *= filter->dims->data[i];
+  }
+  const uint8_t* data = GetTensorData<uint8_t>(filter);
+  const int32_t* bias_data =
+      bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr;
+
+  const int channels = ChannelGroups(output_depth) * kChannelBlock;
+  int32_t* folded_bias = static_cast<int32_t*>(
+      context->AllocatePersistentBuffer(context, channels * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, folded_bias != nullptr);
+  for (int channel = 0; channel < channels; ++channel) {
+    if (channel >= output_depth) {
+      folded_bias[channel] = 0;
+      continue;
+    }
+    int32_t sum = 0;
+    for (int i = 0; i < depth; ++i) {
+      sum += Int4WeightAt(data, channel * depth + i);
+    }
+    const int32_t b = bias_data != nullptr ? bias_data[channel] : 0;
+    folded_bias[channel] = b - input_zero_point * sum;
+  }
+
+  weights->weights = data;
+  weights->bias = folded_bias;
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,150 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+// Largest packed weights buffer, in bytes, that PreparePackedWeights allocates
+// from the arena when the weights are not found in the packed weights table.
+// Larger weights are left unpacked and the kernel uses its generic path.
+#ifndef TF_LITE_PACKED_WEIGHTS_ARENA_LIMIT
+#define TF_LITE_PACKED_WEIGHTS_ARENA_LIMIT 512
+#endif
+
+namespace tflite {
+
+// int8 weights of a CONV_2D or FULLY_CONNECTED repacked for kernels whose
+// inner loop computes four output channels at a time (e.g. ConvM0S8):
+//
+// - the output channels are taken four at a time; their weights are
+//   interleaved and pre-widened to int16, two per word: {w0, w1}, {w2, w3}
+//   for every element of the filter. Thumb-1 loads the pair with one LDR
+//   and splits it with SXTH / ASRS.
+// - the input offset is folded into the bias: bias + input_offset * sum(w),
+//   so the inner loop multiplies the raw int8 input.
+// - the output depth is rounded up to a multiple of four with zero weights.
+//
+// The weights are either packed at Prepare time into a persistent buffer, or
+// packed offline (tools/pack_weights.py) into a PackedWeightsTable in flash
+// that is handed to the interpreter with MicroInterpreter::SetPackedWeights.
+//
+// Weights packed offline can also be block sparse, for pruned layers: the
+// 1x4 blocks of a group (the four weights of one input element, two words)
+// that are all zero are left out, and a bitmap per group tells which input
+// elements have a block. The kernels skip the missing blocks, so both the
+// flash and the MACs drop with the share of zero blocks.
+struct PackedWeights {
+  // ceil(output_depth / 4) groups of depth x 2 words, or of 2 words per
+  // block present when block sparse.
+  const int32_t* weights;
+  // ceil(output_depth / 4) * 4 biases with the input offset folded in.
+  const int32_t* bias;
+  // nullptr for dense weights. Otherwise ceil(output_depth / 4) groups of
+  // PackedWeightsBlockMapWords(depth) words: bit i % 32 of word i / 32 is set
+  // when the block of input element i is present.
+  const uint32_t* block_map;
+};
+
+// Words of the block sparse bitmap of one group of |depth| input elements.
+inline int PackedWeightsBlockMapWords(int depth) { return (depth + 31) / 32; }
+
+// Weights packed offline. |data| holds the layout written by PackWeights, the
+// weights followed by the biases, with only the blocks present in
+// |block_map| when it is not nullptr.
+struct PackedWeightsEntry {
+  // PackedWeightsChecksum of the weights, bias and input zero point the entry
+  // was packed from.
+  uint32_t checksum;
+  int32_t output_depth;
+  int32_t depth;
+  const int32_t* data;
+  // Bitmap of the blocks of block sparse weights, nullptr for dense ones.
+  const uint32_t* block_map;
+  // Number of blocks present in |block_map|.
+  int32_t blocks;
+};
+
+struct PackedWeightsTable {
+  const PackedWeightsEntry* entries;
+  int count;
+};
+
+// Size in bytes of the packed weights and biases of |output_depth| channels
+// with |depth| (height * width * input depth) elements each.
+int PackedWeightsBufferSize(int output_depth, int depth);
+
+// Packs the int8 |weights| of |output_depth| x |depth| elements and their
+// optional |bias| into |buffer|, which has to hold PackedWeightsBufferSize
+// bytes and be word aligned.
+void PackWeights(const int8_t* weights, const int32_t* bias, int output_depth,
+                 int depth, int32_t input_offset, void* buffer,
+                 PackedWeights* packed);
+
+// FNV-1a hash of the weights, the bias (as little endian words, none if
+// nullptr) and the input zero point, which identifies the packed weights
+// independently of where the model is stored.
+uint32_t PackedWeightsChecksum(const int8_t* weights, const int32_t* bias,
+                               int output_depth, int depth,
+                               int32_t input_zero_point);
+
+// Packs the constant int8 |filter| (output depth first) and the optional int32
+// |bias| of a layer whose input has |input_zero_point|. The packed weights
+// are taken from the table set on the interpreter if it has an entry for
+// them, otherwise they are packed into a persistent buffer if it fits
+// TF_LITE_PACKED_WEIGHTS_ARENA_LIMIT. If neither applies, packed->weights is
+// set to nullptr and the kernel has to use the unpacked weights.
+TfLiteStatus PreparePackedWeights(TfLiteContext* context,
+                                  const TfLiteTensor* filter,
+                                  const TfLiteTensor* bias,
+                                  int32_t input_zero_point,
+                                  PackedWeights* packed);
+
+// int4 weights for kernels that unpack the nibbles in their inner loop (e.g.
+// ConvM0S4). The weights are not repacked: they are read in place in the
+// TFLite int4 layout, two elements per byte with the low nibble first, so
+// they take half the flash of int8 weights and no arena. Only the biases,
+// with the input offset folded in as for PackedWeights, are computed at
+// Prepare time.
+struct Int4Weights {
+  // output_depth x depth int4 elements, output depth first.
+  const uint8_t* weights;
+  // ceil(output_depth / 4) * 4 biases with the input offset folded in, zero
+  // past output_depth.
+  const int32_t* bias;
+};
+
+// Returns the int4 element |index| of the packed |weights|.
+inline int32_t Int4WeightAt(const uint8_t* weights, int index) {
+  const uint32_t byte = weights[index >> 1];
+  const uint32_t nibble = (index & 1) != 0 ? byte >> 4 : byte & 0xf;
+  return static_cast<int32_t>(nibble << 28) >> 28;
+}
+
+// Sets up |weights| for the constant int4 |filter| (output depth first) and
+// the optional int32 |bias| of a layer whose input has |input_zero_point|.
+// The folded biases take ceil(output_depth / 4) * 4 words of persistent
+// arena.
+TfLiteStatus PrepareInt4Weights(TfLiteContext* context,
+                                const TfLiteTensor* filter,
+                                const TfLiteTensor* bias,
+                                int32_t input_zero_point,
+                                Int4Weights* weights);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
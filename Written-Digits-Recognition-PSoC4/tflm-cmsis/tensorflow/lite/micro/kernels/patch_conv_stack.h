@@ -0,0 +1,70 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_PATCH_CONV_STACK_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_PATCH_CONV_STACK_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_common.h"
+
+namespace tflite {
+
+// Name under which the patch based CONV_2D / MAX_POOL_2D stack is registered
+// with the op resolver.
+extern const char* const kPatchConvStackOpName;
+
+enum TfLitePatchLayerType {
+  kTfLitePatchLayerConv2D,
+  kTfLitePatchLayerMaxPool2D,
+};
+
+// One layer of a patch based stack. Tensors are referenced by their index in
+// the subgraph; the bias index is -1 when the convolution has no bias. The
+// output shape is recorded here because the intermediate tensors of the stack
+// are not part of the memory plan and no longer carry it.
+struct TfLitePatchLayer {
+  TfLitePatchLayerType type;
+  TfLiteConvParams conv;
+  TfLitePoolParams pool;
+  int input_tensor;
+  int filter_tensor;
+  int bias_tensor;
+  int output_tensor;
+  int output_height;
+  int output_width;
+  int output_depth;
+};
+
+// Builtin data of a patch based stack node. The node reads the input of the
+// first layer and writes the output of the last one. The stack output is
+// produced in tiles of tile_height x tile_width; each tile is computed from
+// the part of the stack input in its receptive field, so the intermediate
+// tensors only ever exist one tile at a time.
+struct TfLitePatchStackParams {
+  int num_layers;
+  int tile_height;
+  int tile_width;
+  const TfLitePatchLayer* layers;
+};
+
+// Returns a TFLMRegistration struct for the patch based stack. Only int8
+// activations are supported, with int8 weights, or int4 weights on cores
+// that use ConvM0S4. The result is bit-exact with running the layers one
+// after the other.
+TFLMRegistration* Register_PATCH_CONV_STACK();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_PATCH_CONV_STACK_H_
@@ -34,8 +34,8 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
 }  // namespace
 
 TFLMRegistration Register_QUANTIZE() {
-  return tflite::micro::RegisterOp(Init, PrepareQuantizeReference,
-                                   EvalQuantizeReference);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      Init, PrepareQuantizeReference, EvalQuantizeReference);
 }
 
 }  // namespace tflite
@@ -42,6 +42,11 @@ TfLiteStatus PrepareMeanOrSum(TfLiteContext* context, TfLiteNode* node) {
                                 static_cast<OpDataReduce*>(node->user_data));
 }
 
+TfLiteStatus PrepareMean(TfLiteContext* context, TfLiteNode* node) {
+  return PrepareMeanHelper(context, node,
+                           static_cast<OpDataReduce*>(node->user_data));
+}
+
 TfLiteStatus EvalMean(TfLiteContext* context, TfLiteNode* node) {
   return EvalMeanHelper(context, node,
                         static_cast<OpDataReduce*>(node->user_data));
@@ -58,15 +63,18 @@ TfLiteStatus EvalSum(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TFLMRegistration Register_MEAN() {
-  return tflite::micro::RegisterOp(InitReduce, PrepareMeanOrSum, EvalMean);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      InitReduce, PrepareMean, EvalMean);
 }
 
 TFLMRegistration Register_REDUCE_MAX() {
-  return tflite::micro::RegisterOp(InitReduce, PrepareMax, EvalMax);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      InitReduce, PrepareMax, EvalMax);
 }
 
 TFLMRegistration Register_SUM() {
-  return tflite::micro::RegisterOp(InitReduce, PrepareMeanOrSum, EvalSum);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      InitReduce, PrepareMeanOrSum, EvalSum);
 }
 
 }  // namespace tflite
@@ -38,6 +38,10 @@ struct OpDataReduce {
   float output_scale;
   int num_output_elements;
   int num_axis;
+  // Set by PrepareMeanHelper for an int8 mean over the spatial axes of a 4D
+  // tensor, which runs on SpatialMeanS8 with no scratch buffer. The division
+  // by the number of pixels is then folded into |multiplier| and |shift|.
+  bool spatial_mean;
 };
 
 TfLiteStatus PrepareMaxHelper(TfLiteContext* context, TfLiteNode* node,
@@ -46,6 +50,9 @@ TfLiteStatus PrepareMaxHelper(TfLiteContext* context, TfLiteNode* node,
 TfLiteStatus PrepareMeanOrSumHelper(TfLiteContext* context, TfLiteNode* node,
                                     OpDataReduce* op_data);
 
+TfLiteStatus PrepareMeanHelper(TfLiteContext* context, TfLiteNode* node,
+                               OpDataReduce* op_data);
+
 TfLiteStatus EvalMaxHelper(TfLiteContext* context, TfLiteNode* node,
                            OpDataReduce* op_data);
 TfLiteStatus EvalMeanHelper(TfLiteContext* context, TfLiteNode* node,
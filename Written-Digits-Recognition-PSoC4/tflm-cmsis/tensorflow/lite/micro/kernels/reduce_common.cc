@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/reduce.h"
+#include "tensorflow/lite/micro/kernels/spatial_mean.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
@@ -92,6 +93,7 @@ TfLiteStatus PrepareMaxHelper(TfLiteContext* context, TfLiteNode* node,
 
 TfLiteStatus PrepareMeanOrSumHelper(TfLiteContext* context, TfLiteNode* node,
                                     OpDataReduce* op_data) {
+  op_data->spatial_mean = false;
   MicroContext* micro_context = GetMicroContext(context);
   TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
   TfLiteTensor* output = micro_context->AllocateTempOutputTensor(node, 0);
@@ -124,6 +126,54 @@ TfLiteStatus PrepareMeanOrSumHelper(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+// Whether |axis| holds exactly axes 1 and 2, in either order.
+bool IsSpatialAxes(const TfLiteTensor* axis) {
+  if (axis->data.data == nullptr || NumElements(axis) != 2) {
+    return false;
+  }
+  const int32_t* axis_data = GetTensorData<int32_t>(axis);
+  return (axis_data[0] == 1 && axis_data[1] == 2) ||
+         (axis_data[0] == 2 && axis_data[1] == 1);
+}
+
+TfLiteStatus PrepareMeanHelper(TfLiteContext* context, TfLiteNode* node,
+                               OpDataReduce* op_data) {
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
+  TfLiteTensor* output = micro_context->AllocateTempOutputTensor(node, 0);
+  TfLiteTensor* axis = micro_context->AllocateTempInputTensor(node, 1);
+  TF_LITE_ENSURE(context, axis != nullptr);
+  const bool spatial_mean = input->type == kTfLiteInt8 &&
+                            NumDimensions(input) == 4 &&
+                            axis->type == kTfLiteInt32 &&
+                            IsConstantTensor(axis) && IsSpatialAxes(axis);
+  if (spatial_mean) {
+    TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, NumElements(output),
+                      SizeOfDimension(input, 0) * SizeOfDimension(input, 3));
+    int32_t multiplier;
+    int shift;
+    QuantizeMultiplier(static_cast<double>(input->params.scale) /
+                           static_cast<double>(output->params.scale),
+                       &multiplier, &shift);
+    SpatialMeanMultiplier(multiplier, shift,
+                          SizeOfDimension(input, 1) * SizeOfDimension(input, 2),
+                          &op_data->multiplier, &op_data->shift);
+    op_data->input_zp = input->params.zero_point;
+    op_data->output_zp = output->params.zero_point;
+    op_data->num_axis = 2;
+  }
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  micro_context->DeallocateTempTfLiteTensor(axis);
+
+  if (!spatial_mean) {
+    return PrepareMeanOrSumHelper(context, node, op_data);
+  }
+  op_data->spatial_mean = true;
+  return kTfLiteOk;
+}
+
 void ResolveAxis(const int* axis_data, int axis_count,
                  tflite::MeanParams* op_params) {
   int i = 0;
@@ -217,6 +267,20 @@ TfLiteStatus EvalMeanHelper(TfLiteContext* context, TfLiteNode* node,
       }
     } break;
     case kTfLiteInt8: {
+      if (op_data->spatial_mean) {
+        SpatialMeanParams mean_params;
+        mean_params.input_zero_point = op_data->input_zp;
+        mean_params.output_zero_point = op_data->output_zp;
+        mean_params.multiplier = op_data->multiplier;
+        mean_params.shift = op_data->shift;
+        const cmsis_nn_dims input_dims = {
+            input->dims->data[0], input->dims->data[1], input->dims->data[2],
+            input->dims->data[3]};
+        SpatialMeanS8(mean_params, input_dims,
+                      tflite::micro::GetTensorData<int8_t>(input),
+                      tflite::micro::GetTensorData<int8_t>(output));
+        break;
+      }
       TF_LITE_ENSURE_OK(
           context, EvalIntegerMean<int8_t>(context, node, num_axis, op_data,
                                            temp_index, resolved_axis));
@@ -0,0 +1,95 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_M0_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_M0_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+// 1 to requantize the outputs of the Cortex-M0+ kernels with 32-bit
+// arithmetic only, see MultiplyByQuantizedMultiplier32. 0 uses
+// MultiplyByQuantizedMultiplier. Both give the same results.
+#ifndef TF_LITE_REQUANTIZE_32BIT
+#define TF_LITE_REQUANTIZE_32BIT 1
+#endif
+
+namespace tflite {
+
+// MultiplyByQuantizedMultiplier with the double rounding of
+// SaturatingRoundingDoublingHighMul and RoundingDivideByPOT, without a 64-bit
+// product. The Cortex-M0+ only multiplies 32 x 32 -> 32 bits, so the 64-bit
+// product of the reference is a call to the runtime library (__aeabi_lmul)
+// followed by 64-bit adds and shifts. Here the magnitude of the scaled input
+// and the multiplier are split in 16-bit halves, whose four products fit in
+// 32 bits, and only the bits of the 64-bit product the rounding needs are
+// put together. Both roundings are symmetric about zero, so the sign is
+// applied at the end.
+//
+// Bit-exact with the reference for every int32 |x| and non-negative
+// |quantized_multiplier| whose scaled input x * 2^max(shift, 0) fits in
+// int32, as the reference requires. tests/requantize_m0_test.cpp checks it
+// over every shift from -31 to 7 and the whole multiplier range.
+inline int32_t MultiplyByQuantizedMultiplier32(int32_t x,
+                                               int32_t quantized_multiplier,
+                                               int shift) {
+  const int left_shift = shift > 0 ? shift : 0;
+  const int right_shift = shift > 0 ? 0 : -shift;
+  const uint32_t scaled = static_cast<uint32_t>(x) << left_shift;
+  const bool negative = static_cast<int32_t>(scaled) < 0;
+  const uint32_t a = negative ? 0u - scaled : scaled;
+  const uint32_t b = static_cast<uint32_t>(quantized_multiplier);
+  const uint32_t a_low = a & 0xffffu;
+  const uint32_t a_high = a >> 16;
+  const uint32_t b_low = b & 0xffffu;
+  const uint32_t b_high = b >> 16;
+  const uint32_t low = a_low * b_low;
+  const uint32_t mid0 = a_high * b_low;
+  const uint32_t mid1 = a_low * b_high;
+  const uint32_t high = a_high * b_high;
+  // The nudge of SaturatingRoundingDoublingHighMul rounds a negative product
+  // half towards zero, which on the magnitude is a nudge of 2^30 - 1.
+  const uint32_t nudge = negative ? (1u << 30) - 1 : 1u << 30;
+  // Bits 16 to 31 of a * b + nudge, with the carry into bit 32 above them.
+  const uint32_t middle = (low >> 16) + (nudge >> 16) +
+                          (((low & 0xffffu) + (nudge & 0xffffu)) >> 16) +
+                          (mid0 & 0xffffu) + (mid1 & 0xffffu);
+  // Bits 32 to 62.
+  const uint32_t top = high + (mid0 >> 16) + (mid1 >> 16) + (middle >> 16);
+  // (a * b + nudge) >> 31, then RoundingDivideByPOT, half away from zero.
+  uint32_t result = (top << 1) | ((middle >> 15) & 1u);
+  if (right_shift > 0) {
+    result = (result + (1u << (right_shift - 1))) >> right_shift;
+  }
+  return negative ? -static_cast<int32_t>(result)
+                  : static_cast<int32_t>(result);
+}
+
+// The requantization of the Cortex-M0+ kernels, selected by
+// TF_LITE_REQUANTIZE_32BIT. Builds with TFLITE_SINGLE_ROUNDING use the
+// reference.
+inline int32_t RequantizeM0(int32_t x, int32_t quantized_multiplier,
+                            int shift) {
+#if TF_LITE_REQUANTIZE_32BIT && !TFLITE_SINGLE_ROUNDING
+  return MultiplyByQuantizedMultiplier32(x, quantized_multiplier, shift);
+#else
+  return MultiplyByQuantizedMultiplier(x, quantized_multiplier, shift);
+#endif
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_M0_H_
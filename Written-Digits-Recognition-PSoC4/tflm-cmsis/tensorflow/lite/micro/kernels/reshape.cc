@@ -54,8 +54,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace reshape
 
 TFLMRegistration Register_RESHAPE() {
-  return tflite::micro::RegisterOp(nullptr, reshape::PrepareReshapeReference,
-                                   reshape::Eval);
+  return tflite::micro::RegisterOpWithoutTempAllocations(
+      nullptr, reshape::PrepareReshapeReference, reshape::Eval);
 }
 
 }  // namespace micro
@@ -0,0 +1,55 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_SPATIAL_MEAN_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_SPATIAL_MEAN_H_
+
+#include <cstdint>
+
+#include "Include/arm_nn_types.h"
+
+namespace tflite {
+
+// Requantization of an int8 mean over the height and width of an NHWC
+// tensor. The division by the number of pixels is folded into the multiplier,
+// see SpatialMeanMultiplier.
+struct SpatialMeanParams {
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t multiplier;
+  int shift;
+};
+
+// Folds the division by |num_pixels| into the input to output |multiplier|
+// and |shift|, the way reference_ops::QuantizedMeanOrSum does it.
+void SpatialMeanMultiplier(int32_t multiplier, int shift, int32_t num_pixels,
+                           int32_t* mean_multiplier, int* mean_shift);
+
+// int8 MEAN over axes 1 and 2 of an NHWC tensor, the global average pooling
+// of a classifier. |output| holds n x c values, which is the layout of both
+// keep_dims forms. The generic reduction walks the tensor with multi-axis
+// index arithmetic and sums into an int32 scratch buffer. Here each group of
+// four channels is summed over all pixels in two registers, as 16-bit lanes
+// of the values biased to unsigned, and requantized once per channel. The
+// result is bit-exact with reference_ops::QuantizedMeanOrSum. The word path is
+// taken when the depth is a multiple of four and |input| is word aligned;
+// other cases sum one channel at a time.
+void SpatialMeanS8(const SpatialMeanParams& params,
+                   const cmsis_nn_dims& input_dims, const int8_t* input,
+                   int8_t* output);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_SPATIAL_MEAN_H_
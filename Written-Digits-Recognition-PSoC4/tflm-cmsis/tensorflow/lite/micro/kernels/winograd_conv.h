@@ -0,0 +1,90 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
+
+#include <cstdint>
+
+#include "Include/arm_nnfunctions.h"
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// int8 3x3 stride 1 convolution with the Winograd F(2x2, 3x3) algorithm: each
+// 2x2 block of outputs is computed from a 4x4 input tile with 16 multiplies
+// per input and output channel instead of 36.
+//
+// Everything stays in integers. The filter transform G g G^T has halves in
+// it, so the filters are transformed offline with 2G instead
+// (tools/winograd_filters.py), which gives int16 filters four times too
+// large. The input transform B^T d B of the tile, with the input offset
+// applied, fits int16 as well, and the products are accumulated in int32.
+// After the output transform the accumulators hold exactly four times those
+// of the direct convolution, so the division by four is exact and the results
+// are bit-exact with reference_integer_ops::ConvPerChannel.
+//
+// The layers to run this way are picked offline: the conv kernel variant
+// returned by Register_CONV_2D_WINOGRAD uses it for the layers whose filter is
+// in the WinogradFilterTable set with MicroInterpreter::SetWinogradFilters,
+// and the regular path for the others.
+
+// Number of elements of a 4x4 input tile and of a transformed filter.
+constexpr int kWinogradTileSize = 16;
+
+// Largest input depth for which the int32 accumulators cannot overflow: the
+// transformed filters are at most 9 * 127 = 1143 in magnitude, the
+// transformed inputs 4 * 255 = 1020, and the output transform adds up to 9
+// accumulators.
+constexpr int kWinogradMaxInputDepth = 204;
+
+// Filter transformed offline, int16 in [output channel][tile element][input
+// channel] order, i.e. output_depth * 16 * depth values.
+struct WinogradFilterEntry {
+  // PackedWeightsChecksum of the weights, bias and input zero point of the
+  // layer.
+  uint32_t checksum;
+  int32_t output_depth;
+  int32_t depth;
+  const int16_t* data;
+};
+
+struct WinogradFilterTable {
+  const WinogradFilterEntry* entries;
+  int count;
+};
+
+// Returns the transformed filter of the constant int8 3x3 |filter| from the
+// table set on the interpreter, or nullptr if it has none.
+const int16_t* FindWinogradFilter(TfLiteContext* context,
+                                  const TfLiteTensor* filter,
+                                  const TfLiteTensor* bias,
+                                  int32_t input_zero_point);
+
+// Size in bytes of the scratch buffer WinogradConvS8 expects in ctx->buf.
+int32_t WinogradConvS8GetBufferSize(const cmsis_nn_dims* filter_dims);
+
+// Same arguments and result as arm_convolve_s8 for a 3x3 filter with stride
+// and dilation 1, with the filter replaced by its transform.
+arm_cmsis_nn_status WinogradConvS8(
+    const cmsis_nn_context* ctx, const cmsis_nn_conv_params* conv_params,
+    const cmsis_nn_per_channel_quant_params* quant_params,
+    const cmsis_nn_dims* input_dims, const int8_t* input_data,
+    const cmsis_nn_dims* filter_dims, const int16_t* filter_data,
+    const cmsis_nn_dims* bias_dims, const int32_t* bias_data,
+    const cmsis_nn_dims* output_dims, int8_t* output_data);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
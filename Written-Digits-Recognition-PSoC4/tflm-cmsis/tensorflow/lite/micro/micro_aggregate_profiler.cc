@@ -0,0 +1,202 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_aggregate_profiler.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+namespace {
+
+// Handle of the events that are not counted.
+constexpr uint32_t kDroppedEvent = std::numeric_limits<uint32_t>::max();
+
+constexpr uint8_t kSummaryRecord = 0;
+constexpr uint8_t kTagRecord = 1;
+constexpr uint8_t kRecordVersion = 1;
+
+int BitLength(uint32_t value) {
+  int length = 0;
+  while (value != 0) {
+    value >>= 1;
+    ++length;
+  }
+  return length;
+}
+
+uint8_t* WriteLittleEndian(uint64_t value, int bytes, uint8_t* out) {
+  for (int i = 0; i < bytes; ++i) {
+    *out++ = static_cast<uint8_t>(value >> (8 * i));
+  }
+  return out;
+}
+
+}  // namespace
+
+int MicroAggregateProfiler::FindOrAddTag(const char* tag, uint8_t parent) {
+  for (int i = 0; i < num_tags_; ++i) {
+    if (tags_[i].parent == parent &&
+        (tags_[i].tag == tag || strcmp(tags_[i].tag, tag) == 0)) {
+      return i;
+    }
+  }
+  if (num_tags_ == kMaxTags) {
+    return -1;
+  }
+  TagStats& stats = tags_[num_tags_];
+  memset(&stats, 0, sizeof(stats));
+  stats.tag = tag;
+  stats.parent = parent;
+  stats.min_ticks = std::numeric_limits<uint32_t>::max();
+  return num_tags_++;
+}
+
+uint32_t MicroAggregateProfiler::BeginEvent(const char* tag) {
+  const uint8_t parent =
+      num_open_events_ > 0 ? open_events_[num_open_events_ - 1].tag_index
+                           : kNoParent;
+  const int tag_index =
+      num_open_events_ < kMaxOpenEvents ? FindOrAddTag(tag, parent) : -1;
+  if (tag_index < 0) {
+    ++dropped_events_;
+    return kDroppedEvent;
+  }
+  OpenEvent& event = open_events_[num_open_events_];
+  event.tag_index = static_cast<uint8_t>(tag_index);
+  event.start_ticks = GetCurrentTimeTicks();
+  return num_open_events_++;
+}
+
+void MicroAggregateProfiler::EndEvent(uint32_t event_handle) {
+  const uint32_t end_ticks = GetCurrentTimeTicks();
+  if (event_handle >= static_cast<uint32_t>(num_open_events_)) {
+    return;
+  }
+  const OpenEvent& event = open_events_[event_handle];
+  num_open_events_ = event_handle;
+
+  const uint32_t ticks = end_ticks - event.start_ticks;
+  TagStats& stats = tags_[event.tag_index];
+  ++stats.count;
+  if (ticks < stats.min_ticks) {
+    stats.min_ticks = ticks;
+  }
+  if (ticks > stats.max_ticks) {
+    stats.max_ticks = ticks;
+  }
+  stats.sum_ticks += ticks;
+  const uint64_t squared = static_cast<uint64_t>(ticks) * ticks;
+  if (stats.sum_squared_ticks >
+      std::numeric_limits<uint64_t>::max() - squared) {
+    stats.sum_squared_ticks = std::numeric_limits<uint64_t>::max();
+  } else {
+    stats.sum_squared_ticks += squared;
+  }
+  uint16_t& bin = stats.histogram[BitLength(ticks)];
+  if (bin != std::numeric_limits<uint16_t>::max()) {
+    ++bin;
+  }
+}
+
+void MicroAggregateProfiler::ClearEvents() {
+  num_tags_ = 0;
+  num_open_events_ = 0;
+  dropped_events_ = 0;
+}
+
+void MicroAggregateProfiler::LogCsv() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroPrintf("\"Tag\",\"Parent\",\"Count\",\"Mean\",\"Min\",\"Max\"");
+  for (int i = 0; i < num_tags_; ++i) {
+    const TagStats& stats = tags_[i];
+    if (stats.count == 0) {
+      continue;
+    }
+    MicroPrintf("%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32,
+                stats.tag,
+                stats.parent != kNoParent ? tags_[stats.parent].tag : "",
+                stats.count,
+                static_cast<uint32_t>(stats.sum_ticks / stats.count),
+                stats.min_ticks, stats.max_ticks);
+  }
+  if (dropped_events_ != 0) {
+    MicroPrintf("%" PRIu32 " events dropped", dropped_events_);
+  }
+#endif
+}
+
+size_t MicroAggregateProfiler::SerializeRecord(int index, uint8_t* buffer,
+                                               size_t size) const {
+  if (index == 0) {
+    if (size < 11) {
+      return 0;
+    }
+    uint8_t* out = buffer;
+    *out++ = kSummaryRecord;
+    *out++ = kRecordVersion;
+    out = WriteLittleEndian(ticks_per_second(), 4, out);
+    *out++ = static_cast<uint8_t>(num_tags_);
+    out = WriteLittleEndian(dropped_events_, 4, out);
+    return out - buffer;
+  }
+  if (index < 0 || index > num_tags_) {
+    return 0;
+  }
+  const TagStats& stats = tags_[index - 1];
+  size_t name_length = strlen(stats.tag);
+  if (name_length > kMaxRecordTagLength) {
+    name_length = kMaxRecordTagLength;
+  }
+  int first_bin = 0;
+  int end_bin = kHistogramBins;
+  while (first_bin < end_bin && stats.histogram[first_bin] == 0) {
+    ++first_bin;
+  }
+  while (end_bin > first_bin && stats.histogram[end_bin - 1] == 0) {
+    --end_bin;
+  }
+  if (first_bin == end_bin) {
+    first_bin = end_bin = 0;
+  }
+  if (size < 4 + name_length + 28 + 2 + 2 * (end_bin - first_bin)) {
+    return 0;
+  }
+
+  uint8_t* out = buffer;
+  *out++ = kTagRecord;
+  *out++ = static_cast<uint8_t>(index - 1);
+  *out++ = stats.parent;
+  *out++ = static_cast<uint8_t>(name_length);
+  memcpy(out, stats.tag, name_length);
+  out += name_length;
+  out = WriteLittleEndian(stats.count, 4, out);
+  out = WriteLittleEndian(stats.count != 0 ? stats.min_ticks : 0, 4, out);
+  out = WriteLittleEndian(stats.max_ticks, 4, out);
+  out = WriteLittleEndian(stats.sum_ticks, 8, out);
+  out = WriteLittleEndian(stats.sum_squared_ticks, 8, out);
+  *out++ = static_cast<uint8_t>(first_bin);
+  *out++ = static_cast<uint8_t>(end_bin - first_bin);
+  for (int bin = first_bin; bin < end_bin; ++bin) {
+    out = WriteLittleEndian(stats.histogram[bin], 2, out);
+  }
+  return out - buffer;
+}
+
+}  // namespace tflite
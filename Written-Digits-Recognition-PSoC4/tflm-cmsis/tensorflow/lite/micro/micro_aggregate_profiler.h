@@ -0,0 +1,125 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_AGGREGATE_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_AGGREGATE_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+namespace tflite {
+
+// A profiler for long runs in the field: instead of keeping the events, as
+// MicroProfiler does, it folds every event into statistics per tag, in
+// constant memory. Events nest (an operator inside an application level
+// event), and a tag is counted separately under each parent tag it appears
+// in, so the statistics also give a flame chart.
+//
+// The statistics are read out as binary records, see SerializeRecord, e.g.
+// over the UART; tools/profile_report.py decodes them.
+class MicroAggregateProfiler : public MicroProfilerInterface {
+ public:
+  // Distinct (tag, parent) pairs kept. The events of further ones are
+  // dropped and counted.
+  static constexpr int kMaxTags = 16;
+  // Events open at the same time.
+  static constexpr int kMaxOpenEvents = 8;
+  // Bin b of the histogram counts the durations of bit length b: 0 ticks in
+  // bin 0, [2^(b - 1), 2^b) ticks in bin b.
+  static constexpr int kHistogramBins = 33;
+  // Longest tag name in a record; longer ones are cut.
+  static constexpr int kMaxRecordTagLength = 32;
+  // Parent of the top level tags.
+  static constexpr uint8_t kNoParent = 0xff;
+  // Largest record, for a tag name of kMaxRecordTagLength characters.
+  static constexpr size_t kMaxRecordSize =
+      4 + kMaxRecordTagLength + 28 + 2 + 2 * kHistogramBins;
+
+  struct TagStats {
+    const char* tag;
+    uint8_t parent;
+    uint32_t count;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint64_t sum_ticks;
+    // Saturates at the largest uint64_t.
+    uint64_t sum_squared_ticks;
+    // Saturate at the largest uint16_t.
+    uint16_t histogram[kHistogramBins];
+  };
+
+  MicroAggregateProfiler() = default;
+  virtual ~MicroAggregateProfiler() = default;
+
+  // The lifetime of the tag parameter must exceed that of the profiler. Tags
+  // are matched by their text.
+  virtual uint32_t BeginEvent(const char* tag) override;
+
+  // Ends the event and any event begun after it that is still open.
+  virtual void EndEvent(uint32_t event_handle) override;
+
+  // Clears the statistics. Events still open are not counted.
+  void ClearEvents();
+
+  int num_tags() const { return num_tags_; }
+  const TagStats& tag_stats(int index) const { return tags_[index]; }
+
+  // Events dropped since the last ClearEvents() because all the tags or all
+  // the open events were in use.
+  uint32_t dropped_events() const { return dropped_events_; }
+
+  // Prints count, mean, minimum and maximum ticks per tag in CSV form.
+  void LogCsv() const;
+
+  // Record 0 is the summary, records 1 to num_tags() the tags. All integers
+  // are little endian:
+  //
+  //   summary: 0 (1) | version 1 (1) | ticks per second (4) | tags (1) |
+  //            dropped events (4)
+  //   tag:     1 (1) | tag index (1) | parent index or kNoParent (1) |
+  //            name length n (1) | name (n) | count (4) | min ticks (4) |
+  //            max ticks (4) | sum of ticks (8) | sum of squared ticks (8) |
+  //            first bin f (1) | bins m (1) | counts of bins f to f + m - 1
+  //            (2 each)
+  //
+  // The histogram is cut to its non-empty range. Writes record |index| to
+  // |buffer| and returns its size, or 0 if there is no such record or it
+  // does not fit in |size| bytes (kMaxRecordSize always do).
+  size_t SerializeRecord(int index, uint8_t* buffer, size_t size) const;
+  int num_records() const { return num_tags_ + 1; }
+
+ private:
+  struct OpenEvent {
+    uint8_t tag_index;
+    uint32_t start_ticks;
+  };
+
+  int FindOrAddTag(const char* tag, uint8_t parent);
+
+  TagStats tags_[kMaxTags];
+  int num_tags_ = 0;
+  OpenEvent open_events_[kMaxOpenEvents];
+  int num_open_events_ = 0;
+  uint32_t dropped_events_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_AGGREGATE_PROFILER_H_
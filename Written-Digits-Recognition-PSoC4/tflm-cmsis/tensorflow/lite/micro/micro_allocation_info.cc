@@ -258,10 +258,16 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
     // Each operator has a new allocation scope.
     allocation_scope_count_++;
     const auto* op = subgraph->operators()->Get(i);
+    // Tensor lifetimes follow the node input and output arrays rather than
+    // the flatbuffer operators, so that graph rewrites done before memory
+    // planning (see micro_op_fusion.h) are honoured.
+    const TfLiteNode& node =
+        allocations[subgraph_idx].node_and_registrations[i].node;
+    const TfLiteIntArray* op_inputs = node.inputs;
+    const TfLiteIntArray* op_outputs = node.outputs;
     // Figure out when the first creation and use of each tensor is.
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; op_outputs != nullptr && n < op_outputs->size; ++n) {
+      const int tensor_index = op_outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateFirstCreated(current, allocation_scope_count_);
     }
@@ -276,9 +282,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
                                      scratch_buffer_handles, allocations);
 
     // Figure out when the last use of each tensor is.
-    for (size_t n = 0; op->inputs() != nullptr && n < op->inputs()->size();
-         ++n) {
-      const int tensor_index = op->inputs()->Get(n);
+    for (int n = 0; op_inputs != nullptr && n < op_inputs->size; ++n) {
+      const int tensor_index = op_inputs->data[n];
       // Optional bias tensors can have an index of -1 when they are omitted.
       if (tensor_index >= 0) {
         AllocationInfo* current = &subgraph_allocation_info[tensor_index];
@@ -288,9 +293,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
         UpdateLastUsed(current, allocation_scope_count_);
       }
     }
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; op_outputs != nullptr && n < op_outputs->size; ++n) {
+      const int tensor_index = op_outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateLastUsed(current, allocation_scope_count_);
     }
@@ -312,6 +316,7 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
             &(scratch_buffer_handles[scratch_idx]);
         current->output_ptr = reinterpret_cast<void**>(&current_handle->data);
         current->bytes = request.bytes;
+        current_handle->bytes = request.bytes;
         UpdateFirstCreated(current, start_allocation_scope_count);
         UpdateLastUsed(current, allocation_scope_count_);
       }
@@ -578,6 +578,26 @@ size_t MicroAllocator::used_bytes() const {
          persistent_buffer_allocator_->GetPersistentUsedBytes();
 }
 
+size_t MicroAllocator::persistent_used_bytes() const {
+  return persistent_buffer_allocator_->GetPersistentUsedBytes();
+}
+
+void MicroAllocator::UpdateHeadHighWater(const void* data, size_t bytes) {
+  // Weights in flash and persistent buffers are outside of the head section.
+  const uintptr_t head = reinterpret_cast<uintptr_t>(
+      non_persistent_buffer_allocator_->GetOverlayMemoryAddress());
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  if (begin < head ||
+      begin - head >=
+          non_persistent_buffer_allocator_->GetNonPersistentUsedBytes()) {
+    return;
+  }
+  const size_t end = begin - head + bytes;
+  if (end > head_high_water_) {
+    head_high_water_ = end;
+  }
+}
+
 TfLiteStatus MicroAllocator::AllocateNodeAndRegistrations(
     const Model* model, SubgraphAllocations* subgraph_allocations) {
   TFLITE_DCHECK(subgraph_allocations != nullptr);
@@ -717,6 +737,13 @@ void MicroAllocator::DeallocateTempBuffer(uint8_t* buffer) {
 }
 
 TfLiteStatus MicroAllocator::ResetTempAllocations() {
+  if (head_high_water_enabled_) {
+    const size_t temp_end =
+        non_persistent_buffer_allocator_->GetTempEndOffset();
+    if (temp_end > head_high_water_) {
+      head_high_water_ = temp_end;
+    }
+  }
   return non_persistent_buffer_allocator_->ResetTempAllocations();
 }
 
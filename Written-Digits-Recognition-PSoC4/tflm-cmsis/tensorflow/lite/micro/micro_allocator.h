@@ -77,6 +77,8 @@ struct NodeAndRegistration {
 struct ScratchBufferHandle {
   // Pointer to location of the scratch buffer:
   uint8_t* data;
+  // Size requested by the kernel, for the arena watermarks.
+  size_t bytes;
 };
 
 // Stores all per-subgraph allocations. This includes the node and registration
@@ -235,6 +237,31 @@ class MicroAllocator {
 
   TfLiteBridgeBuiltinDataAllocator* GetBuiltinDataAllocator();
 
+  // Interpreters sharing the allocator (multi-tenant arena) all plan their
+  // activations in the same head section, so only the last one that ran holds
+  // valid activations. The interpreters record themselves here when they
+  // allocate or start an inference, which lets a time sliced inference detect
+  // that another interpreter ran in between.
+  void set_head_owner(const void* owner) { head_owner_ = owner; }
+  const void* head_owner() const { return head_owner_; }
+
+  // High-water mark of the head section: the end of the highest buffer used
+  // since the last ResetHeadHighWater(), as an offset from the start of the
+  // arena. It is only kept after EnableHeadHighWater(); the interpreters then
+  // report the tensors and scratch buffers of the nodes they run through
+  // NoteHeadUse(), and the temp allocations are counted when they are reset.
+  void EnableHeadHighWater() { head_high_water_enabled_ = true; }
+  void ResetHeadHighWater() { head_high_water_ = 0; }
+  size_t head_high_water_bytes() const { return head_high_water_; }
+  void NoteHeadUse(const void* data, size_t bytes) {
+    if (head_high_water_enabled_) {
+      UpdateHeadHighWater(data, bytes);
+    }
+  }
+
+  // Returns the size of the persistent section at the end of the arena.
+  size_t persistent_used_bytes() const;
+
  protected:
   MicroAllocator(SingleArenaBufferAllocator* memory_allocator,
                  MicroMemoryPlanner* memory_planner);
@@ -302,6 +329,10 @@ class MicroAllocator {
   // the head section.
   internal::ScratchBufferRequest* GetScratchBufferRequests();
 
+  // Raises the head high-water mark to the end of |data|, if it lies in the
+  // head section.
+  void UpdateHeadHighWater(const void* data, size_t bytes);
+
   // A simple memory allocator that always allocate from the arena tail or head.
   INonPersistentBufferAllocator* non_persistent_buffer_allocator_;
   IPersistentBufferAllocator* persistent_buffer_allocator_;
@@ -325,6 +356,13 @@ class MicroAllocator {
   // to ensure that multi-tenant allocations can share the head for buffers.
   size_t max_head_buffer_usage_ = 0;
 
+  // The interpreter whose activations are currently held by the head.
+  const void* head_owner_ = nullptr;
+
+  // See EnableHeadHighWater().
+  bool head_high_water_enabled_ = false;
+  size_t head_high_water_ = 0;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -28,6 +28,16 @@ struct TFLMRegistration {
   void (*reset)(TfLiteContext* context, void* buffer);
   int32_t builtin_code;
   const char* custom_name;
+  // Set by kernels whose invoke never allocates temp tensors through the
+  // MicroContext. The lean invoke path (MicroGraph::InvokeLean) skips
+  // resetting the temp allocations after such kernels.
+  bool invoke_without_temp_allocations;
+  // Optional. Runs part |step| of invoke, for kernels that split their work
+  // (e.g. in blocks of output rows) so that a time sliced invoke can yield in
+  // between, see MicroInterpreter::InvokeStep. Sets |*done| after the last
+  // part; running all parts in order gives the same result as invoke.
+  TfLiteStatus (*invoke_step)(TfLiteContext* context, TfLiteNode* node,
+                              int step, bool* done);
 };
 
 #endif  // THIRD_PARTY_TFLITE_MICRO_TENSORFLOW_LITE_MICRO_MICRO_COMMON_H_
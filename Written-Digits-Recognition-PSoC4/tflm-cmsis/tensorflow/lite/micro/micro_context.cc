@@ -48,6 +48,7 @@ TfLiteStatus MicroContext::RequestScratchBufferInArena(size_t bytes,
 void* MicroContext::GetScratchBuffer(int buffer_idx) {
   TFLITE_DCHECK(state_ == InterpreterState::kInvoke);
   ScratchBufferHandle* handle = scratch_buffer_handles_ + buffer_idx;
+  allocator_.NoteHeadUse(handle->data, handle->bytes);
   return handle->data;
 }
 
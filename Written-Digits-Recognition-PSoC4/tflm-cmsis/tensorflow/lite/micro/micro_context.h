@@ -16,11 +16,18 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_MICRO_CONTEXT_H_
 #define TENSORFLOW_LITE_MICRO_MICRO_CONTEXT_H_
 
+#include <cstdint>
+#include <limits>
+
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_graph.h"
 
 namespace tflite {
+
+struct PackedWeightsTable;
+struct WinogradFilterTable;
+
 // MicroContext is eventually going to become the API between TFLM and the
 // kernels, replacing all the functions in TfLiteContext. The end state is code
 // kernels to have code like:
@@ -122,6 +129,31 @@ class MicroContext {
 
   MicroGraph& graph() { return graph_; }
 
+  // Weights packed offline for the kernels that use PreparePackedWeights, see
+  // MicroInterpreter::SetPackedWeights. nullptr if there are none.
+  void set_packed_weights(const PackedWeightsTable* table) {
+    packed_weights_ = table;
+  }
+  const PackedWeightsTable* packed_weights() const { return packed_weights_; }
+
+  // Filters transformed offline for the Winograd convolution, see
+  // MicroInterpreter::SetWinogradFilters. nullptr if there are none.
+  void set_winograd_filters(const WinogradFilterTable* table) {
+    winograd_filters_ = table;
+  }
+  const WinogradFilterTable* winograd_filters() const {
+    return winograd_filters_;
+  }
+
+  // Smallest softmax output at which the argmax classifier head reports a
+  // class, see MicroInterpreter::SetArgMaxConfidenceThreshold.
+  void set_argmax_confidence_threshold(int8_t threshold) {
+    argmax_confidence_threshold_ = threshold;
+  }
+  int8_t argmax_confidence_threshold() const {
+    return argmax_confidence_threshold_;
+  }
+
   // Sets the pointer to a list of ScratchBufferHandle instances.
   // Not API between TFLM and kernels. Primarily used by the framework for
   // housekeeping in MicroContext.
@@ -139,6 +171,9 @@ class MicroContext {
 
   ScratchBufferHandle* scratch_buffer_handles_ = nullptr;
   void* external_context_payload_ = nullptr;
+  const PackedWeightsTable* packed_weights_ = nullptr;
+  const WinogradFilterTable* winograd_filters_ = nullptr;
+  int8_t argmax_confidence_threshold_ = std::numeric_limits<int8_t>::lowest();
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
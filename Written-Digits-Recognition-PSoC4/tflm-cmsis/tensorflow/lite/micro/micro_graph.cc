@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -35,6 +36,20 @@ const char* OpNameFromRegistration(const TFLMRegistration* registration) {
   }
 }
 
+// Raises the head high-water mark of |allocator| to the tensors |indices|.
+void NoteTensorsHeadUse(MicroAllocator* allocator,
+                        const TfLiteIntArray* indices,
+                        const TfLiteEvalTensor* tensors) {
+  for (int i = 0; indices != nullptr && i < indices->size; ++i) {
+    const int index = indices->data[i];
+    size_t bytes;
+    if (index >= 0 &&
+        TfLiteEvalTensorByteLength(&tensors[index], &bytes) == kTfLiteOk) {
+      allocator->NoteHeadUse(tensors[index].data.data, bytes);
+    }
+  }
+}
+
 }  // namespace
 
 MicroGraph::MicroGraph(TfLiteContext* context, const Model* model,
@@ -173,6 +188,12 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
                 subgraph_idx, subgraphs_->size());
     return kTfLiteError;
   }
+  const bool record_watermarks =
+      subgraph_idx == 0 && node_arena_watermarks_ != nullptr;
+  if (record_watermarks) {
+    invoke_arena_watermark_ = 0;
+    allocator_->ResetHeadHighWater();
+  }
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
   for (size_t i = 0; i < operators_size; ++i) {
     TfLiteNode* node =
@@ -198,6 +219,9 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
     // temp section. The call below resets the chain of allocations to
     // prepare for the next call.
     allocator_->ResetTempAllocations();
+    if (record_watermarks) {
+      RecordArenaWatermark(i);
+    }
 
     if (invoke_status == kTfLiteError) {
       MicroPrintf("Node %s (number %d) failed to invoke with status %d",
@@ -211,6 +235,179 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroGraph::PrepareLeanInvoke(int subgraph_idx) {
+  if (static_cast<size_t>(subgraph_idx) >= subgraphs_->size()) {
+    MicroPrintf("Accessing subgraph %d but only %d subgraphs found",
+                subgraph_idx, subgraphs_->size());
+    return kTfLiteError;
+  }
+  NodeAndRegistration* node_and_registrations =
+      subgraph_allocations_[subgraph_idx].node_and_registrations;
+  const uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
+
+  int count = 0;
+  for (size_t i = 0; i < operators_size; ++i) {
+    if (!IsFusedAwayRegistration(node_and_registrations[i].registration)) {
+      ++count;
+    }
+  }
+  LeanInvokeEntry* entries =
+      static_cast<LeanInvokeEntry*>(allocator_->AllocatePersistentBuffer(
+          count * sizeof(LeanInvokeEntry)));
+  if (count > 0 && entries == nullptr) {
+    MicroPrintf("Failed to allocate the lean invoke dispatch table.");
+    return kTfLiteError;
+  }
+
+  int entry = 0;
+  for (size_t i = 0; i < operators_size; ++i) {
+    const TFLMRegistration* registration =
+        node_and_registrations[i].registration;
+    if (IsFusedAwayRegistration(registration)) {
+      continue;
+    }
+    TFLITE_DCHECK(registration->invoke);
+    entries[entry].invoke = registration->invoke;
+    entries[entry].node = &node_and_registrations[i].node;
+    entries[entry].invoke_step = registration->invoke_step;
+    entries[entry].reset_temp_allocations =
+        !registration->invoke_without_temp_allocations;
+    ++entry;
+  }
+
+  lean_invoke_entries_ = entries;
+  lean_invoke_entries_count_ = count;
+  lean_invoke_subgraph_idx_ = subgraph_idx;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::InvokeLean() {
+  if (lean_invoke_entries_ == nullptr) {
+    MicroPrintf("Lean invoke: no dispatch table, was PrepareLeanInvoke() "
+                "called?");
+    return kTfLiteError;
+  }
+  int previous_subgraph_idx = current_subgraph_index_;
+  current_subgraph_index_ = lean_invoke_subgraph_idx_;
+
+  const bool record_watermarks =
+      lean_invoke_subgraph_idx_ == 0 && node_arena_watermarks_ != nullptr;
+  if (record_watermarks) {
+    invoke_arena_watermark_ = 0;
+    allocator_->ResetHeadHighWater();
+  }
+  const LeanInvokeEntry* entry = lean_invoke_entries_;
+  const LeanInvokeEntry* end = entry + lean_invoke_entries_count_;
+  for (; entry != end; ++entry) {
+    TfLiteStatus invoke_status = entry->invoke(context_, entry->node);
+    if (entry->reset_temp_allocations) {
+      allocator_->ResetTempAllocations();
+    }
+    if (record_watermarks) {
+      RecordArenaWatermark(LeanInvokeNodeIndex(*entry));
+    }
+    if (invoke_status != kTfLiteOk) {
+      if (invoke_status == kTfLiteError) {
+        MicroPrintf("Lean invoke: entry %d failed to invoke with status %d",
+                    static_cast<int>(entry - lean_invoke_entries_),
+                    invoke_status);
+      }
+      current_subgraph_index_ = previous_subgraph_idx;
+      return invoke_status;
+    }
+  }
+  current_subgraph_index_ = previous_subgraph_idx;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::InvokeLeanStep(InvokeResumeToken* token) {
+  if (token->finished) {
+    return kTfLiteOk;
+  }
+  if (token->entry >= lean_invoke_entries_count_) {
+    MicroPrintf("Lean invoke: no entry %d, was PrepareLeanInvoke() called?",
+                token->entry);
+    return kTfLiteError;
+  }
+  int previous_subgraph_idx = current_subgraph_index_;
+  current_subgraph_index_ = lean_invoke_subgraph_idx_;
+
+  const bool record_watermarks =
+      lean_invoke_subgraph_idx_ == 0 && node_arena_watermarks_ != nullptr;
+  if (record_watermarks && token->entry == 0 && token->step == 0) {
+    invoke_arena_watermark_ = 0;
+    allocator_->ResetHeadHighWater();
+  }
+  const LeanInvokeEntry& entry = lean_invoke_entries_[token->entry];
+  bool done = true;
+  TfLiteStatus invoke_status =
+      entry.invoke_step != nullptr
+          ? entry.invoke_step(context_, entry.node, token->step, &done)
+          : entry.invoke(context_, entry.node);
+  if (entry.reset_temp_allocations) {
+    allocator_->ResetTempAllocations();
+  }
+  if (record_watermarks) {
+    RecordArenaWatermark(LeanInvokeNodeIndex(entry));
+  }
+  current_subgraph_index_ = previous_subgraph_idx;
+
+  if (invoke_status != kTfLiteOk) {
+    if (invoke_status == kTfLiteError) {
+      MicroPrintf("Lean invoke: entry %d step %d failed with status %d",
+                  token->entry, token->step, invoke_status);
+    }
+    return invoke_status;
+  }
+  if (done) {
+    ++token->entry;
+    token->step = 0;
+    token->finished = token->entry == lean_invoke_entries_count_;
+  } else {
+    ++token->step;
+  }
+  return kTfLiteOk;
+}
+
+void MicroGraph::SetArenaWatermarks(size_t* node_watermarks, int count) {
+  node_arena_watermarks_ = node_watermarks;
+  node_arena_watermarks_count_ = count;
+  ResetArenaWatermarks();
+  allocator_->EnableHeadHighWater();
+}
+
+void MicroGraph::ResetArenaWatermarks() {
+  for (int i = 0; i < node_arena_watermarks_count_; ++i) {
+    node_arena_watermarks_[i] = 0;
+  }
+  invoke_arena_watermark_ = 0;
+}
+
+void MicroGraph::RecordArenaWatermark(int node_idx) {
+  const TfLiteNode& node =
+      subgraph_allocations_[0].node_and_registrations[node_idx].node;
+  const TfLiteEvalTensor* tensors = subgraph_allocations_[0].tensors;
+  NoteTensorsHeadUse(allocator_, node.inputs, tensors);
+  NoteTensorsHeadUse(allocator_, node.outputs, tensors);
+  NoteTensorsHeadUse(allocator_, node.intermediates, tensors);
+
+  const size_t watermark = allocator_->head_high_water_bytes();
+  allocator_->ResetHeadHighWater();
+  if (watermark > node_arena_watermarks_[node_idx]) {
+    node_arena_watermarks_[node_idx] = watermark;
+  }
+  if (watermark > invoke_arena_watermark_) {
+    invoke_arena_watermark_ = watermark;
+  }
+}
+
+int MicroGraph::LeanInvokeNodeIndex(const LeanInvokeEntry& entry) const {
+  // The node is the first member of its NodeAndRegistration.
+  return static_cast<int>(
+      reinterpret_cast<const NodeAndRegistration*>(entry.node) -
+      subgraph_allocations_[lean_invoke_subgraph_idx_].node_and_registrations);
+}
+
 TfLiteStatus MicroGraph::ResetVariableTensors() {
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
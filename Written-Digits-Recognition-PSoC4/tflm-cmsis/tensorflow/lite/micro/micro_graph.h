@@ -23,6 +23,27 @@ limitations under the License.
 
 namespace tflite {
 
+// One entry of the dispatch table run by MicroGraph::InvokeLean().
+struct LeanInvokeEntry {
+  TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node);
+  TfLiteNode* node;
+  // Optional, see TFLMRegistration::invoke_step.
+  TfLiteStatus (*invoke_step)(TfLiteContext* context, TfLiteNode* node,
+                              int step, bool* done);
+  // False for kernels that declare they never allocate temp tensors in
+  // invoke, see TFLMRegistration::invoke_without_temp_allocations.
+  bool reset_temp_allocations;
+};
+
+// Position of a time sliced invoke: the next entry of the dispatch table and,
+// for kernels that split their work, the next part of it. A default
+// constructed token starts a new inference.
+struct InvokeResumeToken {
+  int entry = 0;
+  int step = 0;
+  bool finished = false;
+};
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -58,6 +79,37 @@ class MicroGraph {
   // in the model.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
+  // Builds the dispatch table used by InvokeLean() for a single subgraph. Has
+  // to be called after all subgraphs have been prepared; the table is
+  // allocated from the persistent section of the arena.
+  TfLiteStatus PrepareLeanInvoke(int subgraph_idx);
+
+  // Runs the subgraph passed to PrepareLeanInvoke() from its dispatch table:
+  // nodes absorbed by a fused kernel are skipped, the flatbuffer is not
+  // accessed, no profiler events are recorded and the temp allocations are
+  // only reset after kernels that may use them.
+  TfLiteStatus InvokeLean();
+
+  // Runs the next step of the dispatch table built by PrepareLeanInvoke() and
+  // advances |token|: one part of a kernel that splits its work, or a whole
+  // node otherwise. Sets token->finished after the last step.
+  TfLiteStatus InvokeLeanStep(InvokeResumeToken* token);
+
+  // Records the arena watermarks of subgraph 0 while it runs, see
+  // MicroInterpreter::EnableArenaWatermarks(). |node_watermarks| holds one
+  // entry per operator.
+  void SetArenaWatermarks(size_t* node_watermarks, int count);
+  void ResetArenaWatermarks();
+  size_t invoke_arena_watermark() const { return invoke_arena_watermark_; }
+  size_t node_arena_watermark(int node_idx) const {
+    return node_idx >= 0 && node_idx < node_arena_watermarks_count_
+               ? node_arena_watermarks_[node_idx]
+               : 0;
+  }
+  int node_arena_watermarks_count() const {
+    return node_arena_watermarks_count_;
+  }
+
   // Zeros out all variable tensors in all subgraphs in the model.
   virtual TfLiteStatus ResetVariableTensors();
 
@@ -100,6 +152,20 @@ class MicroGraph {
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
 
+  LeanInvokeEntry* lean_invoke_entries_ = nullptr;
+  int lean_invoke_entries_count_ = 0;
+  int lean_invoke_subgraph_idx_ = 0;
+
+  // Folds the head high-water mark of the allocator, raised to the tensors of
+  // node |node_idx| of subgraph 0, into the watermarks and restarts it.
+  void RecordArenaWatermark(int node_idx);
+  // Index of the node of a lean invoke entry.
+  int LeanInvokeNodeIndex(const LeanInvokeEntry& entry) const;
+
+  size_t* node_arena_watermarks_ = nullptr;
+  int node_arena_watermarks_count_ = 0;
+  size_t invoke_arena_watermark_ = 0;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -22,12 +22,15 @@ limitations under the License.
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/kernels/classifier_head.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/micro_time.h"
 #include "tensorflow/lite/micro/tflite_bridge/flatbuffer_conversions_bridge.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
@@ -194,9 +197,13 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
     return kTfLiteError;
   }
 
+  allocator_.set_head_owner(this);
   graph_.SetSubgraphAllocations(allocations);
 
   TF_LITE_ENSURE_STATUS(PrepareNodeAndRegistrationDataFromFlatbuffer());
+  TF_LITE_ENSURE_STATUS(FuseOperators(model_, op_resolver_,
+                                      patch_execution_config_, allocator_,
+                                      graph_.GetAllocations()));
 
   micro_context_.SetInterpreterState(MicroContext::InterpreterState::kInit);
   TF_LITE_ENSURE_STATUS(graph_.InitSubgraphs());
@@ -276,9 +283,62 @@ TfLiteStatus MicroInterpreter::Invoke() {
   if (!tensors_allocated_) {
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
   }
+  allocator_.set_head_owner(this);
   return graph_.InvokeSubgraph(0);
 }
 
+TfLiteStatus MicroInterpreter::PrepareLeanInvoke() {
+  if (!tensors_allocated_) {
+    MicroPrintf(
+        "PrepareLeanInvoke() has to be called after AllocateTensors().");
+    return kTfLiteError;
+  }
+  return graph_.PrepareLeanInvoke(0);
+}
+
+TfLiteStatus MicroInterpreter::EnableArenaWatermarks() {
+  if (!tensors_allocated_) {
+    MicroPrintf(
+        "EnableArenaWatermarks() has to be called after AllocateTensors().");
+    return kTfLiteError;
+  }
+  if (graph_.node_arena_watermarks_count() > 0) {
+    return kTfLiteOk;
+  }
+  const int count =
+      static_cast<int>(NumSubgraphOperators(model_->subgraphs()->Get(0)));
+  size_t* watermarks = static_cast<size_t*>(
+      allocator_.AllocatePersistentBuffer(count * sizeof(size_t)));
+  if (count > 0 && watermarks == nullptr) {
+    MicroPrintf("Failed to allocate the arena watermarks.");
+    return kTfLiteError;
+  }
+  graph_.SetArenaWatermarks(watermarks, count);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::InvokeStep(InvokeResumeToken* token) {
+  if (token->entry == 0 && token->step == 0) {
+    allocator_.set_head_owner(this);
+  } else if (allocator_.head_owner() != this) {
+    MicroPrintf(
+        "Another interpreter sharing the arena ran during InvokeStep().");
+    return kTfLiteError;
+  }
+  return graph_.InvokeLeanStep(token);
+}
+
+TfLiteStatus MicroInterpreter::InvokeFor(uint32_t budget_ticks,
+                                         InvokeResumeToken* token) {
+  const bool has_time_source = ticks_per_second() != 0;
+  const uint32_t start = GetCurrentTimeTicks();
+  do {
+    TF_LITE_ENSURE_STATUS(InvokeStep(token));
+  } while (!token->finished && has_time_source &&
+           GetCurrentTimeTicks() - start < budget_ticks);
+  return kTfLiteOk;
+}
+
 TfLiteTensor* MicroInterpreter::input(size_t index) {
   const size_t length = inputs_size();
   if (index >= length) {
@@ -305,6 +365,67 @@ TfLiteStatus MicroInterpreter::Reset() {
   return graph_.ResetVariableTensors();
 }
 
+TfLiteStatus MicroInterpreter::SetPatchExecutionConfig(
+    const PatchExecutionConfig& config) {
+  if (graph_.GetAllocations() != nullptr) {
+    MicroPrintf(
+        "SetPatchExecutionConfig() has to be called before "
+        "AllocateTensors().");
+    return kTfLiteError;
+  }
+  patch_execution_config_ = config;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetPackedWeights(
+    const PackedWeightsTable* table) {
+  if (graph_.GetAllocations() != nullptr) {
+    MicroPrintf(
+        "SetPackedWeights() has to be called before AllocateTensors().");
+    return kTfLiteError;
+  }
+  micro_context_.set_packed_weights(table);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetWinogradFilters(
+    const WinogradFilterTable* table) {
+  if (graph_.GetAllocations() != nullptr) {
+    MicroPrintf(
+        "SetWinogradFilters() has to be called before AllocateTensors().");
+    return kTfLiteError;
+  }
+  micro_context_.set_winograd_filters(table);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetArgMaxConfidenceThreshold(int8_t threshold) {
+  micro_context_.set_argmax_confidence_threshold(threshold);
+  if (!tensors_allocated_) {
+    return kTfLiteOk;
+  }
+  // The heads prepared since read their margins only, so they are updated
+  // here rather than checked for a new threshold on every invoke.
+  const TFLMRegistration* classifier_head =
+      op_resolver_.FindOp(kMeanFullyConnectedArgMaxOpName);
+  if (classifier_head == nullptr) {
+    return kTfLiteOk;
+  }
+  for (int subgraph_idx = 0; subgraph_idx < graph_.NumSubgraphs();
+       subgraph_idx++) {
+    NodeAndRegistration* node_and_registrations =
+        graph_.GetAllocations()[subgraph_idx].node_and_registrations;
+    const uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
+    for (uint32_t i = 0; i < operators_size; ++i) {
+      if (node_and_registrations[i].registration == classifier_head) {
+        UpdateArgMaxConfidenceThreshold(
+            node_and_registrations[i].node.user_data, threshold);
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroInterpreter::SetMicroExternalContext(
     void* external_context_payload) {
   return micro_context_.set_external_context(external_context_payload);
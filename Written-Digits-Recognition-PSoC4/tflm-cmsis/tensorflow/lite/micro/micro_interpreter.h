@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_op_fusion.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler_interface.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
@@ -57,6 +58,16 @@ class MicroInterpreter {
   // have allocation handled in more than one interpreter or for recording
   // allocations inside the interpreter. The lifetime of the allocator must be
   // as long as that of the interpreter object.
+  //
+  // Interpreters created with the same allocator share its arena: the
+  // persistent allocations of every model are kept side by side at the tail,
+  // and the activations of all models are planned in the same head section,
+  // sized for the largest of them. Their inferences must not overlap: running
+  // one interpreter (or allocating its tensors) invalidates the inputs,
+  // outputs and activations of the others, so the inputs have to be written
+  // right before the inference and the outputs read before another
+  // interpreter runs. A time sliced inference (InvokeStep) fails if another
+  // interpreter sharing the arena ran since it started.
   MicroInterpreter(const Model* model, const MicroOpResolver& op_resolver,
                    MicroAllocator* allocator,
                    MicroResourceVariables* resource_variables = nullptr,
@@ -64,6 +75,32 @@ class MicroInterpreter {
 
   ~MicroInterpreter();
 
+  // Runs the leading layers of the model patch by patch, see
+  // PatchExecutionConfig. Has to be called before AllocateTensors().
+  TfLiteStatus SetPatchExecutionConfig(const PatchExecutionConfig& config);
+
+  // Weights packed offline by tools/pack_weights.py, which the kernels use
+  // instead of packing them into the arena (see PreparePackedWeights). The
+  // table is matched against the weights of the model, entries for other
+  // models are ignored. Has to be called before AllocateTensors().
+  TfLiteStatus SetPackedWeights(const PackedWeightsTable* table);
+
+  // Filters transformed offline by tools/winograd_filters.py. The CONV_2D
+  // kernel variant returned by Register_CONV_2D_WINOGRAD runs the layers
+  // found in the table with WinogradConvS8. Has to be called before
+  // AllocateTensors().
+  TfLiteStatus SetWinogradFilters(const WinogradFilterTable* table);
+
+  // Makes the argmax classifier head (AddMeanFullyConnectedArgMax) report a
+  // class only where the softmax it replaces would have output at least
+  // |threshold|, and the lowest value for every class otherwise. The softmax
+  // itself is not computed: the threshold is turned into margins on the
+  // logits when the tensors are allocated. The default, the lowest int8
+  // value, reports the argmax of every input. A threshold set later
+  // recomputes the margins of the allocated heads here, and takes effect at
+  // the next invoke.
+  TfLiteStatus SetArgMaxConfidenceThreshold(int8_t threshold);
+
   // Runs through the model and allocates all necessary input, output and
   // intermediate tensors.
   TfLiteStatus AllocateTensors();
@@ -73,6 +110,35 @@ class MicroInterpreter {
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
   TfLiteStatus Invoke();
 
+  // Builds the dispatch table used by InvokeLean(). Has to be called after
+  // AllocateTensors(); allocates a few bytes per node from the arena.
+  TfLiteStatus PrepareLeanInvoke();
+
+  // Same result as Invoke(), with less per node overhead: it runs the
+  // dispatch table built by PrepareLeanInvoke() without profiler events or
+  // status checks beyond the kernel return values. Use Invoke() when
+  // profiling. Fails, without running any node, if PrepareLeanInvoke() was not
+  // called.
+  TfLiteStatus InvokeLean() {
+    allocator_.set_head_owner(this);
+    return graph_.InvokeLean();
+  }
+
+  // Time sliced invoke, for applications that have to keep servicing other
+  // work during inference. Runs the next step of the inference described by
+  // |token| and returns: a single node, or a single part of a kernel that
+  // splits its work (e.g. one output row of an int8 CONV_2D). Call again with
+  // the same token until token->finished is set; the result is the same as
+  // for Invoke(). Needs PrepareLeanInvoke(). The inputs must not be changed
+  // until the inference has finished.
+  TfLiteStatus InvokeStep(InvokeResumeToken* token);
+
+  // Runs steps of the inference described by |token| until it has finished or
+  // |budget_ticks| of GetCurrentTimeTicks() have elapsed. At least one step is
+  // run, so a call can take up to the budget plus the longest step. Without a
+  // time source (ticks_per_second() returning 0) a single step is run.
+  TfLiteStatus InvokeFor(uint32_t budget_ticks, InvokeResumeToken* token);
+
   // This is the recommended API for an application to pass an external payload
   // pointer as an external context to kernels. The life time of the payload
   // pointer should be at least as long as this interpreter. TFLM supports only
@@ -135,6 +201,39 @@ class MicroInterpreter {
   // arena_used_bytes() + 16.
   size_t arena_used_bytes() const { return allocator_.used_bytes(); }
 
+  // Arena watermarks, to size the arena from real inferences. Has to be called
+  // after AllocateTensors() and takes one size_t per operator from the arena.
+  // From then on every invoke records how far into the arena each node
+  // reaches, as an offset from its start: its input, output and intermediate
+  // tensors, its scratch buffers and the temp allocations made while it runs.
+  // The persistent section, at the end of the arena, only grows while models
+  // are allocated; it takes arena_tail_used_bytes() bytes.
+  TfLiteStatus EnableArenaWatermarks();
+
+  // Clears the watermarks of the nodes.
+  void ResetArenaWatermarks() { graph_.ResetArenaWatermarks(); }
+
+  // Highest offset reached by any node during the last inference.
+  size_t arena_head_high_water_bytes() const {
+    return graph_.invoke_arena_watermark();
+  }
+
+  // Highest offset reached by node |node_index| of the main subgraph since
+  // the watermarks were enabled or reset; 0 for nodes that never ran, e.g.
+  // those absorbed by a fused kernel.
+  size_t node_arena_head_high_water_bytes(int node_index) const {
+    return graph_.node_arena_watermark(node_index);
+  }
+
+  // Number of nodes with a watermark, 0 before EnableArenaWatermarks().
+  int arena_watermark_nodes() const {
+    return graph_.node_arena_watermarks_count();
+  }
+
+  size_t arena_tail_used_bytes() const {
+    return allocator_.persistent_used_bytes();
+  }
+
  protected:
   const MicroAllocator& allocator() const { return allocator_; }
   const TfLiteContext& context() const { return context_; }
@@ -153,6 +252,7 @@ class MicroInterpreter {
   MicroAllocator& allocator_;
   MicroGraph graph_;
   bool tensors_allocated_;
+  PatchExecutionConfig patch_execution_config_;
 
   TfLiteStatus initialization_status_;
 
@@ -24,11 +24,14 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/kernels/add.h"
+#include "tensorflow/lite/micro/kernels/classifier_head.h"
 #include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/conv_max_pool.h"
 #include "tensorflow/lite/micro/kernels/depthwise_conv.h"
 #include "tensorflow/lite/micro/kernels/ethosu.h"
 #include "tensorflow/lite/micro/kernels/fully_connected.h"
 #include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/kernels/patch_conv_stack.h"
 #include "tensorflow/lite/micro/kernels/pooling.h"
 #include "tensorflow/lite/micro/kernels/reduce.h"
 #include "tensorflow/lite/micro/kernels/softmax.h"
@@ -185,6 +188,13 @@ class MicroMutableOpResolver : public MicroOpResolver {
     return AddBuiltin(BuiltinOperator_CONV_2D, registration, ParseConv2D);
   }
 
+  // Registers the fused CONV_2D + MAX_POOL_2D kernel. Graphs are only
+  // rewritten to use it when it has been registered, see micro_op_fusion.h.
+  TfLiteStatus AddConv2DMaxPool2D() {
+    return AddCustom(kConv2DMaxPool2DOpName,
+                     tflite::Register_CONV_2D_MAX_POOL_2D());
+  }
+
   TfLiteStatus AddCos() {
     return AddBuiltin(BuiltinOperator_COS, tflite::Register_COS(), ParseCos);
   }
@@ -365,6 +375,20 @@ class MicroMutableOpResolver : public MicroOpResolver {
                       ParseMirrorPad);
   }
 
+  // Registers the fused MEAN + FULLY_CONNECTED + SOFTMAX classifier head.
+  TfLiteStatus AddMeanFullyConnectedSoftmax() {
+    return AddCustom(kMeanFullyConnectedSoftmaxOpName,
+                     tflite::Register_MEAN_FULLY_CONNECTED_SOFTMAX());
+  }
+
+  // Registers the classifier head variant that replaces the softmax with a
+  // one-hot argmax, see MicroInterpreter::SetArgMaxConfidenceThreshold for
+  // its confidence test. Takes precedence over AddMeanFullyConnectedSoftmax.
+  TfLiteStatus AddMeanFullyConnectedArgMax() {
+    return AddCustom(kMeanFullyConnectedArgMaxOpName,
+                     tflite::Register_MEAN_FULLY_CONNECTED_ARGMAX());
+  }
+
   TfLiteStatus AddMean() {
     return AddBuiltin(BuiltinOperator_MEAN, Register_MEAN(), ParseReducer);
   }
@@ -399,6 +423,13 @@ class MicroMutableOpResolver : public MicroOpResolver {
     return AddBuiltin(BuiltinOperator_PADV2, Register_PADV2(), ParsePadV2);
   }
 
+  // Registers the kernel used for patch based execution, see
+  // MicroInterpreter::SetPatchExecutionConfig.
+  TfLiteStatus AddPatchConvStack() {
+    return AddCustom(kPatchConvStackOpName,
+                     tflite::Register_PATCH_CONV_STACK());
+  }
+
   TfLiteStatus AddPrelu() {
     return AddBuiltin(BuiltinOperator_PRELU, tflite::Register_PRELU(),
                       ParsePrelu);
@@ -0,0 +1,467 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_op_fusion.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/kernels/classifier_head.h"
+#include "tensorflow/lite/micro/kernels/conv_max_pool.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/patch_conv_stack.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_utils.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+namespace {
+
+constexpr char kFusedOpName[] = "FUSED";
+
+TfLiteStatus FusedInvoke(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteOk;
+}
+
+// Registration of the nodes that were absorbed into a fused node. They keep
+// their slot in the node array so that node indices stay aligned with the
+// flatbuffer operators, but do no work.
+const TFLMRegistration* FusedRegistration() {
+  static TFLMRegistration r = [] {
+    TFLMRegistration registration =
+        tflite::micro::RegisterOp(nullptr, nullptr, FusedInvoke);
+    registration.builtin_code = BuiltinOperator_CUSTOM;
+    registration.custom_name = kFusedOpName;
+    return registration;
+  }();
+  return &r;
+}
+
+bool IsBuiltin(const NodeAndRegistration& node_and_registration,
+               BuiltinOperator op) {
+  return node_and_registration.registration != nullptr &&
+         node_and_registration.registration->builtin_code == op;
+}
+
+// Returns true if |tensor_index| is read by no node other than
+// |consumer_index| and is not an output of the subgraph.
+bool HasSingleConsumer(const SubGraph* subgraph,
+                       const NodeAndRegistration* node_and_registrations,
+                       int tensor_index, uint32_t consumer_index) {
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    if (i == consumer_index) {
+      continue;
+    }
+    const TfLiteIntArray* inputs = node_and_registrations[i].node.inputs;
+    for (int n = 0; inputs != nullptr && n < inputs->size; ++n) {
+      if (inputs->data[n] == tensor_index) {
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0;
+       subgraph->outputs() != nullptr && i < subgraph->outputs()->size();
+       ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if both tensors carry the same per-tensor quantization.
+bool HaveSameQuantization(const Tensor* a, const Tensor* b) {
+  const QuantizationParameters* qa = a->quantization();
+  const QuantizationParameters* qb = b->quantization();
+  if (qa == nullptr || qb == nullptr || qa->scale() == nullptr ||
+      qb->scale() == nullptr || qa->zero_point() == nullptr ||
+      qb->zero_point() == nullptr) {
+    return false;
+  }
+  if (qa->scale()->size() != 1 || qb->scale()->size() != 1 ||
+      qa->zero_point()->size() != 1 || qb->zero_point()->size() != 1) {
+    return false;
+  }
+  return qa->scale()->Get(0) == qb->scale()->Get(0) &&
+         qa->zero_point()->Get(0) == qb->zero_point()->Get(0);
+}
+
+TfLiteIntArray* AllocateIntArray(MicroAllocator& allocator, int size) {
+  TfLiteIntArray* array = reinterpret_cast<TfLiteIntArray*>(
+      allocator.AllocatePersistentBuffer(TfLiteIntArrayGetSizeInBytes(size)));
+  if (array == nullptr) {
+    MicroPrintf("Failed to allocate memory for fused op, %d bytes required",
+                TfLiteIntArrayGetSizeInBytes(size));
+    return nullptr;
+  }
+  array->size = size;
+  return array;
+}
+
+// Removes |tensor| from the memory plan by giving it zero elements.
+TfLiteStatus DropIntermediateTensor(MicroAllocator& allocator,
+                                    TfLiteEvalTensor* tensor) {
+  TfLiteIntArray* dims = AllocateIntArray(allocator, 1);
+  if (dims == nullptr) {
+    return kTfLiteError;
+  }
+  dims->data[0] = 0;
+  tensor->dims = dims;
+  return kTfLiteOk;
+}
+
+bool IsInt8(const SubGraph* subgraph, int tensor_index) {
+  return subgraph->tensors()->Get(tensor_index)->type() == TensorType_INT8;
+}
+
+// Fuses CONV_2D followed by MAX_POOL_2D into CONV_2D_MAX_POOL_2D.
+TfLiteStatus TryFuseConvMaxPool(const SubGraph* subgraph,
+                                const TFLMRegistration* fused_registration,
+                                MicroAllocator& allocator,
+                                SubgraphAllocations& allocations, uint32_t i) {
+  NodeAndRegistration* nodes = allocations.node_and_registrations;
+  NodeAndRegistration& conv = nodes[i];
+  NodeAndRegistration& pool = nodes[i + 1];
+  if (!IsBuiltin(conv, BuiltinOperator_CONV_2D) ||
+      !IsBuiltin(pool, BuiltinOperator_MAX_POOL_2D)) {
+    return kTfLiteOk;
+  }
+  if (conv.node.outputs->size != 1 || pool.node.inputs->size != 1 ||
+      pool.node.outputs->size != 1 || conv.node.inputs->size < 2) {
+    return kTfLiteOk;
+  }
+
+  const int intermediate_index = conv.node.outputs->data[0];
+  const int filter_index = conv.node.inputs->data[1];
+  const int output_index = pool.node.outputs->data[0];
+  if (pool.node.inputs->data[0] != intermediate_index ||
+      !HasSingleConsumer(subgraph, nodes, intermediate_index, i + 1)) {
+    return kTfLiteOk;
+  }
+
+  const Tensor* intermediate = subgraph->tensors()->Get(intermediate_index);
+  const Tensor* filter = subgraph->tensors()->Get(filter_index);
+  const Tensor* output = subgraph->tensors()->Get(output_index);
+  if (intermediate->type() != TensorType_INT8 ||
+      filter->type() != TensorType_INT8 ||
+      !HaveSameQuantization(intermediate, output)) {
+    return kTfLiteOk;
+  }
+
+  TfLiteEvalTensor* intermediate_eval =
+      &allocations.tensors[intermediate_index];
+  if (intermediate_eval->dims->size != 4) {
+    return kTfLiteOk;
+  }
+
+  TfLiteConvMaxPoolParams* params = reinterpret_cast<TfLiteConvMaxPoolParams*>(
+      allocator.AllocatePersistentBuffer(sizeof(TfLiteConvMaxPoolParams)));
+  if (params == nullptr) {
+    MicroPrintf("Failed to allocate memory for fused op params.");
+    return kTfLiteError;
+  }
+  params->conv = *static_cast<const TfLiteConvParams*>(conv.node.builtin_data);
+  params->pool = *static_cast<const TfLitePoolParams*>(pool.node.builtin_data);
+  params->conv_output_height = intermediate_eval->dims->data[1];
+  params->conv_output_width = intermediate_eval->dims->data[2];
+
+  TF_LITE_ENSURE_STATUS(DropIntermediateTensor(allocator, intermediate_eval));
+
+  conv.registration = fused_registration;
+  conv.node.builtin_data = params;
+  conv.node.outputs = pool.node.outputs;
+  pool.registration = FusedRegistration();
+  return kTfLiteOk;
+}
+
+// Fuses MEAN over the spatial dimensions, FULLY_CONNECTED and SOFTMAX into a
+// single classifier head.
+TfLiteStatus TryFuseClassifierHead(const SubGraph* subgraph,
+                                   const TFLMRegistration* fused_registration,
+                                   MicroAllocator& allocator,
+                                   SubgraphAllocations& allocations,
+                                   uint32_t i) {
+  NodeAndRegistration* nodes = allocations.node_and_registrations;
+  NodeAndRegistration& mean = nodes[i];
+  NodeAndRegistration& fully_connected = nodes[i + 1];
+  NodeAndRegistration& softmax = nodes[i + 2];
+  if (!IsBuiltin(mean, BuiltinOperator_MEAN) ||
+      !IsBuiltin(fully_connected, BuiltinOperator_FULLY_CONNECTED) ||
+      !IsBuiltin(softmax, BuiltinOperator_SOFTMAX)) {
+    return kTfLiteOk;
+  }
+  if (mean.node.inputs->size != 2 || mean.node.outputs->size != 1 ||
+      fully_connected.node.inputs->size < 2 ||
+      fully_connected.node.outputs->size != 1 ||
+      softmax.node.inputs->size != 1 || softmax.node.outputs->size != 1) {
+    return kTfLiteOk;
+  }
+
+  const int input_index = mean.node.inputs->data[0];
+  const int axis_index = mean.node.inputs->data[1];
+  const int mean_output_index = mean.node.outputs->data[0];
+  const int fc_output_index = fully_connected.node.outputs->data[0];
+  const int output_index = softmax.node.outputs->data[0];
+  if (fully_connected.node.inputs->data[0] != mean_output_index ||
+      softmax.node.inputs->data[0] != fc_output_index ||
+      !HasSingleConsumer(subgraph, nodes, mean_output_index, i + 1) ||
+      !HasSingleConsumer(subgraph, nodes, fc_output_index, i + 2)) {
+    return kTfLiteOk;
+  }
+  if (!IsInt8(subgraph, input_index) || !IsInt8(subgraph, mean_output_index) ||
+      !IsInt8(subgraph, fully_connected.node.inputs->data[1]) ||
+      !IsInt8(subgraph, fc_output_index) || !IsInt8(subgraph, output_index)) {
+    return kTfLiteOk;
+  }
+
+  // Only a mean over the two spatial dimensions of a 4D tensor is fused.
+  const TfLiteEvalTensor& input = allocations.tensors[input_index];
+  const TfLiteEvalTensor& axis = allocations.tensors[axis_index];
+  if (input.dims->size != 4 || axis.data.data == nullptr ||
+      axis.type != kTfLiteInt32 || ElementCount(*axis.dims) != 2) {
+    return kTfLiteOk;
+  }
+  const int32_t* axis_data = axis.data.i32;
+  if (!((axis_data[0] == 1 && axis_data[1] == 2) ||
+        (axis_data[0] == 2 && axis_data[1] == 1))) {
+    return kTfLiteOk;
+  }
+
+  const auto* fc_params = static_cast<const TfLiteFullyConnectedParams*>(
+      fully_connected.node.builtin_data);
+  if (fc_params->weights_format != kTfLiteFullyConnectedWeightsFormatDefault) {
+    return kTfLiteOk;
+  }
+
+  TfLiteClassifierHeadParams* params =
+      reinterpret_cast<TfLiteClassifierHeadParams*>(
+          allocator.AllocatePersistentBuffer(
+              sizeof(TfLiteClassifierHeadParams)));
+  TfLiteIntArray* inputs =
+      AllocateIntArray(allocator, fully_connected.node.inputs->size);
+  TfLiteIntArray* intermediates = AllocateIntArray(allocator, 2);
+  if (params == nullptr || inputs == nullptr || intermediates == nullptr) {
+    MicroPrintf("Failed to allocate memory for fused op params.");
+    return kTfLiteError;
+  }
+  params->mean =
+      *static_cast<const TfLiteReducerParams*>(mean.node.builtin_data);
+  params->fully_connected = *fc_params;
+  params->softmax =
+      *static_cast<const TfLiteSoftmaxParams*>(softmax.node.builtin_data);
+
+  inputs->data[0] = input_index;
+  for (int n = 1; n < inputs->size; ++n) {
+    inputs->data[n] = fully_connected.node.inputs->data[n];
+  }
+  intermediates->data[0] = mean_output_index;
+  intermediates->data[1] = fc_output_index;
+
+  TF_LITE_ENSURE_STATUS(DropIntermediateTensor(
+      allocator, &allocations.tensors[mean_output_index]));
+  TF_LITE_ENSURE_STATUS(DropIntermediateTensor(
+      allocator, &allocations.tensors[fc_output_index]));
+
+  mean.registration = fused_registration;
+  mean.node.builtin_data = params;
+  mean.node.inputs = inputs;
+  mean.node.outputs = softmax.node.outputs;
+  mean.node.intermediates = intermediates;
+  fully_connected.registration = FusedRegistration();
+  softmax.registration = FusedRegistration();
+  return kTfLiteOk;
+}
+
+// Replaces the first |config.num_layers| operators starting at the first
+// CONV_2D of the subgraph with a single PATCH_CONV_STACK node. Unlike the
+// opportunistic fusions, this is explicitly requested, so a graph that does
+// not match is reported as an error.
+TfLiteStatus PatchLeadingLayers(const SubGraph* subgraph,
+                                const TFLMRegistration* patch_registration,
+                                const PatchExecutionConfig& config,
+                                MicroAllocator& allocator,
+                                SubgraphAllocations& allocations) {
+  NodeAndRegistration* nodes = allocations.node_and_registrations;
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  uint32_t first = 0;
+  while (first < operators_size &&
+         !IsBuiltin(nodes[first], BuiltinOperator_CONV_2D)) {
+    ++first;
+  }
+  if (first + config.num_layers > operators_size) {
+    MicroPrintf("Patch execution: model has less than %d layers to patch.",
+                config.num_layers);
+    return kTfLiteError;
+  }
+
+  TfLitePatchLayer* layers =
+      reinterpret_cast<TfLitePatchLayer*>(allocator.AllocatePersistentBuffer(
+          sizeof(TfLitePatchLayer) * config.num_layers));
+  TfLitePatchStackParams* params = reinterpret_cast<TfLitePatchStackParams*>(
+      allocator.AllocatePersistentBuffer(sizeof(TfLitePatchStackParams)));
+  if (layers == nullptr || params == nullptr) {
+    MicroPrintf("Failed to allocate memory for fused op params.");
+    return kTfLiteError;
+  }
+
+  for (int l = 0; l < config.num_layers; ++l) {
+    const NodeAndRegistration& layer_node = nodes[first + l];
+    const TfLiteNode& node = layer_node.node;
+    TfLitePatchLayer& layer = layers[l];
+    layer = {};
+    if (IsBuiltin(layer_node, BuiltinOperator_CONV_2D) &&
+        node.inputs->size >= 2) {
+      layer.type = kTfLitePatchLayerConv2D;
+      layer.conv = *static_cast<const TfLiteConvParams*>(node.builtin_data);
+      layer.filter_tensor = node.inputs->data[1];
+      layer.bias_tensor = node.inputs->size > 2 ? node.inputs->data[2] : -1;
+    } else if (IsBuiltin(layer_node, BuiltinOperator_MAX_POOL_2D) &&
+               HaveSameQuantization(
+                   subgraph->tensors()->Get(node.inputs->data[0]),
+                   subgraph->tensors()->Get(node.outputs->data[0]))) {
+      layer.type = kTfLitePatchLayerMaxPool2D;
+      layer.pool = *static_cast<const TfLitePoolParams*>(node.builtin_data);
+      layer.filter_tensor = -1;
+      layer.bias_tensor = -1;
+    } else {
+      MicroPrintf("Patch execution: layer %d is not a supported layer.", l);
+      return kTfLiteError;
+    }
+    if (node.outputs->size != 1) {
+      MicroPrintf("Patch execution: layer %d has more than one output.", l);
+      return kTfLiteError;
+    }
+    layer.input_tensor = node.inputs->data[0];
+    layer.output_tensor = node.outputs->data[0];
+
+    const TfLiteEvalTensor& output = allocations.tensors[layer.output_tensor];
+    if (output.dims->size != 4 || !IsInt8(subgraph, layer.input_tensor) ||
+        !IsInt8(subgraph, layer.output_tensor) ||
+        (layer.filter_tensor >= 0 && !IsInt8(subgraph, layer.filter_tensor) &&
+         subgraph->tensors()->Get(layer.filter_tensor)->type() !=
+             TensorType_INT4)) {
+      MicroPrintf("Patch execution: layer %d is not a 4D int8 layer.", l);
+      return kTfLiteError;
+    }
+    layer.output_height = output.dims->data[1];
+    layer.output_width = output.dims->data[2];
+    layer.output_depth = output.dims->data[3];
+
+    if (l > 0 && (layer.input_tensor != layers[l - 1].output_tensor ||
+                  !HasSingleConsumer(subgraph, nodes, layer.input_tensor,
+                                     first + l))) {
+      MicroPrintf("Patch execution: layer %d does not only feed layer %d.",
+                  l - 1, l);
+      return kTfLiteError;
+    }
+  }
+
+  const TfLitePatchLayer& last = layers[config.num_layers - 1];
+  if (config.tile_height <= 0 || config.tile_width <= 0 ||
+      config.tile_height > last.output_height ||
+      config.tile_width > last.output_width) {
+    MicroPrintf("Patch execution: invalid %dx%d tile for %dx%d output.",
+                config.tile_height, config.tile_width, last.output_height,
+                last.output_width);
+    return kTfLiteError;
+  }
+
+  params->num_layers = config.num_layers;
+  params->tile_height = config.tile_height;
+  params->tile_width = config.tile_width;
+  params->layers = layers;
+
+  TfLiteIntArray* inputs = AllocateIntArray(allocator, 1);
+  if (inputs == nullptr) {
+    return kTfLiteError;
+  }
+  inputs->data[0] = layers[0].input_tensor;
+
+  for (int l = 0; l + 1 < config.num_layers; ++l) {
+    TF_LITE_ENSURE_STATUS(DropIntermediateTensor(
+        allocator, &allocations.tensors[layers[l].output_tensor]));
+  }
+
+  NodeAndRegistration& stack = nodes[first];
+  stack.registration = patch_registration;
+  stack.node.builtin_data = params;
+  stack.node.inputs = inputs;
+  stack.node.outputs = nodes[first + config.num_layers - 1].node.outputs;
+  for (int l = 1; l < config.num_layers; ++l) {
+    nodes[first + l].registration = FusedRegistration();
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+bool IsFusedAwayRegistration(const TFLMRegistration* registration) {
+  return registration == FusedRegistration();
+}
+
+TfLiteStatus FuseOperators(const Model* model,
+                           const MicroOpResolver& op_resolver,
+                           const PatchExecutionConfig& patch_config,
+                           MicroAllocator& allocator,
+                           SubgraphAllocations* allocations) {
+  if (patch_config.num_layers > 0) {
+    const TFLMRegistration* patch_conv_stack =
+        op_resolver.FindOp(kPatchConvStackOpName);
+    if (patch_conv_stack == nullptr) {
+      MicroPrintf("Patch execution requires %s to be registered.",
+                  kPatchConvStackOpName);
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(PatchLeadingLayers(model->subgraphs()->Get(0),
+                                             patch_conv_stack, patch_config,
+                                             allocator, allocations[0]));
+  }
+
+  const TFLMRegistration* conv_max_pool =
+      op_resolver.FindOp(kConv2DMaxPool2DOpName);
+  const TFLMRegistration* classifier_head =
+      op_resolver.FindOp(kMeanFullyConnectedArgMaxOpName);
+  if (classifier_head == nullptr) {
+    classifier_head = op_resolver.FindOp(kMeanFullyConnectedSoftmaxOpName);
+  }
+  if (conv_max_pool == nullptr && classifier_head == nullptr) {
+    return kTfLiteOk;
+  }
+
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       ++subgraph_idx) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    TFLITE_DCHECK(subgraph != nullptr);
+    const uint32_t operators_size = NumSubgraphOperators(subgraph);
+    for (uint32_t i = 0; conv_max_pool != nullptr && i + 1 < operators_size;
+         ++i) {
+      TF_LITE_ENSURE_STATUS(TryFuseConvMaxPool(
+          subgraph, conv_max_pool, allocator, allocations[subgraph_idx], i));
+    }
+    for (uint32_t i = 0; classifier_head != nullptr && i + 2 < operators_size;
+         ++i) {
+      TF_LITE_ENSURE_STATUS(TryFuseClassifierHead(
+          subgraph, classifier_head, allocator, allocations[subgraph_idx], i));
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,64 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Configures patch based execution of the leading layers of a model. The
+// first num_layers operators starting at the first CONV_2D, which all have to
+// be CONV_2D or MAX_POOL_2D, are run as a single PATCH_CONV_STACK node that
+// produces the output of the last one tile by tile. Smaller tiles lower the
+// arena peak but recompute more of the overlap between neighbouring receptive
+// fields. A num_layers of zero disables patch based execution.
+struct PatchExecutionConfig {
+  int num_layers = 0;
+  int tile_height = 0;
+  int tile_width = 0;
+};
+
+// Rewrites the node and registration data of every subgraph so that chains of
+// operators with a fused kernel registered in |op_resolver| run as a single
+// node. Runs after the nodes have been populated from the flatbuffer and
+// before any kernel is initialized.
+//
+// A fused chain keeps its original number of nodes: the first node takes over
+// the inputs of the chain and the outputs of its last node, the remaining
+// nodes become no-ops. Intermediate tensors that are no longer produced are
+// given zero elements, which removes them from the memory plan.
+//
+// Fusions are opt-in: nothing is rewritten unless the fused kernel has been
+// added to the op resolver, e.g. with
+// MicroMutableOpResolver::AddConv2DMaxPool2D. Patch based execution
+// additionally needs |patch_config| to be set, and takes precedence over the
+// fusions for the layers it covers.
+TfLiteStatus FuseOperators(const Model* model,
+                           const MicroOpResolver& op_resolver,
+                           const PatchExecutionConfig& patch_config,
+                           MicroAllocator& allocator,
+                           SubgraphAllocations* allocations);
+
+// Returns true for the registration given to the nodes that were absorbed into
+// a fused node. Their invoke does nothing and can be skipped.
+bool IsFusedAwayRegistration(const TFLMRegistration* registration);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OP_FUSION_H_
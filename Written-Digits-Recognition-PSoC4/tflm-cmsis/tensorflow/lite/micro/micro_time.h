@@ -26,6 +26,16 @@ uint32_t ticks_per_second();
 // Return time in ticks.  The meaning of a tick varies per platform.
 uint32_t GetCurrentTimeTicks();
 
+// Returns the current time in ticks of a tick source, see SetMicroTimeSource.
+typedef uint32_t (*MicroTimeTicksFunction)();
+
+// Replaces the platform's tick source with |get_ticks|, ticking
+// |ticks_per_second| times per second, e.g. with a free-running hardware timer
+// of the application or with FakeMicroTime on a host. nullptr goes back to the
+// platform's source. Implemented next to GetCurrentTimeTicks by each target.
+void SetMicroTimeSource(MicroTimeTicksFunction get_ticks,
+                        uint32_t ticks_per_second);
+
 inline uint32_t TicksToMs(int32_t ticks) {
   return static_cast<uint32_t>(1000.0f * static_cast<float>(ticks) /
                                static_cast<float>(ticks_per_second()));
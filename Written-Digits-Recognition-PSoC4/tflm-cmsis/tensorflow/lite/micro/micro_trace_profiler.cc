@@ -0,0 +1,155 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_trace_profiler.h"
+
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+namespace {
+
+// Handle of the events whose tag did not fit.
+constexpr uint32_t kDroppedEvent = std::numeric_limits<uint32_t>::max();
+
+constexpr uint8_t kSummaryRecord = 0;
+constexpr uint8_t kTagRecord = 1;
+constexpr uint8_t kEventRecord = 2;
+constexpr uint8_t kRecordVersion = 1;
+
+constexpr int kPhaseShift = 6;
+
+static_assert(MicroTraceProfiler::kMaxTags <= (1 << kPhaseShift),
+              "the tag index has to fit below the phase");
+static_assert(MicroTraceProfiler::kMaxEvents <= 0xffff,
+              "the event index of a record has 16 bits");
+
+uint8_t* WriteLittleEndian(uint32_t value, int bytes, uint8_t* out) {
+  for (int i = 0; i < bytes; ++i) {
+    *out++ = static_cast<uint8_t>(value >> (8 * i));
+  }
+  return out;
+}
+
+}  // namespace
+
+int MicroTraceProfiler::FindOrAddTag(const char* tag) {
+  for (int i = 0; i < num_tags_; ++i) {
+    if (tags_[i] == tag || strcmp(tags_[i], tag) == 0) {
+      return i;
+    }
+  }
+  if (num_tags_ == kMaxTags) {
+    return -1;
+  }
+  tags_[num_tags_] = tag;
+  return num_tags_++;
+}
+
+void MicroTraceProfiler::AddEvent(int tag_index, Phase phase) {
+  // Taken first, so that the lookup of the tag is not part of the event.
+  const uint32_t ticks = GetCurrentTimeTicks();
+  if (tag_index < 0 || num_events_ == kMaxEvents) {
+    ++dropped_events_;
+    return;
+  }
+  ticks_[num_events_] = ticks;
+  tag_phases_[num_events_] =
+      static_cast<uint8_t>(tag_index | (phase << kPhaseShift));
+  ++num_events_;
+}
+
+uint32_t MicroTraceProfiler::BeginEvent(const char* tag) {
+  const int tag_index = FindOrAddTag(tag);
+  AddEvent(tag_index, kBegin);
+  return tag_index >= 0 ? static_cast<uint32_t>(tag_index) : kDroppedEvent;
+}
+
+void MicroTraceProfiler::EndEvent(uint32_t event_handle) {
+  AddEvent(event_handle < static_cast<uint32_t>(num_tags_)
+               ? static_cast<int>(event_handle)
+               : -1,
+           kEnd);
+}
+
+void MicroTraceProfiler::EndEventOf(const char* tag) {
+  AddEvent(FindOrAddTag(tag), kEnd);
+}
+
+void MicroTraceProfiler::InstantEvent(const char* tag) {
+  AddEvent(FindOrAddTag(tag), kInstant);
+}
+
+void MicroTraceProfiler::ClearEvents() {
+  num_events_ = 0;
+  num_tags_ = 0;
+  dropped_events_ = 0;
+}
+
+size_t MicroTraceProfiler::SerializeRecord(int index, uint8_t* buffer,
+                                           size_t size) const {
+  uint8_t* out = buffer;
+  if (index == 0) {
+    if (size < 13) {
+      return 0;
+    }
+    *out++ = kSummaryRecord;
+    *out++ = kRecordVersion;
+    out = WriteLittleEndian(ticks_per_second(), 4, out);
+    *out++ = static_cast<uint8_t>(num_tags_);
+    out = WriteLittleEndian(num_events_, 2, out);
+    out = WriteLittleEndian(dropped_events_, 4, out);
+    return out - buffer;
+  }
+  if (index < 0 || index >= num_records()) {
+    return 0;
+  }
+  if (index <= num_tags_) {
+    const char* tag = tags_[index - 1];
+    size_t name_length = strlen(tag);
+    if (name_length > kMaxRecordTagLength) {
+      name_length = kMaxRecordTagLength;
+    }
+    if (size < 3 + name_length) {
+      return 0;
+    }
+    *out++ = kTagRecord;
+    *out++ = static_cast<uint8_t>(index - 1);
+    *out++ = static_cast<uint8_t>(name_length);
+    memcpy(out, tag, name_length);
+    return out + name_length - buffer;
+  }
+
+  const int first = (index - 1 - num_tags_) * kRecordEvents;
+  int count = num_events_ - first;
+  if (count > kRecordEvents) {
+    count = kRecordEvents;
+  }
+  if (size < 4 + 5 * static_cast<size_t>(count)) {
+    return 0;
+  }
+  *out++ = kEventRecord;
+  out = WriteLittleEndian(first, 2, out);
+  *out++ = static_cast<uint8_t>(count);
+  for (int i = first; i < first + count; ++i) {
+    out = WriteLittleEndian(ticks_[i], 4, out);
+    *out++ = tag_phases_[i];
+  }
+  return out - buffer;
+}
+
+}  // namespace tflite
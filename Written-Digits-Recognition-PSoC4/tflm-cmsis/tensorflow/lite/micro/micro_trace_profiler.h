@@ -0,0 +1,114 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_TRACE_PROFILER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_TRACE_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+namespace tflite {
+
+// A profiler that keeps a timeline: every begin, end and instant is stored
+// as a timestamped trace event of 5 bytes, so the latency of one inference,
+// and of the application stages around it, can be laid out step by step.
+// Unlike with MicroProfiler, the begin and the end are separate trace
+// events, so a span may begin in one function and end in another, see
+// EndEventOf.
+//
+// Trace events after the buffer is full are dropped and counted until
+// ClearEvents(). They are read out as binary records, see SerializeRecord,
+// e.g. over the UART; tools/trace_to_chrome.py turns them into a Chrome
+// trace.
+class MicroTraceProfiler : public MicroProfilerInterface {
+ public:
+  // Trace events kept.
+  static constexpr int kMaxEvents = 128;
+  // Distinct tags. The trace events of further ones are dropped and
+  // counted.
+  static constexpr int kMaxTags = 32;
+  // Longest tag name in a record; longer ones are cut.
+  static constexpr int kMaxRecordTagLength = 32;
+  // Trace events in an event record.
+  static constexpr int kRecordEvents = 24;
+  // Largest record: an event record, or a tag of kMaxRecordTagLength.
+  static constexpr size_t kMaxRecordSize = 4 + 5 * kRecordEvents;
+
+  enum Phase : uint8_t { kBegin = 0, kEnd = 1, kInstant = 2 };
+
+  MicroTraceProfiler() = default;
+  virtual ~MicroTraceProfiler() = default;
+
+  // The lifetime of the tag parameter must exceed that of the profiler. Tags
+  // are matched by their text. The handle is the index of the tag.
+  virtual uint32_t BeginEvent(const char* tag) override;
+  virtual void EndEvent(uint32_t event_handle) override;
+
+  // Ends the event of |tag|, for events that end in another scope than
+  // the one they began in.
+  void EndEventOf(const char* tag);
+
+  // Marks a point in time, e.g. the detection of an input.
+  void InstantEvent(const char* tag);
+
+  // Clears the trace events and the tags.
+  void ClearEvents();
+
+  int num_events() const { return num_events_; }
+  int num_tags() const { return num_tags_; }
+
+  // Trace events dropped since the last ClearEvents() because the buffer or
+  // all the tags were in use.
+  uint32_t dropped_events() const { return dropped_events_; }
+
+  // Record 0 is the summary, records 1 to num_tags() the tags, and the
+  // records after them the trace events, kRecordEvents at a time. All
+  // integers are little endian:
+  //
+  //   summary: 0 (1) | version 1 (1) | ticks per second (4) | tags (1) |
+  //            events (2) | dropped (4)
+  //   tag:     1 (1) | tag index (1) | name length n (1) | name (n)
+  //   events:  2 (1) | first event (2) | events m (1) | m times: ticks (4),
+  //            tag index in bits 0 to 5 and phase in bits 6 and 7 (1)
+  //
+  // The ticks are GetCurrentTimeTicks() and wrap around. Writes record
+  // |index| to |buffer| and returns its size, or 0 if there is no such
+  // record or it does not fit in |size| bytes (kMaxRecordSize always do).
+  size_t SerializeRecord(int index, uint8_t* buffer, size_t size) const;
+  int num_records() const {
+    return 1 + num_tags_ + (num_events_ + kRecordEvents - 1) / kRecordEvents;
+  }
+
+ private:
+  int FindOrAddTag(const char* tag);
+  void AddEvent(int tag_index, Phase phase);
+
+  // Kept apart, as a struct would pad each event to 8 bytes.
+  uint32_t ticks_[kMaxEvents];
+  uint8_t tag_phases_[kMaxEvents];
+  int num_events_ = 0;
+  const char* tags_[kMaxTags];
+  int num_tags_ = 0;
+  uint32_t dropped_events_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_TRACE_PROFILER_H_
@@ -0,0 +1,207 @@
+"""Benchmarks the CNN on the board and changes its settings at run time.
+
+The application answers the binary frames of src/uart_frame.h on its UART
+with a small command shell (src/command_shell.h), next to the text it prints
+for the GUI. This script sends the requests and prints the replies:
+
+- --bench N invokes the CNN N times on the test digit of
+  test_data/test_sample.h and prints the fastest, slowest and mean time, and
+  the prediction, which is 3 for that digit. The board stops scanning the
+  touch pad while it runs, and answers BUSY in the middle of an inference.
+- --stats prints the stack and arena usage and the last benchmark again. The
+  stack needs MEMORY_WATERMARKS in src/config.h, the arena high-water mark
+  the arena watermarks.
+- --threshold, --pen-up-ms and --verbosity change the confidence threshold,
+  the pen up timeout and the text output of each digit: 0 nothing, 1 the
+  scores and the prediction, 2 the input image too, as the GUI expects. The
+  settings last until the board is reset; the defaults are in src/config.h.
+
+The current settings are printed in any case. With a profiler in the build
+(PROFILE_OUTPUT), the benchmark runs are also recorded under the CNN tag,
+for tools/profile_report.py.
+
+Usage:
+    python board_shell.py --port COM5 [--baud 115200] [--bench 20] [--stats]
+                          [--threshold 128] [--pen-up-ms 700]
+                          [--verbosity 2]
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import upload_model
+
+BENCH = 0x16
+STATS = 0x17
+SETTINGS_GET = 0x18
+SETTINGS_SET = 0x19
+
+STATUS = ['ok', 'rejected', 'busy with an inference']
+
+# COMMAND_SHELL_MAX_RUNS and the pen up timeout range of command_shell.h.
+MAX_RUNS = 100
+MIN_PEN_UP_MS = 50
+MAX_PEN_UP_MS = 6500
+VERBOSITY = ['quiet', 'result', 'full']
+
+# Upper bound of a run on the Cortex-M0+, for the reply timeout.
+MAX_RUN_SECONDS = 0.5
+
+BENCHMARK_FORMAT = '<H3IQB'
+MEMORY_FORMAT = '<6I'
+SETTINGS_FORMAT = '<BHB'
+
+
+class Benchmark:
+
+    def __init__(self, data):
+        (self.runs, self.ticks_per_second, self.min_ticks, self.max_ticks,
+         self.total_ticks, self.prediction) = struct.unpack_from(
+             BENCHMARK_FORMAT, data)
+
+    def report(self):
+        if not self.runs:
+            return 'no benchmark run yet'
+        if not self.ticks_per_second:
+            return '%d runs, the board has no tick rate' % self.runs
+        scale = 1000.0 / self.ticks_per_second
+        prediction = ('below the threshold' if self.prediction > 9
+                      else self.prediction)
+        return ('%d runs: mean %.3f ms, fastest %.3f ms, slowest %.3f ms, '
+                'prediction %s' % (
+                    self.runs, self.total_ticks * scale / self.runs,
+                    self.min_ticks * scale, self.max_ticks * scale,
+                    prediction))
+
+
+class Settings:
+
+    def __init__(self, data):
+        (self.threshold, self.pen_up_ms,
+         self.verbosity) = struct.unpack_from(SETTINGS_FORMAT, data)
+
+    def pack(self):
+        return struct.pack(SETTINGS_FORMAT, self.threshold, self.pen_up_ms,
+                           self.verbosity)
+
+    def report(self):
+        verbosity = (VERBOSITY[self.verbosity]
+                     if self.verbosity < len(VERBOSITY) else self.verbosity)
+        return ('confidence threshold %d, pen up timeout %d ms, verbosity %s'
+                % (self.threshold, self.pen_up_ms, verbosity))
+
+
+def memory_report(data):
+    (stack_used, stack_headroom, stack_reserved, arena_size, arena_used,
+     arena_high_water) = struct.unpack_from(MEMORY_FORMAT, data)
+    lines = []
+    if stack_reserved:
+        lines.append('stack: %d bytes used, %d bytes of headroom, %d '
+                     'reserved' % (stack_used, stack_headroom,
+                                   stack_reserved))
+    else:
+        lines.append('stack: not measured, needs MEMORY_WATERMARKS')
+    lines.append('arena: %d of %d bytes allocated' % (arena_used,
+                                                     arena_size))
+    if arena_high_water:
+        lines.append('  the last inference reached %d bytes into it'
+                     % arena_high_water)
+    return '\n'.join(lines)
+
+
+class Shell(upload_model.Uploader):
+    """Sends the shell requests over the frames of the model upload."""
+
+    def call(self, command, payload=b'', timeout=None, retries=None):
+        """Returns the payload of the reply after its status."""
+        frame = upload_model.encode_frame(command, payload)
+        for _ in range(retries or self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + (timeout or self.timeout)
+            while time.monotonic() < deadline:
+                for reply, data in self.decoder.feed(self.port.read(64)):
+                    if reply != command | upload_model.REPLY or not data:
+                        continue
+                    if data[0] != 0:
+                        raise upload_model.UploadError(
+                            STATUS[data[0]] if data[0] < len(STATUS)
+                            else 'status %d' % data[0])
+                    return data[1:]
+        raise upload_model.UploadError('no reply to command 0x%02x'
+                                       % command)
+
+    def bench(self, runs):
+        # Sent once: a repeated request would run the benchmark again.
+        return Benchmark(self.call(
+            BENCH, struct.pack('<H', runs),
+            timeout=self.timeout + runs * MAX_RUN_SECONDS, retries=1))
+
+    def stats(self):
+        data = self.call(STATS)
+        return memory_report(data), Benchmark(
+            data[struct.calcsize(MEMORY_FORMAT):])
+
+    def settings(self):
+        return Settings(self.call(SETTINGS_GET))
+
+    def set_settings(self, settings):
+        return Settings(self.call(SETTINGS_SET, settings.pack()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--port', required=True,
+                        help='serial port, e.g. COM5 or /dev/ttyACM0')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--bench', type=int, metavar='N',
+                        help='invoke the CNN N times (1 to %d) on the test '
+                        'digit' % MAX_RUNS)
+    parser.add_argument('--stats', action='store_true',
+                        help='print the stack and arena usage')
+    parser.add_argument('--threshold', type=int,
+                        help='confidence threshold on the uint8 scores')
+    parser.add_argument('--pen-up-ms', type=int,
+                        help='time without a touch that ends a digit')
+    parser.add_argument('--verbosity', type=int,
+                        choices=range(len(VERBOSITY)),
+                        help='0 nothing, 1 the scores and the prediction, '
+                        '2 the input image too')
+    args = parser.parse_args()
+    if args.bench is not None and not 1 <= args.bench <= MAX_RUNS:
+        parser.error('--bench takes 1 to %d runs' % MAX_RUNS)
+    if args.threshold is not None and not 0 <= args.threshold <= 255:
+        parser.error('--threshold takes 0 to 255')
+    if args.pen_up_ms is not None and not (
+            MIN_PEN_UP_MS <= args.pen_up_ms <= MAX_PEN_UP_MS):
+        parser.error('--pen-up-ms takes %d to %d' % (MIN_PEN_UP_MS,
+                                                      MAX_PEN_UP_MS))
+
+    import serial
+    with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+        shell = Shell(port)
+        try:
+            settings = shell.settings()
+            changes = {'threshold': args.threshold,
+                       'pen_up_ms': args.pen_up_ms,
+                       'verbosity': args.verbosity}
+            if any(value is not None for value in changes.values()):
+                for name, value in changes.items():
+                    if value is not None:
+                        setattr(settings, name, value)
+                settings = shell.set_settings(settings)
+            print(settings.report())
+            if args.bench:
+                print(shell.bench(args.bench).report())
+            if args.stats:
+                memory, benchmark = shell.stats()
+                print(memory)
+                print('last benchmark: ' + benchmark.report())
+        except upload_model.UploadError as error:
+            sys.exit('Request failed: %s' % error)
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,180 @@
+"""Reads the stack and arena high-water marks of the board.
+
+With MEMORY_WATERMARKS set in src/config.h, the application paints the free
+RAM below its stack at start up (src/stack_watermark.h), and both models
+record how far into the tensor arena each node reaches, counting its tensors,
+scratch buffers and temp allocations
+(tflite::MicroInterpreter::EnableArenaWatermarks). The numbers are read out
+as binary records over the UART (src/memory_dump.h).
+
+This script reads the records with the binary frames of src/uart_frame.h,
+next to the text the application prints on the same UART, or from a file
+saved earlier with --save. It prints the stack usage and, for each model and
+node, the head high-water mark and the free arena left above it. The node
+names come from the models, by default the built-in gatekeeper and CNN, in
+the order the application registers them. --reset clears the arena
+watermarks on the board after reading them.
+
+Usage:
+    python memory_report.py --port COM5 [--baud 115200] [--save dump.bin]
+                            [--reset] [--models gatekeeper.cc cnn.tflite]
+    python memory_report.py --input dump.bin [--models ...]
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import pack_weights
+import profile_report
+import tflite_model
+import upload_model
+
+READ = 0x12
+RESET = 0x13
+
+SUMMARY_RECORD = 0
+MODEL_RECORD = 1
+RECORD_VERSION = 1
+
+# main.cpp registers the gatekeeper first, then the CNN.
+DEFAULT_MODELS = [pack_weights.DEFAULT_MODELS[1],
+                  pack_weights.DEFAULT_MODELS[0]]
+
+
+class Memory:
+
+    def __init__(self, records):
+        (kind, version, self.stack_used, self.stack_headroom,
+         self.stack_reserved, self.arena_size, self.tail_used,
+         num_models) = struct.unpack_from('<2B5IB', records[0])
+        if kind != SUMMARY_RECORD or version != RECORD_VERSION:
+            raise ValueError('unsupported summary record')
+        if len(records) != num_models + 1:
+            raise ValueError('%d model records for %d models'
+                             % (len(records) - 1, num_models))
+        self.models = []
+        for record in records[1:]:
+            kind, index, last, nodes = struct.unpack_from('<2BIB', record)
+            if kind != MODEL_RECORD:
+                raise ValueError('not a model record')
+            self.models.append(
+                (last, struct.unpack_from('<%dI' % nodes, record, 7)))
+
+    def report(self, names):
+        lines = ['stack: %d bytes used, %d bytes of headroom, %d reserved'
+                 % (self.stack_used, self.stack_headroom,
+                    self.stack_reserved)]
+        if self.stack_used > self.stack_reserved:
+            lines.append('  the stack runs %d bytes past its section into '
+                         'the heap RAM' % (self.stack_used -
+                                           self.stack_reserved))
+        head_size = self.arena_size - self.tail_used
+        lines.append('arena: %d bytes, %d in the tail, %d left for the head'
+                     % (self.arena_size, self.tail_used, head_size))
+        for m, (last, nodes) in enumerate(self.models):
+            model_names = names[m] if m < len(names) else []
+            peak = max(nodes) if nodes else last
+            lines.append('model %d: last inference %d, peak %d, %d bytes '
+                         'free' % (m, last, peak, head_size - peak))
+            width = max([len(name) for name in model_names] + [8])
+            lines.append('  %4s %-*s %8s %8s' % ('node', width, 'operator',
+                                                 'head', 'free'))
+            for i, watermark in enumerate(nodes):
+                name = model_names[i] if i < len(model_names) else ''
+                if watermark == 0:
+                    lines.append('  %4d %-*s %8s' % (i, width, name,
+                                                     'not run'))
+                else:
+                    lines.append('  %4d %-*s %8d %8d' % (
+                        i, width, name, watermark, head_size - watermark))
+        return '\n'.join(lines)
+
+
+class MemoryReader(upload_model.Uploader):
+    """Reads the records over the frames of the model upload."""
+
+    def record(self, index):
+        frame = upload_model.encode_frame(READ, bytes([index]))
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, data in self.decoder.feed(self.port.read(64)):
+                    if reply != READ | upload_model.REPLY or not data:
+                        continue
+                    if data[0] != 0:
+                        raise upload_model.UploadError(
+                            'no memory record %d' % index)
+                    # A late reply to an earlier request is skipped.
+                    if (data[1] == SUMMARY_RECORD) == (index == 0) and (
+                            index == 0 or data[2] == index - 1):
+                        return data[1:]
+        raise upload_model.UploadError('no reply to memory record %d'
+                                       % index)
+
+    def records(self):
+        summary = self.record(0)
+        num_models = struct.unpack_from('<2B5IB', summary)[7]
+        return [summary] + [self.record(i + 1) for i in range(num_models)]
+
+    def reset(self):
+        frame = upload_model.encode_frame(RESET)
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, _ in self.decoder.feed(self.port.read(64)):
+                    if reply == RESET | upload_model.REPLY:
+                        return
+        raise upload_model.UploadError('no reply to the watermark reset')
+
+
+def operator_names(path):
+    return [op.custom_code or op.opcode
+            for op in tflite_model.load_model(path).operators]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port, e.g. COM5 or '
+                        '/dev/ttyACM0')
+    source.add_argument('--input', help='records saved with --save')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--save', help='file to save the records read from '
+                        'the board to')
+    parser.add_argument('--reset', action='store_true',
+                        help='clear the arena watermarks on the board after '
+                        'reading them')
+    parser.add_argument('--models', nargs='*', default=DEFAULT_MODELS,
+                        help='.tflite files or C arrays of the models, in '
+                        'the order of the application, for the operator '
+                        'names')
+    args = parser.parse_args()
+    if args.input and (args.save or args.reset):
+        parser.error('--save and --reset need --port')
+
+    if args.input:
+        records = profile_report.load_records(args.input)
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+            reader = MemoryReader(port)
+            try:
+                records = reader.records()
+                if args.reset:
+                    reader.reset()
+            except upload_model.UploadError as error:
+                sys.exit('Read failed: %s' % error)
+        if args.save:
+            profile_report.save_records(args.save, records)
+
+    print(Memory(records).report([operator_names(path)
+                                  for path in args.models]))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
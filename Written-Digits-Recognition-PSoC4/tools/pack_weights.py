@@ -0,0 +1,259 @@
+"""Packs the weights of the models offline for the Cortex-M0+ kernels.
+
+ConvM0S8 and FullyConnectedM0S8 (tflm-cmsis/.../kernels/conv_m0.h) read their
+weights interleaved four output channels at a time, pre-widened to int16 and
+with the input offset folded into the bias (see PackedWeights). Packing them
+at Prepare time costs arena: twice the int8 weights plus the biases, so
+PreparePackedWeights only does it for layers up to
+TF_LITE_PACKED_WEIGHTS_ARENA_LIMIT bytes and leaves the larger ones on the
+CMSIS-NN path.
+
+This script packs the CONV_2D and FULLY_CONNECTED weights of the given models
+into a PackedWeightsTable that lives in flash, which the application hands to
+its interpreters with MicroInterpreter::SetPackedWeights. Entries are matched
+by a checksum of the weights, so a model uploaded over the UART that differs
+from the packed one is simply run without them.
+
+Layers with all zero 1x4 blocks (the weights of one input element in a group
+of four output channels), such as those pruned by prune_blocks.py, are packed
+block sparse when that takes less flash: the zero blocks are left out and a
+bitmap per group marks the blocks that are present. The kernels skip the
+missing blocks, so their MACs drop as well.
+
+FULLY_CONNECTED layers fed by a MEAN are left out: the fusion pass replaces
+them with the classifier head kernel, which does not use packed weights.
+
+Usage:
+    python pack_weights.py [model ...] [--output ../src/packed_weights]
+
+The defaults pack the two built-in models into src/packed_weights.h/.cpp;
+rerun it whenever one of them changes.
+"""
+
+import argparse
+import os
+import struct
+
+import tflite_model
+
+MODELS_DIR = os.path.join(os.path.dirname(__file__), '..', 'models')
+DEFAULT_MODELS = [
+    os.path.join(MODELS_DIR, 'written-digit-recognition-cnn-v3.0-8bit.cc'),
+    os.path.join(MODELS_DIR, 'digit-gatekeeper-8bit.cc'),
+]
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(__file__), '..', 'src',
+                              'packed_weights')
+
+# Output channels per group of interleaved weights, see PackedWeights.
+CHANNEL_BLOCK = 4
+
+FNV_OFFSET_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+
+def fnv1a(data, value=FNV_OFFSET_BASIS):
+    for byte in data:
+        value = ((value ^ byte) * FNV_PRIME) & 0xffffffff
+    return value
+
+
+def checksum(weights, bias, input_zero_point):
+    """Same as PackedWeightsChecksum in kernels/packed_weights.cc."""
+    value = fnv1a(struct.pack('<%db' % len(weights), *weights))
+    if bias is not None:
+        value = fnv1a(struct.pack('<%di' % len(bias), *bias), value)
+    return fnv1a(struct.pack('<i', input_zero_point), value)
+
+
+def block_map_words(depth):
+    """Same as PackedWeightsBlockMapWords in kernels/packed_weights.h."""
+    return (depth + 31) // 32
+
+
+def pack(weights, bias, output_depth, depth, input_offset, sparse=False):
+    """Same layout as PackWeights: the weights, then the folded biases.
+    Returns the packed words, and with |sparse| the bitmap of the blocks
+    kept (None otherwise) and their number."""
+    groups = (output_depth + CHANNEL_BLOCK - 1) // CHANNEL_BLOCK
+    words = []
+    folded_bias = []
+    block_map = [] if sparse else None
+    blocks = 0
+    for group in range(groups):
+        channels = range(group * CHANNEL_BLOCK, (group + 1) * CHANNEL_BLOCK)
+        sums = [0] * CHANNEL_BLOCK
+        bits = [0] * block_map_words(depth)
+        for i in range(depth):
+            w = [weights[c * depth + i] if c < output_depth else 0
+                 for c in channels]
+            if sparse and not any(w):
+                continue
+            bits[i // 32] |= 1 << (i % 32)
+            blocks += 1
+            sums = [s + v for s, v in zip(sums, w)]
+            for low, high in ((w[0], w[1]), (w[2], w[3])):
+                word = (low & 0xffff) | ((high & 0xffff) << 16)
+                words.append(word - (1 << 32) if word & 0x80000000 else word)
+        if sparse:
+            block_map.extend(bits)
+        for c, s in zip(channels, sums):
+            b = bias[c] if bias is not None and c < output_depth else 0
+            folded_bias.append(b + input_offset * s)
+    return words + folded_bias, block_map, blocks
+
+
+def packable_layers(model):
+    """Yields (operator, weights, bias, input zero point) of the layers the
+    M0 kernels run from packed weights."""
+    for op in model.operators:
+        if op.opcode not in ('CONV_2D', 'FULLY_CONNECTED'):
+            continue
+        input_tensor = model.tensors[op.inputs[0]]
+        filter_tensor = model.tensors[op.inputs[1]]
+        if (input_tensor.type != 'INT8' or filter_tensor.type != 'INT8' or
+                not model.is_constant(op.inputs[1])):
+            continue
+        if op.opcode == 'FULLY_CONNECTED':
+            if any(filter_tensor.zero_point):
+                continue
+            producers = [p for p in model.operators
+                         if op.inputs[0] in p.outputs]
+            if producers and producers[0].opcode == 'MEAN':
+                continue
+        buffer = model.buffers[filter_tensor.buffer]
+        weights = struct.unpack('<%db' % len(buffer), buffer)
+        bias = None
+        if len(op.inputs) > 2 and op.inputs[2] >= 0:
+            bias_buffer = model.buffers[model.tensors[op.inputs[2]].buffer]
+            bias = struct.unpack('<%di' % (len(bias_buffer) // 4),
+                                 bias_buffer)
+        zero_point = input_tensor.zero_point[0] if input_tensor.zero_point \
+            else 0
+        yield op, weights, bias, zero_point
+
+
+def c_int32(value):
+    # -2147483648 would be the negation of a literal too large for an int.
+    return '(-2147483647 - 1)' if value == -2 ** 31 else '%d' % value
+
+
+def write_table(path, entries, model_paths):
+    name = os.path.basename(path)
+    sources = ''.join(' *  %s\n' % os.path.basename(p) for p in model_paths)
+    guard = 'SRC_PACKED_WEIGHTS_H_'
+    with open(path + '.h', 'w') as f:
+        f.write('/*\n'
+                ' * %s.h\n'
+                ' *\n'
+                ' *  Generated by tools/pack_weights.py, do not edit, from:\n'
+                '%s'
+                ' *  Weights packed for the Cortex-M0+ kernels, see\n'
+                ' *  MicroInterpreter::SetPackedWeights.\n'
+                ' */\n\n'
+                '#ifndef %s\n'
+                '#define %s\n\n'
+                '#include "tensorflow/lite/micro/kernels/packed_weights.h"\n\n'
+                'extern const tflite::PackedWeightsTable packed_weights;\n\n'
+                '#endif /* %s */\n' % (name, sources, guard, guard, guard))
+
+    lines = ['/*',
+             ' * %s.cpp' % name,
+             ' *',
+             ' *  Generated by tools/pack_weights.py, do not edit, from:',
+             sources + ' */',
+             '',
+             '#include "%s.h"' % name,
+             '']
+    for index, entry in enumerate(entries):
+        lines.append('/* %s */' % entry['description'])
+        lines.append('static const int32_t packed_weights_%d[] = {' % index)
+        data = entry['data']
+        for i in range(0, len(data), 8):
+            chunk = ', '.join(c_int32(v) for v in data[i:i + 8])
+            lines.append('  ' + chunk + (',' if i + 8 < len(data) else ''))
+        lines.append('};')
+        lines.append('')
+        block_map = entry['block_map']
+        if block_map is not None:
+            lines.append('static const uint32_t packed_block_map_%d[] = {' %
+                         index)
+            for i in range(0, len(block_map), 6):
+                chunk = ', '.join('0x%08xu' % v for v in block_map[i:i + 6])
+                lines.append('  ' + chunk +
+                             (',' if i + 6 < len(block_map) else ''))
+            lines.append('};')
+            lines.append('')
+    lines.append('static const tflite::PackedWeightsEntry '
+                 'packed_weights_entries[] = {')
+    for index, entry in enumerate(entries):
+        if entry['block_map'] is None:
+            lines.append('  {0x%08xu, %d, %d, packed_weights_%d, nullptr, 0},' %
+                         (entry['checksum'], entry['output_depth'],
+                          entry['depth'], index))
+        else:
+            lines.append('  {0x%08xu, %d, %d, packed_weights_%d, '
+                         'packed_block_map_%d, %d},' %
+                         (entry['checksum'], entry['output_depth'],
+                          entry['depth'], index, index, entry['blocks']))
+    lines.append('};')
+    lines.append('')
+    lines.append('const tflite::PackedWeightsTable packed_weights = {')
+    lines.append('  packed_weights_entries, %d' % len(entries))
+    lines.append('};')
+    with open(path + '.cpp', 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('models', nargs='*', default=DEFAULT_MODELS,
+                        help='.tflite files or C arrays of the models')
+    parser.add_argument('--output', default=DEFAULT_OUTPUT,
+                        help='path of the .h/.cpp pair to write, without '
+                        'extension (default: ../src/packed_weights)')
+    args = parser.parse_args()
+
+    entries = []
+    print('model  operator  weights [B]  packed [B]  blocks kept')
+    for path in args.models:
+        model = tflite_model.load_model(path)
+        for op, weights, bias, zero_point in packable_layers(model):
+            output_depth = model.tensors[op.inputs[1]].shape[0]
+            depth = len(weights) // output_depth
+            data, block_map, blocks = pack(weights, bias, output_depth, depth,
+                                           -zero_point)
+            dense_blocks = blocks
+            sparse_data, sparse_map, sparse_blocks = pack(
+                weights, bias, output_depth, depth, -zero_point, sparse=True)
+            if len(sparse_data) + len(sparse_map) < len(data):
+                data, block_map, blocks = sparse_data, sparse_map, \
+                    sparse_blocks
+            entries.append({
+                'checksum': checksum(weights, bias, zero_point),
+                'output_depth': output_depth,
+                'depth': depth,
+                'data': data,
+                'block_map': block_map,
+                'blocks': blocks,
+                'description': '%s, operator %d (%s), %dx%d%s' %
+                               (os.path.basename(path), op.index, op.opcode,
+                                output_depth, depth,
+                                ', block sparse' if block_map else ''),
+            })
+            print('%s  %d %s  %d  %d  %d/%d' %
+                  (os.path.basename(path), op.index, op.opcode,
+                   len(weights) + (4 * len(bias) if bias else 0),
+                   4 * (len(data) + len(block_map or [])), blocks,
+                   dense_blocks))
+
+    write_table(args.output, entries, args.models)
+    print('%d layers, %d bytes of flash, written to %s.h/.cpp' %
+          (len(entries),
+           sum(4 * (len(e['data']) + len(e['block_map'] or []))
+               for e in entries),
+           os.path.normpath(args.output)))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,340 @@
+"""Picks the tile size for the patch based execution of a model.
+
+Patch based execution (see MicroInterpreter::SetPatchExecutionConfig) runs the
+leading CONV_2D / MAX_POOL_2D layers of the model tile by tile, so their
+intermediate activations never exist in full. Smaller tiles lower the arena
+peak but recompute more of the overlap between neighbouring receptive fields.
+
+For every candidate number of layers and tile size this script estimates the
+activation peak of the tensor arena, using the same receptive field and
+buffer sizing rules as the PATCH_CONV_STACK kernel, and the number of MACs
+compared to running the layers one after the other. It prints the
+arena-versus-latency trade-off, picks the configuration with the lowest peak
+within the allowed MAC overhead and can write it to src/patch_config.h.
+
+The arena estimate only covers activations and kernel scratch buffers; the
+persistent allocations of the interpreter come on top of it and do not depend
+on the tile size. The other operator fusions are not taken into account.
+
+Usage:
+    python patch_tile_planner.py [model] [--max-overhead 0.5] [--layers N]
+                                 [--all] [--output ../src/patch_config.h]
+"""
+
+import argparse
+import os
+
+import tflite_model
+
+DEFAULT_MODEL = os.path.join(os.path.dirname(__file__), '..', 'models',
+                             'written-digit-recognition-cnn-v3.0-8bit.cc')
+
+# Tensors in the arena are aligned to 16 bytes by the TFLM allocator.
+ARENA_ALIGNMENT = 16
+
+
+def align(size, alignment=ARENA_ALIGNMENT):
+    return (size + alignment - 1) // alignment * alignment
+
+
+def conv_scratch_size(input_depth, filter_height, filter_width):
+    # arm_convolve_s8_get_buffer_size() for cores without MVE.
+    return 2 * input_depth * filter_width * filter_height * 2
+
+
+class Layer:
+    """Geometry of a CONV_2D or MAX_POOL_2D layer of the patch stack."""
+
+    def __init__(self, model, op):
+        self.op = op
+        self.type = op.opcode
+        input_shape = model.tensors[op.inputs[0]].shape
+        output_shape = model.tensors[op.outputs[0]].shape
+        self.input_height, self.input_width, self.input_depth = input_shape[1:]
+        self.output_height, self.output_width, self.output_depth = (
+            output_shape[1:])
+        options = op.options
+        self.stride_height = options['stride_h']
+        self.stride_width = options['stride_w']
+        if self.type == 'CONV_2D':
+            filter_shape = model.tensors[op.inputs[1]].shape
+            self.filter_height, self.filter_width = filter_shape[1:3]
+            self.dilation_height = options['dilation_h']
+            self.dilation_width = options['dilation_w']
+        else:
+            self.filter_height = options['filter_h']
+            self.filter_width = options['filter_w']
+            self.dilation_height = 1
+            self.dilation_width = 1
+        self.padding_height = self._padding(
+            options['padding'], self.stride_height, self.dilation_height,
+            self.input_height, self.filter_height, self.output_height)
+        self.padding_width = self._padding(
+            options['padding'], self.stride_width, self.dilation_width,
+            self.input_width, self.filter_width, self.output_width)
+
+    @staticmethod
+    def _padding(padding, stride, dilation, in_size, filter_size, out_size):
+        # Same as ComputePaddingHeightWidth() in kernels/padding.h.
+        if padding != tflite_model.PADDING_SAME:
+            return 0
+        effective_filter_size = (filter_size - 1) * dilation + 1
+        return max(((out_size - 1) * stride + effective_filter_size - in_size)
+                   // 2, 0)
+
+    def macs_per_output(self):
+        """MACs (comparisons for pooling) per output element."""
+        macs = self.filter_height * self.filter_width
+        if self.type == 'CONV_2D':
+            macs *= self.input_depth
+        return macs
+
+    def scratch_size(self):
+        if self.type != 'CONV_2D':
+            return 0
+        return conv_scratch_size(self.input_depth, self.filter_height,
+                                 self.filter_width)
+
+
+def input_range(out_range, stride, dilation, filter_size, padding, in_size):
+    start = max(out_range[0] * stride - padding, 0)
+    end = min((out_range[1] - 1) * stride - padding +
+              (filter_size - 1) * dilation + 1, in_size)
+    return (start, end)
+
+
+def tile_ranges(layers, tile_rows, tile_cols):
+    """Receptive field of a tile, as in ComputeTileRanges() of the kernel."""
+    rows = [None] * len(layers) + [tile_rows]
+    cols = [None] * len(layers) + [tile_cols]
+    for l in range(len(layers) - 1, -1, -1):
+        layer = layers[l]
+        rows[l] = input_range(rows[l + 1], layer.stride_height,
+                              layer.dilation_height, layer.filter_height,
+                              layer.padding_height, layer.input_height)
+        cols[l] = input_range(cols[l + 1], layer.stride_width,
+                              layer.dilation_width, layer.filter_width,
+                              layer.padding_width, layer.input_width)
+    return rows, cols
+
+
+def size(r):
+    return r[1] - r[0]
+
+
+def evaluate_tiling(layers, tile_height, tile_width):
+    """Returns (tile buffer size, number of tiles, MACs) for one tiling."""
+    last = layers[-1]
+    tile_buffer_size = 0
+    macs = 0
+    tiles = 0
+    for y in range(0, last.output_height, tile_height):
+        for x in range(0, last.output_width, tile_width):
+            tiles += 1
+            rows, cols = tile_ranges(
+                layers, (y, min(y + tile_height, last.output_height)),
+                (x, min(x + tile_width, last.output_width)))
+            for l, layer in enumerate(layers):
+                tile_buffer_size = max(
+                    tile_buffer_size,
+                    size(rows[l]) * size(cols[l]) * layer.input_depth)
+                macs += (size(rows[l + 1]) * size(cols[l + 1]) *
+                         layer.output_depth * layer.macs_per_output())
+            tile_buffer_size = max(
+                tile_buffer_size,
+                size(rows[-1]) * size(cols[-1]) * last.output_depth)
+    return (tile_buffer_size + 3) & ~3, tiles, macs
+
+
+def patch_stack(model, num_layers):
+    """Returns the layers patch based execution would cover, or None."""
+    first = next((op for op in model.operators if op.opcode == 'CONV_2D'),
+                 None)
+    if first is None:
+        return None
+    ops = model.operators[first.index:first.index + num_layers]
+    if len(ops) < num_layers:
+        return None
+    for i, op in enumerate(ops):
+        if op.opcode not in ('CONV_2D', 'MAX_POOL_2D'):
+            return None
+        if len(model.tensors[op.inputs[0]].shape) != 4:
+            return None
+        if i + 1 < len(ops):
+            consumers = model.consumers(op.outputs[0])
+            if consumers != [ops[i + 1]] or op.outputs[0] in model.outputs:
+                return None
+    return [Layer(model, op) for op in ops]
+
+
+def lifetimes(model):
+    """First and last operator index at which each activation is live."""
+    result = {}
+    for op in model.operators:
+        for tensor in op.inputs + op.outputs:
+            if tensor < 0 or model.is_constant(tensor):
+                continue
+            first, _ = result.get(tensor, (op.index, op.index))
+            result[tensor] = (first, op.index)
+    for tensor in model.inputs:
+        result[tensor] = (0, result.get(tensor, (0, 0))[1])
+    last_op = len(model.operators) - 1
+    for tensor in model.outputs:
+        result[tensor] = (result.get(tensor, (last_op, last_op))[0], last_op)
+    return result
+
+
+def op_scratch_size(model, op):
+    if op.opcode != 'CONV_2D':
+        return 0
+    input_depth = model.tensors[op.inputs[0]].shape[3]
+    filter_shape = model.tensors[op.inputs[1]].shape
+    return conv_scratch_size(input_depth, filter_shape[1], filter_shape[2])
+
+
+def arena_peak(model, layers=None, tile_buffer_size=0):
+    """Activation peak of the arena, with |layers| run as a patch stack."""
+    live = lifetimes(model)
+    covered = set()
+    stack_scratch = 0
+    if layers:
+        covered = {layer.op.index for layer in layers}
+        for layer in layers[:-1]:
+            del live[layer.op.outputs[0]]
+        # The stack writes its output while it reads its input.
+        output = layers[-1].op.outputs[0]
+        live[output] = (layers[0].op.index, live[output][1])
+        stack_scratch = (align(2 * tile_buffer_size) +
+                         align(max(layer.scratch_size() for layer in layers)))
+    peak = 0
+    for op in model.operators:
+        in_use = sum(align(model.tensors[t].bytes())
+                     for t, (first, last) in live.items()
+                     if first <= op.index <= last)
+        if op.index in covered:
+            in_use += stack_scratch
+        else:
+            in_use += align(op_scratch_size(model, op))
+        peak = max(peak, in_use)
+    return peak
+
+
+def plan(model, layer_counts):
+    baseline_peak = arena_peak(model)
+    results = []
+    for num_layers in layer_counts:
+        layers = patch_stack(model, num_layers)
+        if layers is None:
+            continue
+        baseline_macs = sum(layer.output_height * layer.output_width *
+                            layer.output_depth * layer.macs_per_output()
+                            for layer in layers)
+        last = layers[-1]
+        for tile_height in range(1, last.output_height + 1):
+            for tile_width in range(1, last.output_width + 1):
+                tile_buffer_size, tiles, macs = evaluate_tiling(
+                    layers, tile_height, tile_width)
+                results.append({
+                    'layers': num_layers,
+                    'tile_height': tile_height,
+                    'tile_width': tile_width,
+                    'tiles': tiles,
+                    'peak': arena_peak(model, layers, tile_buffer_size),
+                    'overhead': macs / baseline_macs - 1.0,
+                })
+    return baseline_peak, results
+
+
+def pareto_front(results):
+    """Configurations not beaten in both arena peak and MAC overhead."""
+    front = []
+    best_overhead = None
+    for result in sorted(results, key=lambda r: (r['peak'], r['overhead'],
+                                                 r['tiles'])):
+        if best_overhead is None or result['overhead'] < best_overhead:
+            front.append(result)
+            best_overhead = result['overhead']
+    return front
+
+
+def write_config(path, config, model_path):
+    guard = 'SRC_PATCH_CONFIG_H_'
+    with open(path, 'w') as f:
+        f.write('/*\n'
+                ' * patch_config.h\n'
+                ' *\n'
+                ' *  Generated by tools/patch_tile_planner.py from\n'
+                ' *  %s, do not edit.\n'
+                ' *  Estimated activation peak: %d bytes, MAC overhead: %.1f%%.\n'
+                ' *  Set PATCH_NUM_LAYERS to 0 to disable patch based '
+                'execution.\n'
+                ' */\n\n'
+                '#ifndef %s\n'
+                '#define %s\n\n'
+                '#define PATCH_NUM_LAYERS %d\n'
+                '#define PATCH_TILE_HEIGHT %d\n'
+                '#define PATCH_TILE_WIDTH %d\n\n'
+                '#endif /* %s */\n' %
+                (os.path.basename(model_path), config['peak'],
+                 100.0 * config['overhead'], guard, guard, config['layers'],
+                 config['tile_height'], config['tile_width'], guard))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', nargs='?', default=DEFAULT_MODEL,
+                        help='.tflite file or C array of the model')
+    parser.add_argument('--max-overhead', type=float, default=0.5,
+                        help='largest MAC overhead allowed, as a fraction of '
+                        'the MACs of the covered layers (default: 0.5)')
+    parser.add_argument('--layers', type=int, default=0,
+                        help='number of layers to cover (default: try all)')
+    parser.add_argument('--all', action='store_true',
+                        help='print every configuration, not only the '
+                        'Pareto-optimal ones')
+    parser.add_argument('--output', help='header to write the chosen '
+                        'configuration to, e.g. ../src/patch_config.h')
+    args = parser.parse_args()
+
+    model = tflite_model.load_model(args.model)
+    layer_counts = [args.layers] if args.layers else range(1, 9)
+    baseline_peak, results = plan(model, layer_counts)
+    if not results:
+        print('The model has no CONV_2D / MAX_POOL_2D stack to run patch '
+              'based.')
+        return 1
+
+    print('Activation peak without patch based execution: %d bytes\n' %
+          baseline_peak)
+    print('layers  tile    tiles  peak [B]  saved [B]  MAC overhead')
+    for result in results if args.all else pareto_front(results):
+        print('%6d  %2dx%-2d  %5d  %8d  %9d  %11.1f%%' %
+              (result['layers'], result['tile_height'], result['tile_width'],
+               result['tiles'], result['peak'],
+               baseline_peak - result['peak'], 100.0 * result['overhead']))
+
+    allowed = [r for r in results if r['overhead'] <= args.max_overhead]
+    if not allowed:
+        print('\nNo configuration within a MAC overhead of %.1f%%.' %
+              (100.0 * args.max_overhead))
+        return 1
+    best = min(allowed, key=lambda r: (r['peak'], r['overhead'], r['tiles']))
+    if best['peak'] >= baseline_peak:
+        best = {'layers': 0, 'tile_height': 0, 'tile_width': 0, 'tiles': 0,
+                'peak': baseline_peak, 'overhead': 0.0}
+        print('\nPatch based execution does not lower the peak, keep it '
+              'disabled.')
+    else:
+        print('\nChosen: %d layers, %dx%d tiles, %d bytes peak (%d saved), '
+              '%.1f%% more MACs.' %
+              (best['layers'], best['tile_height'], best['tile_width'],
+               best['peak'], baseline_peak - best['peak'],
+               100.0 * best['overhead']))
+    if args.output:
+        write_config(args.output, best, args.model)
+        print('Written to %s' % args.output)
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,257 @@
+"""Reads the profiling statistics of the board and renders them.
+
+With PROFILE_OUTPUT set in src/config.h, the application runs both models
+with a tflite::MicroAggregateProfiler
+(tflm-cmsis/.../micro_aggregate_profiler.h). It keeps count, minimum,
+maximum, sum, sum of squares and a log2 histogram of the ticks of every tag
+(operator or application stage) under each parent tag, and hands them out as
+binary records over the UART (src/profile_dump.h).
+
+This script reads the records with the binary frames of src/uart_frame.h,
+next to the text the application prints on the same UART, or from a file
+saved earlier with --save. It prints a table of the statistics and a flame
+chart in text, and with --folded writes the self time of every stack in the
+folded format of flamegraph.pl and speedscope. --clear resets the statistics
+on the board after reading them.
+
+Usage:
+    python profile_report.py --port COM5 [--baud 115200] [--save dump.bin]
+                             [--folded profile.folded] [--clear]
+    python profile_report.py --input dump.bin [--folded profile.folded]
+"""
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+import upload_model
+
+READ = 0x10
+CLEAR = 0x11
+
+SUMMARY_RECORD = 0
+TAG_RECORD = 1
+RECORD_VERSION = 1
+NO_PARENT = 0xff
+
+CHART_WIDTH = 60
+
+
+class Tag:
+    """The statistics of a tag under its parent."""
+
+    def __init__(self, record):
+        kind, self.index, self.parent, length = struct.unpack_from(
+            '<4B', record)
+        if kind != TAG_RECORD:
+            raise ValueError('not a tag record')
+        self.name = record[4:4 + length].decode('ascii', 'replace')
+        (self.count, self.min, self.max, self.sum, self.sum_squares,
+         self.first_bin, bins) = struct.unpack_from('<3I2Q2B', record,
+                                                     4 + length)
+        self.histogram = struct.unpack_from('<%dH' % bins, record,
+                                            4 + length + 30)
+        self.children = []
+
+    def mean(self):
+        return self.sum / self.count if self.count else 0.0
+
+    def std(self):
+        if self.count == 0:
+            return 0.0
+        variance = self.sum_squares / self.count - self.mean() ** 2
+        return math.sqrt(max(variance, 0.0))
+
+    def median_range(self):
+        """Tick range of the histogram bin holding the median."""
+        seen = 0
+        for offset, count in enumerate(self.histogram):
+            seen += count
+            if 2 * seen >= self.count:
+                bin_index = self.first_bin + offset
+                if bin_index == 0:
+                    return 0, 0
+                return 1 << (bin_index - 1), (1 << bin_index) - 1
+        return 0, 0
+
+
+class Profile:
+
+    def __init__(self, records):
+        kind, version, self.ticks_per_second, num_tags, self.dropped = \
+            struct.unpack_from('<2BIBI', records[0])
+        if kind != SUMMARY_RECORD or version != RECORD_VERSION:
+            raise ValueError('unsupported summary record')
+        if len(records) != num_tags + 1:
+            raise ValueError('%d tag records for %d tags'
+                             % (len(records) - 1, num_tags))
+        self.records = records
+        self.tags = [Tag(record) for record in records[1:]]
+        self.roots = []
+        for tag in self.tags:
+            if tag.parent == NO_PARENT:
+                self.roots.append(tag)
+            else:
+                self.tags[tag.parent].children.append(tag)
+
+    def walk(self, tags=None, depth=0):
+        """Yields (depth, tag) depth first."""
+        for tag in self.roots if tags is None else tags:
+            yield depth, tag
+            yield from self.walk(tag.children, depth + 1)
+
+    def time(self, ticks):
+        if not self.ticks_per_second:
+            return '%d ticks' % ticks
+        us = 1e6 * ticks / self.ticks_per_second
+        return '%.1f ms' % (us / 1000) if us >= 10000 else '%.1f us' % us
+
+    def table(self):
+        width = max([len('  ' * depth + tag.name)
+                     for depth, tag in self.walk()] + [3])
+        lines = ['%-*s %8s %11s %11s %11s %11s %13s' %
+                 (width, 'tag', 'count', 'mean', 'std', 'min', 'max',
+                  'median in')]
+        for depth, tag in self.walk():
+            low, high = tag.median_range()
+            lines.append('%-*s %8d %11s %11s %11s %11s %13s' % (
+                width, '  ' * depth + tag.name, tag.count,
+                self.time(tag.mean()), self.time(tag.std()),
+                self.time(tag.min), self.time(tag.max),
+                '%d..%d' % (low, high)))
+        if self.dropped:
+            lines.append('%d events dropped: more tags or nesting than the '
+                         'profiler keeps' % self.dropped)
+        return '\n'.join(lines)
+
+    def flame_chart(self):
+        """One bar per tag, its total time relative to the largest root,
+        indented under its parent."""
+        total = max([tag.sum for tag in self.roots] + [1])
+        lines = []
+        for depth, tag in self.walk():
+            width = max(1, round(CHART_WIDTH * tag.sum / total))
+            lines.append('%s%s %s %s' % ('  ' * depth, '#' * width, tag.name,
+                                         self.time(tag.sum)))
+        return '\n'.join(lines)
+
+    def folded(self):
+        """Folded stacks with the self ticks of every tag."""
+        lines = []
+
+        def visit(tag, stack):
+            stack = stack + [tag.name]
+            self_ticks = tag.sum - sum(child.sum for child in tag.children)
+            if self_ticks > 0:
+                lines.append('%s %d' % (';'.join(stack), self_ticks))
+            for child in tag.children:
+                visit(child, stack)
+
+        for root in self.roots:
+            visit(root, [])
+        return '\n'.join(lines) + '\n'
+
+
+class ProfileReader(upload_model.Uploader):
+    """Reads the records over the frames of the model upload."""
+
+    def record(self, index):
+        frame = upload_model.encode_frame(READ, bytes([index]))
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, data in self.decoder.feed(self.port.read(64)):
+                    if reply != READ | upload_model.REPLY or not data:
+                        continue
+                    if data[0] != 0:
+                        raise upload_model.UploadError(
+                            'no profile record %d' % index)
+                    # A late reply to an earlier request is skipped.
+                    if (data[1] == SUMMARY_RECORD) == (index == 0) and (
+                            index == 0 or data[2] == index - 1):
+                        return data[1:]
+        raise upload_model.UploadError('no reply to profile record %d'
+                                       % index)
+
+    def records(self):
+        summary = self.record(0)
+        num_tags = struct.unpack_from('<2BIB', summary)[3]
+        return [summary] + [self.record(i + 1) for i in range(num_tags)]
+
+    def clear(self):
+        frame = upload_model.encode_frame(CLEAR)
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, _ in self.decoder.feed(self.port.read(64)):
+                    if reply == CLEAR | upload_model.REPLY:
+                        return
+        raise upload_model.UploadError('no reply to the profile clear')
+
+
+def save_records(path, records):
+    with open(path, 'wb') as f:
+        for record in records:
+            f.write(struct.pack('<H', len(record)) + record)
+
+
+def load_records(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    records = []
+    offset = 0
+    while offset < len(data):
+        length, = struct.unpack_from('<H', data, offset)
+        records.append(data[offset + 2:offset + 2 + length])
+        offset += 2 + length
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port, e.g. COM5 or '
+                        '/dev/ttyACM0')
+    source.add_argument('--input', help='records saved with --save')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--save', help='file to save the records read from '
+                        'the board to')
+    parser.add_argument('--folded', help='file to write the folded stacks to')
+    parser.add_argument('--clear', action='store_true',
+                        help='reset the statistics on the board after '
+                        'reading them')
+    args = parser.parse_args()
+    if args.input and (args.save or args.clear):
+        parser.error('--save and --clear need --port')
+
+    if args.input:
+        records = load_records(args.input)
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+            reader = ProfileReader(port)
+            try:
+                records = reader.records()
+                if args.clear:
+                    reader.clear()
+            except upload_model.UploadError as error:
+                sys.exit('Read failed: %s' % error)
+        if args.save:
+            save_records(args.save, records)
+
+    profile = Profile(records)
+    print(profile.table())
+    print()
+    print(profile.flame_chart())
+    if args.folded:
+        with open(args.folded, 'w') as f:
+            f.write(profile.folded())
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
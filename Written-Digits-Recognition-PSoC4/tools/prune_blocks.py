@@ -0,0 +1,161 @@
+"""Prunes the weights of a model in 1x4 blocks for the block sparse kernels.
+
+The Cortex-M0+ kernels read their weights packed four output channels at a
+time (PackedWeights in tflm-cmsis/.../kernels/packed_weights.h). A block is
+the four weights of one input element in such a group of channels; when all
+four are zero, pack_weights.py leaves the block out of the packed table and
+the kernels skip it, so flash and MACs drop with the share of zero blocks.
+
+This script zeroes the blocks with the smallest magnitude (the sum of the
+absolute real weights, with the per channel scales applied) of the selected
+CONV_2D and FULLY_CONNECTED layers, in place in the flatbuffer, until the
+given share of blocks of each layer is zero. The rest of the model is left as
+it is. The weights are not fine-tuned after pruning.
+
+Unless --samples is 0, it then runs the original and the pruned model on the
+recorded digits with the integer evaluation of winograd_filters.py and
+compares their accuracy.
+
+The result is a .tflite file. Pack its weights with pack_weights.py for the
+block sparse kernels to be used.
+
+Usage:
+    python prune_blocks.py [model] [--sparsity 0.5] [--layers 2 3]
+                           [--output ../models/...-pruned.tflite]
+                           [--dataset ../data_collection/...csv]
+                           [--samples N]
+"""
+
+import argparse
+import os
+import struct
+
+import pack_weights
+import tflite_model
+import winograd_filters
+
+TOOLS_DIR = os.path.dirname(__file__)
+DEFAULT_MODEL = os.path.join(TOOLS_DIR, '..', 'models',
+                             'written-digit-recognition-cnn-v3.0-8bit.cc')
+DEFAULT_OUTPUT = os.path.join(TOOLS_DIR, '..', 'models',
+                              'written-digit-recognition-cnn-v3.0-pruned.tflite')
+
+
+def block_magnitudes(weights, scales, output_depth, depth):
+    """Returns {(group, element): magnitude} of the 1x4 blocks."""
+    block = pack_weights.CHANNEL_BLOCK
+    magnitudes = {}
+    for group in range((output_depth + block - 1) // block):
+        channels = range(group * block, min((group + 1) * block, output_depth))
+        for i in range(depth):
+            magnitudes[group, i] = sum(
+                abs(weights[c * depth + i]) *
+                scales[c if len(scales) > 1 else 0] for c in channels)
+    return magnitudes
+
+
+def prune_layer(model, editor, op, weights, sparsity):
+    """Zeroes the smallest blocks of |op| and returns the pruned weights and
+    the number of blocks kept and in total."""
+    filter_tensor = model.tensors[op.inputs[1]]
+    output_depth = filter_tensor.shape[0]
+    depth = len(weights) // output_depth
+    magnitudes = block_magnitudes(weights, filter_tensor.scale, output_depth,
+                                  depth)
+    order = sorted(magnitudes, key=lambda key: magnitudes[key])
+    pruned = list(weights)
+    for group, i in order[:int(round(sparsity * len(order)))]:
+        for c in range(group * pack_weights.CHANNEL_BLOCK,
+                       min((group + 1) * pack_weights.CHANNEL_BLOCK,
+                           output_depth)):
+            pruned[c * depth + i] = 0
+    editor.set_buffer(filter_tensor.buffer,
+                      struct.pack('<%db' % len(pruned), *pruned))
+    kept = sum(1 for group, i in order if any(
+        pruned[c * depth + i] for c in range(
+            group * pack_weights.CHANNEL_BLOCK,
+            min((group + 1) * pack_weights.CHANNEL_BLOCK, output_depth))))
+    return pruned, kept, len(order)
+
+
+def packed_bytes(weights, bias, output_depth, depth, zero_point):
+    """Flash of the packed weights, dense and block sparse."""
+    dense, _, _ = pack_weights.pack(weights, bias, output_depth, depth,
+                                    -zero_point)
+    sparse, block_map, _ = pack_weights.pack(weights, bias, output_depth,
+                                             depth, -zero_point, sparse=True)
+    return 4 * len(dense), 4 * (len(sparse) + len(block_map))
+
+
+def accuracy(model, digits):
+    network = winograd_filters.Network(model)
+    correct = sum(network.predict(image, {}, {}) == label
+                  for label, image in digits)
+    return correct / len(digits)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', nargs='?', default=DEFAULT_MODEL,
+                        help='.tflite file or C array of the model')
+    parser.add_argument('--sparsity', type=float, default=0.5,
+                        help='share of the blocks of every layer to zero '
+                        '(default: %(default)s)')
+    parser.add_argument('--layers', type=int, nargs='*',
+                        help='operator indices of the layers to prune '
+                        '(default: all the ones with packed weights)')
+    parser.add_argument('--output', default=DEFAULT_OUTPUT,
+                        help='.tflite file to write (default: '
+                        '%(default)s)')
+    parser.add_argument('--dataset', default=winograd_filters.DEFAULT_DATASET,
+                        help='CSV of recorded digits (default: %(default)s)')
+    parser.add_argument('--samples', type=int, default=-1,
+                        help='number of digits to evaluate, 0 to skip the '
+                        'evaluation (default: all)')
+    args = parser.parse_args()
+    if not 0.0 <= args.sparsity < 1.0:
+        parser.error('--sparsity has to be in [0, 1)')
+
+    model = tflite_model.load_model(args.model)
+    candidates = {op.index: (op, weights, bias, zero_point)
+                  for op, weights, bias, zero_point in
+                  pack_weights.packable_layers(model)}
+    layers = sorted(candidates) if args.layers is None else args.layers
+    for index in layers:
+        if index not in candidates:
+            parser.error('operator %d has no packed weights' % index)
+
+    editor = tflite_model.ModelEditor(model.data)
+    print('operator  blocks kept  MACs per output  packed [B] dense  sparse')
+    for index in layers:
+        op, weights, bias, zero_point = candidates[index]
+        output_depth = model.tensors[op.inputs[1]].shape[0]
+        depth = len(weights) // output_depth
+        pruned, kept, total = prune_layer(model, editor, op, weights,
+                                          args.sparsity)
+        dense, sparse = packed_bytes(pruned, bias, output_depth, depth,
+                                     zero_point)
+        print('%d %s  %d/%d  %d -> %d  %d  %d' %
+              (index, op.opcode, kept, total,
+               total * pack_weights.CHANNEL_BLOCK,
+               kept * pack_weights.CHANNEL_BLOCK, dense, sparse))
+
+    data = bytes(editor.data)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    print('model written to %s' % os.path.normpath(args.output))
+
+    if args.samples == 0:
+        return 0
+    digits = winograd_filters.load_digits(args.dataset)
+    if args.samples > 0:
+        digits = digits[:args.samples]
+    before = accuracy(model, digits)
+    after = accuracy(tflite_model.Model(data), digits)
+    print('%d digits: accuracy %.4f dense, %.4f pruned (delta %+.4f)' %
+          (len(digits), before, after, after - before))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,186 @@
+"""Requantizes the CONV_2D filters of a model to int4.
+
+The Cortex-M0+ convolution reads int4 filters in place (ConvM0S4 in
+tflm-cmsis/.../kernels/conv_m0.h): two weights per byte in the TFLite int4
+layout, unpacked with shifts in the inner loop. They take half the flash of
+int8 filters, and a quarter of the int8 filters packed by pack_weights.py,
+and need no arena apart from the folded biases.
+
+This script rewrites the int8 per channel filters of the selected CONV_2D
+layers as int4, in place in the flatbuffer: the tensor type, the packed
+weights, the per channel scales of the filter and of the bias, and the bias
+rescaled to them. The rest of the model is left as it is. Every output
+channel gets a symmetric scale of max |w| / 7: clipping the largest weights
+for a smaller quantization step costs more accuracy on this model than it
+saves.
+
+Unless --samples is 0, it then runs the int8 and the int4 model on the
+recorded digits with the integer evaluation of winograd_filters.py and
+compares their accuracy.
+
+The result is a .tflite file, which can be sent to the board with
+upload_model.py.
+
+Usage:
+    python quantize_int4.py [model] [--layers 1 2 3]
+                            [--output ../models/...-4bit.tflite]
+                            [--dataset ../data_collection/...csv]
+                            [--samples N]
+"""
+
+import argparse
+import math
+import os
+import struct
+
+import tflite_model
+import winograd_filters
+
+TOOLS_DIR = os.path.dirname(__file__)
+DEFAULT_MODEL = os.path.join(TOOLS_DIR, '..', 'models',
+                             'written-digit-recognition-cnn-v3.0-8bit.cc')
+DEFAULT_OUTPUT = os.path.join(TOOLS_DIR, '..', 'models',
+                              'written-digit-recognition-cnn-v3.0-4bit.tflite')
+
+INT4_MAX = 7
+
+
+def round_half_away(x):
+    return int(math.copysign(math.floor(abs(x) + 0.5), x))
+
+
+def quantize_channel(weights):
+    """Returns the int4 weights, on a symmetric scale of max |w| / 7, and the
+    ratio of their scale to the int8 one."""
+    step = max(abs(w) for w in weights) / INT4_MAX
+    if step == 0:
+        return [0] * len(weights), 1.0
+    return [round_half_away(w / step) for w in weights], step
+
+
+def pack_int4(values):
+    """TFLite packed int4: two elements per byte, low nibble first."""
+    data = bytearray((len(values) + 1) // 2)
+    for i, value in enumerate(values):
+        data[i // 2] |= (value & 0xf) << (4 * (i % 2))
+    return bytes(data)
+
+
+def eligible(model, op):
+    if op.opcode != 'CONV_2D' or not model.is_constant(op.inputs[1]):
+        return False
+    filter_tensor = model.tensors[op.inputs[1]]
+    return (filter_tensor.type == 'INT8' and
+            len(filter_tensor.scale) == filter_tensor.shape[0] and
+            model.tensors[op.inputs[0]].type == 'INT8')
+
+
+def requantize_layer(model, editor, op):
+    """Rewrites the filter and bias of |op| and returns the size of the
+    filter before and after, and the RMS weight error relative to the
+    largest weight."""
+    filter_tensor = model.tensors[op.inputs[1]]
+    input_scale = model.tensors[op.inputs[0]].scale[0]
+    output_depth = filter_tensor.shape[0]
+    depth = filter_tensor.elements() // output_depth
+    buffer = model.buffers[filter_tensor.buffer]
+    weights = struct.unpack('<%db' % len(buffer), buffer)
+    has_bias = len(op.inputs) > 2 and op.inputs[2] >= 0
+    if has_bias:
+        bias_tensor = model.tensors[op.inputs[2]]
+        bias = list(struct.unpack('<%di' % output_depth,
+                                  model.buffers[bias_tensor.buffer]))
+
+    quantized = []
+    scales = []
+    squared_error = 0.0
+    largest = 0.0
+    for channel in range(output_depth):
+        scale = filter_tensor.scale[channel]
+        channel_weights = weights[channel * depth:(channel + 1) * depth]
+        values, step = quantize_channel(channel_weights)
+        quantized.extend(values)
+        scales.append(scale * step)
+        squared_error += sum(((w - q * step) * scale) ** 2
+                             for w, q in zip(channel_weights, values))
+        largest = max(largest,
+                      max(abs(w) for w in channel_weights) * scale)
+        if has_bias:
+            bias[channel] = round_half_away(bias[channel] / step)
+
+    editor.set_tensor_type(op.inputs[1], 'INT4')
+    editor.set_buffer(filter_tensor.buffer, pack_int4(quantized))
+    editor.set_scales(op.inputs[1], scales)
+    if has_bias:
+        editor.set_buffer(bias_tensor.buffer,
+                          struct.pack('<%di' % output_depth, *bias))
+        editor.set_scales(op.inputs[2], [input_scale * s for s in scales])
+    error = math.sqrt(squared_error / len(weights)) / largest
+    return len(buffer), (len(quantized) + 1) // 2, error
+
+
+def accuracy(model, digits):
+    network = winograd_filters.Network(model)
+    correct = sum(network.predict(image, {}, {}) == label
+                  for label, image in digits)
+    return correct / len(digits)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', nargs='?', default=DEFAULT_MODEL,
+                        help='.tflite file or C array of the model')
+    parser.add_argument('--layers', type=int, nargs='*',
+                        help='operator indices of the CONV_2D layers to '
+                        'requantize (default: all the int8 per channel ones)')
+    parser.add_argument('--output', default=DEFAULT_OUTPUT,
+                        help='.tflite file to write (default: '
+                        '%(default)s)')
+    parser.add_argument('--dataset', default=winograd_filters.DEFAULT_DATASET,
+                        help='CSV of recorded digits (default: %(default)s)')
+    parser.add_argument('--samples', type=int, default=-1,
+                        help='number of digits to evaluate, 0 to skip the '
+                        'evaluation (default: all)')
+    args = parser.parse_args()
+
+    model = tflite_model.load_model(args.model)
+    candidates = [op.index for op in model.operators if eligible(model, op)]
+    layers = candidates if args.layers is None else args.layers
+    for index in layers:
+        if index not in candidates:
+            parser.error('operator %d is not a CONV_2D with constant int8 per '
+                         'channel weights' % index)
+
+    editor = tflite_model.ModelEditor(model.data)
+    print('operator  filter  int8 bytes  int4 bytes  RMS error')
+    total_before = total_after = 0
+    for index in layers:
+        op = model.operators[index]
+        before, after, error = requantize_layer(model, editor, op)
+        total_before += before
+        total_after += after
+        print('%d  %s  %d  %d  %.2f%%' %
+              (index, 'x'.join(map(str, model.tensors[op.inputs[1]].shape)),
+               before, after, 100.0 * error))
+    print('%d layers: %d bytes of weights instead of %d' %
+          (len(layers), total_after, total_before))
+
+    data = bytes(editor.data)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    print('model written to %s' % os.path.normpath(args.output))
+
+    if args.samples == 0:
+        return 0
+    digits = winograd_filters.load_digits(args.dataset)
+    if args.samples > 0:
+        digits = digits[:args.samples]
+    before = accuracy(model, digits)
+    after = accuracy(tflite_model.Model(data), digits)
+    print('%d digits: accuracy %.4f int8, %.4f int4 (delta %+.4f)' %
+          (len(digits), before, after, after - before))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
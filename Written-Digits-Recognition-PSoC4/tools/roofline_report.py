@@ -0,0 +1,457 @@
+"""Predicts the latency of each layer of a model on the Cortex-M0+.
+
+For every operator of the model this script counts, from the flatbuffer
+alone:
+- the MACs (comparisons and additions for pooling and means)
+- the weight bytes read from flash
+- the activation bytes read from and written to the arena
+- the scratch buffer the kernel asks for
+
+The traffic follows the kernels the application runs. ConvM0S8 builds an
+im2col column per output pixel and streams the packed weights (int16 pairs,
+see pack_weights.py) once per pixel. FullyConnectedM0S8 reads its input once
+per group of four output channels. The layers pack_weights.py leaves out run
+from their int8 weights.
+
+The predicted cycles are
+
+    MACs * cycles per MAC + bytes * cycles per byte
+        + output elements * cycles per output
+
+with the last term for the requantization of each output. The Cortex-M0+
+has no cache and does not overlap its loads with arithmetic, so the compute
+and memory times add up. Each layer is also placed on a roofline: its
+arithmetic intensity in MACs per byte against the ridge point, where both
+times are equal. Layers left of the ridge are memory-bound and gain from
+less traffic, such as smaller weights or fusion. Layers right of it are
+compute-bound and gain from fewer MACs, such as sparsity or Winograd.
+
+The operators are grouped into the nodes the interpreter runs after
+FuseOperators: PATCH_CONV_STACK with the tiling of src/patch_config.h,
+CONV_2D_MAX_POOL_2D and the classifier head. A fused node is costed as the
+sum of its layers. The patch stack also pays for its recomputed overlap.
+The sparse input skipping of the convolutions is not modelled, so drawn
+digits run faster than predicted.
+
+With --profile, the prediction is compared with the statistics of
+tools/profile_report.py (saved with --save), tag by tag under the parent
+tag of the model. --calibrate fits the three constants to the measurement,
+to be passed back with --cycles-per-mac, --cycles-per-byte and
+--cycles-per-output.
+
+Usage:
+    python roofline_report.py [model] [--clock 48000000]
+                              [--profile dump.bin [--parent CNN]
+                               [--calibrate]]
+"""
+
+import argparse
+import math
+import os
+import re
+
+import pack_weights
+import patch_tile_planner
+import profile_report
+import tflite_model
+
+SRC_DIR = os.path.join(os.path.dirname(__file__), '..', 'src')
+DEFAULT_MODEL = pack_weights.DEFAULT_MODELS[0]
+
+CLOCK_HZ = 48000000
+# Defaults from the instruction timings of the Cortex-M0+. A MAC is a
+# single-cycle MULS and an ADDS. Operands are loaded a byte or a halfword
+# at a time: 2 cycles each, plus a flash wait state. A requantization is
+# about a dozen multiplies, shifts and clamps in 32-bit arithmetic.
+CYCLES_PER_MAC = 2.0
+CYCLES_PER_BYTE = 1.5
+CYCLES_PER_OUTPUT = 12.0
+
+# Output channels the M0 kernels compute at a time, see PackedWeights.
+CHANNEL_BLOCK = pack_weights.CHANNEL_BLOCK
+
+FUSED_NAME = 'FUSED'
+
+
+def read_define(path, name, default=0):
+    """Value of an integer #define of one of the src/ headers."""
+    try:
+        with open(path) as f:
+            match = re.search(r'#define\s+%s\s+(\d+)' % name, f.read())
+    except OSError:
+        return default
+    return int(match.group(1)) if match else default
+
+
+class Cost:
+    """MACs, traffic and scratch of an operator, or a sum of them."""
+
+    def __init__(self, macs=0, weight_bytes=0, read_bytes=0, write_bytes=0,
+                 scratch_bytes=0, outputs=0):
+        self.macs = macs
+        self.weight_bytes = weight_bytes
+        self.read_bytes = read_bytes
+        self.write_bytes = write_bytes
+        self.scratch_bytes = scratch_bytes
+        self.outputs = outputs
+
+    def __add__(self, other):
+        return Cost(self.macs + other.macs,
+                    self.weight_bytes + other.weight_bytes,
+                    self.read_bytes + other.read_bytes,
+                    self.write_bytes + other.write_bytes,
+                    max(self.scratch_bytes, other.scratch_bytes),
+                    self.outputs + other.outputs)
+
+    def scaled(self, factor):
+        return Cost(self.macs * factor, self.weight_bytes * factor,
+                    self.read_bytes * factor, self.write_bytes * factor,
+                    self.scratch_bytes, self.outputs)
+
+    def traffic(self):
+        return self.weight_bytes + self.read_bytes + self.write_bytes
+
+    def intensity(self):
+        return self.macs / self.traffic() if self.traffic() else math.inf
+
+
+class Constants:
+
+    def __init__(self, cycles_per_mac, cycles_per_byte, cycles_per_output):
+        self.cycles_per_mac = cycles_per_mac
+        self.cycles_per_byte = cycles_per_byte
+        self.cycles_per_output = cycles_per_output
+
+    def compute_cycles(self, cost):
+        return (cost.macs * self.cycles_per_mac +
+                cost.outputs * self.cycles_per_output)
+
+    def memory_cycles(self, cost):
+        return cost.traffic() * self.cycles_per_byte
+
+    def cycles(self, cost):
+        return self.compute_cycles(cost) + self.memory_cycles(cost)
+
+    def ridge(self):
+        """MACs per byte at which the MACs take as long as the traffic."""
+        return self.cycles_per_byte / self.cycles_per_mac
+
+    def bound(self, cost):
+        if cost.traffic() == 0 and cost.macs == 0:
+            return '-'
+        return ('compute' if self.compute_cycles(cost) >=
+                self.memory_cycles(cost) else 'memory')
+
+
+def weight_element_bytes(tensor):
+    return 0.5 if tensor.type == 'INT4' else tensor.type_size
+
+
+def operator_cost(model, op, packed):
+    """Cost of |op| run on its own."""
+    inputs = [model.tensors[i] for i in op.inputs if i >= 0]
+    output = model.tensors[op.outputs[0]]
+    out_bytes = output.bytes()
+    if op.opcode == 'CONV_2D':
+        out_pixels = output.elements() // output.shape[-1]
+        out_depth = output.shape[-1]
+        filter_tensor = inputs[1]
+        column = filter_tensor.elements() // filter_tensor.shape[0]
+        groups = (out_depth + CHANNEL_BLOCK - 1) // CHANNEL_BLOCK
+        if packed:
+            weights = groups * CHANNEL_BLOCK * (2 * column + 4)
+        else:
+            weights = (filter_tensor.elements() *
+                       weight_element_bytes(filter_tensor) + 4 * out_depth)
+        return Cost(
+            macs=out_pixels * out_depth * column,
+            weight_bytes=out_pixels * weights,
+            # The column is gathered from the input, written to the scratch
+            # buffer and read back by every group of channels.
+            read_bytes=out_pixels * column * (1 + groups),
+            write_bytes=out_pixels * column + out_bytes,
+            scratch_bytes=patch_tile_planner.align(column),
+            outputs=output.elements())
+    if op.opcode == 'DEPTHWISE_CONV_2D':
+        window = inputs[1].shape[1] * inputs[1].shape[2]
+        return Cost(macs=output.elements() * window,
+                    weight_bytes=output.elements() * window,
+                    read_bytes=output.elements() * window,
+                    write_bytes=out_bytes, outputs=output.elements())
+    if op.opcode == 'FULLY_CONNECTED':
+        filter_tensor = inputs[1]
+        out_depth = filter_tensor.shape[0]
+        depth = filter_tensor.elements() // out_depth
+        groups = (out_depth + CHANNEL_BLOCK - 1) // CHANNEL_BLOCK
+        if packed:
+            weights = groups * CHANNEL_BLOCK * (2 * depth + 4)
+            reads = groups * depth
+        else:
+            weights = (filter_tensor.elements() *
+                       weight_element_bytes(filter_tensor) + 4 * out_depth)
+            reads = out_depth * depth
+        batches = output.elements() // out_depth
+        return Cost(macs=output.elements() * depth,
+                    weight_bytes=batches * weights,
+                    read_bytes=batches * reads, write_bytes=out_bytes,
+                    outputs=output.elements())
+    if op.opcode in ('MAX_POOL_2D', 'AVERAGE_POOL_2D'):
+        window = op.options['filter_h'] * op.options['filter_w']
+        return Cost(macs=output.elements() * window,
+                    read_bytes=output.elements() * window,
+                    write_bytes=out_bytes,
+                    outputs=output.elements()
+                    if op.opcode == 'AVERAGE_POOL_2D' else 0)
+    if op.opcode == 'MEAN':
+        return Cost(macs=inputs[0].elements(), read_bytes=inputs[0].bytes(),
+                    write_bytes=out_bytes, outputs=output.elements())
+    if op.opcode == 'RESHAPE':
+        return Cost(read_bytes=inputs[0].bytes(), write_bytes=out_bytes)
+    # Elementwise: QUANTIZE, SOFTMAX, ADD, ARG_MAX...
+    return Cost(read_bytes=sum(t.bytes() for t in inputs
+                               if not model.is_constant(t.index)),
+                write_bytes=out_bytes, outputs=output.elements())
+
+
+def runtime_nodes(model, patch_layers, tile_height, tile_width):
+    """Yields (tag, operators, MAC factor) of the nodes the interpreter runs
+    after FuseOperators, in order. Absorbed operators are FUSED nodes."""
+    tags = [op.opcode for op in model.operators]
+    groups = {}
+    factor = 1.0
+    stack = (patch_tile_planner.patch_stack(model, patch_layers)
+             if patch_layers else None)
+    if stack:
+        _, _, macs = patch_tile_planner.evaluate_tiling(stack, tile_height,
+                                                        tile_width)
+        factor = macs / sum(layer.output_height * layer.output_width *
+                            layer.output_depth * layer.macs_per_output()
+                            for layer in stack)
+        first = stack[0].op.index
+        tags[first] = 'PATCH_CONV_STACK'
+        groups[first] = [layer.op for layer in stack]
+    ops = model.operators
+    for i in range(len(ops) - 1):
+        if tags[i] == 'CONV_2D' and tags[i + 1] == 'MAX_POOL_2D' and (
+                model.consumers(ops[i].outputs[0]) == [ops[i + 1]]):
+            tags[i] = 'CONV_2D_MAX_POOL_2D'
+            groups[i] = ops[i:i + 2]
+    for i in range(len(ops) - 2):
+        if tags[i:i + 3] == ['MEAN', 'FULLY_CONNECTED', 'SOFTMAX']:
+            tags[i] = 'MEAN_FULLY_CONNECTED_SOFTMAX'
+            groups[i] = ops[i:i + 3]
+    absorbed = {op.index for first, group in groups.items()
+                for op in group if op.index != first}
+    for op in ops:
+        if op.index in absorbed:
+            yield FUSED_NAME, [], 1.0
+        elif tags[op.index] == 'PATCH_CONV_STACK':
+            yield tags[op.index], groups[op.index], factor
+        else:
+            yield tags[op.index], groups.get(op.index, [op]), 1.0
+
+
+def analyze(model, patch_layers, tile_height, tile_width):
+    """Returns [(operator, cost)] and [(tag, operators, cost)]."""
+    packed = {op.index for op, _, _, _ in pack_weights.packable_layers(model)}
+    costs = {op.index: operator_cost(model, op, op.index in packed)
+             for op in model.operators}
+    nodes = []
+    for tag, ops, factor in runtime_nodes(model, patch_layers, tile_height,
+                                          tile_width):
+        cost = Cost()
+        for op in ops:
+            cost = cost + costs[op.index].scaled(factor)
+        nodes.append((tag, ops, cost))
+    return [(op, costs[op.index]) for op in model.operators], nodes
+
+
+def operator_table(operators, nodes, constants, clock):
+    node_of = {}
+    for index, (_, ops, _) in enumerate(nodes):
+        for op in ops:
+            node_of[op.index] = index
+    lines = ['%3s %-17s %4s %9s %9s %9s %9s %8s %7s %-7s %9s' % (
+        'op', 'operator', 'node', 'MACs', 'weight B', 'read B', 'write B',
+        'scratch', 'MAC/B', 'bound', 'us')]
+    total = Cost()
+    for op, cost in operators:
+        total = total + cost
+        lines.append('%3d %-17s %4d %9d %9d %9d %9d %8d %7.2f %-7s %9.1f' % (
+            op.index, op.opcode, node_of.get(op.index, -1), cost.macs,
+            cost.weight_bytes, cost.read_bytes, cost.write_bytes,
+            cost.scratch_bytes, cost.intensity(), constants.bound(cost),
+            1e6 * constants.cycles(cost) / clock))
+    lines.append('%3s %-17s %4s %9d %9d %9d %9d %8d %7.2f %-7s %9.1f' % (
+        '', 'total', '', total.macs, total.weight_bytes, total.read_bytes,
+        total.write_bytes, total.scratch_bytes, total.intensity(),
+        constants.bound(total), 1e6 * constants.cycles(total) / clock))
+    return '\n'.join(lines)
+
+
+def node_table(nodes, constants, clock):
+    lines = ['%4s %-29s %10s %7s %-7s %10s' % ('node', 'tag', 'cycles',
+                                               'MAC/B', 'bound', 'us')]
+    total = 0
+    for index, (tag, _, cost) in enumerate(nodes):
+        if tag == FUSED_NAME:
+            lines.append('%4d %s' % (index, tag))
+            continue
+        cycles = constants.cycles(cost)
+        total += cycles
+        lines.append('%4d %-29s %10d %7.2f %-7s %10.1f' % (
+            index, tag, cycles, cost.intensity(), constants.bound(cost),
+            1e6 * cycles / clock))
+    lines.append('%4s %-29s %10d %7s %-7s %10.1f' % (
+        '', 'inference', total, '', '', 1e6 * total / clock))
+    lines.append('ridge point: %.2f MACs per byte' % constants.ridge())
+    return '\n'.join(lines)
+
+
+def measured_cycles(profile, parent_name, clock):
+    """Cycles per inference of each tag under |parent_name|."""
+    parents = [tag for tag in profile.tags
+               if tag.name == parent_name and tag.count]
+    if not parents:
+        raise ValueError('no tag %s in the profile' % parent_name)
+    if not profile.ticks_per_second:
+        raise ValueError('the profile has no tick rate')
+    parent = parents[0]
+    to_cycles = clock / profile.ticks_per_second
+    return {child.name: child.sum * to_cycles / parent.count
+            for child in parent.children}
+
+
+def tag_costs(nodes):
+    costs = {}
+    for tag, _, cost in nodes:
+        if tag != FUSED_NAME:
+            costs[tag] = costs.get(tag, Cost()) + cost
+    return costs
+
+
+def cross_check(nodes, measured, constants, clock):
+    lines = ['%-29s %10s %10s %7s' % ('tag', 'predicted', 'measured',
+                                      'ratio')]
+    for tag, cost in tag_costs(nodes).items():
+        predicted = constants.cycles(cost)
+        if tag in measured:
+            lines.append('%-29s %8.1fus %8.1fus %7.2f' % (
+                tag, 1e6 * predicted / clock, 1e6 * measured[tag] / clock,
+                measured[tag] / predicted if predicted else math.inf))
+        else:
+            lines.append('%-29s %8.1fus %10s' % (tag,
+                                                 1e6 * predicted / clock,
+                                                 'not run'))
+    return '\n'.join(lines)
+
+
+def solve(matrix, vector):
+    """Solves the small linear system by Gaussian elimination, or returns
+    None if it is singular."""
+    n = len(vector)
+    rows = [list(matrix[i]) + [vector[i]] for i in range(n)]
+    for col in range(n):
+        pivot = max(range(col, n), key=lambda r: abs(rows[r][col]))
+        if abs(rows[pivot][col]) < 1e-12:
+            return None
+        rows[col], rows[pivot] = rows[pivot], rows[col]
+        for r in range(n):
+            if r != col:
+                scale = rows[r][col] / rows[col][col]
+                rows[r] = [a - scale * b for a, b in zip(rows[r], rows[col])]
+    return [rows[i][n] / rows[i][i] for i in range(n)]
+
+
+def calibrate(nodes, measured, constants):
+    """Least squares fit of the constants to the measured tags. With fewer
+    tags than constants, or a fit with a negative constant, the defaults
+    are scaled by a single factor instead."""
+    samples = [(cost, measured[tag]) for tag, cost in tag_costs(nodes).items()
+               if tag in measured]
+    if not samples:
+        return None
+    features = [(cost.macs, cost.traffic(), cost.outputs)
+                for cost, _ in samples]
+    if len(samples) >= 3:
+        normal = [[sum(f[i] * f[j] for f in features) for j in range(3)]
+                  for i in range(3)]
+        right = [sum(f[i] * m for f, (_, m) in zip(features, samples))
+                 for i in range(3)]
+        fitted = solve(normal, right)
+        if fitted is not None and min(fitted) >= 0:
+            return Constants(*fitted)
+    predicted = sum(constants.cycles(cost) for cost, _ in samples)
+    scale = sum(m for _, m in samples) / predicted if predicted else 1.0
+    return Constants(constants.cycles_per_mac * scale,
+                     constants.cycles_per_byte * scale,
+                     constants.cycles_per_output * scale)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', nargs='?', default=DEFAULT_MODEL,
+                        help='.tflite file or C array of the model')
+    parser.add_argument('--clock', type=int, default=CLOCK_HZ,
+                        help='core clock in Hz (default: 48 MHz)')
+    parser.add_argument('--cycles-per-mac', type=float,
+                        default=CYCLES_PER_MAC)
+    parser.add_argument('--cycles-per-byte', type=float,
+                        default=CYCLES_PER_BYTE)
+    parser.add_argument('--cycles-per-output', type=float,
+                        default=CYCLES_PER_OUTPUT)
+    parser.add_argument('--patch-config',
+                        default=os.path.join(SRC_DIR, 'patch_config.h'),
+                        help='patch_config.h with the tiling of the leading '
+                        'layers; none applies to models without a matching '
+                        'CONV_2D stack')
+    parser.add_argument('--profile', help='profile records saved by '
+                        'profile_report.py --save, to compare with')
+    parser.add_argument('--parent', default='CNN',
+                        help='profiler tag the model runs under (default: '
+                        'CNN, GATEKEEPER for the gatekeeper)')
+    parser.add_argument('--calibrate', action='store_true',
+                        help='fit the constants to the profile')
+    args = parser.parse_args()
+    if args.calibrate and not args.profile:
+        parser.error('--calibrate needs --profile')
+
+    model = tflite_model.load_model(args.model)
+    constants = Constants(args.cycles_per_mac, args.cycles_per_byte,
+                          args.cycles_per_output)
+    operators, nodes = analyze(
+        model, read_define(args.patch_config, 'PATCH_NUM_LAYERS'),
+        read_define(args.patch_config, 'PATCH_TILE_HEIGHT', 1),
+        read_define(args.patch_config, 'PATCH_TILE_WIDTH', 1))
+
+    print('Operators, with the latency each would take on its own at %.0f '
+          'MHz:\n' % (args.clock / 1e6))
+    print(operator_table(operators, nodes, constants, args.clock))
+    print('\nNodes run by the interpreter:\n')
+    print(node_table(nodes, constants, args.clock))
+
+    if args.profile:
+        try:
+            profile = profile_report.Profile(
+                profile_report.load_records(args.profile))
+            measured = measured_cycles(profile, args.parent, args.clock)
+        except ValueError as error:
+            raise SystemExit('Bad profile: %s' % error)
+        print('\nAgainst the profile, per inference:\n')
+        print(cross_check(nodes, measured, constants, args.clock))
+        if args.calibrate:
+            fitted = calibrate(nodes, measured, constants)
+            if fitted is None:
+                print('\nNo tag of the model in the profile to calibrate '
+                      'with.')
+            else:
+                print('\nCalibrated: --cycles-per-mac %.3f --cycles-per-byte '
+                      '%.3f --cycles-per-output %.3f' % (
+                          fitted.cycles_per_mac, fitted.cycles_per_byte,
+                          fitted.cycles_per_output))
+                print(cross_check(nodes, measured, fitted, args.clock))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,440 @@
+"""Minimal reader and writer for the TFLite flatbuffers of the host tools.
+
+Only the parts of the schema needed by the tools are decoded: operator codes,
+tensors with their quantization, operators with the options of the builtin
+ops used by the digit recognition model, and buffers. The model can be read
+either from a .tflite file or from the C array the firmware is built with
+(e.g. models/written-digit-recognition-cnn-v3.0-8bit.cc), so no TensorFlow
+installation is needed.
+
+ModelBuilder writes small models of the same subset, e.g. the gatekeeper
+model generated by train_gatekeeper.py.
+"""
+
+import re
+import struct
+
+# BuiltinOperator values from the TFLite schema.
+BUILTIN_OPS = {
+    0: 'ADD',
+    1: 'AVERAGE_POOL_2D',
+    3: 'CONV_2D',
+    4: 'DEPTHWISE_CONV_2D',
+    9: 'FULLY_CONNECTED',
+    17: 'MAX_POOL_2D',
+    22: 'RESHAPE',
+    25: 'SOFTMAX',
+    32: 'CUSTOM',
+    40: 'MEAN',
+    56: 'ARG_MAX',
+    114: 'QUANTIZE',
+}
+
+# TensorType values from the TFLite schema, with their size in bytes.
+TENSOR_TYPES = {
+    0: ('FLOAT32', 4),
+    1: ('FLOAT16', 2),
+    2: ('INT32', 4),
+    3: ('UINT8', 1),
+    4: ('INT64', 8),
+    6: ('BOOL', 1),
+    7: ('INT16', 2),
+    9: ('INT8', 1),
+    17: ('INT4', 1),
+}
+
+PADDING_SAME = 0
+PADDING_VALID = 1
+
+
+class _Table:
+    """A flatbuffer table at a given position of the buffer."""
+
+    def __init__(self, buf, pos):
+        self.buf = buf
+        self.pos = pos
+        vtable = pos - struct.unpack_from('<i', buf, pos)[0]
+        vtable_size = struct.unpack_from('<H', buf, vtable)[0]
+        self.fields = [struct.unpack_from('<H', buf, vtable + 4 + 2 * i)[0]
+                       for i in range((vtable_size - 4) // 2)]
+
+    def _offset(self, field):
+        if field < len(self.fields) and self.fields[field] != 0:
+            return self.pos + self.fields[field]
+        return None
+
+    def scalar(self, field, fmt, default=0):
+        offset = self._offset(field)
+        if offset is None:
+            return default
+        return struct.unpack_from('<' + fmt, self.buf, offset)[0]
+
+    def _indirect(self, field):
+        offset = self._offset(field)
+        if offset is None:
+            return None
+        return offset + struct.unpack_from('<I', self.buf, offset)[0]
+
+    def table(self, field):
+        offset = self._indirect(field)
+        return None if offset is None else _Table(self.buf, offset)
+
+    def vector(self, field, fmt):
+        offset = self._indirect(field)
+        if offset is None:
+            return []
+        length = struct.unpack_from('<I', self.buf, offset)[0]
+        return list(struct.unpack_from('<%d%s' % (length, fmt), self.buf,
+                                       offset + 4))
+
+    def bytes(self, field):
+        offset = self._indirect(field)
+        if offset is None:
+            return b''
+        length = struct.unpack_from('<I', self.buf, offset)[0]
+        return bytes(self.buf[offset + 4:offset + 4 + length])
+
+    def string(self, field):
+        return self.bytes(field).decode('utf-8', errors='replace')
+
+    def tables(self, field):
+        offset = self._indirect(field)
+        if offset is None:
+            return []
+        length = struct.unpack_from('<I', self.buf, offset)[0]
+        result = []
+        for i in range(length):
+            element = offset + 4 + 4 * i
+            result.append(_Table(self.buf, element + struct.unpack_from(
+                '<I', self.buf, element)[0]))
+        return result
+
+
+class Tensor:
+
+    def __init__(self, index, table):
+        self.index = index
+        self.shape = table.vector(0, 'i')
+        type_code = table.scalar(1, 'b')
+        self.type, self.type_size = TENSOR_TYPES.get(type_code,
+                                                     (str(type_code), 1))
+        self.buffer = table.scalar(2, 'I')
+        self.name = table.string(3)
+        quantization = table.table(4)
+        self.scale = quantization.vector(2, 'f') if quantization else []
+        self.zero_point = quantization.vector(3, 'q') if quantization else []
+
+    def elements(self):
+        count = 1
+        for dim in self.shape:
+            count *= dim
+        return count
+
+    def bytes(self):
+        return self.elements() * self.type_size
+
+
+class Operator:
+
+    def __init__(self, index, table, opcodes):
+        self.index = index
+        self.opcode, self.custom_code = opcodes[table.scalar(0, 'I')]
+        self.inputs = table.vector(1, 'i')
+        self.outputs = table.vector(2, 'i')
+        self.options = {}
+        options = table.table(4)
+        if options is None:
+            return
+        if self.opcode == 'CONV_2D' or self.opcode == 'DEPTHWISE_CONV_2D':
+            self.options['padding'] = options.scalar(0, 'b')
+            self.options['stride_w'] = options.scalar(1, 'i')
+            self.options['stride_h'] = options.scalar(2, 'i')
+            if self.opcode == 'CONV_2D':
+                self.options['dilation_w'] = options.scalar(4, 'i', 1)
+                self.options['dilation_h'] = options.scalar(5, 'i', 1)
+            else:
+                self.options['depth_multiplier'] = options.scalar(3, 'i')
+                self.options['dilation_w'] = options.scalar(5, 'i', 1)
+                self.options['dilation_h'] = options.scalar(6, 'i', 1)
+        elif self.opcode in ('MAX_POOL_2D', 'AVERAGE_POOL_2D'):
+            self.options['padding'] = options.scalar(0, 'b')
+            self.options['stride_w'] = options.scalar(1, 'i')
+            self.options['stride_h'] = options.scalar(2, 'i')
+            self.options['filter_w'] = options.scalar(3, 'i')
+            self.options['filter_h'] = options.scalar(4, 'i')
+        elif self.opcode == 'MEAN':
+            self.options['keep_dims'] = options.scalar(0, 'b') != 0
+
+
+class Model:
+
+    def __init__(self, data):
+        self.data = bytes(data)
+        root = _Table(self.data, struct.unpack_from('<I', self.data, 0)[0])
+        opcodes = []
+        for code in root.tables(1):
+            builtin = max(code.scalar(0, 'b'), code.scalar(3, 'i'))
+            opcodes.append((BUILTIN_OPS.get(builtin, str(builtin)),
+                            code.string(1)))
+        subgraph = root.tables(2)[0]
+        self.tensors = [Tensor(i, t) for i, t in enumerate(subgraph.tables(0))]
+        self.inputs = subgraph.vector(1, 'i')
+        self.outputs = subgraph.vector(2, 'i')
+        self.operators = [Operator(i, t, opcodes)
+                          for i, t in enumerate(subgraph.tables(3))]
+        self.buffers = [b.bytes(0) for b in root.tables(4)]
+
+    def is_constant(self, tensor_index):
+        """True if the tensor is stored in the model (weights, biases...)."""
+        return len(self.buffers[self.tensors[tensor_index].buffer]) > 0
+
+    def consumers(self, tensor_index):
+        return [op for op in self.operators if tensor_index in op.inputs]
+
+
+class ModelEditor:
+    """In place edits of a model that keep its layout: tensor types,
+    quantization scales and buffer contents no larger than the original.
+    The edited flatbuffer is in |data|."""
+
+    def __init__(self, data):
+        self.data = bytearray(data)
+        root = _Table(self.data, struct.unpack_from('<I', self.data, 0)[0])
+        self._tensors = root.tables(2)[0].tables(0)
+        self._buffers = root.tables(4)
+
+    def set_tensor_type(self, index, type_name):
+        offset = self._tensors[index]._offset(1)
+        if offset is None:
+            raise ValueError('tensor %d has the default type' % index)
+        code = next(code for code, (name, _) in TENSOR_TYPES.items()
+                    if name == type_name)
+        struct.pack_into('<b', self.data, offset, code)
+
+    def set_scales(self, index, scales):
+        quantization = self._tensors[index].table(4)
+        offset = quantization._indirect(2) if quantization else None
+        if offset is None or struct.unpack_from(
+                '<I', self.data, offset)[0] != len(scales):
+            raise ValueError('tensor %d has no %d scales' %
+                             (index, len(scales)))
+        struct.pack_into('<%df' % len(scales), self.data, offset + 4, *scales)
+
+    def set_buffer(self, index, data):
+        offset = self._buffers[index]._indirect(0)
+        if offset is None or struct.unpack_from(
+                '<I', self.data, offset)[0] < len(data):
+            raise ValueError('buffer %d is smaller than %d bytes' %
+                             (index, len(data)))
+        struct.pack_into('<I', self.data, offset, len(data))
+        self.data[offset + 4:offset + 4 + len(data)] = data
+
+
+def read_model_bytes(path):
+    """Returns the flatbuffer stored in a .tflite file or in a C array."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[4:8] == b'TFL3':
+        return data
+    text = data.decode('utf-8', errors='replace')
+    body = text[text.index('{') + 1:text.index('}')]
+    return bytes(int(value, 16) for value in re.findall(r'0x[0-9a-fA-F]+',
+                                                       body))
+
+
+def load_model(path):
+    return Model(read_model_bytes(path))
+
+
+# BuiltinOptions union types of the options written by ModelBuilder.
+OPTIONS_TYPES = {
+    'CONV_2D': 1,
+    'DEPTHWISE_CONV_2D': 2,
+    'AVERAGE_POOL_2D': 5,
+    'MAX_POOL_2D': 5,
+    'FULLY_CONNECTED': 8,
+    'SOFTMAX': 9,
+    'RESHAPE': 17,
+    'MEAN': 27,
+}
+
+ACTIVATION_NONE = 0
+ACTIVATION_RELU = 1
+
+
+class _Vector:
+
+    def __init__(self, fmt, values, alignment=4):
+        self.fmt = fmt
+        self.values = values
+        self.alignment = max(alignment, struct.calcsize('<' + (fmt or 'I')))
+
+
+class _TableData:
+    """A table to serialize: a list of (field, format, value) triples. The
+    format is a struct format for scalars, or None for a table, vector or
+    string stored out of line."""
+
+    def __init__(self, fields):
+        self.fields = [f for f in fields if f[2] is not None]
+
+
+def _pad(buf, alignment):
+    buf.extend(b'\0' * (-len(buf) % alignment))
+
+
+def _serialize(buf, obj):
+    """Appends |obj| to |buf| and returns its position. Children are written
+    after their parent, so all the unsigned offsets point forward."""
+    if isinstance(obj, str):
+        obj = obj.encode('utf-8') + b'\0'
+        _pad(buf, 4)
+        pos = len(buf)
+        buf.extend(struct.pack('<I', len(obj) - 1))
+        buf.extend(obj)
+        return pos
+    if isinstance(obj, _Vector):
+        while (len(buf) + 4) % obj.alignment:
+            buf.append(0)
+        pos = len(buf)
+        buf.extend(struct.pack('<I', len(obj.values)))
+        if obj.fmt is not None:
+            buf.extend(struct.pack('<%d%s' % (len(obj.values), obj.fmt),
+                                   *obj.values))
+            return pos
+        slots = []
+        for _ in obj.values:
+            slots.append(len(buf))
+            buf.extend(b'\0' * 4)
+        for slot, child in zip(slots, obj.values):
+            struct.pack_into('<I', buf, slot, _serialize(buf, child) - slot)
+        return pos
+
+    # Table: the vtable goes right before the table.
+    fields = sorted(obj.fields, key=lambda f: -struct.calcsize(
+        '<' + (f[1] or 'I')))
+    layout = []
+    size = 4
+    for field, fmt, value in fields:
+        width = struct.calcsize('<' + (fmt or 'I'))
+        size += -size % width
+        layout.append((field, fmt, value, size))
+        size += width
+    size += -size % 4
+    num_fields = max([f[0] for f in fields], default=-1) + 1
+    offsets = [0] * num_fields
+    for field, _, _, offset in layout:
+        offsets[field] = offset
+    _pad(buf, 4)
+    if num_fields % 2:
+        buf.extend(b'\0\0')
+    vtable = len(buf)
+    buf.extend(struct.pack('<%dH' % (2 + num_fields), 4 + 2 * num_fields,
+                           size, *offsets))
+    pos = len(buf)
+    buf.extend(b'\0' * size)
+    struct.pack_into('<i', buf, pos, pos - vtable)
+    children = []
+    for field, fmt, value, offset in layout:
+        if fmt is None:
+            children.append((pos + offset, value))
+        else:
+            struct.pack_into('<' + fmt, buf, pos + offset, value)
+    for slot, child in children:
+        struct.pack_into('<I', buf, slot, _serialize(buf, child) - slot)
+    return pos
+
+
+class ModelBuilder:
+    """Builds a single subgraph TFLite flatbuffer.
+
+    Only the fields read by TFLM are written. Constant data is aligned to 16
+    bytes within the flatbuffer, so the array holding the model has to be
+    aligned to 16 bytes as well.
+    """
+
+    def __init__(self):
+        self.opcodes = []
+        self.tensors = []
+        self.operators = []
+        self.buffers = [b'']
+
+    def add_tensor(self, name, type_name, shape, scale=None, zero_point=None,
+                   data=None):
+        """Adds a tensor and returns its index. |data| holds the bytes of a
+        constant tensor."""
+        type_code = [code for code, (name_, _) in TENSOR_TYPES.items()
+                     if name_ == type_name][0]
+        buffer = 0
+        if data is not None:
+            buffer = len(self.buffers)
+            self.buffers.append(bytes(data))
+        quantization = None
+        if scale is not None:
+            quantization = _TableData([
+                (2, None, _Vector('f', list(scale))),
+                (3, None, _Vector('q', list(zero_point))),
+            ])
+        self.tensors.append(_TableData([
+            (0, None, _Vector('i', list(shape))),
+            (1, 'b', type_code),
+            (2, 'I', buffer),
+            (3, None, name),
+            (4, None, quantization),
+        ]))
+        return len(self.tensors) - 1
+
+    def add_operator(self, opcode, inputs, outputs, options=None):
+        """Adds an operator. |options| is a list of (field, format, value)
+        triples of the builtin options table of the op."""
+        builtin = [code for code, name in BUILTIN_OPS.items()
+                   if name == opcode][0]
+        if builtin not in self.opcodes:
+            self.opcodes.append(builtin)
+        fields = [
+            (0, 'I', self.opcodes.index(builtin)),
+            (1, None, _Vector('i', list(inputs))),
+            (2, None, _Vector('i', list(outputs))),
+        ]
+        if options is not None:
+            fields.append((3, 'B', OPTIONS_TYPES[opcode]))
+            fields.append((4, None, _TableData(options)))
+        self.operators.append(_TableData(fields))
+
+    def finish(self, inputs, outputs, description):
+        """Returns the flatbuffer of the model."""
+        opcodes = [_TableData([(0, 'b', min(code, 127)), (2, 'i', 1),
+                               (3, 'i', code)]) for code in self.opcodes]
+        subgraph = _TableData([
+            (0, None, _Vector(None, self.tensors)),
+            (1, None, _Vector('i', list(inputs))),
+            (2, None, _Vector('i', list(outputs))),
+            (3, None, _Vector(None, self.operators)),
+            (4, None, 'main'),
+        ])
+        buffers = [_TableData([(0, None, _Vector('B', list(data), 16))]
+                              if data else []) for data in self.buffers]
+        root = _TableData([
+            (0, 'I', 3),
+            (1, None, _Vector(None, opcodes)),
+            (2, None, _Vector(None, [subgraph])),
+            (3, None, description),
+            (4, None, _Vector(None, buffers)),
+        ])
+        buf = bytearray(b'\0' * 4 + b'TFL3')
+        struct.pack_into('<I', buf, 0, _serialize(buf, root))
+        _pad(buf, 16)
+        return bytes(buf)
+
+
+def write_c_array(path, data, array_name, header):
+    """Writes |data| as a C array in the format of the models/ directory."""
+    lines = ['#include "%s"' % header, '',
+             'alignas(16) const unsigned char %s[] = {' % array_name]
+    for i in range(0, len(data), 12):
+        chunk = ', '.join('0x%02x' % b for b in data[i:i + 12])
+        lines.append('  ' + chunk + (',' if i + 12 < len(data) else ''))
+    lines.append('};')
+    lines.append('const unsigned int %s_len = %d;' % (array_name, len(data)))
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
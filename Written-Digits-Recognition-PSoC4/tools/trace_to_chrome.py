@@ -0,0 +1,252 @@
+"""Reads the latency trace of the board and converts it into a Chrome trace.
+
+With TRACE_OUTPUT set in src/config.h, the application records the stages of
+each digit (stroke, pen up timer, preprocessing, input copies, gatekeeper,
+CNN, argmax and UART output, see src/trace.h) and the operators of both
+models as begin and end events with their SysTick time in a
+tflite::MicroTraceProfiler (tflm-cmsis/.../micro_trace_profiler.h), and
+hands them out as binary records over the UART (src/trace_dump.h).
+
+This script reads the records with the binary frames of src/uart_frame.h,
+next to the text the application prints on the same UART, or from a file
+saved earlier with --save. It writes the trace in the trace_event JSON
+format, which chrome://tracing and https://ui.perfetto.dev open, and prints
+the time spent in each tag. --clear empties the trace buffer on the board
+after reading it, so that the next read starts with the next digit.
+
+Usage:
+    python trace_to_chrome.py --port COM5 [--baud 115200] [--save dump.bin]
+                              [--output trace.json] [--clear]
+    python trace_to_chrome.py --input dump.bin [--output trace.json]
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+import profile_report
+import upload_model
+
+READ = 0x14
+CLEAR = 0x15
+
+SUMMARY_RECORD = 0
+TAG_RECORD = 1
+EVENT_RECORD = 2
+RECORD_VERSION = 1
+# Trace events in an event record, MicroTraceProfiler::kRecordEvents.
+RECORD_EVENTS = 24
+
+BEGIN = 0
+END = 1
+INSTANT = 2
+PHASE_SHIFT = 6
+TAG_MASK = (1 << PHASE_SHIFT) - 1
+
+
+class Trace:
+
+    def __init__(self, records, ticks_per_second=None):
+        (kind, version, board_ticks_per_second, num_tags, num_events,
+         self.dropped) = struct.unpack_from('<2BIBHI', records[0])
+        if kind != SUMMARY_RECORD or version != RECORD_VERSION:
+            raise ValueError('unsupported summary record')
+        self.ticks_per_second = ticks_per_second or board_ticks_per_second
+        if not self.ticks_per_second:
+            raise ValueError('the board has no tick rate, give '
+                             '--ticks-per-second')
+        self.tags = []
+        for record in records[1:1 + num_tags]:
+            kind, index, length = struct.unpack_from('<3B', record)
+            if kind != TAG_RECORD or index != len(self.tags):
+                raise ValueError('not tag record %d' % len(self.tags))
+            self.tags.append(record[3:3 + length].decode('ascii', 'replace'))
+        # (ticks, tag index, phase) in the order they were recorded.
+        self.events = []
+        for record in records[1 + num_tags:]:
+            kind, first, count = struct.unpack_from('<BHB', record)
+            if kind != EVENT_RECORD or first != len(self.events):
+                raise ValueError('not event record %d'
+                                 % (len(self.events) // RECORD_EVENTS))
+            for i in range(count):
+                ticks, tag_phase = struct.unpack_from('<IB', record,
+                                                      4 + 5 * i)
+                self.events.append((ticks, tag_phase & TAG_MASK,
+                                    tag_phase >> PHASE_SHIFT))
+        if len(self.events) != num_events:
+            raise ValueError('%d events for %d' % (len(self.events),
+                                                   num_events))
+
+    def times_us(self):
+        """The time of each event in microseconds after the first one. The
+        32 bit ticks wrap around; the events are in time order, so each one
+        is taken to be less than a wrap after the one before it."""
+        times = []
+        elapsed = 0
+        previous = None
+        for ticks, _, _ in self.events:
+            if previous is not None:
+                elapsed += (ticks - previous) & 0xffffffff
+            previous = ticks
+            times.append(1e6 * elapsed / self.ticks_per_second)
+        return times
+
+    def spans(self):
+        """Yields (name, start, duration, depth) of each begin matched with
+        its end, and (name, time, None, depth) of each instant, in us.
+        Begins whose end was dropped and ends without a begin are left
+        out."""
+        open_spans = []
+        for time_us, (_, tag, phase) in zip(self.times_us(), self.events):
+            name = self.tags[tag] if tag < len(self.tags) else str(tag)
+            if phase == BEGIN:
+                open_spans.append((tag, time_us))
+            elif phase == END:
+                for i in range(len(open_spans) - 1, -1, -1):
+                    if open_spans[i][0] == tag:
+                        start = open_spans[i][1]
+                        del open_spans[i:]
+                        yield name, start, time_us - start, i
+                        break
+            elif phase == INSTANT:
+                yield name, time_us, None, len(open_spans)
+
+    def chrome(self):
+        """The trace_event JSON object, with complete ("X") events so that
+        an unmatched event cannot break the nesting of the others."""
+        events = [{'name': 'process_name', 'ph': 'M', 'pid': 0,
+                   'args': {'name': 'PSoC 4'}}]
+        for name, start, duration, _ in self.spans():
+            event = {'name': name, 'pid': 0, 'tid': 0, 'ts': start}
+            if duration is None:
+                event.update(ph='i', s='t')
+            else:
+                event.update(ph='X', dur=duration)
+            events.append(event)
+        return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+    def table(self):
+        # The tags in the order they first began, indented by their depth.
+        totals = {}
+        spans = sorted(self.spans(), key=lambda span: span[1])
+        for name, _, duration, depth in spans:
+            if duration is None:
+                continue
+            count, total, longest, _ = totals.get(name, (0, 0.0, 0.0, depth))
+            totals[name] = (count + 1, total + duration,
+                            max(longest, duration), depth)
+        width = max([len('  ' * depth + name)
+                     for name, (_, _, _, depth) in totals.items()] + [3])
+        lines = ['%-*s %6s %12s %12s' % (width, 'tag', 'count', 'mean ms',
+                                         'max ms')]
+        for name, (count, total, longest, depth) in totals.items():
+            lines.append('%-*s %6d %12.3f %12.3f' % (
+                width, '  ' * depth + name, count, total / count / 1000,
+                longest / 1000))
+        if self.dropped:
+            lines.append('%d events dropped: the buffer was full, --clear '
+                         'empties it' % self.dropped)
+        return '\n'.join(lines)
+
+
+class TraceReader(upload_model.Uploader):
+    """Reads the records over the frames of the model upload."""
+
+    def record(self, index, kind, key=None):
+        frame = upload_model.encode_frame(READ, bytes([index]))
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, data in self.decoder.feed(self.port.read(64)):
+                    if reply != READ | upload_model.REPLY or not data:
+                        continue
+                    if data[0] != 0:
+                        raise upload_model.UploadError(
+                            'no trace record %d' % index)
+                    # A late reply to an earlier request is skipped.
+                    if data[1] != kind:
+                        continue
+                    if kind == TAG_RECORD and data[2] != key:
+                        continue
+                    if kind == EVENT_RECORD and struct.unpack_from(
+                            '<H', data, 2)[0] != key:
+                        continue
+                    return data[1:]
+        raise upload_model.UploadError('no reply to trace record %d'
+                                       % index)
+
+    def records(self):
+        summary = self.record(0, SUMMARY_RECORD)
+        num_tags, num_events = struct.unpack_from('<2BIBH', summary)[3:5]
+        records = [summary]
+        for i in range(num_tags):
+            records.append(self.record(1 + i, TAG_RECORD, i))
+        for first in range(0, num_events, RECORD_EVENTS):
+            records.append(self.record(1 + num_tags + first // RECORD_EVENTS,
+                                       EVENT_RECORD, first))
+        return records
+
+    def clear(self):
+        frame = upload_model.encode_frame(CLEAR)
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, _ in self.decoder.feed(self.port.read(64)):
+                    if reply == CLEAR | upload_model.REPLY:
+                        return
+        raise upload_model.UploadError('no reply to the trace clear')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port, e.g. COM5 or '
+                        '/dev/ttyACM0')
+    source.add_argument('--input', help='records saved with --save')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--save', help='file to save the records read from '
+                        'the board to')
+    parser.add_argument('--output', default='trace.json',
+                        help='file to write the Chrome trace to')
+    parser.add_argument('--ticks-per-second', type=int,
+                        help='tick rate, if the board reports none or a '
+                        'wrong one')
+    parser.add_argument('--clear', action='store_true',
+                        help='empty the trace buffer on the board after '
+                        'reading it')
+    args = parser.parse_args()
+    if args.input and (args.save or args.clear):
+        parser.error('--save and --clear need --port')
+
+    if args.input:
+        records = profile_report.load_records(args.input)
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+            reader = TraceReader(port)
+            try:
+                records = reader.records()
+                if args.clear:
+                    reader.clear()
+            except upload_model.UploadError as error:
+                sys.exit('Read failed: %s' % error)
+        if args.save:
+            profile_report.save_records(args.save, records)
+
+    try:
+        trace = Trace(records, args.ticks_per_second)
+    except ValueError as error:
+        sys.exit('Bad trace: %s' % error)
+    with open(args.output, 'w') as f:
+        json.dump(trace.chrome(), f)
+    print(trace.table())
+    print('%d events written to %s' % (len(trace.events), args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
@@ -0,0 +1,373 @@
+"""Trains the "is this a digit?" gatekeeper model.
+
+The gatekeeper runs on every stroke before the digit recognition CNN and
+rejects the input that is not a digit (palm touches, taps, scribbles), so
+the CNN only runs on strokes that have a chance to pass the confidence
+threshold. It is a tiny int8 model with the same uint8 28x28 input as the
+CNN:
+
+    QUANTIZE -> AVERAGE_POOL_2D 4x4 -> FULLY_CONNECTED 49x8 + RELU
+             -> FULLY_CONNECTED 8x1
+
+The single int8 output is a logit: the stroke is a digit when it is above
+GATEKEEPER_THRESHOLD (src/config.h).
+
+The digits are the recorded strokes of data_collection/fine_tuning_dataset.csv.
+No recordings of non-digit input exist, so the negatives are synthesized with
+the same brush and 112x112 to 28x28 rescaling as the firmware
+(src/capsense_input_preprocessing.cpp). Both are split 80/20 into a training
+and a test set.
+
+The script trains the model in float, quantizes it, evaluates the quantized
+model with the integer arithmetic of the TFLM kernels and reports the
+accept rate of the digits, the reject rate of each kind of negative and the
+average MACs per stroke with and without the gatekeeper. It only uses the
+Python standard library.
+
+Usage:
+    python train_gatekeeper.py [--dataset ../data_collection/...csv]
+                               [--output ../models/digit-gatekeeper-8bit.cc]
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+
+import tflite_model
+
+TOOLS_DIR = os.path.dirname(__file__)
+DEFAULT_DATASET = os.path.join(TOOLS_DIR, '..', 'data_collection',
+                               'fine_tuning_dataset.csv')
+DEFAULT_CNN = os.path.join(TOOLS_DIR, '..', 'models',
+                           'written-digit-recognition-cnn-v3.0-8bit.cc')
+ARRAY_NAME = 'digit_gatekeeper_8bit_tflite'
+HEADER = 'digit-gatekeeper-8bit.h'
+
+IMAGE_SIZE = 28
+RAW_SIZE = 112
+POOL = 4
+FEATURES = (IMAGE_SIZE // POOL) ** 2
+HIDDEN = 8
+
+# Same as intensity_table in src/intensity_LUT.h.
+INTENSITY = [0, 17, 34, 51, 68, 85, 102, 119, 136, 170, 204, 238, 255, 255,
+             255, 255, 255]
+# Offsets set around each touch by fillInputMatrix().
+BRUSH = [(0, 0)] + [(dx * r, dy * r) for r in (1, 2, 3)
+                    for dx, dy in ((1, 0), (-1, 0), (0, 1), (0, -1), (1, 1),
+                                   (1, -1), (-1, 1), (-1, -1))]
+
+
+# ---------------------------------------------------------------------------
+# Data
+
+
+def load_digits(path):
+    with open(path, newline='') as f:
+        rows = list(csv.reader(f))[1:]
+    return [[int(v) for v in row[1:]] for row in rows]
+
+
+def render(touches):
+    """Returns the 28x28 image the firmware builds from a list of touches."""
+    raw = set()
+    for x, y in touches:
+        for dx, dy in BRUSH:
+            px, py = int(x) + dx, int(y) + dy
+            if 0 <= px < RAW_SIZE and 0 <= py < RAW_SIZE:
+                raw.add((px, py))
+    counts = [0] * (IMAGE_SIZE * IMAGE_SIZE)
+    for px, py in raw:
+        counts[(px // 4) * IMAGE_SIZE + py // 4] += 1
+    return [INTENSITY[c] for c in counts]
+
+
+def line(points, spacing=2.0):
+    """Touches along a polyline, spaced like the CAPSENSE scan of a stroke."""
+    touches = []
+    for (x0, y0), (x1, y1) in zip(points, points[1:]):
+        steps = max(1, int(math.hypot(x1 - x0, y1 - y0) / spacing))
+        touches += [(x0 + (x1 - x0) * i / steps, y0 + (y1 - y0) * i / steps)
+                    for i in range(steps)]
+    return touches + points[-1:]
+
+
+def palm(rng):
+    cx, cy = rng.uniform(30, 82), rng.uniform(30, 82)
+    rx, ry = rng.uniform(18, 45), rng.uniform(18, 45)
+    touches = []
+    for _ in range(rng.randint(40, 160)):
+        a, r = rng.uniform(0, 2 * math.pi), math.sqrt(rng.random())
+        touches.append((cx + rx * r * math.cos(a), cy + ry * r * math.sin(a)))
+    return render(touches)
+
+
+def tap(rng):
+    x, y = rng.uniform(10, 102), rng.uniform(10, 102)
+    return render([(x + rng.uniform(-3, 3), y + rng.uniform(-3, 3))
+                   for _ in range(rng.randint(1, 6))])
+
+
+def scribble(rng):
+    x0, y0 = rng.uniform(5, 40), rng.uniform(5, 40)
+    x1, y1 = rng.uniform(72, 107), rng.uniform(72, 107)
+    points = []
+    for i in range(rng.randint(6, 14)):
+        t = (i + rng.random()) / 14
+        if i % 2:
+            points.append((rng.uniform(x0, x1), y0 + (y1 - y0) * t))
+        else:
+            points.append((x0 + (x1 - x0) * t, rng.uniform(y0, y1)))
+    return render(line(points))
+
+
+NEGATIVES = [('palm', palm), ('tap', tap), ('scribble', scribble)]
+
+
+def split(samples, rng):
+    samples = samples[:]
+    rng.shuffle(samples)
+    cut = len(samples) * 4 // 5
+    return samples[:cut], samples[cut:]
+
+
+# ---------------------------------------------------------------------------
+# Integer inference, same arithmetic as the TFLM / CMSIS-NN kernels
+
+
+def quantize_multiplier(scale):
+    if scale == 0:
+        return 0, 0
+    mantissa, shift = math.frexp(scale)
+    multiplier = int(round(mantissa * (1 << 31)))
+    if multiplier == 1 << 31:
+        multiplier //= 2
+        shift += 1
+    return multiplier, shift
+
+
+def multiply_by_quantized_multiplier(x, multiplier, shift):
+    left = max(shift, 0)
+    right = max(-shift, 0)
+    x = x * (1 << left)
+    # SaturatingRoundingDoublingHighMul.
+    product = x * multiplier
+    nudge = (1 << 30) if product >= 0 else 1 - (1 << 30)
+    high = product + nudge
+    high = abs(high) >> 31 if high >= 0 else -(abs(high) >> 31)
+    # RoundingDivideByPOT.
+    mask = (1 << right) - 1
+    remainder = high & mask
+    threshold = (mask >> 1) + (1 if high < 0 else 0)
+    return (high >> right) + (1 if remainder > threshold else 0)
+
+
+def pool(image):
+    """QUANTIZE (uint8 to int8) and the 4x4 AVERAGE_POOL_2D, as int8."""
+    side = IMAGE_SIZE // POOL
+    pooled = []
+    for row in range(side):
+        for col in range(side):
+            total = sum(image[(row * POOL + i) * IMAGE_SIZE + col * POOL + j]
+                        - 128 for i in range(POOL) for j in range(POOL))
+            count = POOL * POOL
+            if total > 0:
+                pooled.append((total + count // 2) // count)
+            else:
+                pooled.append(-((-total + count // 2) // count))
+    return pooled
+
+
+class QuantizedModel:
+
+    def __init__(self, w1, b1, w2, b2, hidden_max, logit_max):
+        self.input_scale = 1.0 / 255
+        self.hidden_scale = hidden_max / 255
+        self.output_scale = logit_max / 127
+        self.w1_scale = max(abs(w) for row in w1 for w in row) / 127
+        self.w2_scale = max(abs(w) for w in w2) / 127
+        self.w1 = [[round(w / self.w1_scale) for w in row] for row in w1]
+        self.b1 = [round(b / (self.input_scale * self.w1_scale)) for b in b1]
+        self.w2 = [round(w / self.w2_scale) for w in w2]
+        self.b2 = round(b2 / (self.hidden_scale * self.w2_scale))
+        self.m1 = quantize_multiplier(
+            self.input_scale * self.w1_scale / self.hidden_scale)
+        self.m2 = quantize_multiplier(
+            self.hidden_scale * self.w2_scale / self.output_scale)
+
+    def logit(self, pooled):
+        hidden = []
+        for row, bias in zip(self.w1, self.b1):
+            acc = bias + sum((x + 128) * w for x, w in zip(pooled, row))
+            out = multiply_by_quantized_multiplier(acc, *self.m1) - 128
+            hidden.append(min(max(out, -128), 127))
+        acc = self.b2 + sum((h + 128) * w for h, w in zip(hidden, self.w2))
+        out = multiply_by_quantized_multiplier(acc, *self.m2)
+        return min(max(out, -128), 127)
+
+    def serialize(self):
+        builder = tflite_model.ModelBuilder()
+        side = IMAGE_SIZE // POOL
+        image = builder.add_tensor('input', 'UINT8',
+                                   [1, IMAGE_SIZE, IMAGE_SIZE, 1],
+                                   [self.input_scale], [0])
+        quantized = builder.add_tensor('quantized', 'INT8',
+                                       [1, IMAGE_SIZE, IMAGE_SIZE, 1],
+                                       [self.input_scale], [-128])
+        pooled = builder.add_tensor('pooled', 'INT8', [1, side, side, 1],
+                                    [self.input_scale], [-128])
+        w1 = builder.add_tensor(
+            'dense/weights', 'INT8', [HIDDEN, FEATURES], [self.w1_scale], [0],
+            bytes(w & 0xff for row in self.w1 for w in row))
+        b1 = builder.add_tensor(
+            'dense/bias', 'INT32', [HIDDEN],
+            [self.input_scale * self.w1_scale], [0],
+            b''.join(b.to_bytes(4, 'little', signed=True) for b in self.b1))
+        hidden = builder.add_tensor('dense', 'INT8', [1, HIDDEN],
+                                    [self.hidden_scale], [-128])
+        w2 = builder.add_tensor('logit/weights', 'INT8', [1, HIDDEN],
+                                [self.w2_scale], [0],
+                                bytes(w & 0xff for w in self.w2))
+        b2 = builder.add_tensor('logit/bias', 'INT32', [1],
+                                [self.hidden_scale * self.w2_scale], [0],
+                                self.b2.to_bytes(4, 'little', signed=True))
+        logit = builder.add_tensor('logit', 'INT8', [1, 1],
+                                   [self.output_scale], [0])
+        builder.add_operator('QUANTIZE', [image], [quantized])
+        builder.add_operator('AVERAGE_POOL_2D', [quantized], [pooled], [
+            (0, 'b', tflite_model.PADDING_VALID), (1, 'i', POOL),
+            (2, 'i', POOL), (3, 'i', POOL), (4, 'i', POOL),
+            (5, 'b', tflite_model.ACTIVATION_NONE)])
+        builder.add_operator('FULLY_CONNECTED', [pooled, w1, b1], [hidden], [
+            (0, 'b', tflite_model.ACTIVATION_RELU)])
+        builder.add_operator('FULLY_CONNECTED', [hidden, w2, b2], [logit], [
+            (0, 'b', tflite_model.ACTIVATION_NONE)])
+        return builder.finish([image], [logit],
+                              'Digit gatekeeper, tools/train_gatekeeper.py')
+
+
+# ---------------------------------------------------------------------------
+# Training
+
+
+def features(pooled):
+    return [(x + 128) / 255 for x in pooled]
+
+
+def forward(params, x):
+    w1, b1, w2, b2 = params
+    hidden = [max(0.0, b + sum(wi * xi for wi, xi in zip(row, x)))
+              for row, b in zip(w1, b1)]
+    return hidden, b2 + sum(w * h for w, h in zip(w2, hidden))
+
+
+def train(samples, rng, epochs, rate=0.05):
+    """Logistic regression through one ReLU layer, plain SGD."""
+    w1 = [[rng.gauss(0, 0.3) for _ in range(FEATURES)] for _ in range(HIDDEN)]
+    b1 = [0.1] * HIDDEN
+    w2 = [rng.gauss(0, 0.3) for _ in range(HIDDEN)]
+    b2 = 0.0
+    samples = samples[:]
+    for _ in range(epochs):
+        rng.shuffle(samples)
+        for x, label in samples:
+            hidden, logit = forward((w1, b1, w2, b2), x)
+            p = 1 / (1 + math.exp(-max(min(logit, 30), -30)))
+            error = (p - label) * rate
+            for j in range(HIDDEN):
+                if hidden[j] > 0:
+                    g = error * w2[j]
+                    row = w1[j]
+                    for i in range(FEATURES):
+                        row[i] -= g * x[i]
+                    b1[j] -= g
+                w2[j] -= error * hidden[j]
+            b2 -= error
+    return w1, b1, w2, b2
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--dataset', default=DEFAULT_DATASET,
+                        help='CSV of recorded digits (default: %(default)s)')
+    parser.add_argument('--cnn', default=DEFAULT_CNN,
+                        help='digit recognition model, used for the MAC '
+                        'count (default: %(default)s)')
+    parser.add_argument('--negatives', type=int, default=200,
+                        help='synthetic strokes per kind of negative')
+    parser.add_argument('--epochs', type=int, default=40)
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--output', help='C array to write the model to, '
+                        'e.g. ../models/digit-gatekeeper-8bit.cc')
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    digits_train, digits_test = split(load_digits(args.dataset), rng)
+    train_set = [(pool(image), 1) for image in digits_train]
+    test_sets = [('digit', [pool(image) for image in digits_test])]
+    for name, generate in NEGATIVES:
+        images = [generate(rng) for _ in range(args.negatives)]
+        negatives_train, negatives_test = split(images, rng)
+        train_set += [(pool(image), 0) for image in negatives_train]
+        test_sets.append((name, [pool(image) for image in negatives_test]))
+
+    w1, b1, w2, b2 = train([(features(x), y) for x, y in train_set], rng,
+                           args.epochs)
+    hidden_max = logit_max = 0.0
+    for x, _ in train_set:
+        hidden, logit = forward((w1, b1, w2, b2), features(x))
+        hidden_max = max([hidden_max] + hidden)
+        logit_max = max(logit_max, abs(logit))
+    model = QuantizedModel(w1, b1, w2, b2, hidden_max, logit_max)
+
+    print('Test set (int8 model, digit when logit > 0):')
+    negatives_accepted = negatives_total = 0
+    for name, samples in test_sets:
+        accepted = sum(1 for x in samples if model.logit(x) > 0)
+        if name == 'digit':
+            print('  %-9s accepted %5.1f%% (%d/%d)' % (
+                name, 100 * accepted / len(samples), accepted, len(samples)))
+        else:
+            negatives_accepted += accepted
+            negatives_total += len(samples)
+            print('  %-9s rejected %5.1f%% (%d/%d)' % (
+                name, 100 * (1 - accepted / len(samples)),
+                len(samples) - accepted, len(samples)))
+    negative_accept_rate = negatives_accepted / negatives_total
+    recorded = [pool(image) for image in digits_train + digits_test]
+    accept_rate = sum(1 for x in recorded if model.logit(x) > 0) / len(
+        recorded)
+
+    cnn = tflite_model.load_model(args.cnn)
+    cnn_macs = 0
+    for op in cnn.operators:
+        out = cnn.tensors[op.outputs[0]]
+        if op.opcode == 'CONV_2D':
+            filter_shape = cnn.tensors[op.inputs[1]].shape
+            cnn_macs += (out.elements() * filter_shape[1] * filter_shape[2] *
+                         filter_shape[3])
+        elif op.opcode == 'FULLY_CONNECTED':
+            cnn_macs += cnn.tensors[op.inputs[1]].elements()
+    gate_macs = IMAGE_SIZE * IMAGE_SIZE + FEATURES * HIDDEN + HIDDEN
+    print('\nMACs per stroke: CNN %d, gatekeeper %d' % (cnn_macs, gate_macs))
+    print('  recorded dataset: %d with gatekeeper (%.1f%% of CNN only), '
+          '%.1f%% of the strokes accepted' % (
+              gate_macs + accept_rate * cnn_macs,
+              100 * (gate_macs + accept_rate * cnn_macs) / cnn_macs,
+              100 * accept_rate))
+    for share in (0.1, 0.25, 0.5):
+        cost = gate_macs + ((1 - share) * accept_rate +
+                            share * negative_accept_rate) * cnn_macs
+        print('  %2d%% non-digits:   %d with gatekeeper (%.1f%% of CNN only)'
+              % (100 * share, cost, 100 * cost / cnn_macs))
+
+    if args.output:
+        tflite_model.write_c_array(args.output, model.serialize(), ARRAY_NAME,
+                                   HEADER)
+        print('\nWrote', args.output)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,181 @@
+"""Uploads a model into the model slot of the board over the UART.
+
+The model (a .tflite file or a C array as in models/) is sent in CRC-checked
+chunks with the binary frames of src/uart_frame.h, next to the text the
+application keeps printing on the same UART. The board checks the model in
+flash (CRC-32, flatbuffers Verifier, operators registered in its op
+resolver) before marking the slot valid. With --activate the board then
+restarts and runs the uploaded model; otherwise it is used from the next
+boot on. A model that fails to allocate at boot is dropped and the board
+falls back to the model built into the application.
+
+Lost or corrupted frames are sent again. The protocol itself is independent
+of pyserial: Uploader only needs an object with write(bytes) and
+read(size) -> bytes that returns b'' on timeout, e.g. a pseudo terminal on
+Linux.
+
+Usage:
+    python upload_model.py model --port COM5 [--baud 115200] [--activate]
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import tflite_model
+
+SYNC = b'\xa5\x5a'
+REPLY = 0x80
+MAX_PAYLOAD = 136
+
+BEGIN = 0x01
+DATA = 0x02
+COMMIT = 0x03
+ACTIVATE = 0x04
+INFO = 0x05
+
+# model_slot_status_t in src/model_slot.h.
+STATUS = [
+    'ok',
+    'no upload in progress',
+    'model larger than the slot, or incomplete',
+    'data not contiguous with the previous chunk',
+    'flash write failed',
+    'CRC mismatch of the model in flash',
+    'not a valid TFLite flatbuffer',
+    'uses an operator missing from the op resolver',
+    'input or output tensor not the one the application uses',
+]
+
+
+def crc16(data, crc=0xffff):
+    """CRC-16/CCITT-FALSE, as uart_frame_crc16()."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+
+def encode_frame(command, payload=b''):
+    body = struct.pack('<BH', command, len(payload)) + payload
+    return SYNC + body + struct.pack('<H', crc16(body))
+
+
+class FrameDecoder:
+    """Extracts the frames from a byte stream that also carries text."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        """Returns the (command, payload) of the complete frames in data."""
+        self.buffer.extend(data)
+        frames = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[:-1]
+                return frames
+            del self.buffer[:start]
+            if len(self.buffer) < 5:
+                return frames
+            command, length = struct.unpack_from('<BH', self.buffer, 2)
+            if length > MAX_PAYLOAD:
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < 7 + length:
+                return frames
+            body = bytes(self.buffer[2:5 + length])
+            crc, = struct.unpack_from('<H', self.buffer, 5 + length)
+            if crc == crc16(body):
+                frames.append((command, body[3:]))
+                del self.buffer[:7 + length]
+            else:
+                del self.buffer[:1]
+
+
+class UploadError(Exception):
+    pass
+
+
+class Uploader:
+
+    def __init__(self, port, timeout=2.0, retries=5, log=print):
+        self.port = port
+        self.timeout = timeout
+        self.retries = retries
+        self.decoder = FrameDecoder()
+        self.log = log
+
+    def request(self, command, payload=b''):
+        """Sends a request until its reply arrives, returns (status, value)."""
+        frame = encode_frame(command, payload)
+        for _ in range(self.retries):
+            self.port.write(frame)
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                for reply, data in self.decoder.feed(self.port.read(64)):
+                    if reply == command | REPLY and len(data) == 5:
+                        return struct.unpack('<BI', data)
+        raise UploadError('no reply to command 0x%02x' % command)
+
+    def check(self, command, payload=b''):
+        status, value = self.request(command, payload)
+        if status != 0:
+            raise UploadError(STATUS[status] if status < len(STATUS)
+                              else 'status %d' % status)
+        return value
+
+    def upload(self, model, chunk_size=128, activate=False):
+        crc = zlib.crc32(model) & 0xffffffff
+        capacity = self.check(BEGIN, struct.pack('<II', len(model), crc))
+        self.log('Uploading %d bytes (CRC-32 %08x) into a %d byte slot'
+                 % (len(model), crc, capacity))
+        offset = 0
+        while offset < len(model):
+            chunk = model[offset:offset + chunk_size]
+            written = self.check(DATA, struct.pack('<I', offset) + chunk)
+            if written != offset + len(chunk):
+                raise UploadError('board wrote %d bytes, expected %d'
+                                  % (written, offset + len(chunk)))
+            offset = written
+        self.check(COMMIT)
+        self.log('Model verified and stored in the slot')
+        if activate:
+            self.check(ACTIVATE)
+            self.log('Board restarting with the new model')
+
+    def slot_size(self):
+        return self.check(INFO)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', help='.tflite file or C array of the model')
+    parser.add_argument('--port', required=True, help='serial port, e.g. '
+                        'COM5 or /dev/ttyACM0')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--chunk', type=int, default=128,
+                        help='bytes of model per frame (at most %d)'
+                        % (MAX_PAYLOAD - 4))
+    parser.add_argument('--activate', action='store_true',
+                        help='restart the board with the new model')
+    args = parser.parse_args()
+    if not 0 < args.chunk <= MAX_PAYLOAD - 4:
+        parser.error('--chunk must be between 1 and %d' % (MAX_PAYLOAD - 4))
+
+    import serial
+    model = tflite_model.read_model_bytes(args.model)
+    with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+        try:
+            Uploader(port).upload(model, args.chunk, args.activate)
+        except UploadError as error:
+            sys.exit('Upload failed: %s' % error)
+
+
+if __name__ == '__main__':
+    main()
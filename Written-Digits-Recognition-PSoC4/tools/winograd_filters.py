@@ -0,0 +1,501 @@
+"""Transforms 3x3 convolution filters offline for the Winograd kernel.
+
+WinogradConvS8 (tflm-cmsis/.../kernels/winograd_conv.h) computes 3x3 stride 1
+convolutions with the F(2x2, 3x3) algorithm: 16 multiplies per 2x2 block of
+outputs and per input and output channel instead of 36. Its filters are
+transformed offline with 2G instead of G, which keeps them in integers
+(int16, four times the real transform), and the kernel divides the result
+by four, exactly, so the outputs are bit-exact with the direct convolution.
+
+This script writes the transformed filters of the selected layers into a
+WinogradFilterTable, which the application hands to its interpreter with
+MicroInterpreter::SetWinogradFilters and uses with the CONV_2D kernel variant
+returned by tflite::Register_CONV_2D_WINOGRAD(). Only the layers in the table
+take the Winograd path, so the selection is made here with --layers. A
+CONV_2D fused into another kernel (CONV_2D_MAX_POOL_2D, PATCH_CONV_STACK) does
+not go through the variant.
+
+It also reports the multiplies saved per layer and, unless --samples is 0,
+runs the model in integer arithmetic on the recorded digits with the direct
+and the Winograd convolution of the selected layers, and compares the
+activations and the accuracy of both. The classifier head after MAX_POOL_2D
+is evaluated in float on the pooled activations, the same way for both. It
+only uses the Python standard library.
+
+Usage:
+    python winograd_filters.py [model] [--layers 2 3]
+                               [--output ../src/winograd_filters]
+                               [--dataset ../data_collection/...csv]
+                               [--samples N]
+"""
+
+import argparse
+import csv
+import math
+import os
+import struct
+from operator import mul
+
+import pack_weights
+import tflite_model
+
+TOOLS_DIR = os.path.dirname(__file__)
+DEFAULT_MODEL = os.path.join(TOOLS_DIR, '..', 'models',
+                             'written-digit-recognition-cnn-v3.0-8bit.cc')
+DEFAULT_OUTPUT = os.path.join(TOOLS_DIR, '..', 'src', 'winograd_filters')
+DEFAULT_DATASET = os.path.join(TOOLS_DIR, '..', 'data_collection',
+                               'fine_tuning_dataset.csv')
+
+# Same as kWinogradMaxInputDepth in winograd_conv.h.
+MAX_INPUT_DEPTH = 204
+
+# 2G, B^T and A^T of F(2x2, 3x3).
+G2 = [[2, 0, 0], [1, 1, 1], [1, -1, 1], [0, 0, 2]]
+BT = [[1, 0, -1, 0], [0, 1, 1, 0], [0, -1, 1, 0], [0, 1, 0, -1]]
+AT = [[1, 1, 1, 0], [0, 1, -1, -1]]
+
+
+def matmul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(len(b)))
+             for j in range(len(b[0]))] for i in range(len(a))]
+
+
+def transpose(a):
+    return [list(row) for row in zip(*a)]
+
+
+def transform_filter(g):
+    """(2G) g (2G)^T of a 3x3 filter, as 16 values in row major order."""
+    u = matmul(matmul(G2, g), transpose(G2))
+    return [v for row in u for v in row]
+
+
+# ---------------------------------------------------------------------------
+# Model
+
+
+def same_padding(in_size, out_size, stride, filter_size):
+    return max((out_size - 1) * stride + filter_size - in_size, 0) // 2
+
+
+def quantize_multiplier(scale):
+    """Same as QuantizeMultiplier in quantization_util.cc."""
+    if scale == 0:
+        return 0, 0
+    mantissa, shift = math.frexp(scale)
+    multiplier = int(round(mantissa * (1 << 31)))
+    if multiplier == 1 << 31:
+        multiplier //= 2
+        shift += 1
+    return multiplier, shift
+
+
+def multiply_by_quantized_multiplier(x, multiplier, shift):
+    left = max(shift, 0)
+    right = max(-shift, 0)
+    x = x * (1 << left)
+    # SaturatingRoundingDoublingHighMul.
+    product = x * multiplier
+    nudge = (1 << 30) if product >= 0 else 1 - (1 << 30)
+    high = product + nudge
+    high = abs(high) >> 31 if high >= 0 else -(abs(high) >> 31)
+    # RoundingDivideByPOT.
+    mask = (1 << right) - 1
+    remainder = high & mask
+    threshold = (mask >> 1) + (1 if high < 0 else 0)
+    return (high >> right) + (1 if remainder > threshold else 0)
+
+
+def unpack_int4(data, count):
+    """The |count| elements of TFLite packed int4 |data|, low nibble
+    first."""
+    values = []
+    for byte in data:
+        for nibble in (byte & 0xf, byte >> 4):
+            values.append(nibble - 16 if nibble & 0x8 else nibble)
+    return tuple(values[:count])
+
+
+class ConvLayer:
+    """An int8 CONV_2D of the model, with int8 or int4 weights, and its
+    quantization parameters."""
+
+    def __init__(self, model, op):
+        self.op = op
+        input_tensor = model.tensors[op.inputs[0]]
+        filter_tensor = model.tensors[op.inputs[1]]
+        output_tensor = model.tensors[op.outputs[0]]
+        self.output_depth, self.filter_height, self.filter_width, \
+            self.input_depth = filter_tensor.shape
+        _, self.input_height, self.input_width, _ = input_tensor.shape
+        _, self.output_height, self.output_width, _ = output_tensor.shape
+        self.stride_h = op.options['stride_h']
+        self.stride_w = op.options['stride_w']
+        self.dilation_h = op.options.get('dilation_h', 1)
+        self.dilation_w = op.options.get('dilation_w', 1)
+        if op.options['padding'] == tflite_model.PADDING_SAME:
+            self.pad_h = same_padding(self.input_height, self.output_height,
+                                      self.stride_h, self.filter_height)
+            self.pad_w = same_padding(self.input_width, self.output_width,
+                                      self.stride_w, self.filter_width)
+        else:
+            self.pad_h = self.pad_w = 0
+        buffer = model.buffers[filter_tensor.buffer]
+        if filter_tensor.type == 'INT4':
+            self.weights = unpack_int4(buffer, filter_tensor.elements())
+        else:
+            self.weights = struct.unpack('<%db' % len(buffer), buffer)
+        self.bias = None
+        if len(op.inputs) > 2 and op.inputs[2] >= 0:
+            bias_buffer = model.buffers[model.tensors[op.inputs[2]].buffer]
+            self.bias = struct.unpack('<%di' % (len(bias_buffer) // 4),
+                                      bias_buffer)
+        self.input_zero_point = input_tensor.zero_point[0]
+        self.output_zero_point = output_tensor.zero_point[0]
+        scales = filter_tensor.scale
+        if len(scales) == 1:
+            scales = scales * self.output_depth
+        self.multipliers = [
+            quantize_multiplier(input_tensor.scale[0] * s /
+                                output_tensor.scale[0]) for s in scales]
+        self.input_type = input_tensor.type
+        self.filter_type = filter_tensor.type
+        self.constant = model.is_constant(op.inputs[1])
+
+    def winograd_eligible(self):
+        return (self.input_type == 'INT8' and self.filter_type == 'INT8' and
+                self.constant and self.filter_height == 3 and
+                self.filter_width == 3 and self.stride_h == 1 and
+                self.stride_w == 1 and self.dilation_h == 1 and
+                self.dilation_w == 1 and self.input_depth <= MAX_INPUT_DEPTH)
+
+    def filter_depth(self):
+        return self.filter_height * self.filter_width * self.input_depth
+
+    def transformed_filter(self):
+        """[output channel][tile element][input channel], see
+        WinogradFilterEntry."""
+        data = []
+        size = self.filter_depth()
+        for oc in range(self.output_depth):
+            w = self.weights[oc * size:(oc + 1) * size]
+            per_channel = [
+                transform_filter([[w[(y * 3 + x) * self.input_depth + c]
+                                   for x in range(3)] for y in range(3)])
+                for c in range(self.input_depth)]
+            for k in range(16):
+                data.extend(u[k] for u in per_channel)
+        return data
+
+    def requantize(self, oc, acc):
+        if self.bias is not None:
+            acc += self.bias[oc]
+        out = multiply_by_quantized_multiplier(acc, *self.multipliers[oc])
+        return min(max(out + self.output_zero_point, -128), 127)
+
+    def direct(self, x):
+        """The convolution of the int8 activations |x| (HWC), as int8."""
+        h, w, c = self.input_height, self.input_width, self.input_depth
+        size = self.filter_depth()
+        filters = [self.weights[oc * size:(oc + 1) * size]
+                   for oc in range(self.output_depth)]
+        out = []
+        for oy in range(self.output_height):
+            for ox in range(self.output_width):
+                col = []
+                for ky in range(self.filter_height):
+                    y = oy * self.stride_h - self.pad_h + ky * self.dilation_h
+                    for kx in range(self.filter_width):
+                        x_ = ox * self.stride_w - self.pad_w + \
+                            kx * self.dilation_w
+                        if 0 <= y < h and 0 <= x_ < w:
+                            base = (y * w + x_) * c
+                            col.extend(v - self.input_zero_point
+                                       for v in x[base:base + c])
+                        else:
+                            col.extend([0] * c)
+                for oc, f in enumerate(filters):
+                    out.append(self.requantize(oc, sum(map(mul, col, f))))
+        return out
+
+    def winograd(self, x, transformed):
+        """Same as direct() with the integer F(2x2, 3x3) algorithm of
+        WinogradConvS8."""
+        h, w, c = self.input_height, self.input_width, self.input_depth
+        oh, ow, od = self.output_height, self.output_width, self.output_depth
+        filters = [[transformed[(oc * 16 + k) * c:(oc * 16 + k + 1) * c]
+                    for k in range(16)] for oc in range(od)]
+        out = [0] * (oh * ow * od)
+        for ty in range(0, oh, 2):
+            for tx in range(0, ow, 2):
+                # V[k] over the input channels.
+                d = []
+                for y in range(ty - self.pad_h, ty - self.pad_h + 4):
+                    for x_ in range(tx - self.pad_w, tx - self.pad_w + 4):
+                        if 0 <= y < h and 0 <= x_ < w:
+                            base = (y * w + x_) * c
+                            d.append([v - self.input_zero_point
+                                      for v in x[base:base + c]])
+                        else:
+                            d.append([0] * c)
+                v = [[0] * c for _ in range(16)]
+                for i in range(4):
+                    for j in range(4):
+                        for a in range(4):
+                            for b in range(4):
+                                coeff = BT[i][a] * BT[j][b]
+                                if coeff:
+                                    src = d[a * 4 + b]
+                                    dst = v[i * 4 + j]
+                                    for ch in range(c):
+                                        dst[ch] += coeff * src[ch]
+                for oc in range(od):
+                    m = [sum(map(mul, filters[oc][k], v[k]))
+                         for k in range(16)]
+                    for y in range(min(2, oh - ty)):
+                        for x_ in range(min(2, ow - tx)):
+                            acc = sum(AT[y][a] * AT[x_][b] * m[a * 4 + b]
+                                      for a in range(4) for b in range(4))
+                            assert acc % 4 == 0
+                            out[((ty + y) * ow + tx + x_) * od + oc] = \
+                                self.requantize(oc, acc // 4)
+        return out
+
+    def multiplies(self):
+        direct = (self.output_height * self.output_width * self.output_depth *
+                  self.filter_depth())
+        tiles = ((self.output_height + 1) // 2) * \
+            ((self.output_width + 1) // 2)
+        winograd = tiles * self.output_depth * 16 * self.input_depth
+        return direct, winograd
+
+
+def max_pool(x, h, w, c, op):
+    stride_h, stride_w = op.options['stride_h'], op.options['stride_w']
+    filter_h, filter_w = op.options['filter_h'], op.options['filter_w']
+    oh = (h + stride_h - 1) // stride_h
+    ow = (w + stride_w - 1) // stride_w
+    if op.options['padding'] == tflite_model.PADDING_VALID:
+        oh = (h - filter_h) // stride_h + 1
+        ow = (w - filter_w) // stride_w + 1
+    pad_h = same_padding(h, oh, stride_h, filter_h) \
+        if op.options['padding'] == tflite_model.PADDING_SAME else 0
+    pad_w = same_padding(w, ow, stride_w, filter_w) \
+        if op.options['padding'] == tflite_model.PADDING_SAME else 0
+    out = []
+    for oy in range(oh):
+        for ox in range(ow):
+            for ch in range(c):
+                out.append(max(
+                    x[(y * w + x_) * c + ch]
+                    for y in range(max(oy * stride_h - pad_h, 0),
+                                   min(oy * stride_h - pad_h + filter_h, h))
+                    for x_ in range(max(ox * stride_w - pad_w, 0),
+                                    min(ox * stride_w - pad_w + filter_w, w))))
+    return out, oh, ow
+
+
+class Network:
+    """QUANTIZE, the CONV_2D layers and MAX_POOL_2D in integers, then the
+    MEAN / FULLY_CONNECTED head in float."""
+
+    def __init__(self, model):
+        self.model = model
+        self.ops = model.operators
+        self.convs = {op.index: ConvLayer(model, op)
+                      for op in self.ops if op.opcode == 'CONV_2D'}
+
+    def predict(self, image, transformed, mismatches):
+        x = image
+        _, h, w, c = self.model.tensors[self.ops[0].inputs[0]].shape
+        pooled_scale = pooled_zero_point = None
+        for op in self.ops:
+            if op.opcode == 'QUANTIZE' and op.index == 0:
+                # uint8 to int8 with the same scale.
+                offset = (self.model.tensors[op.outputs[0]].zero_point[0] -
+                          self.model.tensors[op.inputs[0]].zero_point[0])
+                x = [v + offset for v in x]
+            elif op.opcode == 'CONV_2D':
+                layer = self.convs[op.index]
+                out = layer.direct(x)
+                if op.index in transformed:
+                    winograd = layer.winograd(x, transformed[op.index])
+                    mismatches[op.index] += sum(
+                        a != b for a, b in zip(out, winograd))
+                    out = winograd
+                x, h, w, c = (out, layer.output_height, layer.output_width,
+                              layer.output_depth)
+            elif op.opcode == 'MAX_POOL_2D':
+                tensor = self.model.tensors[op.outputs[0]]
+                x, h, w = max_pool(x, h, w, c, op)
+                pooled_scale = tensor.scale[0]
+                pooled_zero_point = tensor.zero_point[0]
+            elif op.opcode == 'FULLY_CONNECTED':
+                return self.head(x, h * w, c, op, pooled_scale,
+                                 pooled_zero_point)
+        raise ValueError('model has no FULLY_CONNECTED head')
+
+    def head(self, x, pixels, c, op, scale, zero_point):
+        mean = [scale * (sum(x[p * c + ch] for p in range(pixels)) / pixels -
+                         zero_point) for ch in range(c)]
+        weights_tensor = self.model.tensors[op.inputs[1]]
+        weights = struct.unpack(
+            '<%db' % weights_tensor.elements(),
+            self.model.buffers[weights_tensor.buffer])
+        bias_tensor = self.model.tensors[op.inputs[2]]
+        bias = struct.unpack('<%di' % bias_tensor.elements(),
+                             self.model.buffers[bias_tensor.buffer])
+        logits = [bias[o] * bias_tensor.scale[0] +
+                  sum(weights_tensor.scale[0] * weights[o * c + ch] * mean[ch]
+                      for ch in range(c))
+                  for o in range(weights_tensor.shape[0])]
+        return logits.index(max(logits))
+
+
+# ---------------------------------------------------------------------------
+# Output
+
+
+def write_table(path, entries, model_path):
+    name = os.path.basename(path)
+    guard = 'SRC_WINOGRAD_FILTERS_H_'
+    with open(path + '.h', 'w') as f:
+        f.write('/*\n'
+                ' * %s.h\n'
+                ' *\n'
+                ' *  Generated by tools/winograd_filters.py, do not edit, '
+                'from:\n'
+                ' *  %s\n'
+                ' *  Filters transformed for the Winograd convolution, see\n'
+                ' *  MicroInterpreter::SetWinogradFilters.\n'
+                ' */\n\n'
+                '#ifndef %s\n'
+                '#define %s\n\n'
+                '#include "tensorflow/lite/micro/kernels/winograd_conv.h"\n\n'
+                'extern const tflite::WinogradFilterTable winograd_filters;\n\n'
+                '#endif /* %s */\n' % (name, os.path.basename(model_path),
+                                       guard, guard, guard))
+
+    lines = ['/*',
+             ' * %s.cpp' % name,
+             ' *',
+             ' *  Generated by tools/winograd_filters.py, do not edit, from:',
+             ' *  %s' % os.path.basename(model_path),
+             ' */',
+             '',
+             '#include "%s.h"' % name,
+             '']
+    for index, entry in enumerate(entries):
+        lines.append('/* %s */' % entry['description'])
+        lines.append('static const int16_t winograd_filter_%d[] = {' % index)
+        data = entry['data']
+        for i in range(0, len(data), 12):
+            chunk = ', '.join('%d' % v for v in data[i:i + 12])
+            lines.append('  ' + chunk + (',' if i + 12 < len(data) else ''))
+        lines.append('};')
+        lines.append('')
+    lines.append('static const tflite::WinogradFilterEntry '
+                 'winograd_filter_entries[] = {')
+    for index, entry in enumerate(entries):
+        lines.append('  {0x%08xu, %d, %d, winograd_filter_%d},' %
+                     (entry['checksum'], entry['output_depth'],
+                      entry['depth'], index))
+    lines.append('};')
+    lines.append('')
+    lines.append('const tflite::WinogradFilterTable winograd_filters = {')
+    lines.append('  winograd_filter_entries, %d' % len(entries))
+    lines.append('};')
+    with open(path + '.cpp', 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def load_digits(path):
+    with open(path, newline='') as f:
+        rows = list(csv.reader(f))[1:]
+    return [(int(row[0]), [int(v) for v in row[1:]]) for row in rows]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', nargs='?', default=DEFAULT_MODEL,
+                        help='.tflite file or C array of the model')
+    parser.add_argument('--layers', type=int, nargs='*',
+                        help='operator indices of the CONV_2D layers to '
+                        'transform (default: all the 3x3 stride 1 ones)')
+    parser.add_argument('--output', default=DEFAULT_OUTPUT,
+                        help='path of the .h/.cpp pair to write, without '
+                        'extension (default: ../src/winograd_filters)')
+    parser.add_argument('--dataset', default=DEFAULT_DATASET,
+                        help='CSV of recorded digits (default: %(default)s)')
+    parser.add_argument('--samples', type=int, default=-1,
+                        help='number of digits to evaluate, 0 to skip the '
+                        'evaluation (default: all)')
+    args = parser.parse_args()
+
+    model = tflite_model.load_model(args.model)
+    network = Network(model)
+    eligible = [i for i, layer in sorted(network.convs.items())
+                if layer.winograd_eligible()]
+    layers = eligible if args.layers is None else args.layers
+    for index in layers:
+        if index not in eligible:
+            parser.error('operator %d is not an int8 3x3 stride 1 CONV_2D' %
+                         index)
+
+    entries = []
+    transformed = {}
+    total_direct = sum(layer.multiplies()[0]
+                       for layer in network.convs.values())
+    total_winograd = total_direct
+    print('operator  shape  direct MACs  Winograd multiplies  saving')
+    for index in layers:
+        layer = network.convs[index]
+        data = layer.transformed_filter()
+        transformed[index] = data
+        entries.append({
+            'checksum': pack_weights.checksum(layer.weights, layer.bias,
+                                              layer.input_zero_point),
+            'output_depth': layer.output_depth,
+            'depth': layer.input_depth,
+            'data': data,
+            'description': 'operator %d (CONV_2D), %dx3x3x%d' %
+                           (index, layer.output_depth, layer.input_depth),
+        })
+        direct, winograd = layer.multiplies()
+        total_winograd += winograd - direct
+        print('%d  %dx%dx%d -> %dx%dx%d  %d  %d  %.2fx' %
+              (index, layer.input_height, layer.input_width,
+               layer.input_depth, layer.output_height, layer.output_width,
+               layer.output_depth, direct, winograd, direct / winograd))
+    print('all CONV_2D layers: %d MACs direct, %d with Winograd (-%.1f%%)' %
+          (total_direct, total_winograd,
+           100.0 * (total_direct - total_winograd) / total_direct))
+
+    write_table(args.output, entries, args.model)
+    print('%d layers, %d bytes of flash, written to %s.h/.cpp' %
+          (len(entries), sum(2 * len(e['data']) for e in entries),
+           os.path.normpath(args.output)))
+
+    if args.samples == 0:
+        return 0
+    digits = load_digits(args.dataset)
+    if args.samples > 0:
+        digits = digits[:args.samples]
+    mismatches = {index: 0 for index in layers}
+    correct_direct = correct_winograd = 0
+    for label, image in digits:
+        correct_direct += network.predict(image, {}, {}) == label
+        correct_winograd += network.predict(image, transformed,
+                                            mismatches) == label
+    count = len(digits)
+    print('%d digits: accuracy %.4f direct, %.4f Winograd (delta %+.4f)' %
+          (count, correct_direct / count, correct_winograd / count,
+           (correct_winograd - correct_direct) / count))
+    for index in layers:
+        print('operator %d: %d activations differ from the direct '
+              'convolution' % (index, mismatches[index]))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())